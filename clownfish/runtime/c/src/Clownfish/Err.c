@@ -29,10 +29,75 @@
 #include "Clownfish/Util/Memory.h"
 #include "Clownfish/VTable.h"
 
-/* TODO: Thread safety */
-static Err *current_error;
-static Err *thrown_error;
-static jmp_buf  *current_env;
+/* Each thread gets its own error state, so that Err_get_error() reports the
+ * error set by the current thread and Err_trap() only catches exceptions
+ * thrown within it.
+ */
+typedef struct {
+    Err     *current_error;
+    Err     *thrown_error;
+    jmp_buf *current_env;
+} ErrState;
+
+#if defined(CFISH_NOTHREADS) || defined(_MSC_VER) || defined(__GNUC__)
+
+#if defined(CFISH_NOTHREADS)
+  #define THREAD_LOCAL
+#elif defined(_MSC_VER)
+  #define THREAD_LOCAL __declspec(thread)
+#else
+  #define THREAD_LOCAL __thread
+#endif
+
+static THREAD_LOCAL ErrState err_state;
+
+static CFISH_INLINE ErrState*
+S_get_state(void) {
+    return &err_state;
+}
+
+#elif defined(CHY_HAS_PTHREAD_H)
+
+/* Without compiler support for thread-local variables, keep each thread's
+ * state in thread-specific data, created on first use.
+ */
+#include <pthread.h>
+
+static pthread_key_t  err_state_key;
+static pthread_once_t err_state_once = PTHREAD_ONCE_INIT;
+
+static void
+S_destroy_state(void *arg) {
+    ErrState *state = (ErrState*)arg;
+    DECREF(state->current_error);
+    free(state);
+}
+
+static void
+S_create_key(void) {
+    if (pthread_key_create(&err_state_key, S_destroy_state) != 0) {
+        fprintf(stderr, "Can't create thread-specific key for Err\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static ErrState*
+S_get_state(void) {
+    pthread_once(&err_state_once, S_create_key);
+    ErrState *state = (ErrState*)pthread_getspecific(err_state_key);
+    if (!state) {
+        state = (ErrState*)calloc(1, sizeof(ErrState));
+        if (!state || pthread_setspecific(err_state_key, state) != 0) {
+            fprintf(stderr, "Can't allocate thread-specific Err state\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return state;
+}
+
+#else
+  #error "No thread-local storage for Err; configure with --disable-threads"
+#endif
 
 void
 Err_init_class(void) {
@@ -40,22 +105,24 @@ Err_init_class(void) {
 
 Err*
 Err_get_error() {
-    return current_error;
+    return S_get_state()->current_error;
 }
 
 void
 Err_set_error(Err *error) {
-    if (current_error) {
-        DECREF(current_error);
+    ErrState *state = S_get_state();
+    if (state->current_error) {
+        DECREF(state->current_error);
     }
-    current_error = error;
+    state->current_error = error;
 }
 
 void
 Err_do_throw(Err *error) {
-    if (current_env) {
-        thrown_error = error;
-        longjmp(*current_env, 1);
+    ErrState *state = S_get_state();
+    if (state->current_env) {
+        state->thrown_error = error;
+        longjmp(*state->current_env, 1);
     }
     else {
         String *message = Err_Get_Mess(error);
@@ -90,18 +157,19 @@ Err_warn_mess(String *message) {
 
 Err*
 Err_trap(Err_Attempt_t routine, void *context) {
-    jmp_buf  env;
-    jmp_buf *prev_env = current_env;
-    current_env = &env;
+    ErrState *state    = S_get_state();
+    jmp_buf   env;
+    jmp_buf  *prev_env = state->current_env;
+    state->current_env = &env;
 
     if (!setjmp(env)) {
         routine(context);
     }
 
-    current_env = prev_env;
+    state->current_env = prev_env;
 
-    Err *error = thrown_error;
-    thrown_error = NULL;
+    Err *error = state->thrown_error;
+    state->thrown_error = NULL;
     return error;
 }
 
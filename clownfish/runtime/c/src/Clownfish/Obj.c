@@ -22,34 +22,44 @@
 
 #include "Clownfish/Obj.h"
 #include "Clownfish/Err.h"
+#include "Clownfish/Util/Atomic.h"
 
 uint32_t
 Obj_Get_RefCount_IMP(Obj *self) {
     return self->refcount;
 }
 
+/* Refcounts are manipulated atomically unless threads are disabled, so that
+ * an object may be shared among threads so long as no thread modifies it.
+ */
 Obj*
 Obj_Inc_RefCount_IMP(Obj *self) {
-    self->refcount++;
+    Atomic_inc_size_t(&self->refcount);
     return self;
 }
 
 uint32_t
 Obj_Dec_RefCount_IMP(Obj *self) {
-    uint32_t modified_refcount = INT32_MAX;
+    size_t modified_refcount;
     switch (self->refcount) {
         case 0:
             THROW(ERR, "Illegal refcount of 0");
-            break; // useless
+            UNREACHABLE_RETURN(uint32_t);
         case 1:
-            modified_refcount = 0;
+            // We hold the only reference, so no other thread can change the
+            // refcount.
             Obj_Destroy(self);
-            break;
+            return 0;
         default:
-            modified_refcount = --self->refcount;
-            break;
+            modified_refcount = Atomic_dec_size_t(&self->refcount);
+            if (modified_refcount == 0) {
+                // Another thread let go between our read and our decrement.
+                // Restore the refcount seen by Destroy() in the common case.
+                self->refcount = 1;
+                Obj_Destroy(self);
+            }
+            return (uint32_t)modified_refcount;
     }
-    return modified_refcount;
 }
 
 void*
@@ -6794,6 +6794,9 @@ typedef struct SourceFileContext {
 static const char cfish_version[]       = "0.3.0";
 static const char cfish_major_version[] = "0.3";
 
+/* Whether to build with thread support (the default). */
+static int use_threads = 1;
+
 static void
 S_add_compiler_flags(struct chaz_CLIArgs *args) {
     chaz_CFlags *extra_cflags = chaz_CC_get_extra_cflags();
@@ -7015,6 +7018,9 @@ S_write_makefile(struct chaz_CLIArgs *args) {
     if (math_library) {
         chaz_CFlags_add_external_library(link_flags, math_library);
     }
+    if (use_threads && chaz_HeadCheck_check_header("pthread.h")) {
+        chaz_CFlags_add_external_library(link_flags, "pthread");
+    }
     if (args->code_coverage) {
         chaz_CFlags_enable_code_coverage(link_flags);
     }
@@ -7026,6 +7032,9 @@ S_write_makefile(struct chaz_CLIArgs *args) {
     chaz_CFlags_enable_optimization(test_cflags);
     chaz_CFlags_add_include_dir(test_cflags, autogen_inc_dir);
     chaz_CFlags_add_library(test_cflags, lib);
+    if (use_threads && chaz_HeadCheck_check_header("pthread.h")) {
+        chaz_CFlags_add_external_library(test_cflags, "pthread");
+    }
     scratch = chaz_Util_join(dir_sep, "t", "test_cfish.c", NULL);
     rule = chaz_MakeFile_add_compiled_exe(makefile, test_cfish_exe, scratch,
                                           test_cflags);
@@ -7108,6 +7117,7 @@ int main(int argc, const char **argv) {
             if (strncmp(argv[i], "--disable-threads", 17) == 0) {
                 chaz_CFlags *extra_cflags = chaz_CC_get_extra_cflags();
                 chaz_CFlags_append(extra_cflags, "-DCFISH_NOTHREADS");
+                use_threads = 0;
                 break;
             }
         }
@@ -143,7 +143,7 @@ Hash_do_store(Hash *self, Obj *key, Obj *value,
             break;
         }
         else if (entry->hash_sum == hash_sum
-                 && Obj_Equals(key, entry->key)
+                 && (entry->key == key || Obj_Equals(key, entry->key))
                 ) {
             DECREF(entry->value);
             entry->value = value;
@@ -192,7 +192,7 @@ SI_fetch_entry(Hash *self, Obj *key, int32_t hash_sum) {
             return NULL;
         }
         else if (entry->hash_sum == hash_sum
-                 && Obj_Equals(key, entry->key)
+                 && (entry->key == key || Obj_Equals(key, entry->key))
                 ) {
             return entry;
         }
@@ -78,7 +78,8 @@ Str_init_from_trusted_utf8(String *self, const char *utf8, size_t size) {
     // Assign.
     self->ptr    = ptr;
     self->size   = size;
-    self->origin = self;
+    self->origin   = self;
+    self->hash_sum = 0;
 
     return self;
 }
@@ -100,9 +101,10 @@ Str_new_steal_trusted_utf8(char *utf8, size_t size) {
 
 String*
 Str_init_steal_trusted_utf8(String *self, char *utf8, size_t size) {
-    self->ptr    = utf8;
-    self->size   = size;
-    self->origin = self;
+    self->ptr      = utf8;
+    self->size     = size;
+    self->origin   = self;
+    self->hash_sum = 0;
     return self;
 }
 
@@ -123,9 +125,10 @@ Str_new_wrap_trusted_utf8(const char *utf8, size_t size) {
 
 String*
 Str_init_wrap_trusted_utf8(String *self, const char *ptr, size_t size) {
-    self->ptr    = ptr;
-    self->size   = size;
-    self->origin = NULL;
+    self->ptr      = ptr;
+    self->size     = size;
+    self->origin   = NULL;
+    self->hash_sum = 0;
     return self;
 }
 
@@ -137,9 +140,10 @@ Str_new_from_char(int32_t code_point) {
     ptr[size] = '\0';
 
     String *self = (String*)VTable_Make_Obj(STRING);
-    self->ptr    = ptr;
-    self->size   = size;
-    self->origin = self;
+    self->ptr      = ptr;
+    self->size     = size;
+    self->origin   = self;
+    self->hash_sum = 0;
     return self;
 }
 
@@ -164,9 +168,10 @@ S_new_substring(String *string, size_t byte_offset, size_t size) {
         Str_init_from_trusted_utf8(self, string->ptr + byte_offset, size);
     }
     else {
-        self->ptr    = string->ptr + byte_offset;
-        self->size   = size;
-        self->origin = (String*)INCREF(string->origin);
+        self->ptr      = string->ptr + byte_offset;
+        self->size     = size;
+        self->origin   = (String*)INCREF(string->origin);
+        self->hash_sum = 0;
     }
 
     return self;
@@ -197,19 +202,64 @@ Str_Destroy_IMP(String *self) {
     SUPER_DESTROY(self, STRING);
 }
 
-int32_t
-Str_Hash_Sum_IMP(String *self) {
-    uint32_t hashvalue = 5381;
-    StackStringIterator *iter = STR_STACKTOP(self);
+// Multiplicative constants borrowed from the 64-bit finalizer of
+// MurmurHash3.
+#define HASH_MUL_1 UINT64_C(0xff51afd7ed558ccd)
+#define HASH_MUL_2 UINT64_C(0xc4ceb9fe1a85ec53)
 
-    const SStrIter_Next_t next
-        = METHOD_PTR(STACKSTRINGITERATOR, CFISH_SStrIter_Next);
-    int32_t code_point;
-    while (STRITER_DONE != (code_point = next(iter))) {
-        hashvalue = ((hashvalue << 5) + hashvalue) ^ code_point;
+static CFISH_INLINE uint64_t
+SI_load_u64(const char *ptr) {
+    uint64_t word;
+    memcpy(&word, ptr, sizeof(uint64_t));
+    return word;
+}
+
+static CFISH_INLINE uint64_t
+SI_rotl64(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Hash the raw UTF-8 bytes a word at a time.  Two Strings are Equal exactly
+// when their bytes match, so there's no need to decode code points.  The
+// per-word step is a cheap xor/multiply/rotate; a full avalanche at the end
+// makes sure that the low bits which Hash uses as a bucket mask depend on
+// every input byte.
+static uint32_t
+S_hash_bytes(const char *ptr, size_t size) {
+    uint64_t    hash = UINT64_C(0x9e3779b97f4a7c15) ^ (uint64_t)size;
+    const char *end  = ptr + size;
+
+    while (end - ptr >= 8) {
+        hash = SI_rotl64((hash ^ SI_load_u64(ptr)) * HASH_MUL_1, 29);
+        ptr += 8;
+    }
+    if (ptr < end) {
+        uint64_t tail = 0;
+        memcpy(&tail, ptr, (size_t)(end - ptr));
+        hash = SI_rotl64((hash ^ tail) * HASH_MUL_1, 29);
     }
 
-    return (int32_t) hashvalue;
+    hash ^= hash >> 33;
+    hash *= HASH_MUL_1;
+    hash ^= hash >> 33;
+    hash *= HASH_MUL_2;
+    hash ^= hash >> 33;
+
+    return (uint32_t)hash;
+}
+
+int32_t
+Str_Hash_Sum_IMP(String *self) {
+    // Strings are immutable, so the hash sum is computed once and cached.
+    // Zero marks an empty cache.  Concurrent callers may race to fill it,
+    // but they all store the same value.
+    uint32_t hash_sum = self->hash_sum;
+    if (hash_sum == 0) {
+        hash_sum = S_hash_bytes(self->ptr, self->size);
+        if (hash_sum == 0) { hash_sum = 1; }
+        self->hash_sum = hash_sum;
+    }
+    return (int32_t)hash_sum;
 }
 
 static void
@@ -554,9 +604,10 @@ SStr_new_from_str(void *allocation, size_t alloc_size, String *string) {
     ptr[size] = '\0';
 
     StackString *self = (StackString*)VTable_Init_Obj(STACKSTRING, allocation);
-    self->ptr    = ptr;
-    self->size   = size;
-    self->origin = NULL;
+    self->ptr      = ptr;
+    self->size     = size;
+    self->origin   = NULL;
+    self->hash_sum = 0;
     return self;
 }
 
@@ -564,9 +615,10 @@ StackString*
 SStr_wrap_str(void *allocation, const char *ptr, size_t size) {
     StackString *self
         = (StackString*)VTable_Init_Obj(STACKSTRING, allocation);
-    self->size   = size;
-    self->ptr    = ptr;
-    self->origin = NULL;
+    self->size     = size;
+    self->ptr      = ptr;
+    self->origin   = NULL;
+    self->hash_sum = 0;
     return self;
 }
 
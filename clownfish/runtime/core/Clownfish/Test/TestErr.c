@@ -17,6 +17,13 @@
 #define CFISH_USE_SHORT_NAMES
 #define TESTCFISH_USE_SHORT_NAMES
 
+#include "charmony.h"
+
+#if !defined(CFISH_NOTHREADS) && defined(CHY_HAS_PTHREAD_H)
+  #include <pthread.h>
+  #define TESTERR_USE_PTHREADS
+#endif
+
 #include "Clownfish/Test/TestErr.h"
 
 #include "Clownfish/String.h"
@@ -41,10 +48,87 @@ test_To_String(TestBatchRunner *runner) {
     DECREF(error);
 }
 
+#ifdef TESTERR_USE_PTHREADS
+
+#define NUM_TRAPS 2000
+
+typedef struct {
+    String *message;
+    int     num_wrong;
+} TrapContext;
+
+static void
+S_throw_message(void *context) {
+    TrapContext *trap_context = (TrapContext*)context;
+    Err_throw_mess(ERR, (String*)INCREF(trap_context->message));
+}
+
+// Trap errors thrown by this thread and set this thread's error over and
+// over, counting each time the wrong error turns up.
+static void*
+S_trap_errors(void *context) {
+    TrapContext *trap_context = (TrapContext*)context;
+    for (int i = 0; i < NUM_TRAPS; i++) {
+        Err *error = Err_trap(S_throw_message, trap_context);
+        if (!error
+            || !Str_Equals(Err_Get_Mess(error),
+                           (Obj*)trap_context->message)
+           ) {
+            trap_context->num_wrong++;
+        }
+        Err_set_error(error);
+        if (Err_get_error() != error) {
+            trap_context->num_wrong++;
+        }
+    }
+    Err_set_error(NULL);
+    return NULL;
+}
+
+static void
+test_threads(TestBatchRunner *runner) {
+    TrapContext contexts[2];
+    pthread_t   threads[2];
+    contexts[0].message   = Str_newf("thrown by thread 0");
+    contexts[0].num_wrong = 0;
+    contexts[1].message   = Str_newf("thrown by thread 1");
+    contexts[1].num_wrong = 0;
+
+    // Join every thread that started, even if a later one failed to, so
+    // that none outlives the contexts.
+    int num_started = 0;
+    while (num_started < 2
+           && pthread_create(&threads[num_started], NULL, S_trap_errors,
+                             &contexts[num_started]) == 0
+          ) {
+        num_started++;
+    }
+    for (int i = 0; i < num_started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    TEST_INT_EQ(runner, num_started, 2, "start threads");
+    TEST_INT_EQ(runner, contexts[0].num_wrong + contexts[1].num_wrong, 0,
+                "each thread traps its own errors");
+    DECREF(contexts[0].message);
+    DECREF(contexts[1].message);
+}
+
+#else /* TESTERR_USE_PTHREADS */
+
+static void
+test_threads(TestBatchRunner *runner) {
+    SKIP(runner, "no pthreads");
+    SKIP(runner, "no pthreads");
+}
+
+#endif /* TESTERR_USE_PTHREADS */
+
 void
 TestErr_Run_IMP(TestErr *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 1);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 3);
     test_To_String(runner);
+    test_threads(runner);
 }
 
 
@@ -280,6 +280,33 @@ test_Length(TestBatchRunner *runner) {
     DECREF(string);
 }
 
+static void
+test_Hash_Sum(TestBatchRunner *runner) {
+    String *string = Str_newf("a%s%sb%sc-0123456789", smiley, smiley, smiley);
+    String *twin   = Str_Clone(string);
+    String *longer = Str_newf("xa%s%sb%sc-0123456789", smiley, smiley, smiley);
+    String *substr = Str_SubString(longer, 1, Str_Length(longer) - 1);
+    StackString *wrapped = SSTR_WRAP_UTF8(Str_Get_Ptr8(string),
+                                          Str_Get_Size(string));
+    int32_t hash_sum = Str_Hash_Sum(string);
+
+    TEST_TRUE(runner, Str_Hash_Sum(string) == hash_sum,
+              "Hash_Sum is stable across calls");
+    TEST_TRUE(runner, Str_Hash_Sum(twin) == hash_sum,
+              "Hash_Sum of copy matches");
+    TEST_TRUE(runner, Str_Hash_Sum(substr) == hash_sum,
+              "Hash_Sum of equal substring matches");
+    TEST_TRUE(runner, SStr_Hash_Sum(wrapped) == hash_sum,
+              "Hash_Sum of StackString matches");
+    TEST_FALSE(runner, Str_Hash_Sum(longer) == hash_sum,
+               "Different content spoils Hash_Sum (probably)");
+
+    DECREF(substr);
+    DECREF(longer);
+    DECREF(twin);
+    DECREF(string);
+}
+
 static void
 test_Compare_To(TestBatchRunner *runner) {
     String *abc = Str_newf("a%s%sb%sc", smiley, smiley, smiley);
@@ -506,7 +533,7 @@ test_iterator_substring(TestBatchRunner *runner) {
 
 void
 TestStr_Run_IMP(TestString *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 101);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 106);
     test_Cat(runner);
     test_Clone(runner);
     test_Code_Point_At_and_From(runner);
@@ -517,6 +544,7 @@ TestStr_Run_IMP(TestString *self, TestBatchRunner *runner) {
     test_To_I64(runner);
     test_To_Utf8(runner);
     test_Length(runner);
+    test_Hash_Sum(runner);
     test_Compare_To(runner);
     test_Swap_Chars(runner);
     test_iterator(runner);
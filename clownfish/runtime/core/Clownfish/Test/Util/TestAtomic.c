@@ -56,10 +56,25 @@ test_cas_ptr(TestBatchRunner *runner) {
     TEST_TRUE(runner, target == bar_pointer, "cas_ptr sets target");
 }
 
+static void
+test_inc_dec_size_t(TestBatchRunner *runner) {
+    size_t target = 1;
+
+    TEST_TRUE(runner, Atomic_inc_size_t(&target) == 2,
+              "inc_size_t returns new value");
+    TEST_TRUE(runner, target == 2, "inc_size_t increments target");
+    TEST_TRUE(runner, Atomic_dec_size_t(&target) == 1,
+              "dec_size_t returns new value");
+    TEST_TRUE(runner, Atomic_dec_size_t(&target) == 0,
+              "dec_size_t to zero");
+    TEST_TRUE(runner, target == 0, "dec_size_t decrements target");
+}
+
 void
 TestAtomic_Run_IMP(TestAtomic *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 6);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 11);
     test_cas_ptr(runner);
+    test_inc_dec_size_t(runner);
 }
 
 
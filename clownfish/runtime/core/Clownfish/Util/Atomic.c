@@ -32,6 +32,24 @@ cfish_Atomic_wrapped_cas_ptr(void *volatile *target, void *old_value,
            == old_value;
 }
 
+size_t
+cfish_Atomic_wrapped_inc_size_t(volatile size_t *target) {
+#ifdef _WIN64
+    return (size_t)InterlockedIncrement64((volatile LONGLONG*)target);
+#else
+    return (size_t)InterlockedIncrement((volatile LONG*)target);
+#endif
+}
+
+size_t
+cfish_Atomic_wrapped_dec_size_t(volatile size_t *target) {
+#ifdef _WIN64
+    return (size_t)InterlockedDecrement64((volatile LONGLONG*)target);
+#else
+    return (size_t)InterlockedDecrement((volatile LONG*)target);
+#endif
+}
+
 /************************** Fall back to ptheads ***************************/
 #elif defined(CHY_HAS_PTHREAD_H)
 
@@ -0,0 +1,179 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_COMMONGRAMSFILTER
+#define C_LUCY_TOKEN
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Analysis/CommonGramsFilter.h"
+#include "Lucy/Analysis/Token.h"
+#include "Lucy/Analysis/Inversion.h"
+#include "Lucy/Util/Freezer.h"
+
+static CFISH_INLINE bool
+SI_is_common(Hash *common_words, TokenIVARS *token_ivars) {
+    return Hash_Fetch_Utf8(common_words, token_ivars->text, token_ivars->len)
+           != NULL;
+}
+
+// Create a Token joining the texts of two adjacent Tokens.
+static Token*
+S_make_gram(TokenIVARS *first, TokenIVARS *second);
+
+CommonGramsFilter*
+CommonGrams_new(Hash *common_words) {
+    CommonGramsFilter *self
+        = (CommonGramsFilter*)VTable_Make_Obj(COMMONGRAMSFILTER);
+    return CommonGrams_init(self, common_words);
+}
+
+CommonGramsFilter*
+CommonGrams_init(CommonGramsFilter *self, Hash *common_words) {
+    Analyzer_init((Analyzer*)self);
+    CommonGramsFilterIVARS *const ivars = CommonGrams_IVARS(self);
+    ivars->common_words = (Hash*)INCREF(CERTIFY(common_words, HASH));
+    return self;
+}
+
+void
+CommonGrams_Destroy_IMP(CommonGramsFilter *self) {
+    CommonGramsFilterIVARS *const ivars = CommonGrams_IVARS(self);
+    DECREF(ivars->common_words);
+    SUPER_DESTROY(self, COMMONGRAMSFILTER);
+}
+
+Hash*
+CommonGrams_Get_Common_Words_IMP(CommonGramsFilter *self) {
+    return CommonGrams_IVARS(self)->common_words;
+}
+
+static Token*
+S_make_gram(TokenIVARS *first, TokenIVARS *second) {
+    size_t  len  = first->len + 1 + second->len;
+    char   *text = (char*)MALLOCATE(len + 1);
+    memcpy(text, first->text, first->len);
+    text[first->len] = ' ';
+    memcpy(text + first->len + 1, second->text, second->len);
+    text[len] = '\0';
+    // A position increment of 0 places the gram at the same position as the
+    // first word, which follows it.
+    Token *gram = Token_new(text, len, first->start_offset,
+                            second->end_offset, first->boost, 0);
+    FREEMEM(text);
+    return gram;
+}
+
+Inversion*
+CommonGrams_Transform_IMP(CommonGramsFilter *self, Inversion *inversion) {
+    Hash *const common_words  = CommonGrams_IVARS(self)->common_words;
+    Inversion  *new_inversion = Inversion_new(NULL);
+    Token      *token         = Inversion_Next(inversion);
+
+    while (token) {
+        TokenIVARS *const token_ivars = Token_IVARS(token);
+        Token *next = Inversion_Next(inversion);
+
+        // Only words which are actually adjacent -- e.g. not separated by a
+        // removed stopword -- form a gram.
+        if (next && token_ivars->pos_inc == 1) {
+            TokenIVARS *const next_ivars = Token_IVARS(next);
+            if (SI_is_common(common_words, token_ivars)
+                || SI_is_common(common_words, next_ivars)
+               ) {
+                Inversion_Append(new_inversion,
+                                 S_make_gram(token_ivars, next_ivars));
+            }
+        }
+        Inversion_Append(new_inversion, (Token*)INCREF(token));
+        token = next;
+    }
+
+    return new_inversion;
+}
+
+VArray*
+CommonGrams_Rewrite_Phrase_IMP(CommonGramsFilter *self, VArray *terms) {
+    Hash *const    common_words = CommonGrams_IVARS(self)->common_words;
+    const uint32_t num_terms    = VA_Get_Size(terms);
+    VArray        *rewritten    = VA_new(num_terms);
+    bool           covered      = false;
+
+    for (uint32_t i = 0; i < num_terms; i++) {
+        String *term = (String*)CERTIFY(VA_Fetch(terms, i), STRING);
+        String *next = i + 1 < num_terms
+                       ? (String*)CERTIFY(VA_Fetch(terms, i + 1), STRING)
+                       : NULL;
+        if (next
+            && (Hash_Fetch(common_words, (Obj*)term)
+                || Hash_Fetch(common_words, (Obj*)next))
+           ) {
+            VA_Push(rewritten, (Obj*)Str_newf("%o %o", term, next));
+            covered = true;
+        }
+        else if (next || !covered) {
+            VA_Push(rewritten, INCREF(term));
+            covered = false;
+        }
+    }
+
+    return rewritten;
+}
+
+bool
+CommonGrams_Equals_IMP(CommonGramsFilter *self, Obj *other) {
+    if ((CommonGramsFilter*)other == self)   { return true; }
+    if (!Obj_Is_A(other, COMMONGRAMSFILTER)) { return false; }
+    CommonGramsFilterIVARS *const ivars = CommonGrams_IVARS(self);
+    CommonGramsFilterIVARS *const ovars
+        = CommonGrams_IVARS((CommonGramsFilter*)other);
+
+    // Only the keys matter; values may not survive a Dump/Load round trip.
+    Hash *words       = ivars->common_words;
+    Hash *other_words = ovars->common_words;
+    if (Hash_Get_Size(words) != Hash_Get_Size(other_words)) { return false; }
+    Obj *key;
+    Obj *value;
+    Hash_Iterate(words);
+    while (Hash_Next(words, &key, &value)) {
+        if (!Hash_Fetch(other_words, key)) { return false; }
+    }
+    return true;
+}
+
+Obj*
+CommonGrams_Dump_IMP(CommonGramsFilter *self) {
+    CommonGramsFilterIVARS *const ivars = CommonGrams_IVARS(self);
+    CommonGrams_Dump_t super_dump
+        = SUPER_METHOD_PTR(COMMONGRAMSFILTER, LUCY_CommonGrams_Dump);
+    Hash *dump = (Hash*)CERTIFY(super_dump(self), HASH);
+    Hash_Store_Utf8(dump, "common_words", 12,
+                    Freezer_dump((Obj*)ivars->common_words));
+    return (Obj*)dump;
+}
+
+Obj*
+CommonGrams_Load_IMP(CommonGramsFilter *self, Obj *dump) {
+    Hash *source = (Hash*)CERTIFY(dump, HASH);
+    CommonGrams_Load_t super_load
+        = SUPER_METHOD_PTR(COMMONGRAMSFILTER, LUCY_CommonGrams_Load);
+    CommonGramsFilter *loaded = (CommonGramsFilter*)super_load(self, dump);
+    Obj *common_words
+        = CERTIFY(Hash_Fetch_Utf8(source, "common_words", 12), HASH);
+    CommonGrams_IVARS(loaded)->common_words
+        = (Hash*)CERTIFY(Freezer_load(common_words), HASH);
+    return (Obj*)loaded;
+}
+
@@ -68,6 +68,16 @@ Inversion_Get_Size_IMP(Inversion *self) {
     return Inversion_IVARS(self)->size;
 }
 
+uint32_t
+Inversion_Get_Length_IMP(Inversion *self) {
+    InversionIVARS *const ivars = Inversion_IVARS(self);
+    uint32_t length = 0;
+    for (uint32_t i = 0; i < ivars->size; i++) {
+        if (Token_IVARS(ivars->tokens[i])->pos_inc != 0) { length++; }
+    }
+    return length;
+}
+
 Token*
 Inversion_Next_IMP(Inversion *self) {
     InversionIVARS *const ivars = Inversion_IVARS(self);
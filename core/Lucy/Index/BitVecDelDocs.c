@@ -22,39 +22,113 @@
 #include "Lucy/Store/InStream.h"
 
 BitVecDelDocs*
-BitVecDelDocs_new(Folder *folder, String *filename) {
+BitVecDelDocs_new(Folder *folder, String *filename, String *delta_file) {
     BitVecDelDocs *self = (BitVecDelDocs*)VTable_Make_Obj(BITVECDELDOCS);
-    return BitVecDelDocs_init(self, folder, filename);
+    return BitVecDelDocs_init(self, folder, filename, delta_file);
 }
 
 BitVecDelDocs*
 BitVecDelDocs_init(BitVecDelDocs *self, Folder *folder,
-                   String *filename) {
+                   String *filename, String *delta_file) {
     BitVec_init((BitVector*)self, 0);
     BitVecDelDocsIVARS *const ivars = BitVecDelDocs_IVARS(self);
-    ivars->filename = Str_Clone(filename);
-    ivars->instream = Folder_Open_In(folder, filename);
-    if (!ivars->instream) {
-        Err *error = (Err*)INCREF(Err_get_error());
-        DECREF(self);
-        RETHROW(error);
+    ivars->folder     = (Folder*)INCREF(folder);
+    ivars->filename   = filename ? Str_Clone(filename) : NULL;
+    ivars->delta_file = delta_file ? Str_Clone(delta_file) : NULL;
+    ivars->delta      = NULL;
+    if (filename) {
+        ivars->instream = Folder_Open_In(folder, filename);
+        if (!ivars->instream) {
+            Err *error = (Err*)INCREF(Err_get_error());
+            DECREF(self);
+            RETHROW(error);
+        }
+        int32_t len    = (int32_t)InStream_Length(ivars->instream);
+        ivars->bits    = (uint8_t*)InStream_Buf(ivars->instream, len);
+        ivars->cap     = (uint32_t)(len * 8);
     }
-    int32_t len    = (int32_t)InStream_Length(ivars->instream);
-    ivars->bits    = (uint8_t*)InStream_Buf(ivars->instream, len);
-    ivars->cap     = (uint32_t)(len * 8);
     return self;
 }
 
 void
 BitVecDelDocs_Destroy_IMP(BitVecDelDocs *self) {
     BitVecDelDocsIVARS *const ivars = BitVecDelDocs_IVARS(self);
+    DECREF(ivars->folder);
     DECREF(ivars->filename);
+    DECREF(ivars->delta_file);
+    DECREF(ivars->delta);
     if (ivars->instream) {
         InStream_Close(ivars->instream);
         DECREF(ivars->instream);
+        ivars->bits = NULL;
     }
-    ivars->bits = NULL;
     SUPER_DESTROY(self, BITVECDELDOCS);
 }
 
+// Read the delta file the first time it's needed.  It holds a count
+// followed by the delta-encoded ids of docs missing from the bitmap.
+static I32Array*
+S_delta(BitVecDelDocs *self) {
+    BitVecDelDocsIVARS *const ivars = BitVecDelDocs_IVARS(self);
+    if (!ivars->delta && ivars->delta_file) {
+        InStream *instream = Folder_Open_In(ivars->folder, ivars->delta_file);
+        if (!instream) { RETHROW(INCREF(Err_get_error())); }
+        uint32_t  count  = InStream_Read_C32(instream);
+        int32_t  *ids    = (int32_t*)MALLOCATE((count + 1) * sizeof(int32_t));
+        int32_t   doc_id = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            doc_id += (int32_t)InStream_Read_C32(instream);
+            ids[i] = doc_id;
+        }
+        InStream_Close(instream);
+        DECREF(instream);
+        ivars->delta = I32Arr_new_steal(ids, count);
+    }
+    return ivars->delta;
+}
+
+// Return the position of the first delta id at or above `tick`.
+static uint32_t
+S_lower_bound(I32Array *delta, uint32_t tick) {
+    uint32_t lo = 0;
+    uint32_t hi = I32Arr_Get_Size(delta);
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if ((uint32_t)I32Arr_Get(delta, mid) < tick) { lo = mid + 1; }
+        else                                         { hi = mid; }
+    }
+    return lo;
+}
+
+bool
+BitVecDelDocs_Get_IMP(BitVecDelDocs *self, uint32_t tick) {
+    BitVecDelDocsIVARS *const ivars = BitVecDelDocs_IVARS(self);
+    if (tick < ivars->cap && NumUtil_u1get(ivars->bits, tick)) {
+        return true;
+    }
+    I32Array *delta = S_delta(self);
+    if (delta) {
+        uint32_t pos = S_lower_bound(delta, tick);
+        return pos < I32Arr_Get_Size(delta)
+               && (uint32_t)I32Arr_Get(delta, pos) == tick;
+    }
+    return false;
+}
+
+int32_t
+BitVecDelDocs_Next_Hit_IMP(BitVecDelDocs *self, uint32_t tick) {
+    BitVecDelDocs_Next_Hit_t super_next_hit
+        = (BitVecDelDocs_Next_Hit_t)SUPER_METHOD_PTR(BITVECDELDOCS,
+                                                     LUCY_BitVecDelDocs_Next_Hit);
+    int32_t   hit   = super_next_hit(self, tick);
+    I32Array *delta = S_delta(self);
+    if (delta) {
+        uint32_t pos = S_lower_bound(delta, tick);
+        if (pos < I32Arr_Get_Size(delta)) {
+            int32_t delta_hit = I32Arr_Get(delta, pos);
+            if (hit == -1 || delta_hit < hit) { hit = delta_hit; }
+        }
+    }
+    return hit;
+}
 
@@ -0,0 +1,195 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_COMMITGROUP
+#include "Lucy/Util/ToolSet.h"
+
+#include <time.h>
+
+#include "Lucy/Index/CommitGroup.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Store/Folder.h"
+
+// Return a monotonic timestamp in microseconds.
+static int64_t
+S_now_micros(void);
+
+// Sync the entries of each Folder.  On failure, set Err_error and return
+// false.
+static bool
+S_sync_dirs(VArray *folders);
+
+CommitGroup*
+CommitGroup_new() {
+    CommitGroup *self = (CommitGroup*)VTable_Make_Obj(COMMITGROUP);
+    return CommitGroup_init(self);
+}
+
+CommitGroup*
+CommitGroup_init(CommitGroup *self) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    ivars->indexers        = VA_new(0);
+    ivars->num_commits     = 0;
+    ivars->num_syncs       = 0;
+    ivars->sync_micros     = 0;
+    ivars->max_sync_micros = 0;
+    return self;
+}
+
+void
+CommitGroup_Destroy_IMP(CommitGroup *self) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    DECREF(ivars->indexers);
+    SUPER_DESTROY(self, COMMITGROUP);
+}
+
+void
+CommitGroup_Add_IMP(CommitGroup *self, Indexer *indexer) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    VA_Push(ivars->indexers, INCREF(indexer));
+}
+
+void
+CommitGroup_Commit_IMP(CommitGroup *self) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+
+    // Take ownership of the enlisted Indexers, so that the group is empty
+    // even if something fails.
+    VArray   *indexers     = ivars->indexers;
+    uint32_t  num_indexers = VA_Get_Size(indexers);
+    ivars->indexers = VA_new(0);
+
+    // Prepare every commit up front, so that the expensive work of writing
+    // segments stays out of the timed section.  Collect each distinct Folder
+    // which will need its entries synced.
+    VArray *sync_paths = VA_new(num_indexers);
+    VArray *folders    = VA_new(num_indexers);
+    for (uint32_t i = 0; i < num_indexers; i++) {
+        Indexer *indexer = (Indexer*)VA_Fetch(indexers, i);
+        VArray  *paths   = Indexer_Sync_Paths(indexer);
+        if (!paths) { continue; }
+        VA_Store(sync_paths, i, INCREF(paths));
+        Folder *folder = Indexer_Get_Folder(indexer);
+        bool    seen   = false;
+        for (uint32_t j = 0, max = VA_Get_Size(folders); j < max; j++) {
+            if (VA_Fetch(folders, j) == (Obj*)folder) { seen = true; }
+        }
+        if (!seen) { VA_Push(folders, INCREF(folder)); }
+    }
+
+    int64_t start = S_now_micros();
+
+    // Start writeback of everything, then wait for each file in turn.  By
+    // the time the first wait returns, most of the rest is on its way.
+    for (uint32_t i = 0; i < num_indexers; i++) {
+        VArray *paths = (VArray*)VA_Fetch(sync_paths, i);
+        if (paths) {
+            Indexer *indexer = (Indexer*)VA_Fetch(indexers, i);
+            Folder_Start_Sync(Indexer_Get_Folder(indexer), paths);
+        }
+    }
+    for (uint32_t i = 0; i < num_indexers; i++) {
+        VArray *paths = (VArray*)VA_Fetch(sync_paths, i);
+        if (paths) {
+            Indexer *indexer = (Indexer*)VA_Fetch(indexers, i);
+            if (!Folder_Sync(Indexer_Get_Folder(indexer), paths)) {
+                DECREF(sync_paths);
+                DECREF(folders);
+                DECREF(indexers);
+                RETHROW(INCREF(Err_get_error()));
+            }
+        }
+    }
+
+    // Make the new segment directories and temporary snapshot files
+    // reachable, publish, then make the renames durable.  Only once the new
+    // snapshots are sure to survive a crash may the files they supersede be
+    // purged and the locks be handed on to the next writer.
+    bool synced = S_sync_dirs(folders);
+    if (synced) {
+        for (uint32_t i = 0; i < num_indexers; i++) {
+            Indexer *indexer = (Indexer*)VA_Fetch(indexers, i);
+            Indexer_Publish(indexer);
+        }
+        synced = S_sync_dirs(folders);
+    }
+    if (!synced) {
+        DECREF(sync_paths);
+        DECREF(folders);
+        DECREF(indexers);
+        RETHROW(INCREF(Err_get_error()));
+    }
+    for (uint32_t i = 0; i < num_indexers; i++) {
+        Indexer *indexer = (Indexer*)VA_Fetch(indexers, i);
+        Indexer_Release(indexer);
+    }
+
+    int64_t elapsed = S_now_micros() - start;
+    ivars->num_commits += num_indexers;
+    if (VA_Get_Size(folders)) {
+        ivars->num_syncs   += 1;
+        ivars->sync_micros += elapsed;
+        if (elapsed > ivars->max_sync_micros) {
+            ivars->max_sync_micros = elapsed;
+        }
+    }
+
+    DECREF(sync_paths);
+    DECREF(folders);
+    DECREF(indexers);
+}
+
+int64_t
+CommitGroup_Get_Num_Commits_IMP(CommitGroup *self) {
+    return CommitGroup_IVARS(self)->num_commits;
+}
+
+int64_t
+CommitGroup_Get_Num_Syncs_IMP(CommitGroup *self) {
+    return CommitGroup_IVARS(self)->num_syncs;
+}
+
+int64_t
+CommitGroup_Get_Sync_Micros_IMP(CommitGroup *self) {
+    return CommitGroup_IVARS(self)->sync_micros;
+}
+
+int64_t
+CommitGroup_Get_Max_Sync_Micros_IMP(CommitGroup *self) {
+    return CommitGroup_IVARS(self)->max_sync_micros;
+}
+
+static bool
+S_sync_dirs(VArray *folders) {
+    String *root = (String*)SSTR_WRAP_UTF8("", 0);
+    for (uint32_t i = 0, max = VA_Get_Size(folders); i < max; i++) {
+        Folder *folder = (Folder*)VA_Fetch(folders, i);
+        if (!Folder_Sync_Dir(folder, root)) { return false; }
+    }
+    return true;
+}
+
+static int64_t
+S_now_micros(void) {
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return (int64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
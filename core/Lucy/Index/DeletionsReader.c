@@ -17,6 +17,7 @@
 #define C_LUCY_DELETIONSREADER
 #define C_LUCY_POLYDELETIONSREADER
 #define C_LUCY_DEFAULTDELETIONSREADER
+#define C_LUCY_RAMDELETIONSREADER
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/DeletionsReader.h"
@@ -150,6 +151,7 @@ void
 DefDelReader_Destroy_IMP(DefaultDeletionsReader *self) {
     DefaultDeletionsReaderIVARS *const ivars = DefDelReader_IVARS(self);
     DECREF(ivars->deldocs);
+    DECREF(ivars->file_meta);
     SUPER_DESTROY(self, DEFAULTDELETIONSREADER);
 }
 
@@ -159,8 +161,7 @@ DefDelReader_Read_Deletions_IMP(DefaultDeletionsReader *self) {
     VArray  *segments    = DefDelReader_Get_Segments(self);
     Segment *segment     = DefDelReader_Get_Segment(self);
     String  *my_seg_name = Seg_Get_Name(segment);
-    String  *del_file    = NULL;
-    int32_t  del_count   = 0;
+    Hash    *file_meta   = NULL;
 
     // Start with deletions files in the most recently added segments and work
     // backwards.  The first one we find which addresses our segment is the
@@ -175,31 +176,44 @@ DefDelReader_Read_Deletions_IMP(DefaultDeletionsReader *self) {
             Hash *seg_files_data
                 = (Hash*)Hash_Fetch(files, (Obj*)my_seg_name);
             if (seg_files_data) {
-                Obj *count = (Obj*)CERTIFY(
-                                 Hash_Fetch_Utf8(seg_files_data, "count", 5),
-                                 OBJ);
-                del_count = (int32_t)Obj_To_I64(count);
-                del_file  = (String*)CERTIFY(
-                                Hash_Fetch_Utf8(seg_files_data, "filename", 8),
-                                STRING);
+                file_meta = (Hash*)CERTIFY(seg_files_data, HASH);
                 break;
             }
         }
     }
 
     DECREF(ivars->deldocs);
-    if (del_file) {
-        ivars->deldocs = (BitVector*)BitVecDelDocs_new(ivars->folder, del_file);
-        ivars->del_count = del_count;
+    DECREF(ivars->file_meta);
+    if (file_meta) {
+        // Deletions consist of an optional bitmap and an optional delta
+        // file listing docs deleted since the bitmap was written.
+        Obj *count = (Obj*)CERTIFY(
+                         Hash_Fetch_Utf8(file_meta, "count", 5), OBJ);
+        String *del_file   = (String*)Hash_Fetch_Utf8(file_meta,
+                                                      "filename", 8);
+        String *delta_file = (String*)Hash_Fetch_Utf8(file_meta, "delta", 5);
+        if (del_file)   { CERTIFY(del_file, STRING); }
+        if (delta_file) { CERTIFY(delta_file, STRING); }
+        ivars->deldocs   = (BitVector*)BitVecDelDocs_new(ivars->folder,
+                                                         del_file,
+                                                         delta_file);
+        ivars->del_count = (int32_t)Obj_To_I64(count);
+        ivars->file_meta = (Hash*)INCREF(file_meta);
     }
     else {
-        ivars->deldocs = NULL;
+        ivars->deldocs   = NULL;
         ivars->del_count = 0;
+        ivars->file_meta = NULL;
     }
 
     return ivars->deldocs;
 }
 
+Hash*
+DefDelReader_Get_File_Meta_IMP(DefaultDeletionsReader *self) {
+    return DefDelReader_IVARS(self)->file_meta;
+}
+
 Matcher*
 DefDelReader_Iterator_IMP(DefaultDeletionsReader *self) {
     DefaultDeletionsReaderIVARS *const ivars = DefDelReader_IVARS(self);
@@ -211,4 +225,51 @@ DefDelReader_Del_Count_IMP(DefaultDeletionsReader *self) {
     return DefDelReader_IVARS(self)->del_count;
 }
 
+RAMDeletionsReader*
+RAMDelReader_new(Matcher *deletions, int32_t doc_max) {
+    RAMDeletionsReader *self
+        = (RAMDeletionsReader*)VTable_Make_Obj(RAMDELETIONSREADER);
+    return RAMDelReader_init(self, deletions, doc_max);
+}
 
+RAMDeletionsReader*
+RAMDelReader_init(RAMDeletionsReader *self, Matcher *deletions,
+                  int32_t doc_max) {
+    DelReader_init((DeletionsReader*)self, NULL, NULL, NULL, NULL, -1);
+    RAMDeletionsReaderIVARS *const ivars = RAMDelReader_IVARS(self);
+    ivars->deldocs   = BitVec_new(doc_max + 1);
+    ivars->del_count = 0;
+    if (deletions) {
+        int32_t doc_id;
+        while (0 != (doc_id = Matcher_Next(deletions))) {
+            BitVec_Set(ivars->deldocs, doc_id);
+            ivars->del_count++;
+        }
+    }
+    return self;
+}
+
+void
+RAMDelReader_Close_IMP(RAMDeletionsReader *self) {
+    RAMDeletionsReaderIVARS *const ivars = RAMDelReader_IVARS(self);
+    DECREF(ivars->deldocs);
+    ivars->deldocs = NULL;
+}
+
+void
+RAMDelReader_Destroy_IMP(RAMDeletionsReader *self) {
+    RAMDeletionsReaderIVARS *const ivars = RAMDelReader_IVARS(self);
+    DECREF(ivars->deldocs);
+    SUPER_DESTROY(self, RAMDELETIONSREADER);
+}
+
+int32_t
+RAMDelReader_Del_Count_IMP(RAMDeletionsReader *self) {
+    return RAMDelReader_IVARS(self)->del_count;
+}
+
+Matcher*
+RAMDelReader_Iterator_IMP(RAMDeletionsReader *self) {
+    RAMDeletionsReaderIVARS *const ivars = RAMDelReader_IVARS(self);
+    return (Matcher*)BitVecMatcher_new(ivars->deldocs);
+}
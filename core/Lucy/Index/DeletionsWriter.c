@@ -22,7 +22,11 @@
 
 #include "Lucy/Index/DeletionsWriter.h"
 #include "Lucy/Index/DeletionsReader.h"
+#include "Lucy/Index/BitVecDelDocs.h"
 #include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/KeyFilterReader.h"
+#include "Lucy/Index/Lexicon.h"
+#include "Lucy/Index/LexiconReader.h"
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Index/PostingList.h"
 #include "Lucy/Index/PostingListReader.h"
@@ -46,6 +50,21 @@ DelWriter_init(DeletionsWriter *self, Schema *schema, Snapshot *snapshot,
     return self;
 }
 
+void
+DelWriter_Delete_By_Terms_IMP(DeletionsWriter *self, String *field,
+                              VArray *terms) {
+    for (uint32_t i = 0, max = VA_Get_Size(terms); i < max; i++) {
+        DelWriter_Delete_By_Term(self, field, VA_Fetch(terms, i));
+    }
+}
+
+bool
+DelWriter_Hosts_Del_Base_IMP(DeletionsWriter *self, String *seg_name) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(seg_name);
+    return false;
+}
+
 I32Array*
 DelWriter_Generate_Doc_Map_IMP(DeletionsWriter *self, Matcher *deletions,
                                int32_t doc_max, int32_t offset) {
@@ -66,7 +85,7 @@ DelWriter_Generate_Doc_Map_IMP(DeletionsWriter *self, Matcher *deletions,
     return I32Arr_new_steal(doc_map, doc_max + 1);
 }
 
-int32_t DefDelWriter_current_file_format = 1;
+int32_t DefDelWriter_current_file_format = 2;
 
 DefaultDeletionsWriter*
 DefDelWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
@@ -88,6 +107,8 @@ DefDelWriter_init(DefaultDeletionsWriter *self, Schema *schema,
     ivars->seg_starts           = PolyReader_Offsets(polyreader);
     ivars->bit_vecs             = VA_new(num_seg_readers);
     ivars->updated              = (bool*)CALLOCATE(num_seg_readers, sizeof(bool));
+    ivars->rewrite              = (bool*)CALLOCATE(num_seg_readers, sizeof(bool));
+    ivars->file_metas           = VA_new(num_seg_readers);
     ivars->searcher             = IxSearcher_new((Obj*)polyreader);
     ivars->name_to_tick         = Hash_new(num_seg_readers);
 
@@ -126,16 +147,81 @@ DefDelWriter_Destroy_IMP(DefaultDeletionsWriter *self) {
     DECREF(ivars->bit_vecs);
     DECREF(ivars->searcher);
     DECREF(ivars->name_to_tick);
+    DECREF(ivars->file_metas);
     FREEMEM(ivars->updated);
+    FREEMEM(ivars->rewrite);
     SUPER_DESTROY(self, DEFAULTDELETIONSWRITER);
 }
 
 static String*
-S_del_filename(DefaultDeletionsWriter *self, SegReader *target_reader) {
+S_del_filename(DefaultDeletionsWriter *self, SegReader *target_reader,
+               const char *ext) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
     Segment *target_seg = SegReader_Get_Segment(target_reader);
-    return Str_newf("%o/deletions-%o.bv", Seg_Get_Name(ivars->segment),
-                    Seg_Get_Name(target_seg));
+    return Str_newf("%o/deletions-%o.%s", Seg_Get_Name(ivars->segment),
+                    Seg_Get_Name(target_seg), ext);
+}
+
+// Return the metadata describing a segment's current deletions files, or
+// NULL if it has none or doesn't use DefaultDeletionsReader.
+static Hash*
+S_file_meta(SegReader *seg_reader) {
+    DeletionsReader *del_reader
+        = (DeletionsReader*)SegReader_Fetch(
+              seg_reader, VTable_Get_Name(DELETIONSREADER));
+    if (del_reader && DelReader_Is_A(del_reader, DEFAULTDELETIONSREADER)) {
+        return DefDelReader_Get_File_Meta((DefaultDeletionsReader*)del_reader);
+    }
+    return NULL;
+}
+
+// Return the number of doc ids a delta file may hold before it must be
+// folded into a bitmap.  Small segments always get a bitmap.
+static uint32_t
+S_max_delta(int32_t doc_max) {
+    uint32_t byte_size = (uint32_t)ceil((doc_max + 1) / 8.0);
+    return byte_size / (sizeof(int32_t) * DEFDELWRITER_FOLD_RATIO);
+}
+
+static bool
+S_file_in_seg(String *filename, String *seg_name) {
+    String *prefix = Str_newf("%o/", seg_name);
+    bool    in_seg = Str_Starts_With(filename, prefix);
+    DECREF(prefix);
+    return in_seg;
+}
+
+static void
+S_write_bit_vec(Folder *folder, String *filename, BitVector *deldocs,
+                int32_t doc_max) {
+    double     used      = (doc_max + 1) / 8.0;
+    uint32_t   byte_size = (uint32_t)ceil(used);
+    uint32_t   new_max   = byte_size * 8 - 1;
+    OutStream *outstream = Folder_Open_Out(folder, filename);
+    if (!outstream) { RETHROW(INCREF(Err_get_error())); }
+
+    // Ensure that we have 1 bit for each doc in segment.
+    BitVec_Grow(deldocs, new_max);
+
+    // Write deletions data and clean up.
+    OutStream_Write_Bytes(outstream, (char*)BitVec_Get_Raw_Bits(deldocs),
+                          byte_size);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+}
+
+static void
+S_write_delta(Folder *folder, String *filename, int32_t *doc_ids,
+              uint32_t count) {
+    OutStream *outstream = Folder_Open_Out(folder, filename);
+    if (!outstream) { RETHROW(INCREF(Err_get_error())); }
+    OutStream_Write_C32(outstream, count);
+    for (uint32_t i = 0, last = 0; i < count; i++) {
+        OutStream_Write_C32(outstream, (uint32_t)doc_ids[i] - last);
+        last = (uint32_t)doc_ids[i];
+    }
+    OutStream_Close(outstream);
+    DECREF(outstream);
 }
 
 void
@@ -145,27 +231,64 @@ DefDelWriter_Finish_IMP(DefaultDeletionsWriter *self) {
 
     for (uint32_t i = 0, max = VA_Get_Size(ivars->seg_readers); i < max; i++) {
         SegReader *seg_reader = (SegReader*)VA_Fetch(ivars->seg_readers, i);
-        if (ivars->updated[i]) {
-            BitVector *deldocs   = (BitVector*)VA_Fetch(ivars->bit_vecs, i);
-            int32_t    doc_max   = SegReader_Doc_Max(seg_reader);
-            double     used      = (doc_max + 1) / 8.0;
-            uint32_t   byte_size = (uint32_t)ceil(used);
-            uint32_t   new_max   = byte_size * 8 - 1;
-            String    *filename  = S_del_filename(self, seg_reader);
-            OutStream *outstream = Folder_Open_Out(folder, filename);
-            if (!outstream) { RETHROW(INCREF(Err_get_error())); }
-
-            // Ensure that we have 1 bit for each doc in segment.
-            BitVec_Grow(deldocs, new_max);
-
-            // Write deletions data and clean up.
-            OutStream_Write_Bytes(outstream,
-                                  (char*)BitVec_Get_Raw_Bits(deldocs),
-                                  byte_size);
-            OutStream_Close(outstream);
-            DECREF(outstream);
-            DECREF(filename);
+        if (!ivars->updated[i]) { continue; }
+
+        BitVector *deldocs   = (BitVector*)VA_Fetch(ivars->bit_vecs, i);
+        int32_t    doc_max   = SegReader_Doc_Max(seg_reader);
+        Hash      *prev_meta = S_file_meta(seg_reader);
+        String    *base      = prev_meta && !ivars->rewrite[i]
+                               ? (String*)Hash_Fetch_Utf8(prev_meta,
+                                                          "filename", 8)
+                               : NULL;
+        uint32_t   max_delta = S_max_delta(doc_max);
+        int32_t   *delta     = (int32_t*)MALLOCATE(
+                                   (max_delta + 1) * sizeof(int32_t));
+        uint32_t   delta_count = 0;
+        bool       fold      = ivars->rewrite[i];
+        Hash      *file_meta = Hash_new(4);
+
+        // Gather deletions which the previous bitmap doesn't cover.  Give
+        // up as soon as there are too many to keep in a delta file.
+        if (!fold) {
+            BitVector *base_bits = base
+                                   ? (BitVector*)BitVecDelDocs_new(folder,
+                                                                   base, NULL)
+                                   : NULL;
+            for (int32_t doc_id = BitVec_Next_Hit(deldocs, 0);
+                 doc_id != -1;
+                 doc_id = BitVec_Next_Hit(deldocs, doc_id + 1)
+                ) {
+                if (base_bits && BitVec_Get(base_bits, doc_id)) { continue; }
+                if (delta_count == max_delta) {
+                    fold = true;
+                    break;
+                }
+                delta[delta_count++] = doc_id;
+            }
+            DECREF(base_bits);
+        }
+
+        Hash_Store_Utf8(file_meta, "count", 5,
+                        (Obj*)Str_newf("%u32",
+                                       (uint32_t)BitVec_Count(deldocs)));
+        if (fold) {
+            String *filename = S_del_filename(self, seg_reader, "bv");
+            S_write_bit_vec(folder, filename, deldocs, doc_max);
+            Hash_Store_Utf8(file_meta, "filename", 8, (Obj*)filename);
         }
+        else {
+            if (base) {
+                Hash_Store_Utf8(file_meta, "filename", 8,
+                                (Obj*)Str_Clone(base));
+            }
+            if (delta_count) {
+                String *filename = S_del_filename(self, seg_reader, "dd");
+                S_write_delta(folder, filename, delta, delta_count);
+                Hash_Store_Utf8(file_meta, "delta", 5, (Obj*)filename);
+            }
+        }
+        VA_Store(ivars->file_metas, i, (Obj*)file_meta);
+        FREEMEM(delta);
     }
 
     Seg_Store_Metadata_Utf8(ivars->segment, "deletions", 9,
@@ -183,15 +306,10 @@ DefDelWriter_Metadata_IMP(DefaultDeletionsWriter *self) {
 
     for (uint32_t i = 0, max = VA_Get_Size(ivars->seg_readers); i < max; i++) {
         SegReader *seg_reader = (SegReader*)VA_Fetch(ivars->seg_readers, i);
-        if (ivars->updated[i]) {
-            BitVector *deldocs   = (BitVector*)VA_Fetch(ivars->bit_vecs, i);
-            Segment   *segment   = SegReader_Get_Segment(seg_reader);
-            Hash      *mini_meta = Hash_new(2);
-            Hash_Store_Utf8(mini_meta, "count", 5,
-                            (Obj*)Str_newf("%u32", (uint32_t)BitVec_Count(deldocs)));
-            Hash_Store_Utf8(mini_meta, "filename", 8,
-                            (Obj*)S_del_filename(self, seg_reader));
-            Hash_Store(files, (Obj*)Seg_Get_Name(segment), (Obj*)mini_meta);
+        Hash      *file_meta  = (Hash*)VA_Fetch(ivars->file_metas, i);
+        if (file_meta) {
+            Segment *segment = SegReader_Get_Segment(seg_reader);
+            Hash_Store(files, (Obj*)Seg_Get_Name(segment), INCREF(file_meta));
         }
     }
     Hash_Store_Utf8(metadata, "files", 5, (Obj*)files);
@@ -247,6 +365,28 @@ DefDelWriter_Seg_Del_Count_IMP(DefaultDeletionsWriter *self,
     return deldocs ? BitVec_Count(deldocs) : 0;
 }
 
+bool
+DefDelWriter_Hosts_Del_Base_IMP(DefaultDeletionsWriter *self,
+                                String *seg_name) {
+    DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->seg_readers); i < max; i++) {
+        SegReader *seg_reader = (SegReader*)VA_Fetch(ivars->seg_readers, i);
+        Hash      *file_meta  = S_file_meta(seg_reader);
+        String    *base       = file_meta
+                                ? (String*)Hash_Fetch_Utf8(file_meta,
+                                                           "filename", 8)
+                                : NULL;
+        // Only bitmaps which deltas may build on are worth protecting.
+        if (base
+            && S_max_delta(SegReader_Doc_Max(seg_reader))
+            && S_file_in_seg(base, seg_name)
+           ) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void
 DefDelWriter_Delete_By_Term_IMP(DefaultDeletionsWriter *self,
                                 String *field, Obj *term) {
@@ -256,7 +396,15 @@ DefDelWriter_Delete_By_Term_IMP(DefaultDeletionsWriter *self,
         PostingListReader *plist_reader
             = (PostingListReader*)SegReader_Fetch(
                   seg_reader, VTable_Get_Name(POSTINGLISTREADER));
+        KeyFilterReader *key_filter
+            = (KeyFilterReader*)SegReader_Fetch(
+                  seg_reader, VTable_Get_Name(KEYFILTERREADER));
         BitVector *bit_vec = (BitVector*)VA_Fetch(ivars->bit_vecs, i);
+        if (key_filter
+            && !KeyFilterReader_Might_Contain(key_filter, field, term)
+           ) {
+            continue;
+        }
         PostingList *plist = plist_reader
                              ? PListReader_Posting_List(plist_reader, field, term)
                              : NULL;
@@ -265,6 +413,7 @@ DefDelWriter_Delete_By_Term_IMP(DefaultDeletionsWriter *self,
 
         // Iterate through postings, marking each doc as deleted.
         if (plist) {
+            PList_Set_Doc_IDs_Only(plist, true);
             while (0 != (doc_id = PList_Next(plist))) {
                 num_zapped += !BitVec_Get(bit_vec, doc_id);
                 BitVec_Set(bit_vec, doc_id);
@@ -275,6 +424,77 @@ DefDelWriter_Delete_By_Term_IMP(DefaultDeletionsWriter *self,
     }
 }
 
+void
+DefDelWriter_Delete_By_Terms_IMP(DefaultDeletionsWriter *self, String *field,
+                                 VArray *terms) {
+    DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
+    VArray *sorted = VA_Shallow_Copy(terms);
+    VA_Sort(sorted, NULL, NULL);
+    const uint32_t num_terms = VA_Get_Size(sorted);
+
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->seg_readers); i < max; i++) {
+        SegReader *seg_reader = (SegReader*)VA_Fetch(ivars->seg_readers, i);
+        PostingListReader *plist_reader
+            = (PostingListReader*)SegReader_Fetch(
+                  seg_reader, VTable_Get_Name(POSTINGLISTREADER));
+        LexiconReader *lex_reader
+            = (LexiconReader*)SegReader_Fetch(
+                  seg_reader, VTable_Get_Name(LEXICONREADER));
+        KeyFilterReader *key_filter
+            = (KeyFilterReader*)SegReader_Fetch(
+                  seg_reader, VTable_Get_Name(KEYFILTERREADER));
+        BitVector   *bit_vec    = (BitVector*)VA_Fetch(ivars->bit_vecs, i);
+        Lexicon     *lexicon    = NULL;
+        PostingList *plist      = NULL;
+        int32_t      num_zapped = 0;
+        if (!plist_reader || !lex_reader) { continue; }
+
+        for (uint32_t j = 0; j < num_terms; j++) {
+            Obj *term = VA_Fetch(sorted, j);
+            if (j > 0 && Obj_Equals(term, VA_Fetch(sorted, j - 1))) {
+                continue;
+            }
+            if (key_filter
+                && !KeyFilterReader_Might_Contain(key_filter, field, term)
+               ) {
+                continue;
+            }
+
+            // Open the Lexicon and PostingList lazily, so that segments the
+            // key filter rules out entirely are never touched.
+            if (!lexicon) {
+                lexicon = LexReader_Lexicon(lex_reader, field, NULL);
+                plist   = PListReader_Posting_List(plist_reader, field, NULL);
+                if (!lexicon || !plist) { break; }
+                PList_Set_Doc_IDs_Only(plist, true);
+            }
+
+            // Since the terms are sorted, running off the end of the
+            // Lexicon means none of the rest are present.
+            Lex_Seek(lexicon, term);
+            Obj *found = Lex_Get_Term(lexicon);
+            if (!found) { break; }
+            int32_t comparison = Obj_Compare_To(found, term);
+            if (comparison < 0) { break; }
+            if (comparison > 0) { continue; }
+
+            // Iterate through postings, marking each doc as deleted.
+            int32_t doc_id;
+            PList_Seek_Lex(plist, lexicon);
+            while (0 != (doc_id = PList_Next(plist))) {
+                num_zapped += !BitVec_Get(bit_vec, doc_id);
+                BitVec_Set(bit_vec, doc_id);
+            }
+        }
+
+        if (num_zapped) { ivars->updated[i] = true; }
+        DECREF(plist);
+        DECREF(lexicon);
+    }
+
+    DECREF(sorted);
+}
+
 void
 DefDelWriter_Delete_By_Query_IMP(DefaultDeletionsWriter *self, Query *query) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
@@ -343,7 +563,8 @@ DefDelWriter_Merge_Segment_IMP(DefaultDeletionsWriter *self,
                                SegReader *reader, I32Array *doc_map) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
     UNUSED_VAR(doc_map);
-    Segment *segment = SegReader_Get_Segment(reader);
+    Segment *segment     = SegReader_Get_Segment(reader);
+    String  *merged_name = Seg_Get_Name(segment);
     Hash *del_meta = (Hash*)Seg_Fetch_Metadata_Utf8(segment, "deletions", 9);
 
     if (del_meta) {
@@ -366,16 +587,37 @@ DefDelWriter_Merge_Segment_IMP(DefaultDeletionsWriter *self,
                         = Seg_Get_Name(SegReader_Get_Segment(candidate));
 
                     if (Str_Equals(seg, (Obj*)candidate_name)) {
-                        /* If the count hasn't changed, we're about to
-                         * merge away the most recent deletions file
-                         * pointing at this target segment -- so force a
-                         * new file to be written out. */
-                        int32_t count = (int32_t)Obj_To_I64(Hash_Fetch_Utf8(mini_meta, "count", 5));
-                        DeletionsReader *del_reader
-                            = (DeletionsReader*)SegReader_Obtain(
-                                  candidate, VTable_Get_Name(DELETIONSREADER));
-                        if (count == DelReader_Del_Count(del_reader)) {
-                            ivars->updated[i] = true;
+                        Hash *live_meta = S_file_meta(candidate);
+                        if (live_meta) {
+                            /* If these are the current deletions for the
+                             * target segment, we're about to merge them
+                             * away -- so force new files to be written
+                             * out.  If the bitmap they build on is going
+                             * away, write a fresh one. */
+                            String *base
+                                = (String*)Hash_Fetch_Utf8(live_meta,
+                                                           "filename", 8);
+                            if (Hash_Equals(mini_meta, (Obj*)live_meta)) {
+                                ivars->updated[i] = true;
+                            }
+                            if (base && S_file_in_seg(base, merged_name)) {
+                                ivars->updated[i] = true;
+                                ivars->rewrite[i] = true;
+                            }
+                        }
+                        else {
+                            /* If the count hasn't changed, we're about to
+                             * merge away the most recent deletions file
+                             * pointing at this target segment -- so force
+                             * a new file to be written out. */
+                            int32_t count = (int32_t)Obj_To_I64(Hash_Fetch_Utf8(mini_meta, "count", 5));
+                            DeletionsReader *del_reader
+                                = (DeletionsReader*)SegReader_Obtain(
+                                      candidate, VTable_Get_Name(DELETIONSREADER));
+                            if (count == DelReader_Del_Count(del_reader)) {
+                                ivars->updated[i] = true;
+                                ivars->rewrite[i] = true;
+                            }
                         }
                         break;
                     }
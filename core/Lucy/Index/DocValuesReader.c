@@ -0,0 +1,281 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_DOCVALUESREADER
+#define C_LUCY_POLYDOCVALUESREADER
+#define C_LUCY_DEFAULTDOCVALUESREADER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/DocValuesReader.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/Snapshot.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Object/I32Array.h"
+#include "Lucy/Plan/FieldType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/MatchDoc.h"
+#include "Lucy/Search/TopDocs.h"
+#include "Lucy/Store/Folder.h"
+
+DocValuesReader*
+DocValuesReader_init(DocValuesReader *self, Schema *schema, Folder *folder,
+                     Snapshot *snapshot, VArray *segments, int32_t seg_tick) {
+    return (DocValuesReader*)DataReader_init((DataReader*)self, schema,
+                                             folder, snapshot, segments,
+                                             seg_tick);
+}
+
+VArray*
+DocValuesReader_Fetch_Values_IMP(DocValuesReader *self, String *field,
+                                 I32Array *doc_ids) {
+    uint32_t  num_docs = I32Arr_Get_Size(doc_ids);
+    VArray   *values   = VA_new(num_docs);
+    for (uint32_t i = 0; i < num_docs; i++) {
+        int32_t doc_id = I32Arr_Get(doc_ids, i);
+        VA_Store(values, i, DocValuesReader_Fetch_Value(self, field, doc_id));
+    }
+    return values;
+}
+
+VArray*
+DocValuesReader_Fetch_Hit_Values_IMP(DocValuesReader *self, String *field,
+                                     TopDocs *top_docs) {
+    VArray   *match_docs = TopDocs_Get_Match_Docs(top_docs);
+    uint32_t  num_hits   = VA_Get_Size(match_docs);
+    int32_t  *ints       = (int32_t*)MALLOCATE(num_hits * sizeof(int32_t));
+    for (uint32_t i = 0; i < num_hits; i++) {
+        MatchDoc *match_doc = (MatchDoc*)VA_Fetch(match_docs, i);
+        ints[i] = MatchDoc_Get_Doc_ID(match_doc);
+    }
+    I32Array *doc_ids = I32Arr_new_steal(ints, num_hits);
+    VArray   *values  = DocValuesReader_Fetch_Values(self, field, doc_ids);
+    DECREF(doc_ids);
+    return values;
+}
+
+DocValuesReader*
+DocValuesReader_Aggregator_IMP(DocValuesReader *self, VArray *readers,
+                               I32Array *offsets) {
+    UNUSED_VAR(self);
+    return (DocValuesReader*)PolyDocValuesReader_new(readers, offsets);
+}
+
+PolyDocValuesReader*
+PolyDocValuesReader_new(VArray *readers, I32Array *offsets) {
+    PolyDocValuesReader *self
+        = (PolyDocValuesReader*)VTable_Make_Obj(POLYDOCVALUESREADER);
+    return PolyDocValuesReader_init(self, readers, offsets);
+}
+
+PolyDocValuesReader*
+PolyDocValuesReader_init(PolyDocValuesReader *self, VArray *readers,
+                         I32Array *offsets) {
+    DocValuesReader_init((DocValuesReader*)self, NULL, NULL, NULL, NULL, -1);
+    PolyDocValuesReaderIVARS *const ivars = PolyDocValuesReader_IVARS(self);
+    for (uint32_t i = 0, max = VA_Get_Size(readers); i < max; i++) {
+        CERTIFY(VA_Fetch(readers, i), DOCVALUESREADER);
+    }
+    ivars->readers = (VArray*)INCREF(readers);
+    ivars->offsets = (I32Array*)INCREF(offsets);
+    return self;
+}
+
+void
+PolyDocValuesReader_Close_IMP(PolyDocValuesReader *self) {
+    PolyDocValuesReaderIVARS *const ivars = PolyDocValuesReader_IVARS(self);
+    if (ivars->readers) {
+        for (uint32_t i = 0, max = VA_Get_Size(ivars->readers); i < max; i++) {
+            DocValuesReader *reader
+                = (DocValuesReader*)VA_Fetch(ivars->readers, i);
+            if (reader) { DocValuesReader_Close(reader); }
+        }
+        VA_Clear(ivars->readers);
+    }
+}
+
+void
+PolyDocValuesReader_Destroy_IMP(PolyDocValuesReader *self) {
+    PolyDocValuesReaderIVARS *const ivars = PolyDocValuesReader_IVARS(self);
+    DECREF(ivars->readers);
+    DECREF(ivars->offsets);
+    SUPER_DESTROY(self, POLYDOCVALUESREADER);
+}
+
+Obj*
+PolyDocValuesReader_Fetch_Value_IMP(PolyDocValuesReader *self, String *field,
+                                    int32_t doc_id) {
+    PolyDocValuesReaderIVARS *const ivars = PolyDocValuesReader_IVARS(self);
+    uint32_t seg_tick = PolyReader_sub_tick(ivars->offsets, doc_id);
+    int32_t  offset   = I32Arr_Get(ivars->offsets, seg_tick);
+    DocValuesReader *reader
+        = (DocValuesReader*)VA_Fetch(ivars->readers, seg_tick);
+    if (!reader) {
+        THROW(ERR, "Invalid doc_id: %i32", doc_id);
+    }
+    return DocValuesReader_Fetch_Value(reader, field, doc_id - offset);
+}
+
+VArray*
+PolyDocValuesReader_Fetch_Values_IMP(PolyDocValuesReader *self,
+                                     String *field, I32Array *doc_ids) {
+    PolyDocValuesReaderIVARS *const ivars = PolyDocValuesReader_IVARS(self);
+    const uint32_t num_docs    = I32Arr_Get_Size(doc_ids);
+    const uint32_t num_readers = VA_Get_Size(ivars->readers);
+    VArray   *values = VA_new(num_docs);
+    uint32_t *ticks  = (uint32_t*)MALLOCATE((num_docs + 1) * sizeof(uint32_t));
+    uint32_t *starts = (uint32_t*)CALLOCATE(num_readers + 1,
+                                            sizeof(uint32_t));
+    uint32_t *slots  = (uint32_t*)MALLOCATE((num_docs + 1) * sizeof(uint32_t));
+
+    // Find each doc's segment, counting the docs which land in each.
+    for (uint32_t i = 0; i < num_docs; i++) {
+        int32_t  doc_id   = I32Arr_Get(doc_ids, i);
+        uint32_t seg_tick = PolyReader_sub_tick(ivars->offsets, doc_id);
+        if (!VA_Fetch(ivars->readers, seg_tick)) {
+            FREEMEM(slots);
+            FREEMEM(starts);
+            FREEMEM(ticks);
+            DECREF(values);
+            THROW(ERR, "Invalid doc_id: %i32", doc_id);
+        }
+        ticks[i] = seg_tick;
+        starts[seg_tick + 1]++;
+    }
+    for (uint32_t i = 0; i < num_readers; i++) {
+        starts[i + 1] += starts[i];
+    }
+
+    // Sort the positions of the docs by segment, keeping their order within
+    // each segment.
+    for (uint32_t i = 0; i < num_docs; i++) {
+        slots[starts[ticks[i]]++] = i;
+    }
+    for (uint32_t i = num_readers; i > 0; i--) {
+        starts[i] = starts[i - 1];
+    }
+    starts[0] = 0;
+
+    // Make one batch request of each segment, then scatter its values back
+    // to the positions they were asked for in.
+    if (num_docs) { VA_Resize(values, num_docs); }
+    for (uint32_t seg_tick = 0; seg_tick < num_readers; seg_tick++) {
+        const uint32_t start = starts[seg_tick];
+        const uint32_t count = starts[seg_tick + 1] - start;
+        if (!count) { continue; }
+        DocValuesReader *reader
+            = (DocValuesReader*)VA_Fetch(ivars->readers, seg_tick);
+        int32_t  offset = I32Arr_Get(ivars->offsets, seg_tick);
+        int32_t *ints   = (int32_t*)MALLOCATE(count * sizeof(int32_t));
+        for (uint32_t i = 0; i < count; i++) {
+            ints[i] = I32Arr_Get(doc_ids, slots[start + i]) - offset;
+        }
+        I32Array *seg_doc_ids = I32Arr_new_steal(ints, count);
+        VArray   *seg_values
+            = DocValuesReader_Fetch_Values(reader, field, seg_doc_ids);
+        for (uint32_t i = 0; i < count; i++) {
+            Obj *value = VA_Fetch(seg_values, i);
+            if (value) {
+                VA_Store(values, slots[start + i], INCREF(value));
+            }
+        }
+        DECREF(seg_values);
+        DECREF(seg_doc_ids);
+    }
+
+    FREEMEM(slots);
+    FREEMEM(starts);
+    FREEMEM(ticks);
+    return values;
+}
+
+DefaultDocValuesReader*
+DefDocValuesReader_new(Schema *schema, Folder *folder, Snapshot *snapshot,
+                       VArray *segments, int32_t seg_tick,
+                       SortReader *sort_reader) {
+    DefaultDocValuesReader *self
+        = (DefaultDocValuesReader*)VTable_Make_Obj(DEFAULTDOCVALUESREADER);
+    return DefDocValuesReader_init(self, schema, folder, snapshot, segments,
+                                   seg_tick, sort_reader);
+}
+
+DefaultDocValuesReader*
+DefDocValuesReader_init(DefaultDocValuesReader *self, Schema *schema,
+                        Folder *folder, Snapshot *snapshot, VArray *segments,
+                        int32_t seg_tick, SortReader *sort_reader) {
+    DocValuesReader_init((DocValuesReader*)self, schema, folder, snapshot,
+                         segments, seg_tick);
+    DefaultDocValuesReaderIVARS *const ivars = DefDocValuesReader_IVARS(self);
+    ivars->sort_reader = (SortReader*)INCREF(sort_reader);
+    return self;
+}
+
+void
+DefDocValuesReader_Close_IMP(DefaultDocValuesReader *self) {
+    // The SortReader belongs to the SegReader, which closes it.
+    DefaultDocValuesReaderIVARS *const ivars = DefDocValuesReader_IVARS(self);
+    DECREF(ivars->sort_reader);
+    ivars->sort_reader = NULL;
+}
+
+void
+DefDocValuesReader_Destroy_IMP(DefaultDocValuesReader *self) {
+    DefaultDocValuesReaderIVARS *const ivars = DefDocValuesReader_IVARS(self);
+    DECREF(ivars->sort_reader);
+    SUPER_DESTROY(self, DEFAULTDOCVALUESREADER);
+}
+
+// Return the column for the field, or NULL if this segment holds no values
+// for it.
+static SortCache*
+S_fetch_column(DefaultDocValuesReader *self, String *field) {
+    DefaultDocValuesReaderIVARS *const ivars = DefDocValuesReader_IVARS(self);
+    Schema    *schema = DefDocValuesReader_Get_Schema(self);
+    FieldType *type   = Schema_Fetch_Type(schema, field);
+    if (!type || !FType_Sortable(type)) {
+        THROW(ERR, "'%o' isn't a sortable field", field);
+    }
+    return ivars->sort_reader
+           ? SortReader_Fetch_Sort_Cache(ivars->sort_reader, field)
+           : NULL;
+}
+
+Obj*
+DefDocValuesReader_Fetch_Value_IMP(DefaultDocValuesReader *self,
+                                   String *field, int32_t doc_id) {
+    SortCache *cache = S_fetch_column(self, field);
+    if (!cache) { return NULL; }
+    int32_t ord = SortCache_Ordinal(cache, doc_id);
+    return SortCache_Value(cache, ord);
+}
+
+VArray*
+DefDocValuesReader_Fetch_Values_IMP(DefaultDocValuesReader *self,
+                                    String *field, I32Array *doc_ids) {
+    uint32_t   num_docs = I32Arr_Get_Size(doc_ids);
+    VArray    *values   = VA_new(num_docs);
+    SortCache *cache    = S_fetch_column(self, field);
+    if (cache) {
+        for (uint32_t i = 0; i < num_docs; i++) {
+            int32_t ord = SortCache_Ordinal(cache, I32Arr_Get(doc_ids, i));
+            VA_Store(values, i, SortCache_Value(cache, ord));
+        }
+    }
+    else if (num_docs) {
+        VA_Resize(values, num_docs);
+    }
+    return values;
+}
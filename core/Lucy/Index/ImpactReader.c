@@ -0,0 +1,409 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_IMPACTREADER
+#define C_LUCY_DEFAULTIMPACTREADER
+#define C_LUCY_IMPACTLIST
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/ImpactReader.h"
+#include "Lucy/Index/ImpactWriter.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/Snapshot.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/InStream.h"
+#include "Clownfish/Util/SortUtils.h"
+
+ImpactReader*
+ImpactReader_init(ImpactReader *self, Schema *schema, Folder *folder,
+                  Snapshot *snapshot, VArray *segments, int32_t seg_tick) {
+    DataReader_init((DataReader*)self, schema, folder, snapshot, segments,
+                    seg_tick);
+    ABSTRACT_CLASS_CHECK(self, IMPACTREADER);
+    return self;
+}
+
+DataReader*
+ImpactReader_Aggregator_IMP(ImpactReader *self, VArray *readers,
+                            I32Array *offsets) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(readers);
+    UNUSED_VAR(offsets);
+    return NULL;
+}
+
+DefaultImpactReader*
+DefImpactReader_new(Schema *schema, Folder *folder, Snapshot *snapshot,
+                    VArray *segments, int32_t seg_tick) {
+    DefaultImpactReader *self
+        = (DefaultImpactReader*)VTable_Make_Obj(DEFAULTIMPACTREADER);
+    return DefImpactReader_init(self, schema, folder, snapshot, segments,
+                                seg_tick);
+}
+
+DefaultImpactReader*
+DefImpactReader_init(DefaultImpactReader *self, Schema *schema,
+                     Folder *folder, Snapshot *snapshot, VArray *segments,
+                     int32_t seg_tick) {
+    ImpactReader_init((ImpactReader*)self, schema, folder, snapshot,
+                      segments, seg_tick);
+    DefaultImpactReaderIVARS *const ivars = DefImpactReader_IVARS(self);
+    Segment *segment  = DefImpactReader_Get_Segment(self);
+    Hash    *metadata = (Hash*)Seg_Fetch_Metadata_Utf8(segment, "impacts", 7);
+
+    // Init.
+    ivars->fields = NULL;
+    ivars->runs   = NULL;
+    ivars->dicts  = Hash_new(0);
+    ivars->ix_in  = NULL;
+    ivars->dat_in = NULL;
+
+    // Segments written without any impact fields have nothing to read.
+    if (!metadata) { return self; }
+    CERTIFY(metadata, HASH);
+
+    // Check format.
+    Obj *format = Hash_Fetch_Utf8(metadata, "format", 6);
+    if (!format) { THROW(ERR, "Missing 'format' var"); }
+    if (Obj_To_I64(format) != ImpactWriter_current_file_format) {
+        THROW(ERR, "Unsupported impact index format: %i64",
+              Obj_To_I64(format));
+    }
+    ivars->fields = (VArray*)INCREF(CERTIFY(
+                        Hash_Fetch_Utf8(metadata, "fields", 6), VARRAY));
+    ivars->runs = (VArray*)INCREF(CERTIFY(
+                      Hash_Fetch_Utf8(metadata, "runs", 4), VARRAY));
+
+    // Open the term index and the postings.  The term index is only read
+    // once a field's terms are first needed.
+    String *seg_name = Seg_Get_Name(segment);
+    String *ix_file  = Str_newf("%o/impacts.ix", seg_name);
+    ivars->ix_in = Folder_Open_In(folder, ix_file);
+    DECREF(ix_file);
+    if (!ivars->ix_in) {
+        Err *error = (Err*)INCREF(Err_get_error());
+        DECREF(self);
+        RETHROW(error);
+    }
+    String *dat_file = Str_newf("%o/impacts.dat", seg_name);
+    ivars->dat_in = Folder_Open_In(folder, dat_file);
+    DECREF(dat_file);
+    if (!ivars->dat_in) {
+        Err *error = (Err*)INCREF(Err_get_error());
+        DECREF(self);
+        RETHROW(error);
+    }
+
+    return self;
+}
+
+void
+DefImpactReader_Close_IMP(DefaultImpactReader *self) {
+    DefaultImpactReaderIVARS *const ivars = DefImpactReader_IVARS(self);
+    if (ivars->ix_in) {
+        InStream_Close(ivars->ix_in);
+        DECREF(ivars->ix_in);
+        ivars->ix_in = NULL;
+    }
+    if (ivars->dat_in) {
+        InStream_Close(ivars->dat_in);
+        DECREF(ivars->dat_in);
+        ivars->dat_in = NULL;
+    }
+}
+
+void
+DefImpactReader_Destroy_IMP(DefaultImpactReader *self) {
+    DefaultImpactReaderIVARS *const ivars = DefImpactReader_IVARS(self);
+    DECREF(ivars->fields);
+    DECREF(ivars->runs);
+    DECREF(ivars->dicts);
+    DECREF(ivars->ix_in);
+    DECREF(ivars->dat_in);
+    SUPER_DESTROY(self, DEFAULTIMPACTREADER);
+}
+
+// Return the index of `field` among the segment's impact fields, or -1.
+static int32_t
+S_field_num(DefaultImpactReaderIVARS *ivars, String *field) {
+    if (!ivars->fields || !field) { return -1; }
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->fields); i < max; i++) {
+        if (Str_Equals(field, VA_Fetch(ivars->fields, i))) {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+// Return the term dictionaries of a field, one Hash per run mapping each
+// term to the file pointer of its postings, reading them on first use.
+static VArray*
+S_fetch_dicts(DefaultImpactReaderIVARS *ivars, String *field) {
+    VArray *dicts = (VArray*)Hash_Fetch(ivars->dicts, (Obj*)field);
+    if (dicts) { return dicts; }
+    int32_t field_num = S_field_num(ivars, field);
+    if (field_num < 0 || !ivars->ix_in) { return NULL; }
+
+    InStream *ix_in    = ivars->ix_in;
+    uint32_t  num_runs = VA_Get_Size(ivars->runs);
+    ByteBuf  *buf      = BB_new(0);
+    dicts = VA_new(num_runs);
+    for (uint32_t i = 0; i < num_runs; i++) {
+        VArray *run = (VArray*)CERTIFY(VA_Fetch(ivars->runs, i), VARRAY);
+        Obj *start = VA_Fetch(run, (uint32_t)field_num);
+        if (!start) { THROW(ERR, "Missing impact index offset"); }
+        InStream_Seek(ix_in, Obj_To_I64(start));
+        uint32_t  num_terms = InStream_Read_C32(ix_in);
+        Hash     *terms     = Hash_new(num_terms);
+        for (uint32_t j = 0; j < num_terms; j++) {
+            uint32_t len = InStream_Read_C32(ix_in);
+            char *ptr = BB_Grow(buf, len);
+            InStream_Read_Bytes(ix_in, ptr, len);
+            int64_t offset = (int64_t)InStream_Read_C64(ix_in);
+            Hash_Store(terms, (Obj*)Str_new_from_utf8(ptr, len),
+                       (Obj*)Int64_new(offset));
+        }
+        VA_Push(dicts, (Obj*)terms);
+    }
+    DECREF(buf);
+    Hash_Store(ivars->dicts, (Obj*)field, (Obj*)dicts);
+    return dicts;
+}
+
+bool
+DefImpactReader_Has_Field_IMP(DefaultImpactReader *self, String *field) {
+    return S_field_num(DefImpactReader_IVARS(self), field) >= 0;
+}
+
+VArray*
+DefImpactReader_Terms_IMP(DefaultImpactReader *self, String *field) {
+    DefaultImpactReaderIVARS *const ivars = DefImpactReader_IVARS(self);
+    VArray *dicts = S_fetch_dicts(ivars, field);
+    if (!dicts) { return NULL; }
+    Hash *all_terms = Hash_new(0);
+    for (uint32_t i = 0, max = VA_Get_Size(dicts); i < max; i++) {
+        Hash *terms = (Hash*)VA_Fetch(dicts, i);
+        Obj  *term;
+        Obj  *offset;
+        Hash_Iterate(terms);
+        while (Hash_Next(terms, &term, &offset)) {
+            Hash_Store(all_terms, term, INCREF(offset));
+        }
+    }
+    VArray *keys = Hash_Keys(all_terms);
+    VA_Sort(keys, NULL, NULL);
+    DECREF(all_terms);
+    return keys;
+}
+
+ImpactList*
+DefImpactReader_Impact_List_IMP(DefaultImpactReader *self, String *field,
+                                Obj *term) {
+    DefaultImpactReaderIVARS *const ivars = DefImpactReader_IVARS(self);
+    if (!ivars->dat_in || !term) { return NULL; }
+    VArray *dicts = S_fetch_dicts(ivars, field);
+    if (!dicts) { return NULL; }
+
+    VArray *instreams = VA_new(VA_Get_Size(dicts));
+    for (uint32_t i = 0, max = VA_Get_Size(dicts); i < max; i++) {
+        Obj *offset = Hash_Fetch((Hash*)VA_Fetch(dicts, i), term);
+        if (!offset) { continue; }
+        InStream *instream = InStream_Clone(ivars->dat_in);
+        InStream_Seek(instream, Obj_To_I64(offset));
+        VA_Push(instreams, (Obj*)instream);
+    }
+    ImpactList *list = VA_Get_Size(instreams)
+                       ? ImpactList_new(instreams)
+                       : NULL;
+    DECREF(instreams);
+    return list;
+}
+
+/***************************************************************************/
+
+ImpactList*
+ImpactList_new(VArray *instreams) {
+    ImpactList *self = (ImpactList*)VTable_Make_Obj(IMPACTLIST);
+    return ImpactList_init(self, instreams);
+}
+
+// Return the run whose next bucket has the highest level, or -1 if every
+// run has been read to the end.
+static int32_t
+S_top_run(ImpactListIVARS *ivars) {
+    int32_t top = -1;
+    for (uint32_t i = 0; i < ivars->num_runs; i++) {
+        if (ivars->ticks[i] >= ivars->run_starts[i + 1]) { continue; }
+        if (top < 0
+            || ivars->levels[ivars->ticks[i]]
+               > ivars->levels[ivars->ticks[top]]
+           ) {
+            top = (int32_t)i;
+        }
+    }
+    return top;
+}
+
+ImpactList*
+ImpactList_init(ImpactList *self, VArray *instreams) {
+    ImpactListIVARS *const ivars = ImpactList_IVARS(self);
+    const uint32_t num_runs = VA_Get_Size(instreams);
+    ivars->num_runs   = num_runs;
+    ivars->doc_ids    = NULL;
+    ivars->cap        = 0;
+    ivars->instreams  = (InStream**)MALLOCATE(num_runs * sizeof(InStream*));
+    ivars->run_starts = (uint32_t*)MALLOCATE((num_runs + 1)
+                                             * sizeof(uint32_t));
+    ivars->ticks      = (uint32_t*)MALLOCATE((num_runs + 1)
+                                             * sizeof(uint32_t));
+
+    // Read every run's bucket headers into a single set of arrays.
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < num_runs; i++) {
+        InStream *instream = (InStream*)VA_Fetch(instreams, i);
+        ivars->instreams[i]  = (InStream*)INCREF(instream);
+        ivars->run_starts[i] = total;
+        total += InStream_Read_C32(instream);
+        ivars->run_starts[i + 1] = total;
+    }
+    ivars->max_impacts = (float*)MALLOCATE((total + 1) * sizeof(float));
+    ivars->levels      = (int32_t*)MALLOCATE((total + 1) * sizeof(int32_t));
+    ivars->counts      = (uint32_t*)MALLOCATE((total + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < num_runs; i++) {
+        InStream *instream = ivars->instreams[i];
+        uint32_t  run_cap  = 0;
+        for (uint32_t j = ivars->run_starts[i]; j < ivars->run_starts[i + 1];
+             j++) {
+            ivars->max_impacts[j] = InStream_Read_F32(instream);
+            ivars->counts[j]      = InStream_Read_C32(instream);
+            ivars->levels[j]      = ImpactWriter_level(ivars->max_impacts[j]);
+            if (ivars->counts[j] > run_cap) { run_cap = ivars->counts[j]; }
+        }
+        ivars->cap += run_cap;
+    }
+
+    // Count the merged buckets: one for each distinct level.
+    for (uint32_t i = 0; i < num_runs; i++) {
+        ivars->ticks[i] = ivars->run_starts[i];
+    }
+    ivars->num_buckets = 0;
+    int32_t top;
+    while ((top = S_top_run(ivars)) >= 0) {
+        int32_t level = ivars->levels[ivars->ticks[top]];
+        for (uint32_t i = 0; i < num_runs; i++) {
+            if (ivars->ticks[i] < ivars->run_starts[i + 1]
+                && ivars->levels[ivars->ticks[i]] == level
+               ) {
+                ivars->ticks[i]++;
+            }
+        }
+        ivars->num_buckets++;
+    }
+    for (uint32_t i = 0; i < num_runs; i++) {
+        ivars->ticks[i] = ivars->run_starts[i];
+    }
+
+    return self;
+}
+
+void
+ImpactList_Destroy_IMP(ImpactList *self) {
+    ImpactListIVARS *const ivars = ImpactList_IVARS(self);
+    for (uint32_t i = 0; i < ivars->num_runs; i++) {
+        DECREF(ivars->instreams[i]);
+    }
+    FREEMEM(ivars->instreams);
+    FREEMEM(ivars->run_starts);
+    FREEMEM(ivars->ticks);
+    FREEMEM(ivars->max_impacts);
+    FREEMEM(ivars->levels);
+    FREEMEM(ivars->counts);
+    FREEMEM(ivars->doc_ids);
+    SUPER_DESTROY(self, IMPACTLIST);
+}
+
+uint32_t
+ImpactList_Num_Buckets_IMP(ImpactList *self) {
+    return ImpactList_IVARS(self)->num_buckets;
+}
+
+float
+ImpactList_Next_Max_Impact_IMP(ImpactList *self) {
+    ImpactListIVARS *const ivars = ImpactList_IVARS(self);
+    int32_t top = S_top_run(ivars);
+    if (top < 0) { return 0.0f; }
+    int32_t level      = ivars->levels[ivars->ticks[top]];
+    float   max_impact = 0.0f;
+    for (uint32_t i = 0; i < ivars->num_runs; i++) {
+        uint32_t tick = ivars->ticks[i];
+        if (tick < ivars->run_starts[i + 1]
+            && ivars->levels[tick] == level
+            && ivars->max_impacts[tick] > max_impact
+           ) {
+            max_impact = ivars->max_impacts[tick];
+        }
+    }
+    return max_impact;
+}
+
+static int
+S_compare_doc_ids(void *context, const void *va, const void *vb) {
+    int32_t a = *(const int32_t*)va;
+    int32_t b = *(const int32_t*)vb;
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+int32_t*
+ImpactList_Next_Bucket_IMP(ImpactList *self, uint32_t *count) {
+    ImpactListIVARS *const ivars = ImpactList_IVARS(self);
+    int32_t top = S_top_run(ivars);
+    if (top < 0) {
+        *count = 0;
+        return NULL;
+    }
+    if (!ivars->doc_ids) {
+        ivars->doc_ids = (int32_t*)MALLOCATE((ivars->cap + 1) * sizeof(int32_t));
+    }
+
+    // Read the bucket at the top level from every run which has one.
+    const int32_t level = ivars->levels[ivars->ticks[top]];
+    uint32_t num_docs = 0;
+    bool     sorted   = true;
+    for (uint32_t i = 0; i < ivars->num_runs; i++) {
+        uint32_t tick = ivars->ticks[i];
+        if (tick >= ivars->run_starts[i + 1] || ivars->levels[tick] != level) {
+            continue;
+        }
+        InStream *const instream = ivars->instreams[i];
+        int32_t doc_id = 0;
+        for (uint32_t j = 0; j < ivars->counts[tick]; j++) {
+            doc_id += (int32_t)InStream_Read_C32(instream);
+            if (num_docs && doc_id < ivars->doc_ids[num_docs - 1]) {
+                sorted = false;
+            }
+            ivars->doc_ids[num_docs++] = doc_id;
+        }
+        ivars->ticks[i]++;
+    }
+    if (!sorted) {
+        Sort_quicksort(ivars->doc_ids, num_docs, sizeof(int32_t),
+                       S_compare_doc_ids, NULL);
+    }
+    *count = num_docs;
+    return ivars->doc_ids;
+}
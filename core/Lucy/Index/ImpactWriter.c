@@ -0,0 +1,385 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_IMPACTWRITER
+#include "Lucy/Util/ToolSet.h"
+
+#include <math.h>
+
+#include "Lucy/Index/ImpactWriter.h"
+#include "Lucy/Analysis/Inversion.h"
+#include "Lucy/Analysis/Token.h"
+#include "Lucy/Index/ImpactReader.h"
+#include "Lucy/Index/Inverter.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/Similarity.h"
+#include "Lucy/Index/Snapshot.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/OutStream.h"
+#include "Clownfish/Util/SortUtils.h"
+
+int32_t ImpactWriter_current_file_format = 2;
+static size_t default_mem_thresh = 0x400000; // 4 MB
+
+// A single posting: a doc id and the doc's impact for the term.
+typedef struct {
+    int32_t doc_id;
+    float   impact;
+} ImpactPosting;
+
+// Return the index of `field` within `fields`, or -1 if it's not there.
+static int32_t
+S_find_field(VArray *fields, String *field);
+
+// Add one posting to a field's pool, returning the bytes consumed.
+static size_t
+S_add_posting(Hash *pool, const char *text, size_t len, int32_t doc_id,
+              float impact);
+
+// Write out one term's postings, returning the number of buckets.
+static uint32_t
+S_write_term(OutStream *dat_out, ByteBuf *postings);
+
+// Write out the buffered postings as a run of their own, then clear them.
+static void
+S_flush_run(ImpactWriterIVARS *ivars);
+
+ImpactWriter*
+ImpactWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
+                 PolyReader *polyreader) {
+    ImpactWriter *self = (ImpactWriter*)VTable_Make_Obj(IMPACTWRITER);
+    return ImpactWriter_init(self, schema, snapshot, segment, polyreader);
+}
+
+ImpactWriter*
+ImpactWriter_init(ImpactWriter *self, Schema *schema, Snapshot *snapshot,
+                  Segment *segment, PolyReader *polyreader) {
+    DataWriter_init((DataWriter*)self, schema, snapshot, segment, polyreader);
+    ImpactWriterIVARS *const ivars = ImpactWriter_IVARS(self);
+
+    // Derive.  Gather the fields with impacts enabled, in sorted order.
+    VArray *all_fields = Schema_All_Fields(schema);
+    VA_Sort(all_fields, NULL, NULL);
+    ivars->fields       = VA_new(0);
+    ivars->pools        = VA_new(0);
+    ivars->runs         = VA_new(0);
+    ivars->ix_out       = NULL;
+    ivars->dat_out      = NULL;
+    ivars->mem_thresh   = default_mem_thresh;
+    ivars->mem_consumed = 0;
+    for (uint32_t i = 0, max = VA_Get_Size(all_fields); i < max; i++) {
+        String    *field = (String*)VA_Fetch(all_fields, i);
+        FieldType *type  = Schema_Fetch_Type(schema, field);
+        if (FType_Is_A(type, FULLTEXTTYPE)
+            && FType_Indexed(type)
+            && FullTextType_Impacts((FullTextType*)type)
+           ) {
+            VA_Push(ivars->fields, INCREF(field));
+            VA_Push(ivars->pools, (Obj*)Hash_new(0));
+        }
+    }
+    DECREF(all_fields);
+
+    return self;
+}
+
+void
+ImpactWriter_set_default_mem_thresh(size_t mem_thresh) {
+    default_mem_thresh = mem_thresh;
+}
+
+void
+ImpactWriter_Destroy_IMP(ImpactWriter *self) {
+    ImpactWriterIVARS *const ivars = ImpactWriter_IVARS(self);
+    DECREF(ivars->fields);
+    DECREF(ivars->pools);
+    DECREF(ivars->runs);
+    DECREF(ivars->ix_out);
+    DECREF(ivars->dat_out);
+    SUPER_DESTROY(self, IMPACTWRITER);
+}
+
+int32_t
+ImpactWriter_level(float impact) {
+    if (!(impact > 0.0f)) { return INT32_MIN; }
+    return (int32_t)floor(log2(impact) * IMPACTWRITER_LEVELS_PER_DOUBLING);
+}
+
+static int32_t
+S_find_field(VArray *fields, String *field) {
+    for (uint32_t i = 0, max = VA_Get_Size(fields); i < max; i++) {
+        if (Str_Equals(field, VA_Fetch(fields, i))) { return (int32_t)i; }
+    }
+    return -1;
+}
+
+static size_t
+S_add_posting(Hash *pool, const char *text, size_t len, int32_t doc_id,
+              float impact) {
+    StackString *term = SSTR_WRAP_UTF8(text, len);
+    ByteBuf *postings = (ByteBuf*)Hash_Fetch(pool, (Obj*)term);
+    size_t consumed = sizeof(ImpactPosting);
+    if (!postings) {
+        postings = BB_new(sizeof(ImpactPosting));
+        Hash_Store(pool, (Obj*)Str_new_from_trusted_utf8(text, len),
+                   (Obj*)postings);
+        // Account roughly for the term's String, ByteBuf and Hash entry.
+        consumed += len + 64;
+    }
+    ImpactPosting posting;
+    posting.doc_id = doc_id;
+    posting.impact = impact;
+    BB_Cat_Bytes(postings, &posting, sizeof(ImpactPosting));
+    return consumed;
+}
+
+void
+ImpactWriter_Add_Inverted_Doc_IMP(ImpactWriter *self, Inverter *inverter,
+                                  int32_t doc_id) {
+    ImpactWriterIVARS *const ivars = ImpactWriter_IVARS(self);
+    if (!VA_Get_Size(ivars->fields)) { return; }
+
+    float doc_boost = Inverter_Get_Boost(inverter);
+    Inverter_Iterate(inverter);
+    while (Inverter_Next(inverter)) {
+        int32_t tick = S_find_field(ivars->fields,
+                                    Inverter_Get_Field_Name(inverter));
+        if (tick < 0) { continue; }
+        Hash        *pool      = (Hash*)VA_Fetch(ivars->pools, (uint32_t)tick);
+        FieldType   *type      = Inverter_Get_Type(inverter);
+        Similarity  *sim       = Inverter_Get_Similarity(inverter);
+        Inversion   *inversion = Inverter_Get_Inversion(inverter);
+
+        // Derive the norm the same way ScorePosting does, so that impacts
+        // match what the posting's TermMatcher will compute.
+        float length_norm
+            = Sim_Length_Norm(sim, Inversion_Get_Length(inversion));
+        float field_boost = doc_boost * FType_Get_Boost(type) * length_norm;
+        float norm = Sim_Get_Norm_Decoder(sim)[
+                         Sim_Encode_Norm(sim, field_boost)];
+
+        Token   **tokens;
+        uint32_t  freq;
+        Inversion_Reset(inversion);
+        while ((tokens = Inversion_Next_Cluster(inversion, &freq)) != NULL) {
+            float impact = Sim_TF(sim, (float)freq) * norm;
+            ivars->mem_consumed
+                += S_add_posting(pool, Token_Get_Text(*tokens),
+                                 Token_Get_Len(*tokens), doc_id, impact);
+        }
+    }
+
+    if (ivars->mem_consumed >= ivars->mem_thresh) {
+        S_flush_run(ivars);
+    }
+}
+
+void
+ImpactWriter_Add_Segment_IMP(ImpactWriter *self, SegReader *reader,
+                             I32Array *doc_map) {
+    ImpactWriterIVARS *const ivars = ImpactWriter_IVARS(self);
+    DefaultImpactReader *impact_reader
+        = (DefaultImpactReader*)SegReader_Fetch(
+              reader, VTable_Get_Name(IMPACTREADER));
+    if (!impact_reader
+        || !DefImpactReader_Is_A(impact_reader, DEFAULTIMPACTREADER)
+       ) {
+        return;
+    }
+
+    // Read back every term's buckets.  Each posting takes on the maximum
+    // impact of its bucket, which keeps it in the same bucket.
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->fields); i < max; i++) {
+        String *field = (String*)VA_Fetch(ivars->fields, i);
+        Hash   *pool  = (Hash*)VA_Fetch(ivars->pools, i);
+        VArray *terms = DefImpactReader_Terms(impact_reader, field);
+        if (!terms) { continue; }
+        for (uint32_t j = 0, num_terms = VA_Get_Size(terms); j < num_terms;
+             j++) {
+            String *term = (String*)VA_Fetch(terms, j);
+            ImpactList *list
+                = DefImpactReader_Impact_List(impact_reader, field,
+                                              (Obj*)term);
+            if (!list) { continue; }
+            float    impact;
+            uint32_t count;
+            while ((impact = ImpactList_Next_Max_Impact(list)) > 0.0f) {
+                int32_t *doc_ids = ImpactList_Next_Bucket(list, &count);
+                for (uint32_t k = 0; k < count; k++) {
+                    int32_t doc_id = doc_map
+                                     ? I32Arr_Get(doc_map, doc_ids[k])
+                                     : doc_ids[k];
+                    if (!doc_id) { continue; }
+                    ivars->mem_consumed
+                        += S_add_posting(pool, Str_Get_Ptr8(term),
+                                         Str_Get_Size(term), doc_id, impact);
+                }
+            }
+            DECREF(list);
+
+            // Each term's postings from this segment stay within one run.
+            if (ivars->mem_consumed >= ivars->mem_thresh) {
+                S_flush_run(ivars);
+            }
+        }
+        DECREF(terms);
+    }
+}
+
+// Sort postings by descending impact bucket, then by ascending doc id.
+static int
+S_compare_postings(void *context, const void *va, const void *vb) {
+    const ImpactPosting *a = (const ImpactPosting*)va;
+    const ImpactPosting *b = (const ImpactPosting*)vb;
+    int32_t a_level = ImpactWriter_level(a->impact);
+    int32_t b_level = ImpactWriter_level(b->impact);
+    UNUSED_VAR(context);
+    if (a_level != b_level) { return a_level > b_level ? -1 : 1; }
+    return a->doc_id < b->doc_id ? -1 : a->doc_id > b->doc_id ? 1 : 0;
+}
+
+static uint32_t
+S_write_term(OutStream *dat_out, ByteBuf *postings) {
+    ImpactPosting *elems = (ImpactPosting*)BB_Get_Buf(postings);
+    uint32_t num_postings
+        = (uint32_t)(BB_Get_Size(postings) / sizeof(ImpactPosting));
+    Sort_quicksort(elems, num_postings, sizeof(ImpactPosting),
+                   S_compare_postings, NULL);
+
+    // Count buckets.
+    uint32_t num_buckets = 0;
+    for (uint32_t i = 0; i < num_postings; i++) {
+        if (i == 0
+            || ImpactWriter_level(elems[i].impact)
+               != ImpactWriter_level(elems[i - 1].impact)
+           ) {
+            num_buckets++;
+        }
+    }
+
+    // Write the bucket headers -- max impact and size -- followed by the
+    // delta-encoded doc ids of each bucket.
+    OutStream_Write_C32(dat_out, num_buckets);
+    for (uint32_t start = 0; start < num_postings;) {
+        int32_t  level = ImpactWriter_level(elems[start].impact);
+        float    max_impact = elems[start].impact;
+        uint32_t end = start + 1;
+        while (end < num_postings
+               && ImpactWriter_level(elems[end].impact) == level
+              ) {
+            if (elems[end].impact > max_impact) {
+                max_impact = elems[end].impact;
+            }
+            end++;
+        }
+        OutStream_Write_F32(dat_out, max_impact);
+        OutStream_Write_C32(dat_out, end - start);
+        start = end;
+    }
+    for (uint32_t start = 0; start < num_postings;) {
+        int32_t level   = ImpactWriter_level(elems[start].impact);
+        int32_t last_id = 0;
+        uint32_t i      = start;
+        for (; i < num_postings
+               && ImpactWriter_level(elems[i].impact) == level; i++
+            ) {
+            OutStream_Write_C32(dat_out,
+                                (uint32_t)(elems[i].doc_id - last_id));
+            last_id = elems[i].doc_id;
+        }
+        start = i;
+    }
+
+    return num_buckets;
+}
+
+static void
+S_flush_run(ImpactWriterIVARS *ivars) {
+    if (!ivars->mem_consumed) { return; }
+
+    // Open outstreams on the first run.
+    if (!ivars->ix_out) {
+        Folder *folder   = ivars->folder;
+        String *seg_name = Seg_Get_Name(ivars->segment);
+        String *ix_file  = Str_newf("%o/impacts.ix", seg_name);
+        ivars->ix_out = Folder_Open_Out(folder, ix_file);
+        DECREF(ix_file);
+        if (!ivars->ix_out) { RETHROW(INCREF(Err_get_error())); }
+        String *dat_file = Str_newf("%o/impacts.dat", seg_name);
+        ivars->dat_out = Folder_Open_Out(folder, dat_file);
+        DECREF(dat_file);
+        if (!ivars->dat_out) { RETHROW(INCREF(Err_get_error())); }
+    }
+    OutStream *ix_out  = ivars->ix_out;
+    OutStream *dat_out = ivars->dat_out;
+
+    // For each field, write the terms in order along with the file pointer
+    // of each one's buckets.  The run records where each field's terms
+    // begin, so that a reader can load one field without the others.
+    const uint32_t num_fields = VA_Get_Size(ivars->fields);
+    VArray *run = VA_new(num_fields);
+    for (uint32_t i = 0; i < num_fields; i++) {
+        Hash   *pool  = (Hash*)VA_Fetch(ivars->pools, i);
+        VArray *terms = Hash_Keys(pool);
+        VA_Sort(terms, NULL, NULL);
+        uint32_t num_terms = VA_Get_Size(terms);
+        VA_Push(run, (Obj*)Int64_new(OutStream_Tell(ix_out)));
+        OutStream_Write_C32(ix_out, num_terms);
+        for (uint32_t j = 0; j < num_terms; j++) {
+            String  *term     = (String*)VA_Fetch(terms, j);
+            ByteBuf *postings = (ByteBuf*)Hash_Fetch(pool, (Obj*)term);
+            size_t   size     = Str_Get_Size(term);
+            OutStream_Write_C32(ix_out, (uint32_t)size);
+            OutStream_Write_Bytes(ix_out, Str_Get_Ptr8(term), size);
+            OutStream_Write_C64(ix_out, (uint64_t)OutStream_Tell(dat_out));
+            S_write_term(dat_out, postings);
+        }
+        DECREF(terms);
+        Hash_Clear(pool);
+    }
+    VA_Push(ivars->runs, (Obj*)run);
+    ivars->mem_consumed = 0;
+}
+
+void
+ImpactWriter_Finish_IMP(ImpactWriter *self) {
+    ImpactWriterIVARS *const ivars = ImpactWriter_IVARS(self);
+    S_flush_run(ivars);
+    if (!VA_Get_Size(ivars->runs)) { return; }
+
+    OutStream_Close(ivars->dat_out);
+    OutStream_Close(ivars->ix_out);
+    DECREF(ivars->dat_out);
+    DECREF(ivars->ix_out);
+    ivars->dat_out = NULL;
+    ivars->ix_out  = NULL;
+
+    Hash *metadata = ImpactWriter_Metadata(self);
+    Hash_Store_Utf8(metadata, "fields", 6, INCREF(ivars->fields));
+    Hash_Store_Utf8(metadata, "runs", 4, INCREF(ivars->runs));
+    Seg_Store_Metadata_Utf8(ivars->segment, "impacts", 7, (Obj*)metadata);
+}
+
+int32_t
+ImpactWriter_Format_IMP(ImpactWriter *self) {
+    UNUSED_VAR(self);
+    return ImpactWriter_current_file_format;
+}
+
@@ -122,6 +122,14 @@ S_check_cutoff(VArray *array, uint32_t tick, void *data) {
     return SegReader_Get_Seg_Num(seg_reader) > cutoff;
 }
 
+static bool
+S_check_del_base(VArray *array, uint32_t tick, void *data) {
+    SegReader *seg_reader = (SegReader*)VA_Fetch(array, tick);
+    DeletionsWriter *del_writer = (DeletionsWriter*)data;
+    return !DelWriter_Hosts_Del_Base(del_writer,
+                                     SegReader_Get_Seg_Name(seg_reader));
+}
+
 static uint32_t
 S_fibonacci(uint32_t n) {
     uint32_t result = 0;
@@ -143,14 +151,19 @@ IxManager_Recycle_IMP(IndexManager *self, PolyReader *reader,
                       bool optimize) {
     VArray *seg_readers = PolyReader_Get_Seg_Readers(reader);
     VArray *candidates  = VA_Gather(seg_readers, S_check_cutoff, &cutoff);
-    VArray *recyclables = VA_new(VA_Get_Size(candidates));
-    const uint32_t num_candidates = VA_Get_Size(candidates);
 
     if (optimize) {
-        DECREF(recyclables);
         return candidates;
     }
 
+    // Spare segments holding deletions bitmaps which other segments still
+    // build on, since recycling them would force those to be rewritten.
+    VArray *keepers = VA_Gather(candidates, S_check_del_base, del_writer);
+    DECREF(candidates);
+    candidates = keepers;
+    VArray *recyclables = VA_new(VA_Get_Size(candidates));
+    const uint32_t num_candidates = VA_Get_Size(candidates);
+
     // Sort by ascending size in docs, choose sparsely populated segments.
     VA_Sort(candidates, S_compare_doc_count, NULL);
     int32_t *counts = (int32_t*)MALLOCATE(num_candidates * sizeof(int32_t));
@@ -23,6 +23,7 @@
 #include "Lucy/Plan/FieldType.h"
 #include "Lucy/Plan/FullTextType.h"
 #include "Lucy/Plan/Schema.h"
+#include "Lucy/Index/CommitGroup.h"
 #include "Lucy/Index/DeletionsReader.h"
 #include "Lucy/Index/DeletionsWriter.h"
 #include "Lucy/Index/FilePurger.h"
@@ -38,12 +39,18 @@
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Store/FSFolder.h"
 #include "Lucy/Store/Lock.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFile.h"
+#include "Lucy/Store/RAMFolder.h"
 #include "Lucy/Util/Freezer.h"
 #include "Lucy/Util/IndexFileNames.h"
 #include "Lucy/Util/Json.h"
 
 int32_t Indexer_CREATE   = 0x00000001;
 int32_t Indexer_TRUNCATE = 0x00000002;
+int32_t Indexer_NEAR_REAL_TIME = 0x00000004;
+int32_t Indexer_DURABLE        = 0x00000008;
 
 // Release the write lock - if it's there.
 static void
@@ -79,11 +86,21 @@ Indexer_init(Indexer *self, Schema *schema, Obj *index,
 
     // Init.
     ivars->stock_doc     = Doc_new(NULL, 0);
+    ivars->pending_deletes = Hash_new(0);
+    ivars->update_ticks  = Hash_new(0);
+    ivars->update_docs   = VA_new(0);
+    ivars->nrt_folder    = (flags & Indexer_NEAR_REAL_TIME)
+                           ? RAMFolder_new(NULL)
+                           : NULL;
+    ivars->nrt_indexer   = NULL;
     ivars->truncate      = false;
     ivars->optimize      = false;
     ivars->prepared      = false;
+    ivars->published     = false;
     ivars->needs_commit  = false;
+    ivars->durable       = (flags & Indexer_DURABLE) ? true : false;
     ivars->snapfile      = NULL;
+    ivars->sync_paths    = VA_new(3);
     ivars->merge_lock    = NULL;
 
     // Assign.
@@ -229,6 +246,11 @@ Indexer_Destroy_IMP(Indexer *self) {
     DECREF(ivars->segment);
     DECREF(ivars->manager);
     DECREF(ivars->stock_doc);
+    DECREF(ivars->pending_deletes);
+    DECREF(ivars->update_ticks);
+    DECREF(ivars->update_docs);
+    DECREF(ivars->nrt_indexer);
+    DECREF(ivars->nrt_folder);
     DECREF(ivars->polyreader);
     DECREF(ivars->del_writer);
     DECREF(ivars->snapshot);
@@ -236,6 +258,7 @@ Indexer_Destroy_IMP(Indexer *self) {
     DECREF(ivars->file_purger);
     DECREF(ivars->write_lock);
     DECREF(ivars->snapfile);
+    DECREF(ivars->sync_paths);
     SUPER_DESTROY(self, INDEXER);
 }
 
@@ -267,14 +290,119 @@ S_init_folder(Obj *index, bool create) {
     return folder;
 }
 
+// Return the Indexer for the in-memory index, opening it if necessary.
+static Indexer*
+S_nrt_indexer(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    if (!ivars->nrt_indexer) {
+        ivars->nrt_indexer = Indexer_new(ivars->schema,
+                                         (Obj*)ivars->nrt_folder, NULL, 0);
+    }
+    return ivars->nrt_indexer;
+}
+
 void
 Indexer_Add_Doc_IMP(Indexer *self, Doc *doc, float boost) {
     IndexerIVARS *const ivars = Indexer_IVARS(self);
-    SegWriter_Add_Doc(ivars->seg_writer, doc, boost);
+    if (ivars->nrt_folder) {
+        // Buffer the doc in the in-memory index.
+        Indexer_Add_Doc(S_nrt_indexer(self), doc, boost);
+    }
+    else {
+        SegWriter_Add_Doc(ivars->seg_writer, doc, boost);
+    }
 }
 
-void
-Indexer_Delete_By_Term_IMP(Indexer *self, String *field, Obj *term) {
+// Commit docs buffered in the in-memory index.  Return true if the
+// in-memory index holds any data.
+static bool
+S_flush_nrt_docs(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    if (ivars->nrt_indexer) {
+        Indexer_Commit(ivars->nrt_indexer);
+        DECREF(ivars->nrt_indexer);
+        ivars->nrt_indexer = NULL;
+    }
+    String *snapfile = IxFileNames_latest_snapshot((Folder*)ivars->nrt_folder);
+    bool has_data = snapfile != NULL;
+    DECREF(snapfile);
+    return has_data;
+}
+
+// Hand deletions buffered by Update_Doc() to the DeletionsWriter.
+static void
+S_apply_pending_deletes(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    if (Hash_Get_Size(ivars->pending_deletes)) {
+        String *field;
+        VArray *keys;
+        Hash_Iterate(ivars->pending_deletes);
+        while (Hash_Next(ivars->pending_deletes, (Obj**)&field,
+                         (Obj**)&keys)) {
+            DelWriter_Delete_By_Terms(ivars->del_writer, field, keys);
+        }
+        Hash_Clear(ivars->pending_deletes);
+    }
+}
+
+PolyReader*
+Indexer_Open_Reader_IMP(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    if (!ivars->nrt_folder) {
+        THROW(ERR, "Open_Reader() requires the NEAR_REAL_TIME flag");
+    }
+    if (ivars->prepared) {
+        THROW(ERR, "Can't call Open_Reader() after Prepare_Commit()");
+    }
+    S_apply_pending_deletes(self);
+
+    // Open fresh readers for the committed segments, since the Indexer's
+    // own get closed by Prepare_Commit().  Overlay uncommitted deletions.
+    VArray *committed = PolyReader_Get_Seg_Readers(ivars->polyreader);
+    VArray *sub_readers = VA_new(VA_Get_Size(committed));
+    for (uint32_t i = 0, max = VA_Get_Size(committed); i < max; i++) {
+        SegReader *old_reader = (SegReader*)VA_Fetch(committed, i);
+        SegReader *seg_reader
+            = SegReader_new(ivars->schema,
+                            SegReader_Get_Folder(old_reader),
+                            SegReader_Get_Snapshot(old_reader),
+                            SegReader_Get_Segments(old_reader),
+                            SegReader_Get_Seg_Tick(old_reader));
+        String *seg_name = SegReader_Get_Seg_Name(old_reader);
+        if (DelWriter_Seg_Del_Count(ivars->del_writer, seg_name)
+            != SegReader_Del_Count(seg_reader)
+           ) {
+            Matcher *deletions
+                = DelWriter_Seg_Deletions(ivars->del_writer, old_reader);
+            SegReader_Override_Deletions(
+                seg_reader,
+                (DeletionsReader*)RAMDelReader_new(
+                    deletions, SegReader_Doc_Max(seg_reader)));
+            DECREF(deletions);
+        }
+        VA_Push(sub_readers, (Obj*)seg_reader);
+    }
+
+    // Add segments holding the docs added so far.
+    if (S_flush_nrt_docs(self)) {
+        PolyReader *nrt_reader
+            = PolyReader_open((Obj*)ivars->nrt_folder, NULL, NULL);
+        VArray *nrt_seg_readers = PolyReader_Get_Seg_Readers(nrt_reader);
+        for (uint32_t i = 0, max = VA_Get_Size(nrt_seg_readers); i < max; i++) {
+            VA_Push(sub_readers, INCREF(VA_Fetch(nrt_seg_readers, i)));
+        }
+        DECREF(nrt_reader);
+    }
+
+    PolyReader *reader = PolyReader_new(ivars->schema, ivars->folder, NULL,
+                                        NULL, sub_readers);
+    DECREF(sub_readers);
+    return reader;
+}
+
+// Return the indexed form of a term, or NULL if analysis leaves nothing.
+static Obj*
+S_analyze_term(Indexer *self, String *field, Obj *term) {
     IndexerIVARS *const ivars = Indexer_IVARS(self);
     Schema    *schema = ivars->schema;
     FieldType *type   = Schema_Fetch_Type(schema, field);
@@ -284,23 +412,105 @@ Indexer_Delete_By_Term_IMP(Indexer *self, String *field, Obj *term) {
         THROW(ERR, "%o is not an indexed field", field);
     }
 
-    // Analyze term if appropriate, then zap.
+    // Analyze term if appropriate.
     if (FType_Is_A(type, FULLTEXTTYPE)) {
         CERTIFY(term, STRING);
         Analyzer *analyzer = Schema_Fetch_Analyzer(schema, field);
         VArray *terms = Analyzer_Split(analyzer, (String*)term);
-        Obj *analyzed_term = VA_Fetch(terms, 0);
-        if (analyzed_term) {
-            DelWriter_Delete_By_Term(ivars->del_writer, field,
-                                     analyzed_term);
-        }
+        Obj *analyzed_term = INCREF(VA_Fetch(terms, 0));
         DECREF(terms);
+        return analyzed_term;
     }
     else {
-        DelWriter_Delete_By_Term(ivars->del_writer, field, term);
+        return INCREF(term);
+    }
+}
+
+void
+Indexer_Delete_By_Term_IMP(Indexer *self, String *field, Obj *term) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    Obj *analyzed_term = S_analyze_term(self, field, term);
+    if (analyzed_term) {
+        DelWriter_Delete_By_Term(ivars->del_writer, field, analyzed_term);
+        DECREF(analyzed_term);
     }
 }
 
+void
+Indexer_Update_Doc_IMP(Indexer *self, String *field, Doc *doc, float boost) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    Obj *key = Doc_Extract(doc, field);
+    if (!key) {
+        THROW(ERR, "Doc has no value for key field '%o'", field);
+    }
+    Obj *analyzed_key = S_analyze_term(self, field, key);
+    DECREF(key);
+
+    // Buffer the key.  Deletions only affect previously committed segments,
+    // so it's safe to defer them until Prepare_Commit().
+    if (!analyzed_key) {
+        Indexer_Add_Doc(self, doc, boost);
+        return;
+    }
+    VArray *keys = (VArray*)Hash_Fetch(ivars->pending_deletes, (Obj*)field);
+    if (!keys) {
+        keys = VA_new(0);
+        Hash_Store(ivars->pending_deletes, (Obj*)field, (Obj*)keys);
+    }
+    VA_Push(keys, INCREF(analyzed_key));
+
+    // The in-memory index applies its own buffered keys each time it's
+    // flushed, which replaces versions added before the last Open_Reader().
+    if (ivars->nrt_folder) {
+        Indexer_Update_Doc(S_nrt_indexer(self), field, doc, boost);
+        DECREF(analyzed_key);
+        return;
+    }
+
+    // Deletions can't reach docs added to the new segment, so hold the doc
+    // back until Prepare_Commit().  A later update to the same key takes
+    // its place.
+    RAMFile   *file      = RAMFile_new(NULL, false);
+    OutStream *outstream = OutStream_open((Obj*)file);
+    Doc_Serialize(doc, outstream);
+    OutStream_Write_F32(outstream, boost);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    Hash *ticks = (Hash*)Hash_Fetch(ivars->update_ticks, (Obj*)field);
+    if (!ticks) {
+        ticks = Hash_new(0);
+        Hash_Store(ivars->update_ticks, (Obj*)field, (Obj*)ticks);
+    }
+    Obj *tick = Hash_Fetch(ticks, analyzed_key);
+    if (tick) {
+        VA_Store(ivars->update_docs, (uint32_t)Obj_To_I64(tick), (Obj*)file);
+    }
+    else {
+        tick = (Obj*)Int32_new((int32_t)VA_Get_Size(ivars->update_docs));
+        Hash_Store(ticks, analyzed_key, tick);
+        VA_Push(ivars->update_docs, (Obj*)file);
+    }
+    DECREF(analyzed_key);
+}
+
+// Add the docs held back by Update_Doc().
+static void
+S_add_pending_updates(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->update_docs); i < max; i++) {
+        RAMFile  *file     = (RAMFile*)VA_Fetch(ivars->update_docs, i);
+        InStream *instream = InStream_open((Obj*)file);
+        Doc *doc = (Doc*)VTable_Make_Obj(DOC);
+        doc = Doc_Deserialize(doc, instream);
+        float boost = InStream_Read_F32(instream);
+        SegWriter_Add_Doc(ivars->seg_writer, doc, boost);
+        DECREF(doc);
+        DECREF(instream);
+    }
+    VA_Clear(ivars->update_docs);
+    Hash_Clear(ivars->update_ticks);
+}
+
 void
 Indexer_Delete_By_Query_IMP(Indexer *self, Query *query) {
     IndexerIVARS *const ivars = Indexer_IVARS(self);
@@ -490,6 +700,20 @@ Indexer_Prepare_Commit_IMP(Indexer *self) {
         THROW(ERR, "Can't call Prepare_Commit() more than once");
     }
 
+    // Absorb docs buffered for near-real-time search.
+    if (ivars->nrt_folder && S_flush_nrt_docs(self)) {
+        Indexer_Add_Index(self, (Obj*)ivars->nrt_folder);
+    }
+
+    // Add the latest version of each doc replaced by Update_Doc(), then
+    // assign doc ids to any docs held back by an index sort.
+    S_add_pending_updates(self);
+    SegWriter_Flush_Sorted_Docs(ivars->seg_writer);
+
+    // Apply buffered deletions from Update_Doc() before merging, so that
+    // merged segments don't carry replaced docs forward.
+    S_apply_pending_deletes(self);
+
     // Merge existing index data.
     if (num_seg_readers) {
         merge_happened = S_maybe_merge(self, seg_readers);
@@ -523,12 +747,19 @@ Indexer_Prepare_Commit_IMP(Indexer *self) {
             Snapshot_Delete_Entry(snapshot, old_schema_name);
         }
         Snapshot_Add_Entry(snapshot, new_schema_name);
-        DECREF(new_schema_name);
 
         // Write temporary snapshot file.
         Folder_Delete(folder, ivars->snapfile);
         Snapshot_Write_File(snapshot, folder, ivars->snapfile);
 
+        // Record everything written, in case the commit must be synced.
+        String *seg_name = Seg_Get_Name(ivars->segment);
+        if (Folder_Exists(folder, seg_name)) {
+            VA_Push(ivars->sync_paths, (Obj*)Str_Clone(seg_name));
+        }
+        VA_Push(ivars->sync_paths, (Obj*)new_schema_name);
+        VA_Push(ivars->sync_paths, (Obj*)Str_Clone(ivars->snapfile));
+
         ivars->needs_commit = true;
     }
 
@@ -547,9 +778,40 @@ Indexer_Commit_IMP(Indexer *self) {
         THROW(ERR, "Can't call commit() more than once");
     }
 
+    if (ivars->durable) {
+        CommitGroup *group = CommitGroup_new();
+        CommitGroup_Add(group, self);
+        CommitGroup_Commit(group);
+        DECREF(group);
+    }
+    else {
+        if (!ivars->prepared) {
+            Indexer_Prepare_Commit(self);
+        }
+        Indexer_Publish(self);
+        Indexer_Release(self);
+    }
+}
+
+VArray*
+Indexer_Sync_Paths_IMP(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    if (!ivars->write_lock) {
+        THROW(ERR, "Indexer has already committed");
+    }
     if (!ivars->prepared) {
         Indexer_Prepare_Commit(self);
     }
+    return ivars->needs_commit ? ivars->sync_paths : NULL;
+}
+
+void
+Indexer_Publish_IMP(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+
+    if (!ivars->write_lock || !ivars->prepared || ivars->published) {
+        THROW(ERR, "Can't publish a commit which hasn't been prepared");
+    }
 
     if (ivars->needs_commit) {
         bool success;
@@ -567,8 +829,20 @@ Indexer_Commit_IMP(Indexer *self) {
         success = Folder_Rename(ivars->folder, temp_snapfile, ivars->snapfile);
         DECREF(temp_snapfile);
         if (!success) { RETHROW(INCREF(Err_get_error())); }
+    }
+    ivars->published = true;
+}
+
+void
+Indexer_Release_IMP(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
 
-        // Purge obsolete files.
+    if (!ivars->write_lock || !ivars->published) {
+        THROW(ERR, "Can't release a commit which hasn't been published");
+    }
+
+    // Purge obsolete files.
+    if (ivars->needs_commit) {
         FilePurger_Purge(ivars->file_purger);
     }
 
@@ -592,6 +866,11 @@ Indexer_Get_Stock_Doc_IMP(Indexer *self) {
     return Indexer_IVARS(self)->stock_doc;
 }
 
+Folder*
+Indexer_Get_Folder_IMP(Indexer *self) {
+    return Indexer_IVARS(self)->folder;
+}
+
 static void
 S_release_write_lock(Indexer *self) {
     IndexerIVARS *const ivars = Indexer_IVARS(self);
@@ -20,6 +20,7 @@
 
 #include "Lucy/Index/Inverter.h"
 #include "Lucy/Analysis/Analyzer.h"
+#include "Lucy/Analysis/CommonGramsFilter.h"
 #include "Lucy/Analysis/Token.h"
 #include "Lucy/Analysis/Inversion.h"
 #include "Lucy/Document/Doc.h"
@@ -161,6 +162,13 @@ Inverter_Add_Field_IMP(Inverter *self, InverterEntry *entry) {
         entry_ivars->inversion
             = Analyzer_Transform_Text(entry_ivars->analyzer,
                                       (String*)entry_ivars->value);
+        if (entry_ivars->common_grams) {
+            Inversion *with_grams
+                = CommonGrams_Transform(entry_ivars->common_grams,
+                                        entry_ivars->inversion);
+            DECREF(entry_ivars->inversion);
+            entry_ivars->inversion = with_grams;
+        }
         Inversion_Invert(entry_ivars->inversion);
     }
     else if (entry_ivars->indexed || entry_ivars->highlightable) {
@@ -244,6 +252,8 @@ InvEntry_init(InverterEntry *self, Schema *schema, String *field,
         if (FType_Is_A(ivars->type, FULLTEXTTYPE)) {
             ivars->highlightable
                 = FullTextType_Highlightable((FullTextType*)ivars->type);
+            ivars->common_grams = (CommonGramsFilter*)INCREF(
+                FullTextType_Get_Common_Grams((FullTextType*)ivars->type));
         }
     }
     return self;
@@ -255,6 +265,7 @@ InvEntry_Destroy_IMP(InverterEntry *self) {
     DECREF(ivars->field);
     DECREF(ivars->value);
     DECREF(ivars->analyzer);
+    DECREF(ivars->common_grams);
     DECREF(ivars->type);
     DECREF(ivars->sim);
     DECREF(ivars->inversion);
@@ -0,0 +1,192 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_KEYFILTERREADER
+#define C_LUCY_DEFAULTKEYFILTERREADER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/KeyFilterReader.h"
+#include "Lucy/Index/KeyFilterWriter.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/Snapshot.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/InStream.h"
+
+// Read a length-prefixed string.
+static String*
+S_read_string(InStream *instream);
+
+KeyFilterReader*
+KeyFilterReader_init(KeyFilterReader *self, Schema *schema, Folder *folder,
+                     Snapshot *snapshot, VArray *segments, int32_t seg_tick) {
+    DataReader_init((DataReader*)self, schema, folder, snapshot, segments,
+                    seg_tick);
+    ABSTRACT_CLASS_CHECK(self, KEYFILTERREADER);
+    return self;
+}
+
+DataReader*
+KeyFilterReader_Aggregator_IMP(KeyFilterReader *self, VArray *readers,
+                               I32Array *offsets) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(readers);
+    UNUSED_VAR(offsets);
+    return NULL;
+}
+
+DefaultKeyFilterReader*
+DefKeyFilterReader_new(Schema *schema, Folder *folder, Snapshot *snapshot,
+                       VArray *segments, int32_t seg_tick) {
+    DefaultKeyFilterReader *self
+        = (DefaultKeyFilterReader*)VTable_Make_Obj(DEFAULTKEYFILTERREADER);
+    return DefKeyFilterReader_init(self, schema, folder, snapshot, segments,
+                                   seg_tick);
+}
+
+DefaultKeyFilterReader*
+DefKeyFilterReader_init(DefaultKeyFilterReader *self, Schema *schema,
+                        Folder *folder, Snapshot *snapshot, VArray *segments,
+                        int32_t seg_tick) {
+    KeyFilterReader_init((KeyFilterReader*)self, schema, folder, snapshot,
+                         segments, seg_tick);
+    DefaultKeyFilterReaderIVARS *const ivars = DefKeyFilterReader_IVARS(self);
+    Segment *segment  = DefKeyFilterReader_Get_Segment(self);
+    Hash    *metadata
+        = (Hash*)Seg_Fetch_Metadata_Utf8(segment, "keyfilter", 9);
+
+    // Init.
+    ivars->fields     = Hash_new(0);
+    ivars->mins       = VA_new(0);
+    ivars->maxes      = VA_new(0);
+    ivars->filters    = VA_new(0);
+    ivars->num_hashes = 0;
+
+    // Segments written without any key fields have nothing to read.
+    if (!metadata) { return self; }
+    CERTIFY(metadata, HASH);
+
+    // Check format.
+    Obj *format = Hash_Fetch_Utf8(metadata, "format", 6);
+    if (!format) { THROW(ERR, "Missing 'format' var"); }
+    if (Obj_To_I64(format) > KeyFilterWriter_current_file_format) {
+        THROW(ERR, "Unsupported key filter format: %i64",
+              Obj_To_I64(format));
+    }
+
+    // Extract metadata.
+    VArray *fields
+        = (VArray*)CERTIFY(Hash_Fetch_Utf8(metadata, "fields", 6), VARRAY);
+    Obj *num_hashes
+        = CERTIFY(Hash_Fetch_Utf8(metadata, "num_hashes", 10), OBJ);
+    ivars->num_hashes = (uint32_t)Obj_To_I64(num_hashes);
+
+    // Slurp the bounds and filters.
+    String *seg_name = Seg_Get_Name(segment);
+    String *dat_file = Str_newf("%o/keyfilter.dat", seg_name);
+    InStream *dat_in = Folder_Open_In(folder, dat_file);
+    DECREF(dat_file);
+    if (!dat_in) {
+        Err *error = (Err*)INCREF(Err_get_error());
+        DECREF(self);
+        RETHROW(error);
+    }
+    for (uint32_t i = 0, max = VA_Get_Size(fields); i < max; i++) {
+        String   *field     = (String*)VA_Fetch(fields, i);
+        uint64_t  num_words = InStream_Read_C64(dat_in);
+        Hash_Store(ivars->fields, (Obj*)field, (Obj*)Int32_new((int32_t)i));
+        if (!num_words) { continue; }
+        VA_Store(ivars->mins, i, (Obj*)S_read_string(dat_in));
+        VA_Store(ivars->maxes, i, (Obj*)S_read_string(dat_in));
+        ByteBuf  *filter = BB_new((size_t)num_words * sizeof(uint64_t));
+        uint64_t *words  = (uint64_t*)BB_Get_Buf(filter);
+        for (uint64_t j = 0; j < num_words; j++) {
+            words[j] = InStream_Read_U64(dat_in);
+        }
+        BB_Set_Size(filter, (size_t)num_words * sizeof(uint64_t));
+        VA_Store(ivars->filters, i, (Obj*)filter);
+    }
+    InStream_Close(dat_in);
+    DECREF(dat_in);
+
+    return self;
+}
+
+static String*
+S_read_string(InStream *instream) {
+    uint32_t size = InStream_Read_C32(instream);
+    char *ptr = (char*)MALLOCATE(size + 1);
+    InStream_Read_Bytes(instream, ptr, size);
+    ptr[size] = '\0';
+    return Str_new_steal_trusted_utf8(ptr, size);
+}
+
+void
+DefKeyFilterReader_Close_IMP(DefaultKeyFilterReader *self) {
+    // Forget all filters, so that every lookup conservatively passes.
+    DefaultKeyFilterReaderIVARS *const ivars = DefKeyFilterReader_IVARS(self);
+    Hash_Clear(ivars->fields);
+    VA_Clear(ivars->mins);
+    VA_Clear(ivars->maxes);
+    VA_Clear(ivars->filters);
+}
+
+void
+DefKeyFilterReader_Destroy_IMP(DefaultKeyFilterReader *self) {
+    DefaultKeyFilterReaderIVARS *const ivars = DefKeyFilterReader_IVARS(self);
+    DECREF(ivars->fields);
+    DECREF(ivars->mins);
+    DECREF(ivars->maxes);
+    DECREF(ivars->filters);
+    SUPER_DESTROY(self, DEFAULTKEYFILTERREADER);
+}
+
+bool
+DefKeyFilterReader_Might_Contain_IMP(DefaultKeyFilterReader *self,
+                                     String *field, Obj *term) {
+    DefaultKeyFilterReaderIVARS *const ivars = DefKeyFilterReader_IVARS(self);
+    Obj *tick_obj = Hash_Fetch(ivars->fields, (Obj*)field);
+    if (!tick_obj || !term || !Obj_Is_A(term, STRING)) { return true; }
+    uint32_t tick = (uint32_t)Obj_To_I64(tick_obj);
+
+    // No keys at all?
+    ByteBuf *filter = (ByteBuf*)VA_Fetch(ivars->filters, tick);
+    if (!filter) { return false; }
+
+    // Out of bounds?
+    String *key = (String*)term;
+    if (Str_Compare_To((String*)VA_Fetch(ivars->mins, tick), term) > 0
+        || Str_Compare_To((String*)VA_Fetch(ivars->maxes, tick), term) < 0
+       ) {
+        return false;
+    }
+
+    // Probe the Bloom filter.
+    const uint64_t *words    = (const uint64_t*)BB_Get_Buf(filter);
+    const uint64_t  num_bits = BB_Get_Size(filter) * 8;
+    const uint64_t  hash     = KeyFilterWriter_hash(Str_Get_Ptr8(key),
+                                                    Str_Get_Size(key));
+    const uint64_t  h1       = hash & 0xFFFFFFFF;
+    const uint64_t  h2       = hash >> 32;
+    for (uint32_t k = 0; k < ivars->num_hashes; k++) {
+        uint64_t bit = (h1 + k * h2) % num_bits;
+        if (!(words[bit >> 6] & (UINT64_C(1) << (bit & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
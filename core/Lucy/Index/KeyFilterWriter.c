@@ -0,0 +1,253 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_KEYFILTERWRITER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/KeyFilterWriter.h"
+#include "Lucy/Analysis/Inversion.h"
+#include "Lucy/Analysis/Token.h"
+#include "Lucy/Index/Inverter.h"
+#include "Lucy/Index/Lexicon.h"
+#include "Lucy/Index/LexiconReader.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/Snapshot.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/OutStream.h"
+
+int32_t KeyFilterWriter_current_file_format = 1;
+
+// Return the index of `field` within `fields`, or -1 if it's not there.
+static int32_t
+S_find_field(VArray *fields, String *field);
+
+// Record one key for the field at `tick`.
+static void
+S_add_key(KeyFilterWriterIVARS *ivars, uint32_t tick, const char *ptr,
+          size_t size);
+
+KeyFilterWriter*
+KeyFilterWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
+                    PolyReader *polyreader) {
+    KeyFilterWriter *self
+        = (KeyFilterWriter*)VTable_Make_Obj(KEYFILTERWRITER);
+    return KeyFilterWriter_init(self, schema, snapshot, segment, polyreader);
+}
+
+KeyFilterWriter*
+KeyFilterWriter_init(KeyFilterWriter *self, Schema *schema,
+                     Snapshot *snapshot, Segment *segment,
+                     PolyReader *polyreader) {
+    DataWriter_init((DataWriter*)self, schema, snapshot, segment, polyreader);
+    KeyFilterWriterIVARS *const ivars = KeyFilterWriter_IVARS(self);
+
+    // Derive.  Gather the key fields, in sorted order.
+    VArray *all_fields = Schema_All_Fields(schema);
+    VA_Sort(all_fields, NULL, NULL);
+    ivars->fields = VA_new(0);
+    ivars->hashes = VA_new(0);
+    ivars->mins   = VA_new(0);
+    ivars->maxes  = VA_new(0);
+    for (uint32_t i = 0, max = VA_Get_Size(all_fields); i < max; i++) {
+        String    *field = (String*)VA_Fetch(all_fields, i);
+        FieldType *type  = Schema_Fetch_Type(schema, field);
+        if (FType_Is_A(type, STRINGTYPE)
+            && FType_Indexed(type)
+            && StringType_Key((StringType*)type)
+           ) {
+            VA_Push(ivars->fields, INCREF(field));
+            VA_Push(ivars->hashes, (Obj*)BB_new(0));
+        }
+    }
+    DECREF(all_fields);
+
+    return self;
+}
+
+void
+KeyFilterWriter_Destroy_IMP(KeyFilterWriter *self) {
+    KeyFilterWriterIVARS *const ivars = KeyFilterWriter_IVARS(self);
+    DECREF(ivars->fields);
+    DECREF(ivars->hashes);
+    DECREF(ivars->mins);
+    DECREF(ivars->maxes);
+    SUPER_DESTROY(self, KEYFILTERWRITER);
+}
+
+uint64_t
+KeyFilterWriter_hash(const char *ptr, size_t size) {
+    // 64-bit FNV-1a, followed by a final mix so that both halves are usable.
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)ptr[i];
+        hash *= UINT64_C(0x100000001b3);
+    }
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static int32_t
+S_find_field(VArray *fields, String *field) {
+    for (uint32_t i = 0, max = VA_Get_Size(fields); i < max; i++) {
+        if (Str_Equals(field, VA_Fetch(fields, i))) { return (int32_t)i; }
+    }
+    return -1;
+}
+
+static void
+S_add_key(KeyFilterWriterIVARS *ivars, uint32_t tick, const char *ptr,
+          size_t size) {
+    ByteBuf *hashes = (ByteBuf*)VA_Fetch(ivars->hashes, tick);
+    uint64_t hash   = KeyFilterWriter_hash(ptr, size);
+    BB_Cat_Bytes(hashes, &hash, sizeof(uint64_t));
+
+    StackString *key = SSTR_WRAP_UTF8(ptr, size);
+    String *min = (String*)VA_Fetch(ivars->mins, tick);
+    String *max = (String*)VA_Fetch(ivars->maxes, tick);
+    if (!min || Str_Compare_To(min, (Obj*)key) > 0) {
+        VA_Store(ivars->mins, tick, (Obj*)Str_new_from_trusted_utf8(ptr, size));
+    }
+    if (!max || Str_Compare_To(max, (Obj*)key) < 0) {
+        VA_Store(ivars->maxes, tick,
+                 (Obj*)Str_new_from_trusted_utf8(ptr, size));
+    }
+}
+
+void
+KeyFilterWriter_Add_Inverted_Doc_IMP(KeyFilterWriter *self,
+                                     Inverter *inverter, int32_t doc_id) {
+    KeyFilterWriterIVARS *const ivars = KeyFilterWriter_IVARS(self);
+    UNUSED_VAR(doc_id);
+    if (!VA_Get_Size(ivars->fields)) { return; }
+
+    Inverter_Iterate(inverter);
+    while (Inverter_Next(inverter)) {
+        int32_t tick = S_find_field(ivars->fields,
+                                    Inverter_Get_Field_Name(inverter));
+        if (tick < 0) { continue; }
+        Inversion *inversion = Inverter_Get_Inversion(inverter);
+        Token *token;
+        Inversion_Reset(inversion);
+        while ((token = Inversion_Next(inversion)) != NULL) {
+            S_add_key(ivars, (uint32_t)tick, Token_Get_Text(token),
+                      Token_Get_Len(token));
+        }
+    }
+}
+
+void
+KeyFilterWriter_Add_Segment_IMP(KeyFilterWriter *self, SegReader *reader,
+                                I32Array *doc_map) {
+    KeyFilterWriterIVARS *const ivars = KeyFilterWriter_IVARS(self);
+    LexiconReader *lex_reader
+        = (LexiconReader*)SegReader_Fetch(reader,
+                                          VTable_Get_Name(LEXICONREADER));
+    UNUSED_VAR(doc_map);
+    if (!lex_reader) { return; }
+
+    // Read the keys back from the old segment's lexicon.  Keys which belong
+    // only to deleted docs are carried along too; they cost a little filter
+    // space but never cause a key to be missed.
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->fields); i < max; i++) {
+        String  *field   = (String*)VA_Fetch(ivars->fields, i);
+        Lexicon *lexicon = LexReader_Lexicon(lex_reader, field, NULL);
+        if (!lexicon) { continue; }
+        while (Lex_Next(lexicon)) {
+            String *key = (String*)CERTIFY(Lex_Get_Term(lexicon), STRING);
+            S_add_key(ivars, i, Str_Get_Ptr8(key), Str_Get_Size(key));
+        }
+        DECREF(lexicon);
+    }
+}
+
+void
+KeyFilterWriter_Finish_IMP(KeyFilterWriter *self) {
+    KeyFilterWriterIVARS *const ivars = KeyFilterWriter_IVARS(self);
+    const uint32_t num_fields = VA_Get_Size(ivars->fields);
+    bool has_keys = false;
+    for (uint32_t i = 0; i < num_fields; i++) {
+        if (BB_Get_Size((ByteBuf*)VA_Fetch(ivars->hashes, i))) {
+            has_keys = true;
+        }
+    }
+    if (!has_keys) { return; }
+
+    // Open outstream.
+    Folder *folder   = ivars->folder;
+    String *seg_name = Seg_Get_Name(ivars->segment);
+    String *dat_file = Str_newf("%o/keyfilter.dat", seg_name);
+    OutStream *dat_out = Folder_Open_Out(folder, dat_file);
+    DECREF(dat_file);
+    if (!dat_out) { RETHROW(INCREF(Err_get_error())); }
+
+    // For each field, write the bounds followed by the filter's bit words.
+    for (uint32_t i = 0; i < num_fields; i++) {
+        ByteBuf  *hashes   = (ByteBuf*)VA_Fetch(ivars->hashes, i);
+        uint64_t *elems    = (uint64_t*)BB_Get_Buf(hashes);
+        size_t    num_keys = BB_Get_Size(hashes) / sizeof(uint64_t);
+        size_t    num_bits = num_keys * KEYFILTERWRITER_BITS_PER_KEY;
+        size_t    num_words = (num_bits + 63) / 64;
+        OutStream_Write_C64(dat_out, (uint64_t)num_words);
+        if (!num_words) { continue; }
+        num_bits = num_words * 64;
+
+        String *bounds[2];
+        bounds[0] = (String*)VA_Fetch(ivars->mins, i);
+        bounds[1] = (String*)VA_Fetch(ivars->maxes, i);
+        for (int j = 0; j < 2; j++) {
+            size_t size = Str_Get_Size(bounds[j]);
+            OutStream_Write_C32(dat_out, (uint32_t)size);
+            OutStream_Write_Bytes(dat_out, Str_Get_Ptr8(bounds[j]), size);
+        }
+
+        uint64_t *words = (uint64_t*)CALLOCATE(num_words, sizeof(uint64_t));
+        for (size_t j = 0; j < num_keys; j++) {
+            uint64_t h1 = elems[j] & 0xFFFFFFFF;
+            uint64_t h2 = elems[j] >> 32;
+            for (uint32_t k = 0; k < KEYFILTERWRITER_NUM_HASHES; k++) {
+                uint64_t bit = (h1 + k * h2) % num_bits;
+                words[bit >> 6] |= UINT64_C(1) << (bit & 63);
+            }
+        }
+        for (size_t j = 0; j < num_words; j++) {
+            OutStream_Write_U64(dat_out, words[j]);
+        }
+        FREEMEM(words);
+    }
+
+    OutStream_Close(dat_out);
+    DECREF(dat_out);
+
+    Hash *metadata = KeyFilterWriter_Metadata(self);
+    Hash_Store_Utf8(metadata, "fields", 6, INCREF(ivars->fields));
+    Hash_Store_Utf8(metadata, "num_hashes", 10,
+                    (Obj*)Str_newf("%i32",
+                                   (int32_t)KEYFILTERWRITER_NUM_HASHES));
+    Seg_Store_Metadata_Utf8(ivars->segment, "keyfilter", 9, (Obj*)metadata);
+}
+
+int32_t
+KeyFilterWriter_Format_IMP(KeyFilterWriter *self) {
+    UNUSED_VAR(self);
+    return KeyFilterWriter_current_file_format;
+}
+
@@ -0,0 +1,595 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_POINTREADER
+#define C_LUCY_DEFAULTPOINTREADER
+#include "Lucy/Util/ToolSet.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "Lucy/Index/PointReader.h"
+#include "Lucy/Index/PointWriter.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/Snapshot.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Plan/FieldType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/InStream.h"
+
+#define SIGN_BIT UINT64_C(0x8000000000000000)
+
+// State for a single Find_Box() traversal.
+typedef struct {
+    DefaultPointReaderIVARS *ivars;
+    BitVector *result;
+    uint64_t  *lower;
+    uint64_t  *upper;
+    bool      *constrained;
+    int32_t   *doc_ids;
+    uint64_t  *keys;
+    uint8_t   *missing;
+} PointSearch;
+
+// Visit a cell of the tree whose first node is at `node_base` and whose
+// first leaf is `leaf_base`, pruning the cell if it misses the box,
+// collecting it wholesale if it lies within the box, and otherwise
+// descending into it.
+static void
+S_visit(PointSearch *search, uint32_t node_base, uint32_t leaf_base,
+        uint32_t num_leaves, uint32_t node);
+
+// Read a leaf's doc ids and, optionally, its keys (grouped by dimension).
+static uint32_t
+S_read_leaf(DefaultPointReaderIVARS *ivars, uint32_t leaf, int32_t *doc_ids,
+            uint64_t *keys, uint8_t *missing);
+
+// Turn a bound on an integer field which isn't itself an integer into an
+// inclusive integer bound.
+static bool
+S_int_bound_from_f64(double bound, bool upper, bool inclusive,
+                     int64_t *result);
+
+PointReader*
+PointReader_init(PointReader *self, Schema *schema, Folder *folder,
+                 Snapshot *snapshot, VArray *segments, int32_t seg_tick) {
+    DataReader_init((DataReader*)self, schema, folder, snapshot, segments,
+                    seg_tick);
+    ABSTRACT_CLASS_CHECK(self, POINTREADER);
+    return self;
+}
+
+DataReader*
+PointReader_Aggregator_IMP(PointReader *self, VArray *readers,
+                           I32Array *offsets) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(readers);
+    UNUSED_VAR(offsets);
+    return NULL;
+}
+
+static uint64_t
+S_f64_key(double value) {
+    // Adding zero turns -0.0 into 0.0, which compares equal.
+    double   f64 = value + 0.0;
+    uint64_t bits;
+    memcpy(&bits, &f64, sizeof(bits));
+    return bits & SIGN_BIT ? ~bits : bits | SIGN_BIT;
+}
+
+static CFISH_INLINE uint64_t
+SI_i64_key(int64_t value) {
+    // Flip the sign bit so that negatives sort first.
+    return (uint64_t)value ^ SIGN_BIT;
+}
+
+uint64_t
+PointReader_encode_value(FieldType *type, Obj *value) {
+    switch (FType_Primitive_ID(type) & FType_PRIMITIVE_ID_MASK) {
+        case FType_INT32:
+        case FType_INT64:
+            return SI_i64_key(Obj_To_I64(value));
+        case FType_FLOAT32:
+            return S_f64_key((double)(float)Obj_To_F64(value));
+        case FType_FLOAT64:
+            return S_f64_key(Obj_To_F64(value));
+        default:
+            THROW(ERR, "Not a numeric type: %o", FType_Get_Class_Name(type));
+            UNREACHABLE_RETURN(uint64_t);
+    }
+}
+
+// Indicate whether `bound` should be treated as an integer.  Bounds which
+// went through Dump/Load may have become strings.
+static bool
+S_is_integral(Obj *bound) {
+    if (Obj_Is_A(bound, INTNUM)) { return true; }
+    if (Obj_Is_A(bound, FLOATNUM)) { return false; }
+    return (double)Obj_To_I64(bound) == Obj_To_F64(bound);
+}
+
+bool
+PointReader_encode_bound(FieldType *type, Obj *bound, bool upper,
+                         bool inclusive, uint64_t *key) {
+    if (!bound) {
+        *key = upper ? UINT64_MAX : 0;
+        return true;
+    }
+
+    switch (FType_Primitive_ID(type) & FType_PRIMITIVE_ID_MASK) {
+        case FType_INT32:
+        case FType_INT64: {
+                int64_t value;
+                if (!S_is_integral(bound)) {
+                    if (!S_int_bound_from_f64(Obj_To_F64(bound), upper,
+                                              inclusive, &value)) {
+                        return false;
+                    }
+                }
+                else {
+                    value = Obj_To_I64(bound);
+                    if (!inclusive) {
+                        if (upper) {
+                            if (value == INT64_MIN) { return false; }
+                            value--;
+                        }
+                        else {
+                            if (value == INT64_MAX) { return false; }
+                            value++;
+                        }
+                    }
+                }
+                *key = SI_i64_key(value);
+                return true;
+            }
+        case FType_FLOAT32:
+        case FType_FLOAT64: {
+                double value = Obj_To_F64(bound);
+                if (isnan(value)) { return false; }
+                if ((FType_Primitive_ID(type) & FType_PRIMITIVE_ID_MASK)
+                    == FType_FLOAT32
+                   ) {
+                    value = (double)(float)value;
+                }
+                *key = S_f64_key(value);
+                // Keys of adjacent values are adjacent, so stepping the key
+                // steps to the next value.  -0.0 and 0.0 share a key.
+                if (!inclusive) {
+                    if (upper) {
+                        if (*key == 0) { return false; }
+                        (*key)--;
+                    }
+                    else {
+                        if (*key == UINT64_MAX) { return false; }
+                        (*key)++;
+                    }
+                }
+                return true;
+            }
+        default:
+            THROW(ERR, "Not a numeric type: %o", FType_Get_Class_Name(type));
+            UNREACHABLE_RETURN(bool);
+    }
+}
+
+static bool
+S_int_bound_from_f64(double bound, bool upper, bool inclusive,
+                     int64_t *result) {
+    // 2^63, the first double past the range of int64_t.
+    const double limit = 9223372036854775808.0;
+    if (isnan(bound)) { return false; }
+
+    // Round inwards.  An exclusive bound which is already integral must
+    // move one step further, which happens below in integer space, where
+    // the step can't be lost to rounding.
+    double rounded = upper ? floor(bound) : ceil(bound);
+    bool   step    = !inclusive && rounded == bound;
+    if (rounded >= limit) {
+        if (!upper) { return false; }
+        *result = INT64_MAX;
+        return true;
+    }
+    if (rounded < -limit) {
+        if (upper) { return false; }
+        *result = INT64_MIN;
+        return true;
+    }
+    int64_t value = (int64_t)rounded;
+    if (step) {
+        if (upper) {
+            if (value == INT64_MIN) { return false; }
+            value--;
+        }
+        else {
+            if (value == INT64_MAX) { return false; }
+            value++;
+        }
+    }
+    *result = value;
+    return true;
+}
+
+DefaultPointReader*
+DefPointReader_new(Schema *schema, Folder *folder, Snapshot *snapshot,
+                   VArray *segments, int32_t seg_tick) {
+    DefaultPointReader *self
+        = (DefaultPointReader*)VTable_Make_Obj(DEFAULTPOINTREADER);
+    return DefPointReader_init(self, schema, folder, snapshot, segments,
+                               seg_tick);
+}
+
+DefaultPointReader*
+DefPointReader_init(DefaultPointReader *self, Schema *schema, Folder *folder,
+                    Snapshot *snapshot, VArray *segments, int32_t seg_tick) {
+    PointReader_init((PointReader*)self, schema, folder, snapshot, segments,
+                     seg_tick);
+    DefaultPointReaderIVARS *const ivars = DefPointReader_IVARS(self);
+    Segment *segment  = DefPointReader_Get_Segment(self);
+    Hash    *metadata = (Hash*)Seg_Fetch_Metadata_Utf8(segment, "points", 6);
+
+    // Init.
+    ivars->fields         = NULL;
+    ivars->dat_in         = NULL;
+    ivars->node_bounds    = NULL;
+    ivars->node_missing   = NULL;
+    ivars->tree_leaves    = NULL;
+    ivars->leaf_offsets   = NULL;
+    ivars->leaf_counts    = NULL;
+    ivars->num_dims       = 0;
+    ivars->num_trees      = 0;
+    ivars->num_leaves     = 0;
+    ivars->max_leaf_count = 0;
+    ivars->count          = 0;
+
+    // Segments written without any point fields have nothing to read.
+    if (!metadata) { return self; }
+    CERTIFY(metadata, HASH);
+
+    // Check format.
+    Obj *format = Hash_Fetch_Utf8(metadata, "format", 6);
+    if (!format) { THROW(ERR, "Missing 'format' var"); }
+    if (Obj_To_I64(format) != PointWriter_current_file_format) {
+        THROW(ERR, "Unsupported point index format: %i64",
+              Obj_To_I64(format));
+    }
+
+    // Extract metadata.
+    Obj *fields = CERTIFY(Hash_Fetch_Utf8(metadata, "fields", 6), VARRAY);
+    Obj *count  = CERTIFY(Hash_Fetch_Utf8(metadata, "count", 5), OBJ);
+    VArray *trees
+        = (VArray*)CERTIFY(Hash_Fetch_Utf8(metadata, "trees", 5), VARRAY);
+    ivars->fields    = (VArray*)INCREF(fields);
+    ivars->num_dims  = VA_Get_Size(ivars->fields);
+    ivars->count     = (int32_t)Obj_To_I64(count);
+    ivars->num_trees = VA_Get_Size(trees);
+    ivars->tree_leaves
+        = (uint32_t*)MALLOCATE((ivars->num_trees + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < ivars->num_trees; i++) {
+        Obj *num_leaves = CERTIFY(VA_Fetch(trees, i), OBJ);
+        ivars->tree_leaves[i] = (uint32_t)Obj_To_I64(num_leaves);
+        ivars->num_leaves += ivars->tree_leaves[i];
+    }
+
+    // Slurp the cell bounds and leaf locations of each tree.  The nodes of
+    // a tree with n leaves are numbered from 1 to 2n - 1, so each tree's
+    // block of nodes is as long as twice its leaf count.
+    String *seg_name = Seg_Get_Name(segment);
+    String *ix_file  = Str_newf("%o/points.ix", seg_name);
+    InStream *ix_in  = Folder_Open_In(folder, ix_file);
+    DECREF(ix_file);
+    if (!ix_in) {
+        Err *error = (Err*)INCREF(Err_get_error());
+        DECREF(self);
+        RETHROW(error);
+    }
+    const uint32_t num_dims = ivars->num_dims;
+    const size_t   num_nodes = (size_t)ivars->num_leaves * 2;
+    ivars->node_bounds  = (uint64_t*)MALLOCATE(num_nodes * num_dims * 2
+                                               * sizeof(uint64_t) + 1);
+    ivars->node_missing = (uint8_t*)CALLOCATE(num_nodes * num_dims + 1,
+                                              sizeof(uint8_t));
+    ivars->leaf_offsets
+        = (int64_t*)MALLOCATE((ivars->num_leaves + 1) * sizeof(int64_t));
+    ivars->leaf_counts
+        = (uint32_t*)MALLOCATE((ivars->num_leaves + 1) * sizeof(uint32_t));
+    size_t   node_base = 0;
+    uint32_t leaf_base = 0;
+    for (uint32_t tree = 0; tree < ivars->num_trees; tree++) {
+        const uint32_t tree_leaves = ivars->tree_leaves[tree];
+        for (size_t node = 1; node < (size_t)tree_leaves * 2; node++) {
+            for (uint32_t dim = 0; dim < num_dims; dim++) {
+                const size_t tick = (node_base + node) * num_dims + dim;
+                ivars->node_bounds[tick * 2]     = InStream_Read_U64(ix_in);
+                ivars->node_bounds[tick * 2 + 1] = InStream_Read_U64(ix_in);
+                ivars->node_missing[tick]        = InStream_Read_U8(ix_in);
+            }
+        }
+        for (uint32_t leaf = leaf_base; leaf < leaf_base + tree_leaves;
+             leaf++
+            ) {
+            ivars->leaf_offsets[leaf] = InStream_Read_I64(ix_in);
+            ivars->leaf_counts[leaf]  = InStream_Read_U32(ix_in);
+            if (ivars->leaf_counts[leaf] > ivars->max_leaf_count) {
+                ivars->max_leaf_count = ivars->leaf_counts[leaf];
+            }
+        }
+        node_base += (size_t)tree_leaves * 2;
+        leaf_base += tree_leaves;
+    }
+    InStream_Close(ix_in);
+    DECREF(ix_in);
+
+    // Open the leaf data.
+    String *dat_file = Str_newf("%o/points.dat", seg_name);
+    ivars->dat_in = Folder_Open_In(folder, dat_file);
+    DECREF(dat_file);
+    if (!ivars->dat_in) {
+        Err *error = (Err*)INCREF(Err_get_error());
+        DECREF(self);
+        RETHROW(error);
+    }
+
+    return self;
+}
+
+void
+DefPointReader_Close_IMP(DefaultPointReader *self) {
+    DefaultPointReaderIVARS *const ivars = DefPointReader_IVARS(self);
+    if (ivars->dat_in) {
+        InStream_Close(ivars->dat_in);
+        DECREF(ivars->dat_in);
+        ivars->dat_in = NULL;
+    }
+}
+
+void
+DefPointReader_Destroy_IMP(DefaultPointReader *self) {
+    DefaultPointReaderIVARS *const ivars = DefPointReader_IVARS(self);
+    DECREF(ivars->fields);
+    DECREF(ivars->dat_in);
+    FREEMEM(ivars->node_bounds);
+    FREEMEM(ivars->node_missing);
+    FREEMEM(ivars->tree_leaves);
+    FREEMEM(ivars->leaf_offsets);
+    FREEMEM(ivars->leaf_counts);
+    SUPER_DESTROY(self, DEFAULTPOINTREADER);
+}
+
+int32_t
+DefPointReader_Get_Count_IMP(DefaultPointReader *self) {
+    return DefPointReader_IVARS(self)->count;
+}
+
+VArray*
+DefPointReader_Get_Fields_IMP(DefaultPointReader *self) {
+    return DefPointReader_IVARS(self)->fields;
+}
+
+uint32_t
+DefPointReader_Get_Num_Leaves_IMP(DefaultPointReader *self) {
+    return DefPointReader_IVARS(self)->num_leaves;
+}
+
+uint32_t
+DefPointReader_Get_Max_Leaf_Count_IMP(DefaultPointReader *self) {
+    return DefPointReader_IVARS(self)->max_leaf_count;
+}
+
+static int32_t
+S_find_dim(DefaultPointReaderIVARS *ivars, String *field) {
+    if (!ivars->fields) { return -1; }
+    for (uint32_t i = 0; i < ivars->num_dims; i++) {
+        if (Str_Equals(field, VA_Fetch(ivars->fields, i))) {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+bool
+DefPointReader_Has_Field_IMP(DefaultPointReader *self, String *field) {
+    return S_find_dim(DefPointReader_IVARS(self), field) >= 0;
+}
+
+static uint32_t
+S_read_leaf(DefaultPointReaderIVARS *ivars, uint32_t leaf, int32_t *doc_ids,
+            uint64_t *keys, uint8_t *missing) {
+    InStream *const dat_in = ivars->dat_in;
+    const uint32_t  count  = ivars->leaf_counts[leaf];
+    int32_t doc_id = 0;
+
+    InStream_Seek(dat_in, ivars->leaf_offsets[leaf]);
+    for (uint32_t i = 0; i < count; i++) {
+        doc_id += (int32_t)InStream_Read_C32(dat_in);
+        doc_ids[i] = doc_id;
+    }
+    if (keys) {
+        // Each dimension starts with a flag which says whether a bitmap of
+        // missing values follows, then holds one key per point.
+        for (uint32_t dim = 0; dim < ivars->num_dims; dim++) {
+            uint8_t *dim_missing = missing + (size_t)dim * count;
+            uint64_t *dim_keys   = keys + (size_t)dim * count;
+            memset(dim_missing, 0, count);
+            if (InStream_Read_U8(dat_in)) {
+                for (uint32_t i = 0; i < count; i += 8) {
+                    uint8_t bits = InStream_Read_U8(dat_in);
+                    for (uint32_t j = i; j < i + 8 && j < count; j++) {
+                        dim_missing[j] = (bits >> (j - i)) & 1;
+                    }
+                }
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                dim_keys[i] = InStream_Read_U64(dat_in);
+            }
+        }
+    }
+
+    return count;
+}
+
+uint32_t
+DefPointReader_Read_Leaf_IMP(DefaultPointReader *self, uint32_t leaf,
+                             int32_t *doc_ids, uint64_t *keys,
+                             uint8_t *missing) {
+    DefaultPointReaderIVARS *const ivars = DefPointReader_IVARS(self);
+    if (leaf >= ivars->num_leaves) {
+        THROW(ERR, "Leaf %u32 out of range (%u32)", leaf, ivars->num_leaves);
+    }
+    return S_read_leaf(ivars, leaf, doc_ids, keys, missing);
+}
+
+BitVector*
+DefPointReader_Find_Box_IMP(DefaultPointReader *self, VArray *fields,
+                            uint64_t *lower_keys, uint64_t *upper_keys) {
+    DefaultPointReaderIVARS *const ivars = DefPointReader_IVARS(self);
+    const uint32_t num_dims = ivars->num_dims;
+    if (!ivars->count) { return NULL; }
+
+    // Translate the box into this segment's dimensions.  A field which the
+    // segment didn't index can't match anything.
+    uint64_t *lower       = (uint64_t*)MALLOCATE(num_dims * sizeof(uint64_t));
+    uint64_t *upper       = (uint64_t*)MALLOCATE(num_dims * sizeof(uint64_t));
+    bool     *constrained = (bool*)MALLOCATE(num_dims * sizeof(bool));
+    bool      possible    = true;
+    for (uint32_t dim = 0; dim < num_dims; dim++) {
+        lower[dim]       = 0;
+        upper[dim]       = UINT64_MAX;
+        constrained[dim] = false;
+    }
+    for (uint32_t i = 0, max = VA_Get_Size(fields); i < max; i++) {
+        int32_t dim = S_find_dim(ivars, (String*)VA_Fetch(fields, i));
+        if (dim < 0) {
+            possible = false;
+            break;
+        }
+        if (lower_keys[i] > lower[dim]) { lower[dim] = lower_keys[i]; }
+        if (upper_keys[i] < upper[dim]) { upper[dim] = upper_keys[i]; }
+        if (lower[dim] > upper[dim])    { possible = false; }
+        constrained[dim] = true;
+    }
+
+    BitVector *result = NULL;
+    if (possible) {
+        Segment *segment = DefPointReader_Get_Segment(self);
+        const size_t max_keys = (size_t)ivars->max_leaf_count * num_dims;
+        PointSearch search;
+        search.ivars       = ivars;
+        search.result      = BitVec_new((uint32_t)Seg_Get_Count(segment) + 1);
+        search.lower       = lower;
+        search.upper       = upper;
+        search.constrained = constrained;
+        search.doc_ids
+            = (int32_t*)MALLOCATE((ivars->max_leaf_count + 1)
+                                  * sizeof(int32_t));
+        search.keys
+            = (uint64_t*)MALLOCATE((max_keys + 1) * sizeof(uint64_t));
+        search.missing = (uint8_t*)MALLOCATE(max_keys + 1);
+        uint32_t node_base = 0;
+        uint32_t leaf_base = 0;
+        for (uint32_t tree = 0; tree < ivars->num_trees; tree++) {
+            const uint32_t tree_leaves = ivars->tree_leaves[tree];
+            S_visit(&search, node_base, leaf_base, tree_leaves, 1);
+            node_base += tree_leaves * 2;
+            leaf_base += tree_leaves;
+        }
+        FREEMEM(search.doc_ids);
+        FREEMEM(search.keys);
+        FREEMEM(search.missing);
+        result = search.result;
+    }
+
+    FREEMEM(lower);
+    FREEMEM(upper);
+    FREEMEM(constrained);
+    return result;
+}
+
+static void
+S_visit(PointSearch *search, uint32_t node_base, uint32_t leaf_base,
+        uint32_t num_leaves, uint32_t node) {
+    DefaultPointReaderIVARS *const ivars = search->ivars;
+    const uint32_t  num_dims = ivars->num_dims;
+    const size_t    tick     = (size_t)(node_base + node) * num_dims;
+    const uint64_t *bounds   = ivars->node_bounds + tick * 2;
+    const uint8_t  *missing  = ivars->node_missing + tick;
+    bool inside = true;
+
+    for (uint32_t dim = 0; dim < num_dims; dim++) {
+        if (!search->constrained[dim]) { continue; }
+        const uint64_t min = bounds[dim * 2];
+        const uint64_t max = bounds[dim * 2 + 1];
+        if (min > max) {
+            return; // No values at all.
+        }
+        if (max < search->lower[dim] || min > search->upper[dim]) {
+            return; // Disjoint.
+        }
+        if (missing[dim]
+            || min < search->lower[dim]
+            || max > search->upper[dim]
+           ) {
+            inside = false;
+        }
+    }
+
+    if (inside) {
+        // Every doc below this cell matches, so skip reading values.
+        uint32_t first = node;
+        uint32_t last  = node;
+        while (first < num_leaves) {
+            first = first * 2;
+            last  = last * 2 + 1;
+        }
+        for (uint32_t leaf = first - num_leaves; leaf <= last - num_leaves;
+             leaf++
+            ) {
+            uint32_t count = S_read_leaf(ivars, leaf_base + leaf,
+                                         search->doc_ids, NULL, NULL);
+            for (uint32_t i = 0; i < count; i++) {
+                BitVec_Set(search->result, (uint32_t)search->doc_ids[i]);
+            }
+        }
+    }
+    else if (node >= num_leaves) {
+        uint32_t count = S_read_leaf(ivars, leaf_base + node - num_leaves,
+                                     search->doc_ids, search->keys,
+                                     search->missing);
+        for (uint32_t i = 0; i < count; i++) {
+            bool match = true;
+            for (uint32_t dim = 0; dim < num_dims; dim++) {
+                if (!search->constrained[dim]) { continue; }
+                const size_t   at  = (size_t)dim * count + i;
+                const uint64_t key = search->keys[at];
+                if (search->missing[at]
+                    || key < search->lower[dim]
+                    || key > search->upper[dim]
+                   ) {
+                    match = false;
+                    break;
+                }
+            }
+            if (match) {
+                BitVec_Set(search->result, (uint32_t)search->doc_ids[i]);
+            }
+        }
+    }
+    else {
+        S_visit(search, node_base, leaf_base, num_leaves, node * 2);
+        S_visit(search, node_base, leaf_base, num_leaves, node * 2 + 1);
+    }
+}
+
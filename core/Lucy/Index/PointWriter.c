@@ -0,0 +1,539 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_POINTWRITER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/PointWriter.h"
+#include "Lucy/Index/Inverter.h"
+#include "Lucy/Index/PointReader.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/Snapshot.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/OutStream.h"
+#include "Clownfish/Util/SortUtils.h"
+
+#define LEAF_SIZE POINTWRITER_LEAF_SIZE
+
+int32_t PointWriter_current_file_format = 2;
+
+static size_t default_mem_thresh = 0x400000; // 4 MB
+
+// Return the dimension assigned to `field`, or -1 if it has none.
+static int32_t
+S_find_dim(VArray *fields, String *field);
+
+// Make room for one more point, with every value missing, and return its
+// position in the buffer.
+static uint32_t
+S_grow(PointWriterIVARS *ivars);
+
+// Account for the point most recently added to the buffer, writing out the
+// buffer as a tree once it reaches the memory threshold.
+static void
+S_commit_point(PointWriterIVARS *ivars, int32_t doc_id);
+
+// Build a tree over the buffered points, write it out and empty the buffer.
+static void
+S_flush_tree(PointWriterIVARS *ivars);
+
+// Lay out the points in `order` across the leaves below `node`, splitting
+// each cell at the median of its widest dimension.
+static void
+S_build(const uint64_t *keys, const uint8_t *missing, uint32_t num_dims,
+        uint32_t *order, uint32_t node, uint32_t num_leaves, uint32_t start,
+        uint32_t count, uint32_t *leaf_starts, uint32_t *leaf_counts);
+
+PointWriter*
+PointWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
+                PolyReader *polyreader) {
+    PointWriter *self = (PointWriter*)VTable_Make_Obj(POINTWRITER);
+    return PointWriter_init(self, schema, snapshot, segment, polyreader);
+}
+
+PointWriter*
+PointWriter_init(PointWriter *self, Schema *schema, Snapshot *snapshot,
+                 Segment *segment, PolyReader *polyreader) {
+    DataWriter_init((DataWriter*)self, schema, snapshot, segment, polyreader);
+    PointWriterIVARS *const ivars = PointWriter_IVARS(self);
+
+    // Init.
+    ivars->trees       = VA_new(0);
+    ivars->ix_out      = NULL;
+    ivars->dat_out     = NULL;
+    ivars->doc_ids     = NULL;
+    ivars->keys        = NULL;
+    ivars->missing     = NULL;
+    ivars->count       = 0;
+    ivars->cap         = 0;
+    ivars->total_count = 0;
+    ivars->mem_thresh  = default_mem_thresh;
+
+    // Derive.  Every point field in the schema becomes one dimension of the
+    // segment's trees.
+    VArray *all_fields = Schema_All_Fields(schema);
+    VA_Sort(all_fields, NULL, NULL);
+    ivars->fields = VA_new(0);
+    for (uint32_t i = 0, max = VA_Get_Size(all_fields); i < max; i++) {
+        String    *field = (String*)VA_Fetch(all_fields, i);
+        FieldType *type  = Schema_Fetch_Type(schema, field);
+        if (FType_Is_A(type, NUMERICTYPE) && NumType_Points((NumericType*)type)) {
+            VA_Push(ivars->fields, INCREF(field));
+        }
+    }
+    ivars->num_dims = VA_Get_Size(ivars->fields);
+    DECREF(all_fields);
+
+    return self;
+}
+
+void
+PointWriter_set_default_mem_thresh(size_t mem_thresh) {
+    default_mem_thresh = mem_thresh;
+}
+
+void
+PointWriter_Destroy_IMP(PointWriter *self) {
+    PointWriterIVARS *const ivars = PointWriter_IVARS(self);
+    DECREF(ivars->fields);
+    DECREF(ivars->trees);
+    DECREF(ivars->ix_out);
+    DECREF(ivars->dat_out);
+    FREEMEM(ivars->doc_ids);
+    FREEMEM(ivars->keys);
+    FREEMEM(ivars->missing);
+    SUPER_DESTROY(self, POINTWRITER);
+}
+
+static int32_t
+S_find_dim(VArray *fields, String *field) {
+    for (uint32_t i = 0, max = VA_Get_Size(fields); i < max; i++) {
+        if (Str_Equals(field, VA_Fetch(fields, i))) { return (int32_t)i; }
+    }
+    return -1;
+}
+
+static uint32_t
+S_grow(PointWriterIVARS *ivars) {
+    const uint32_t num_dims = ivars->num_dims;
+    if (ivars->count == ivars->cap) {
+        ivars->cap = ivars->cap ? ivars->cap * 2 : 1024;
+        ivars->doc_ids = (int32_t*)REALLOCATE(
+                             ivars->doc_ids, ivars->cap * sizeof(int32_t));
+        ivars->keys = (uint64_t*)REALLOCATE(
+                          ivars->keys,
+                          (size_t)ivars->cap * num_dims * sizeof(uint64_t));
+        ivars->missing = (uint8_t*)REALLOCATE(
+                             ivars->missing, (size_t)ivars->cap * num_dims);
+    }
+    const size_t row = (size_t)ivars->count * num_dims;
+    for (uint32_t dim = 0; dim < num_dims; dim++) {
+        ivars->keys[row + dim]    = 0;
+        ivars->missing[row + dim] = 1;
+    }
+    return ivars->count;
+}
+
+static void
+S_commit_point(PointWriterIVARS *ivars, int32_t doc_id) {
+    const size_t row_size = sizeof(int32_t)
+                            + ivars->num_dims * (sizeof(uint64_t) + 1);
+    ivars->doc_ids[ivars->count] = doc_id;
+    ivars->count++;
+    if ((size_t)ivars->count * row_size >= ivars->mem_thresh) {
+        S_flush_tree(ivars);
+    }
+}
+
+void
+PointWriter_Add_Inverted_Doc_IMP(PointWriter *self, Inverter *inverter,
+                                 int32_t doc_id) {
+    PointWriterIVARS *const ivars = PointWriter_IVARS(self);
+    int64_t tick = -1;
+    if (!ivars->num_dims) { return; }
+
+    Inverter_Iterate(inverter);
+    while (Inverter_Next(inverter)) {
+        FieldType *type = Inverter_Get_Type(inverter);
+        if (FType_Is_A(type, NUMERICTYPE)
+            && NumType_Points((NumericType*)type)
+           ) {
+            String *field = Inverter_Get_Field_Name(inverter);
+            Obj    *value = Inverter_Get_Value(inverter);
+            int32_t dim   = S_find_dim(ivars->fields, field);
+            if (dim < 0 || !value) { continue; }
+            if (tick < 0) { tick = S_grow(ivars); }
+            const size_t at = (size_t)tick * ivars->num_dims + (size_t)dim;
+            ivars->keys[at]    = PointReader_encode_value(type, value);
+            ivars->missing[at] = 0;
+        }
+    }
+
+    if (tick >= 0) {
+        S_commit_point(ivars, doc_id);
+    }
+}
+
+void
+PointWriter_Add_Segment_IMP(PointWriter *self, SegReader *reader,
+                            I32Array *doc_map) {
+    PointWriterIVARS *const ivars = PointWriter_IVARS(self);
+    DefaultPointReader *point_reader
+        = (DefaultPointReader*)SegReader_Fetch(
+              reader, VTable_Get_Name(POINTREADER));
+    if (!ivars->num_dims
+        || !point_reader
+        || !DefPointReader_Is_A(point_reader, DEFAULTPOINTREADER)
+        || !DefPointReader_Get_Count(point_reader)
+       ) {
+        return;
+    }
+
+    // Map the old segment's dimensions onto ours.
+    VArray *old_fields = DefPointReader_Get_Fields(point_reader);
+    const uint32_t old_dims = VA_Get_Size(old_fields);
+    int32_t *dim_map = (int32_t*)MALLOCATE(old_dims * sizeof(int32_t));
+    for (uint32_t i = 0; i < old_dims; i++) {
+        dim_map[i] = S_find_dim(ivars->fields,
+                                (String*)VA_Fetch(old_fields, i));
+    }
+
+    // Read the old points back a leaf at a time and remap doc ids, dropping
+    // deleted docs.
+    const uint32_t max_count  = DefPointReader_Get_Max_Leaf_Count(point_reader);
+    const uint32_t num_leaves = DefPointReader_Get_Num_Leaves(point_reader);
+    const size_t   max_keys   = (size_t)max_count * old_dims;
+    int32_t  *old_doc_ids
+        = (int32_t*)MALLOCATE((max_count + 1) * sizeof(int32_t));
+    uint64_t *old_keys
+        = (uint64_t*)MALLOCATE((max_keys + 1) * sizeof(uint64_t));
+    uint8_t  *old_missing = (uint8_t*)MALLOCATE(max_keys + 1);
+    for (uint32_t leaf = 0; leaf < num_leaves; leaf++) {
+        uint32_t count = DefPointReader_Read_Leaf(point_reader, leaf,
+                                                  old_doc_ids, old_keys,
+                                                  old_missing);
+        for (uint32_t i = 0; i < count; i++) {
+            int32_t remapped = doc_map
+                               ? I32Arr_Get(doc_map, old_doc_ids[i])
+                               : old_doc_ids[i];
+            if (!remapped) { continue; }
+            const size_t row = (size_t)S_grow(ivars) * ivars->num_dims;
+            for (uint32_t j = 0; j < old_dims; j++) {
+                if (dim_map[j] < 0) { continue; }
+                const size_t from = (size_t)j * count + i;
+                ivars->keys[row + (size_t)dim_map[j]]    = old_keys[from];
+                ivars->missing[row + (size_t)dim_map[j]] = old_missing[from];
+            }
+            S_commit_point(ivars, remapped);
+        }
+    }
+
+    FREEMEM(old_missing);
+    FREEMEM(old_keys);
+    FREEMEM(old_doc_ids);
+    FREEMEM(dim_map);
+}
+
+// Missing values sort after everything else.
+static CFISH_INLINE uint64_t
+SI_key(const uint64_t *keys, const uint8_t *missing, uint32_t num_dims,
+       uint32_t dim, uint32_t tick) {
+    const size_t at = (size_t)tick * num_dims + dim;
+    return missing[at] ? UINT64_MAX : keys[at];
+}
+
+// Find the dimension with the widest spread of keys.
+static uint32_t
+S_widest_dim(const uint64_t *keys, const uint8_t *missing, uint32_t num_dims,
+             const uint32_t *order, uint32_t count) {
+    uint32_t widest = 0;
+    uint64_t widest_spread = 0;
+    for (uint32_t dim = 0; dim < num_dims; dim++) {
+        uint64_t min = UINT64_MAX;
+        uint64_t max = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            const size_t at = (size_t)order[i] * num_dims + dim;
+            if (missing[at]) { continue; }
+            if (keys[at] < min) { min = keys[at]; }
+            if (keys[at] > max) { max = keys[at]; }
+        }
+        if (max >= min && max - min > widest_spread) {
+            widest_spread = max - min;
+            widest = dim;
+        }
+    }
+    return widest;
+}
+
+// Partially order `order` so that element `k` is where it would be if the
+// array were sorted by `dim`, with nothing greater before it and nothing
+// smaller after it.
+static void
+S_select(const uint64_t *keys, const uint8_t *missing, uint32_t num_dims,
+         uint32_t dim, uint32_t *order, uint32_t count, uint32_t k) {
+    uint32_t lo = 0;
+    uint32_t hi = count;
+    while (hi - lo > 1) {
+        const uint64_t pivot
+            = SI_key(keys, missing, num_dims, dim, order[lo + (hi - lo) / 2]);
+        uint32_t lt = lo;
+        uint32_t gt = hi;
+        uint32_t i  = lo;
+        while (i < gt) {
+            const uint64_t key = SI_key(keys, missing, num_dims, dim,
+                                        order[i]);
+            if (key < pivot) {
+                uint32_t temp = order[lt];
+                order[lt++] = order[i];
+                order[i++]  = temp;
+            }
+            else if (key > pivot) {
+                uint32_t temp = order[--gt];
+                order[gt] = order[i];
+                order[i]  = temp;
+            }
+            else {
+                i++;
+            }
+        }
+        if (k < lt)       { hi = lt; }
+        else if (k >= gt) { lo = gt; }
+        else              { return; }
+    }
+}
+
+static void
+S_build(const uint64_t *keys, const uint8_t *missing, uint32_t num_dims,
+        uint32_t *order, uint32_t node, uint32_t num_leaves, uint32_t start,
+        uint32_t count, uint32_t *leaf_starts, uint32_t *leaf_counts) {
+    if (node >= num_leaves) {
+        leaf_starts[node - num_leaves] = start;
+        leaf_counts[node - num_leaves] = count;
+        return;
+    }
+    const uint32_t left_count = count / 2;
+    if (count > 1) {
+        uint32_t dim = S_widest_dim(keys, missing, num_dims, order + start,
+                                    count);
+        S_select(keys, missing, num_dims, dim, order + start, count,
+                 left_count);
+    }
+    S_build(keys, missing, num_dims, order, node * 2, num_leaves, start,
+            left_count, leaf_starts, leaf_counts);
+    S_build(keys, missing, num_dims, order, node * 2 + 1, num_leaves,
+            start + left_count, count - left_count, leaf_starts,
+            leaf_counts);
+}
+
+static int
+S_compare_u64(void *context, const void *va, const void *vb) {
+    const uint64_t a = *(const uint64_t*)va;
+    const uint64_t b = *(const uint64_t*)vb;
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static OutStream*
+S_open_out(PointWriterIVARS *ivars, const char *name) {
+    String *seg_name = Seg_Get_Name(ivars->segment);
+    String *file     = Str_newf("%o/%s", seg_name, name);
+    OutStream *outstream = Folder_Open_Out(ivars->folder, file);
+    DECREF(file);
+    if (!outstream) { RETHROW(INCREF(Err_get_error())); }
+    return outstream;
+}
+
+static void
+S_flush_tree(PointWriterIVARS *ivars) {
+    const uint32_t  count    = ivars->count;
+    const uint32_t  num_dims = ivars->num_dims;
+    const uint64_t *keys     = ivars->keys;
+    const uint8_t  *missing  = ivars->missing;
+    if (!count) { return; }
+
+    // Size the tree so that no leaf holds more than LEAF_SIZE points.  Nodes
+    // are numbered from 1, with the children of node n at 2n and 2n + 1 and
+    // the leaves occupying [num_leaves, 2 * num_leaves).
+    uint32_t num_leaves = 1;
+    while ((uint64_t)num_leaves * LEAF_SIZE < count) { num_leaves *= 2; }
+    const uint32_t num_nodes = num_leaves * 2;
+    uint32_t *order       = (uint32_t*)MALLOCATE(count * sizeof(uint32_t));
+    uint32_t *leaf_starts = (uint32_t*)MALLOCATE(num_leaves * sizeof(uint32_t));
+    uint32_t *leaf_counts = (uint32_t*)MALLOCATE(num_leaves * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) { order[i] = i; }
+    S_build(keys, missing, num_dims, order, 1, num_leaves, 0, count,
+            leaf_starts, leaf_counts);
+
+    // Compute cell bounds for the leaves, then roll them up.  A cell with
+    // no values in a dimension keeps a minimum above its maximum.  Missing
+    // values are tracked separately so that a cell is never mistaken for
+    // lying entirely within a query box when some of its docs lack a value.
+    uint64_t *bounds  = (uint64_t*)MALLOCATE((size_t)num_nodes * num_dims * 2
+                                             * sizeof(uint64_t));
+    uint8_t  *node_missing
+        = (uint8_t*)CALLOCATE((size_t)num_nodes * num_dims, sizeof(uint8_t));
+    for (size_t i = 0; i < (size_t)num_nodes * num_dims; i++) {
+        bounds[i * 2]     = UINT64_MAX;
+        bounds[i * 2 + 1] = 0;
+    }
+    for (uint32_t leaf = 0; leaf < num_leaves; leaf++) {
+        const size_t node = num_leaves + leaf;
+        uint64_t *node_bounds = bounds + node * num_dims * 2;
+        uint8_t  *node_miss   = node_missing + node * num_dims;
+        for (uint32_t i = 0; i < leaf_counts[leaf]; i++) {
+            const size_t row
+                = (size_t)order[leaf_starts[leaf] + i] * num_dims;
+            for (uint32_t dim = 0; dim < num_dims; dim++) {
+                if (missing[row + dim]) { node_miss[dim] = 1; continue; }
+                const uint64_t key = keys[row + dim];
+                if (key < node_bounds[dim * 2]) {
+                    node_bounds[dim * 2] = key;
+                }
+                if (key > node_bounds[dim * 2 + 1]) {
+                    node_bounds[dim * 2 + 1] = key;
+                }
+            }
+        }
+    }
+    for (size_t node = num_leaves - 1; node >= 1; node--) {
+        uint64_t *node_bounds  = bounds + node * num_dims * 2;
+        uint64_t *left_bounds  = bounds + node * 2 * num_dims * 2;
+        uint64_t *right_bounds = bounds + (node * 2 + 1) * num_dims * 2;
+        for (uint32_t dim = 0; dim < num_dims; dim++) {
+            node_bounds[dim * 2] = left_bounds[dim * 2] < right_bounds[dim * 2]
+                                   ? left_bounds[dim * 2]
+                                   : right_bounds[dim * 2];
+            node_bounds[dim * 2 + 1]
+                = left_bounds[dim * 2 + 1] > right_bounds[dim * 2 + 1]
+                  ? left_bounds[dim * 2 + 1]
+                  : right_bounds[dim * 2 + 1];
+            node_missing[node * num_dims + dim]
+                = node_missing[node * 2 * num_dims + dim]
+                  | node_missing[(node * 2 + 1) * num_dims + dim];
+        }
+    }
+
+    // Open outstreams on the first flush.
+    if (!ivars->dat_out) {
+        ivars->ix_out  = S_open_out(ivars, "points.ix");
+        ivars->dat_out = S_open_out(ivars, "points.dat");
+    }
+    OutStream *ix_out  = ivars->ix_out;
+    OutStream *dat_out = ivars->dat_out;
+
+    // Write the leaves.  Within each leaf, doc ids are sorted and
+    // delta-encoded.  The keys follow one dimension at a time, each
+    // dimension preceded by a flag and, if any of its values are missing, a
+    // bitmap marking them.
+    uint64_t *sorted = (uint64_t*)MALLOCATE((LEAF_SIZE + 1) * sizeof(uint64_t));
+    int64_t  *leaf_offsets = (int64_t*)MALLOCATE(num_leaves * sizeof(int64_t));
+    for (uint32_t leaf = 0; leaf < num_leaves; leaf++) {
+        const uint32_t leaf_count = leaf_counts[leaf];
+        const uint32_t *leaf_order = order + leaf_starts[leaf];
+        for (uint32_t i = 0; i < leaf_count; i++) {
+            sorted[i] = ((uint64_t)(uint32_t)ivars->doc_ids[leaf_order[i]] << 32)
+                        | leaf_order[i];
+        }
+        Sort_quicksort(sorted, leaf_count, sizeof(uint64_t), S_compare_u64,
+                       NULL);
+        leaf_offsets[leaf] = OutStream_Tell(dat_out);
+        int32_t last_doc_id = 0;
+        for (uint32_t i = 0; i < leaf_count; i++) {
+            int32_t doc_id = (int32_t)(sorted[i] >> 32);
+            OutStream_Write_C32(dat_out, (uint32_t)(doc_id - last_doc_id));
+            last_doc_id = doc_id;
+        }
+        for (uint32_t dim = 0; dim < num_dims; dim++) {
+            const uint8_t has_missing
+                = node_missing[((size_t)num_leaves + leaf) * num_dims + dim];
+            OutStream_Write_U8(dat_out, has_missing);
+            if (has_missing) {
+                for (uint32_t i = 0; i < leaf_count; i += 8) {
+                    uint8_t bits = 0;
+                    for (uint32_t j = i; j < i + 8 && j < leaf_count; j++) {
+                        size_t tick = (size_t)(sorted[j] & 0xFFFFFFFF);
+                        if (missing[tick * num_dims + dim]) {
+                            bits |= (uint8_t)(1 << (j - i));
+                        }
+                    }
+                    OutStream_Write_U8(dat_out, bits);
+                }
+            }
+            for (uint32_t i = 0; i < leaf_count; i++) {
+                size_t tick = (size_t)(sorted[i] & 0xFFFFFFFF);
+                OutStream_Write_U64(dat_out, keys[tick * num_dims + dim]);
+            }
+        }
+    }
+
+    // Write the cell bounds and leaf locations.
+    for (size_t node = 1; node < num_nodes; node++) {
+        for (uint32_t dim = 0; dim < num_dims; dim++) {
+            OutStream_Write_U64(ix_out, bounds[(node * num_dims + dim) * 2]);
+            OutStream_Write_U64(ix_out,
+                                bounds[(node * num_dims + dim) * 2 + 1]);
+            OutStream_Write_U8(ix_out, node_missing[node * num_dims + dim]);
+        }
+    }
+    for (uint32_t leaf = 0; leaf < num_leaves; leaf++) {
+        OutStream_Write_I64(ix_out, leaf_offsets[leaf]);
+        OutStream_Write_U32(ix_out, leaf_counts[leaf]);
+    }
+
+    VA_Push(ivars->trees, (Obj*)Str_newf("%u32", num_leaves));
+    ivars->total_count += count;
+    ivars->count = 0;
+
+    FREEMEM(leaf_offsets);
+    FREEMEM(sorted);
+    FREEMEM(node_missing);
+    FREEMEM(bounds);
+    FREEMEM(leaf_counts);
+    FREEMEM(leaf_starts);
+    FREEMEM(order);
+}
+
+void
+PointWriter_Finish_IMP(PointWriter *self) {
+    PointWriterIVARS *const ivars = PointWriter_IVARS(self);
+    S_flush_tree(ivars);
+    if (!ivars->dat_out) { return; }
+
+    OutStream_Close(ivars->dat_out);
+    OutStream_Close(ivars->ix_out);
+    DECREF(ivars->dat_out);
+    DECREF(ivars->ix_out);
+    ivars->dat_out = NULL;
+    ivars->ix_out  = NULL;
+
+    Hash *metadata = PointWriter_Metadata(self);
+    Hash_Store_Utf8(metadata, "fields", 6, INCREF(ivars->fields));
+    Hash_Store_Utf8(metadata, "count", 5,
+                    (Obj*)Str_newf("%u32", ivars->total_count));
+    Hash_Store_Utf8(metadata, "trees", 5, INCREF(ivars->trees));
+    Seg_Store_Metadata_Utf8(ivars->segment, "points", 6, (Obj*)metadata);
+}
+
+int32_t
+PointWriter_Format_IMP(PointWriter *self) {
+    UNUSED_VAR(self);
+    return PointWriter_current_file_format;
+}
+
@@ -35,6 +35,11 @@ Post_init(Posting *self) {
     return self;
 }
 
+void
+Post_Skip_Record_IMP(Posting *self, InStream *instream) {
+    Post_Read_Record(self, instream);
+}
+
 void
 Post_Set_Doc_ID_IMP(Posting *self, int32_t doc_id) {
     Post_IVARS(self)->doc_id = doc_id;
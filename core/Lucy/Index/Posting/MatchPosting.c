@@ -94,6 +94,17 @@ MatchPost_Read_Record_IMP(MatchPosting *self, InStream *instream) {
     }
 }
 
+void
+MatchPost_Skip_Record_IMP(MatchPosting *self, InStream *instream) {
+    MatchPostingIVARS *const ivars = MatchPost_IVARS(self);
+    const size_t max_bytes = C32_MAX_BYTES * 2;
+    char *buf = InStream_Buf(instream, max_bytes);
+    const uint32_t doc_code = NumUtil_decode_c32(&buf);
+    ivars->doc_id += doc_code >> 1;
+    if (!(doc_code & 1)) { NumUtil_skip_cint(&buf); }
+    InStream_Advance_Buf(instream, buf);
+}
+
 RawPosting*
 MatchPost_Read_Raw_IMP(MatchPosting *self, InStream *instream,
                        int32_t last_doc_id, String *term_text,
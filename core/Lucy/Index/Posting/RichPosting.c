@@ -104,6 +104,22 @@ RichPost_Read_Record_IMP(RichPosting *self, InStream *instream) {
     ivars->weight = aggregate_weight / ivars->freq;
 }
 
+void
+RichPost_Skip_Record_IMP(RichPosting *self, InStream *instream) {
+    RichPostingIVARS *const ivars = RichPost_IVARS(self);
+    uint32_t doc_code = InStream_Read_C32(instream);
+    uint32_t num_prox = (doc_code & 1) ? 1 : InStream_Read_C32(instream);
+    ivars->doc_id += doc_code >> 1;
+
+    // Step over each position and its boost byte.
+    char *buf = InStream_Buf(instream, num_prox * (C32_MAX_BYTES + 1));
+    while (num_prox--) {
+        NumUtil_skip_cint(&buf);
+        buf++;
+    }
+    InStream_Advance_Buf(instream, buf);
+}
+
 void
 RichPost_Add_Inversion_To_Pool_IMP(RichPosting *self, PostingPool *post_pool,
                                    Inversion *inversion, FieldType *type,
@@ -189,15 +205,18 @@ RichPost_Read_Raw_IMP(RichPosting *self, InStream *instream,
     return raw_posting;
 }
 
-RichPostingMatcher*
+Matcher*
 RichPost_Make_Matcher_IMP(RichPosting *self, Similarity *sim,
                           PostingList *plist, Compiler *compiler,
                           bool need_score) {
+    if (!need_score) {
+        RichPost_Make_Matcher_t super_make_matcher
+            = SUPER_METHOD_PTR(RICHPOSTING, LUCY_RichPost_Make_Matcher);
+        return super_make_matcher(self, sim, plist, compiler, need_score);
+    }
     RichPostingMatcher* matcher
         = (RichPostingMatcher*)VTable_Make_Obj(RICHPOSTINGMATCHER);
-    UNUSED_VAR(self);
-    UNUSED_VAR(need_score);
-    return RichPostMatcher_init(matcher, sim, plist, compiler);
+    return (Matcher*)RichPostMatcher_init(matcher, sim, plist, compiler);
 }
 
 RichPostingMatcher*
@@ -58,6 +58,8 @@ ScorePost_init(ScorePosting *self, Similarity *sim) {
     ivars->weight       = 0.0;
     ivars->prox         = NULL;
     ivars->prox_cap     = 0;
+    ivars->prox_in      = NULL;
+    ivars->prox_start   = 0;
     return self;
 }
 
@@ -70,7 +72,31 @@ ScorePost_Destroy_IMP(ScorePosting *self) {
 
 uint32_t*
 ScorePost_Get_Prox_IMP(ScorePosting *self) {
-    return ScorePost_IVARS(self)->prox;
+    ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
+    if (ivars->prox_in) {
+        // Go back and decode the positions which Read_Record() skipped,
+        // then restore the stream to where the PostingList left it.
+        InStream *const instream = ivars->prox_in;
+        const int64_t   resume   = InStream_Tell(instream);
+        uint32_t num_prox = ivars->freq;
+        uint32_t position = 0;
+        if (num_prox > ivars->prox_cap) {
+            ivars->prox = (uint32_t*)REALLOCATE(
+                             ivars->prox, num_prox * sizeof(uint32_t));
+            ivars->prox_cap = num_prox;
+        }
+        uint32_t *positions = ivars->prox;
+
+        InStream_Seek(instream, ivars->prox_start);
+        char *buf = InStream_Buf(instream, num_prox * C32_MAX_BYTES);
+        while (num_prox--) {
+            position += NumUtil_decode_c32(&buf);
+            *positions++ = position;
+        }
+        InStream_Seek(instream, resume);
+        ivars->prox_in = NULL;
+    }
+    return ivars->prox;
 }
 
 void
@@ -124,15 +150,15 @@ ScorePost_Add_Inversion_To_Pool_IMP(ScorePosting *self,
 void
 ScorePost_Reset_IMP(ScorePosting *self) {
     ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
-    ivars->doc_id = 0;
-    ivars->freq   = 0;
-    ivars->weight = 0.0;
+    ivars->doc_id  = 0;
+    ivars->freq    = 0;
+    ivars->weight  = 0.0;
+    ivars->prox_in = NULL;
 }
 
 void
 ScorePost_Read_Record_IMP(ScorePosting *self, InStream *instream) {
     ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
-    uint32_t  position = 0;
     const size_t max_start_bytes = (C32_MAX_BYTES * 2) + 1;
     char *buf = InStream_Buf(instream, max_start_bytes);
     const uint32_t doc_code = NumUtil_decode_c32(&buf);
@@ -151,22 +177,38 @@ ScorePost_Read_Record_IMP(ScorePosting *self, InStream *instream) {
     ivars->weight = ivars->norm_decoder[*(uint8_t*)buf];
     buf++;
 
-    // Read positions.
+    // Skip positions, remembering where they start so that Get_Prox() can
+    // decode them if asked.
     uint32_t num_prox = ivars->freq;
-    if (num_prox > ivars->prox_cap) {
-        ivars->prox = (uint32_t*)REALLOCATE(
-                         ivars->prox, num_prox * sizeof(uint32_t));
-        ivars->prox_cap = num_prox;
+    InStream_Advance_Buf(instream, buf);
+    ivars->prox_in    = instream;
+    ivars->prox_start = InStream_Tell(instream);
+    buf = InStream_Buf(instream, num_prox * C32_MAX_BYTES);
+    while (num_prox--) {
+        NumUtil_skip_cint(&buf);
     }
-    uint32_t *positions = ivars->prox;
 
     InStream_Advance_Buf(instream, buf);
+}
+
+void
+ScorePost_Skip_Record_IMP(ScorePosting *self, InStream *instream) {
+    ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
+    const size_t max_start_bytes = (C32_MAX_BYTES * 2) + 1;
+    char *buf = InStream_Buf(instream, max_start_bytes);
+    const uint32_t doc_code = NumUtil_decode_c32(&buf);
+    uint32_t num_prox = (doc_code & 1) ? 1 : NumUtil_decode_c32(&buf);
+
+    ivars->doc_id  += doc_code >> 1;
+    ivars->prox_in  = NULL;
+
+    // Step over the boost/norm byte and the positions.
+    buf++;
+    InStream_Advance_Buf(instream, buf);
     buf = InStream_Buf(instream, num_prox * C32_MAX_BYTES);
     while (num_prox--) {
-        position += NumUtil_decode_c32(&buf);
-        *positions++ = position;
+        NumUtil_skip_cint(&buf);
     }
-
     InStream_Advance_Buf(instream, buf);
 }
 
@@ -210,15 +252,20 @@ ScorePost_Read_Raw_IMP(ScorePosting *self, InStream *instream,
     return raw_posting;
 }
 
-ScorePostingMatcher*
+Matcher*
 ScorePost_Make_Matcher_IMP(ScorePosting *self, Similarity *sim,
                            PostingList *plist, Compiler *compiler,
                            bool need_score) {
+    UNUSED_VAR(self);
+    if (!need_score) {
+        // Scores will never be asked for, so skip building the score cache.
+        MatchPostingMatcher *matcher
+            = (MatchPostingMatcher*)VTable_Make_Obj(MATCHPOSTINGMATCHER);
+        return (Matcher*)MatchPostMatcher_init(matcher, sim, plist, compiler);
+    }
     ScorePostingMatcher *matcher
         = (ScorePostingMatcher*)VTable_Make_Obj(SCOREPOSTINGMATCHER);
-    UNUSED_VAR(self);
-    UNUSED_VAR(need_score);
-    return ScorePostMatcher_init(matcher, sim, plist, compiler);
+    return (Matcher*)ScorePostMatcher_init(matcher, sim, plist, compiler);
 }
 
 ScorePostingMatcher*
@@ -255,6 +302,68 @@ ScorePostMatcher_Score_IMP(ScorePostingMatcher* self) {
     return score;
 }
 
+uint32_t
+ScorePostMatcher_Next_Block_IMP(ScorePostingMatcher *self, int32_t *doc_ids,
+                                float *scores, uint32_t max) {
+    ScorePostingMatcherIVARS *const ivars = ScorePostMatcher_IVARS(self);
+    PostingList *const plist = ivars->plist;
+    uint32_t freqs[MATCHER_BLOCK_SIZE];
+    float    weights[MATCHER_BLOCK_SIZE];
+    uint32_t num_docs = 0;
+    if (!plist) { return 0; }
+
+    PList_Next_t next
+        = (PList_Next_t)METHOD_PTR(PList_Get_VTable(plist), LUCY_PList_Next);
+    ScorePosting *const posting = (ScorePosting*)PList_Get_Posting(plist);
+    ScorePostingIVARS *const posting_ivars = ScorePost_IVARS(posting);
+    const float *const score_cache = ivars->score_cache;
+    bool exhausted = false;
+    ivars->posting = (Posting*)posting;
+
+    while (num_docs < max && !exhausted) {
+        const uint32_t chunk_start = num_docs;
+        uint32_t chunk_end = max - num_docs > MATCHER_BLOCK_SIZE
+                             ? num_docs + MATCHER_BLOCK_SIZE
+                             : max;
+
+        // Gather doc ids along with the raw scoring inputs...
+        while (num_docs < chunk_end) {
+            int32_t doc_id = next(plist);
+            if (!doc_id) {
+                exhausted = true;
+                break;
+            }
+            doc_ids[num_docs] = doc_id;
+            freqs[num_docs - chunk_start]   = posting_ivars->freq;
+            weights[num_docs - chunk_start] = posting_ivars->weight;
+            num_docs++;
+        }
+
+        // ... then score them all in one tight loop.
+        if (scores) {
+            float *const chunk_scores = scores + chunk_start;
+            for (uint32_t i = 0, max_i = num_docs - chunk_start;
+                 i < max_i; i++
+                ) {
+                const uint32_t freq = freqs[i];
+                const float tf_score
+                    = freq < TERMMATCHER_SCORE_CACHE_SIZE
+                      ? score_cache[freq]
+                      : Sim_TF(ivars->sim, (float)freq) * ivars->weight;
+                chunk_scores[i] = tf_score * weights[i];
+            }
+        }
+    }
+
+    if (exhausted) {
+        // Reclaim resources a little early.
+        DECREF(plist);
+        ivars->plist = NULL;
+    }
+
+    return num_docs;
+}
+
 void
 ScorePostMatcher_Destroy_IMP(ScorePostingMatcher *self) {
     ScorePostingMatcherIVARS *const ivars = ScorePostMatcher_IVARS(self);
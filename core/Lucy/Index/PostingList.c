@@ -30,4 +30,10 @@ PList_init(PostingList *self) {
     return self;
 }
 
+void
+PList_Set_Doc_IDs_Only_IMP(PostingList *self, bool doc_ids_only) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(doc_ids_only);
+}
+
 
@@ -157,7 +157,7 @@ PListWriter_Add_Inverted_Doc_IMP(PostingListWriter *self, Inverter *inverter,
             Similarity  *sim  = Inverter_Get_Similarity(inverter);
             PostingPool *pool = S_lazy_init_posting_pool(self, field_num);
             float length_norm
-                = Sim_Length_Norm(sim, Inversion_Get_Size(inversion));
+                = Sim_Length_Norm(sim, Inversion_Get_Length(inversion));
             PostPool_Add_Inversion(pool, inversion, doc_id, doc_boost,
                                    length_norm);
         }
@@ -46,6 +46,17 @@
 #include "Lucy/Store/InStream.h"
 #include "Lucy/Store/OutStream.h"
 #include "Lucy/Util/MemoryPool.h"
+#include "Clownfish/Util/SortUtils.h"
+
+// Caches smaller than this are handed straight to the comparison sort.
+#define PREFIX_SORT_THRESHOLD 256
+
+// A RawPosting paired with the first bytes of its term text, packed
+// big-endian so that integer order matches memcmp order.
+typedef struct {
+    uint64_t    prefix;
+    RawPosting *posting;
+} PrefixedPosting;
 
 // Prepare to read back postings from disk.
 static void
@@ -57,6 +68,12 @@ static void
 S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
                            OutStream *skip_stream);
 
+// LSD radix sort an array of PrefixedPostings by prefix.  Returns whichever
+// of `elems` and `scratch` holds the sorted result.
+static PrefixedPosting*
+S_radix_sort(PrefixedPosting *elems, PrefixedPosting *scratch,
+             uint32_t num_elems);
+
 PostingPool*
 PostPool_new(Schema *schema, Snapshot *snapshot, Segment *segment,
              PolyReader *polyreader,  String *field,
@@ -160,6 +177,123 @@ PostPool_Compare_IMP(PostingPool *self, void *va, void *vb) {
     return comparison;
 }
 
+static CFISH_INLINE uint64_t
+SI_term_prefix(RawPosting *posting) {
+    RawPostingIVARS *const ivars = RawPost_IVARS(posting);
+    const uint8_t *text = (const uint8_t*)ivars->blob;
+    const uint32_t len  = ivars->content_len < 8 ? ivars->content_len : 8;
+    uint64_t prefix = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        prefix |= (uint64_t)text[i] << (56 - 8 * i);
+    }
+    return prefix;
+}
+
+void
+PostPool_Sort_Cache_IMP(PostingPool *self) {
+    PostingPoolIVARS *const ivars = PostPool_IVARS(self);
+    const uint32_t num_elems = ivars->cache_max;
+    if (num_elems < PREFIX_SORT_THRESHOLD) {
+        PostPool_Sort_Cache_t super_sort_cache
+            = SUPER_METHOD_PTR(POSTINGPOOL, LUCY_PostPool_Sort_Cache);
+        super_sort_cache(self);
+        return;
+    }
+    if (ivars->cache_tick != 0) {
+        THROW(ERR, "Cant Sort_Cache() after fetching %u32 items",
+              ivars->cache_tick);
+    }
+
+    // Pack the leading term bytes next to each pointer, so that the bulk of
+    // the sorting never has to chase a pointer into the MemoryPool.
+    RawPosting **postings = (RawPosting**)ivars->cache;
+    PrefixedPosting *elems
+        = (PrefixedPosting*)MALLOCATE(2 * num_elems * sizeof(PrefixedPosting));
+    for (uint32_t i = 0; i < num_elems; i++) {
+        elems[i].prefix  = SI_term_prefix(postings[i]);
+        elems[i].posting = postings[i];
+    }
+    PrefixedPosting *sorted = S_radix_sort(elems, elems + num_elems,
+                                           num_elems);
+
+    // Postings whose prefixes tie may still differ in later term bytes, and
+    // always need ordering by doc id.  The radix sort is stable and postings
+    // usually arrive in doc id order, so most tied runs are already sorted;
+    // check before paying for a full comparison sort.
+    if (ivars->scratch_cap < ivars->cache_cap) {
+        ivars->scratch_cap = ivars->cache_cap;
+        ivars->scratch
+            = (uint8_t*)REALLOCATE(ivars->scratch,
+                                   ivars->scratch_cap * ivars->width);
+    }
+    uint32_t i = 0;
+    while (i < num_elems) {
+        uint32_t end = i + 1;
+        postings[i] = sorted[i].posting;
+        while (end < num_elems && sorted[end].prefix == sorted[i].prefix) {
+            postings[end] = sorted[end].posting;
+            end++;
+        }
+        for (uint32_t j = i + 1; j < end; j++) {
+            if (PostPool_Compare_IMP(self, postings + j - 1,
+                                     postings + j) > 0) {
+                Sort_mergesort(postings + i, ivars->scratch, end - i,
+                               ivars->width,
+                               (CFISH_Sort_Compare_t)PostPool_Compare_IMP,
+                               self);
+                break;
+            }
+        }
+        i = end;
+    }
+
+    FREEMEM(elems);
+}
+
+static PrefixedPosting*
+S_radix_sort(PrefixedPosting *elems, PrefixedPosting *scratch,
+             uint32_t num_elems) {
+    // Gather the histograms for all eight byte positions in one pass.
+    uint32_t counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    for (uint32_t i = 0; i < num_elems; i++) {
+        uint64_t prefix = elems[i].prefix;
+        for (int byte = 0; byte < 8; byte++) {
+            counts[byte][(prefix >> (8 * byte)) & 0xFF]++;
+        }
+    }
+
+    PrefixedPosting *source = elems;
+    PrefixedPosting *dest   = scratch;
+    for (int byte = 0; byte < 8; byte++) {
+        uint32_t *count = counts[byte];
+        const int shift = 8 * byte;
+
+        // Skip positions where every prefix has the same byte, which is
+        // common for the tail bytes of short terms.
+        if (count[(source[0].prefix >> shift) & 0xFF] == num_elems) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            uint32_t bucket_count = count[bucket];
+            count[bucket] = offset;
+            offset += bucket_count;
+        }
+        for (uint32_t i = 0; i < num_elems; i++) {
+            uint32_t bucket = (source[i].prefix >> shift) & 0xFF;
+            dest[count[bucket]++] = source[i];
+        }
+
+        PrefixedPosting *temp = source;
+        source = dest;
+        dest   = temp;
+    }
+
+    return source;
+}
+
 MemoryPool*
 PostPool_Get_Mem_Pool_IMP(PostingPool *self) {
     return PostPool_IVARS(self)->mem_pool;
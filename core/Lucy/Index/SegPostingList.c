@@ -65,6 +65,7 @@ SegPList_init(SegPostingList *self, PostingListReader *plist_reader,
     // Init.
     ivars->doc_freq        = 0;
     ivars->count           = 0;
+    ivars->doc_ids_only    = false;
 
     // Init skipping vars.
     ivars->skip_stepper    = SkipStepper_new();
@@ -168,7 +169,12 @@ SegPList_Next_IMP(SegPostingList *self) {
     }
     ivars->count++;
 
-    Post_Read_Record(posting, post_stream);
+    if (ivars->doc_ids_only) {
+        Post_Skip_Record(posting, post_stream);
+    }
+    else {
+        Post_Read_Record(posting, post_stream);
+    }
 
     return Post_IVARS(posting)->doc_id;
 }
@@ -304,10 +310,16 @@ Matcher*
 SegPList_Make_Matcher_IMP(SegPostingList *self, Similarity *sim,
                           Compiler *compiler, bool need_score) {
     SegPostingListIVARS *const ivars = SegPList_IVARS(self);
+    if (!need_score) { ivars->doc_ids_only = true; }
     return Post_Make_Matcher(ivars->posting, sim, (PostingList*)self, compiler,
                              need_score);
 }
 
+void
+SegPList_Set_Doc_IDs_Only_IMP(SegPostingList *self, bool doc_ids_only) {
+    SegPList_IVARS(self)->doc_ids_only = doc_ids_only;
+}
+
 RawPosting*
 SegPList_Read_Raw_IMP(SegPostingList *self, int32_t last_doc_id,
                       String *term_text, MemoryPool *mem_pool) {
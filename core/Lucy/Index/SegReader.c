@@ -94,6 +94,16 @@ SegReader_Register_IMP(SegReader *self, String *api,
     Hash_Store(ivars->components, (Obj*)api, (Obj*)component);
 }
 
+void
+SegReader_Override_Deletions_IMP(SegReader *self,
+                                 DeletionsReader *del_reader) {
+    SegReaderIVARS *const ivars = SegReader_IVARS(self);
+    CERTIFY(del_reader, DELETIONSREADER);
+    Hash_Store(ivars->components, (Obj*)VTable_Get_Name(DELETIONSREADER),
+               (Obj*)del_reader);
+    ivars->del_count = DelReader_Del_Count(del_reader);
+}
+
 String*
 SegReader_Get_Seg_Name_IMP(SegReader *self) {
     return SegReader_IVARS(self)->seg_name;
@@ -18,10 +18,16 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/SegWriter.h"
+#include "Clownfish/Util/SortUtils.h"
 #include "Lucy/Document/Doc.h"
+#include "Lucy/Plan/FieldType.h"
 #include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/SortRule.h"
 #include "Lucy/Store/DirHandle.h"
 #include "Lucy/Store/Folder.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFile.h"
 #include "Lucy/Index/DeletionsWriter.h"
 #include "Lucy/Index/Inverter.h"
 #include "Lucy/Index/PolyReader.h"
@@ -30,6 +36,17 @@
 #include "Lucy/Index/Snapshot.h"
 #include "Lucy/Plan/Architecture.h"
 
+// Convert a document's value for the index sort field to the field's type.
+static Obj*
+S_sort_key(FieldType *type, Obj *value);
+
+// Record the sorted runs of a segment being added or merged.
+static void
+S_add_sorted_runs(SegWriter *self, SegReader *reader, I32Array *doc_map);
+
+// Flush buffered docs as a sorted run once they take up this much memory.
+static size_t default_mem_thresh = 0x1000000;
+
 SegWriter*
 SegWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
               PolyReader *polyreader) {
@@ -47,6 +64,26 @@ SegWriter_init(SegWriter *self, Schema *schema, Snapshot *snapshot,
     ivars->inverter = Inverter_new(schema, segment);
     ivars->writers  = VA_new(16);
     Arch_Init_Seg_Writer(arch, self);
+
+    // Prepare to buffer docs if the index is sorted.
+    SortRule *index_sort = Schema_Get_Index_Sort(schema);
+    ivars->sorted_runs = VA_new(1);
+    ivars->runs_valid  = index_sort != NULL;
+    if (index_sort) {
+        String    *field = SortRule_Get_Field(index_sort);
+        FieldType *type  = Schema_Fetch_Type(schema, field);
+        if (!type || !FType_Sortable(type)) {
+            DECREF(self);
+            THROW(ERR, "Index sort field '%o' isn't a sortable field", field);
+        }
+        ivars->index_sort = (SortRule*)INCREF(index_sort);
+        ivars->sort_type  = (FieldType*)INCREF(type);
+        ivars->doc_buf    = RAMFile_new(NULL, false);
+        ivars->doc_out    = OutStream_open((Obj*)ivars->doc_buf);
+        ivars->sort_keys  = VA_new(0);
+        ivars->mem_thresh = default_mem_thresh;
+    }
+
     return self;
 }
 
@@ -57,6 +94,13 @@ SegWriter_Destroy_IMP(SegWriter *self) {
     DECREF(ivars->writers);
     DECREF(ivars->by_api);
     DECREF(ivars->del_writer);
+    DECREF(ivars->index_sort);
+    DECREF(ivars->sort_type);
+    DECREF(ivars->doc_out);
+    DECREF(ivars->doc_buf);
+    DECREF(ivars->sort_keys);
+    DECREF(ivars->sorted_runs);
+    FREEMEM(ivars->doc_offsets);
     SUPER_DESTROY(self, SEGWRITER);
 }
 
@@ -102,15 +146,179 @@ SegWriter_Prep_Seg_Dir_IMP(SegWriter *self) {
     if (!result) { RETHROW(INCREF(Err_get_error())); }
 }
 
+void
+SegWriter_set_default_mem_thresh(size_t mem_thresh) {
+    default_mem_thresh = mem_thresh;
+}
+
 void
 SegWriter_Add_Doc_IMP(SegWriter *self, Doc *doc, float boost) {
     SegWriterIVARS *const ivars = SegWriter_IVARS(self);
+
+    // Buffer the doc along with its sort key.  Doc ids are assigned later.
+    if (ivars->index_sort) {
+        uint32_t tick = VA_Get_Size(ivars->sort_keys);
+        if (tick == ivars->doc_offsets_cap) {
+            size_t new_cap = Memory_oversize(tick + 1, sizeof(int64_t));
+            ivars->doc_offsets
+                = (int64_t*)REALLOCATE(ivars->doc_offsets,
+                                       new_cap * sizeof(int64_t));
+            ivars->doc_offsets_cap = new_cap;
+        }
+        ivars->doc_offsets[tick] = OutStream_Tell(ivars->doc_out);
+        Doc_Serialize(doc, ivars->doc_out);
+        OutStream_Write_F32(ivars->doc_out, boost);
+        Obj *value = Doc_Extract(doc, SortRule_Get_Field(ivars->index_sort));
+        VA_Push(ivars->sort_keys, S_sort_key(ivars->sort_type, value));
+        DECREF(value);
+
+        // Bound the buffer by starting a new sorted run when it gets big.
+        // Each doc costs its serialized size plus its offset and sort key.
+        size_t consumed = (size_t)OutStream_Tell(ivars->doc_out)
+                          + (tick + 1) * (sizeof(int64_t) + sizeof(Obj*) + 32);
+        if (consumed > ivars->mem_thresh) {
+            SegWriter_Flush_Sorted_Docs(self);
+        }
+        return;
+    }
+
     int32_t doc_id = (int32_t)Seg_Increment_Count(ivars->segment, 1);
     Inverter_Invert_Doc(ivars->inverter, doc);
     Inverter_Set_Boost(ivars->inverter, boost);
     SegWriter_Add_Inverted_Doc(self, ivars->inverter, doc_id);
 }
 
+static Obj*
+S_sort_key(FieldType *type, Obj *value) {
+    if (value == NULL) { return NULL; }
+    switch (FType_Primitive_ID(type) & FType_PRIMITIVE_ID_MASK) {
+        case FType_TEXT:
+            return (Obj*)Str_Clone((String*)CERTIFY(value, STRING));
+        case FType_BLOB:
+            return (Obj*)BB_Clone((ByteBuf*)CERTIFY(value, BYTEBUF));
+        case FType_INT32:
+            return (Obj*)Int32_new((int32_t)Obj_To_I64(value));
+        case FType_INT64:
+            return (Obj*)Int64_new(Obj_To_I64(value));
+        case FType_FLOAT32:
+            return (Obj*)Float32_new((float)Obj_To_F64(value));
+        case FType_FLOAT64:
+            return (Obj*)Float64_new(Obj_To_F64(value));
+        default:
+            THROW(ERR, "Unrecognized type: %o", type);
+    }
+    UNREACHABLE_RETURN(Obj*);
+}
+
+// Compare buffered docs by sort key the way SortCollector will, breaking
+// ties by the order in which they were added.
+static int
+S_compare_buffered(void *context, const void *va, const void *vb) {
+    SegWriterIVARS *const ivars = (SegWriterIVARS*)context;
+    uint32_t a = *(uint32_t*)va;
+    uint32_t b = *(uint32_t*)vb;
+    int32_t comparison
+        = FType_null_back_compare_values(ivars->sort_type,
+                                         VA_Fetch(ivars->sort_keys, a),
+                                         VA_Fetch(ivars->sort_keys, b));
+    if (SortRule_Get_Reverse(ivars->index_sort)) {
+        // Same as a reversed SortRule at search time: NULLs come first.
+        comparison = -comparison;
+    }
+    if (comparison == 0) { comparison = a < b ? -1 : a > b ? 1 : 0; }
+    return comparison;
+}
+
+void
+SegWriter_Flush_Sorted_Docs_IMP(SegWriter *self) {
+    SegWriterIVARS *const ivars = SegWriter_IVARS(self);
+    if (!ivars->index_sort) { return; }
+    uint32_t num_docs = VA_Get_Size(ivars->sort_keys);
+    if (!num_docs) { return; }
+
+    uint32_t *order = (uint32_t*)MALLOCATE(num_docs * sizeof(uint32_t));
+    for (uint32_t i = 0; i < num_docs; i++) { order[i] = i; }
+    Sort_quicksort(order, num_docs, sizeof(uint32_t), S_compare_buffered,
+                   ivars);
+
+    // The flushed docs form one sorted run at the end of the segment.
+    int64_t run_start = Seg_Get_Count(ivars->segment) + 1;
+    VA_Push(ivars->sorted_runs, (Obj*)Str_newf("%i64", run_start));
+
+    OutStream_Close(ivars->doc_out);
+    InStream *instream = InStream_open((Obj*)ivars->doc_buf);
+    for (uint32_t i = 0; i < num_docs; i++) {
+        InStream_Seek(instream, ivars->doc_offsets[order[i]]);
+        Doc   *doc    = (Doc*)VTable_Make_Obj(DOC);
+        doc = Doc_Deserialize(doc, instream);
+        float  boost  = InStream_Read_F32(instream);
+        int32_t doc_id = (int32_t)Seg_Increment_Count(ivars->segment, 1);
+        Inverter_Invert_Doc(ivars->inverter, doc);
+        Inverter_Set_Boost(ivars->inverter, boost);
+        SegWriter_Add_Inverted_Doc(self, ivars->inverter, doc_id);
+        DECREF(doc);
+    }
+    DECREF(instream);
+    FREEMEM(order);
+
+    // Release the buffer.
+    VA_Clear(ivars->sort_keys);
+    DECREF(ivars->doc_out);
+    DECREF(ivars->doc_buf);
+    ivars->doc_buf = RAMFile_new(NULL, false);
+    ivars->doc_out = OutStream_open((Obj*)ivars->doc_buf);
+}
+
+static void
+S_add_sorted_runs(SegWriter *self, SegReader *reader, I32Array *doc_map) {
+    SegWriterIVARS *const ivars = SegWriter_IVARS(self);
+    if (!ivars->runs_valid) { return; }
+
+    // Find the first and last surviving docs.
+    int32_t doc_max = SegReader_Doc_Max(reader);
+    int32_t first = 0;
+    for (int32_t i = 1; i <= doc_max; i++) {
+        if (I32Arr_Get(doc_map, i)) { first = i; break; }
+    }
+    if (!first) { return; } // Nothing survives, so order is moot.
+
+    // Only a segment sorted the same way contributes sorted runs.
+    Segment *segment = SegReader_Get_Segment(reader);
+    Hash *metadata
+        = (Hash*)Seg_Fetch_Metadata_Utf8(segment, "index_sort", 10);
+    Obj *field   = metadata ? Hash_Fetch_Utf8(metadata, "field", 5) : NULL;
+    Obj *reverse = metadata ? Hash_Fetch_Utf8(metadata, "reverse", 7) : NULL;
+    VArray *runs = metadata
+                   ? (VArray*)Hash_Fetch_Utf8(metadata, "runs", 4)
+                   : NULL;
+    if (!field || !reverse || !runs
+        || !Str_Equals(SortRule_Get_Field(ivars->index_sort), field)
+        || !!Obj_To_I64(reverse)
+           != !!SortRule_Get_Reverse(ivars->index_sort)
+       ) {
+        ivars->runs_valid = false;
+        return;
+    }
+
+    // Translate each run's first surviving doc to its new doc id.
+    CERTIFY(runs, VARRAY);
+    uint32_t num_runs = VA_Get_Size(runs);
+    for (uint32_t i = 0; i < num_runs; i++) {
+        int32_t start = (int32_t)Obj_To_I64(VA_Fetch(runs, i));
+        int32_t limit = i + 1 < num_runs
+                        ? (int32_t)Obj_To_I64(VA_Fetch(runs, i + 1))
+                        : doc_max + 1;
+        for (int32_t j = start; j < limit; j++) {
+            int32_t new_doc_id = I32Arr_Get(doc_map, j);
+            if (new_doc_id) {
+                VA_Push(ivars->sorted_runs,
+                        (Obj*)Str_newf("%i32", new_doc_id));
+                break;
+            }
+        }
+    }
+}
+
 void
 SegWriter_Add_Inverted_Doc_IMP(SegWriter *self, Inverter *inverter,
                                int32_t doc_id) {
@@ -139,6 +347,8 @@ SegWriter_Add_Segment_IMP(SegWriter *self, SegReader *reader,
                           I32Array *doc_map) {
     SegWriterIVARS *const ivars = SegWriter_IVARS(self);
 
+    S_add_sorted_runs(self, reader, doc_map);
+
     // Bulk add the slab of documents to the various writers.
     for (uint32_t i = 0, max = VA_Get_Size(ivars->writers); i < max; i++) {
         DataWriter *writer = (DataWriter*)VA_Fetch(ivars->writers, i);
@@ -160,6 +370,8 @@ SegWriter_Merge_Segment_IMP(SegWriter *self, SegReader *reader,
     Snapshot *snapshot = SegWriter_Get_Snapshot(self);
     String   *seg_name = Seg_Get_Name(SegReader_Get_Segment(reader));
 
+    S_add_sorted_runs(self, reader, doc_map);
+
     // Have all the sub-writers merge the segment.
     for (uint32_t i = 0, max = VA_Get_Size(ivars->writers); i < max; i++) {
         DataWriter *writer = (DataWriter*)VA_Fetch(ivars->writers, i);
@@ -196,6 +408,20 @@ SegWriter_Finish_IMP(SegWriter *self) {
     SegWriterIVARS *const ivars = SegWriter_IVARS(self);
     String *seg_name = Seg_Get_Name(ivars->segment);
 
+    // Add buffered docs, then record which doc id ranges are sorted.
+    SegWriter_Flush_Sorted_Docs(self);
+    if (ivars->runs_valid && Seg_Get_Count(ivars->segment)) {
+        Hash *metadata = Hash_new(3);
+        String *field = SortRule_Get_Field(ivars->index_sort);
+        Hash_Store_Utf8(metadata, "field", 5, (Obj*)Str_Clone(field));
+        Hash_Store_Utf8(metadata, "reverse", 7,
+                        (Obj*)Str_newf("%i32", (int32_t)SortRule_Get_Reverse(
+                                           ivars->index_sort)));
+        Hash_Store_Utf8(metadata, "runs", 4, INCREF(ivars->sorted_runs));
+        Seg_Store_Metadata_Utf8(ivars->segment, "index_sort", 10,
+                                (Obj*)metadata);
+    }
+
     // Finish off children.
     for (uint32_t i = 0, max = VA_Get_Size(ivars->writers); i < max; i++) {
         DataWriter *writer = (DataWriter*)VA_Fetch(ivars->writers, i);
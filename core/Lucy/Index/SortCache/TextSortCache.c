@@ -60,6 +60,19 @@ TextSortCache_init(TextSortCache *self, String *field,
               "field %o", max_ords, doc_max, field);
     }
 
+    // Memory map the offsets and the character data, so that values can be
+    // read in place.  The offsets hold one entry per ord plus a final entry
+    // marking the end of the data.
+    int64_t ix_len  = InStream_Length(ix_in);
+    int64_t dat_len = InStream_Length(dat_in);
+    if (ix_len < ((int64_t)cardinality + 1) * (int64_t)sizeof(int64_t)) {
+        THROW(ERR, "Sort cache index for field %o too short: %i64 bytes for "
+              "cardinality %i32", field, ix_len, cardinality);
+    }
+    ivars->offsets = InStream_Buf(ix_in, (size_t)ix_len);
+    ivars->dat     = dat_len ? InStream_Buf(dat_in, (size_t)dat_len) : NULL;
+    ivars->dat_len = dat_len;
+
     // Assign.
     ivars->ord_in = (InStream*)INCREF(ord_in);
     ivars->ix_in  = (InStream*)INCREF(ix_in);
@@ -88,35 +101,88 @@ TextSortCache_Destroy_IMP(TextSortCache *self) {
 
 #define NULL_SENTINEL -1
 
-Obj*
-TextSortCache_Value_IMP(TextSortCache *self, int32_t ord) {
+static CFISH_INLINE int64_t
+SI_offset(const char *offsets, int32_t ord) {
+    return (int64_t)NumUtil_decode_bigend_u64(
+               (void*)(offsets + (size_t)ord * sizeof(int64_t)));
+}
+
+const char*
+TextSortCache_Value_Ptr_IMP(TextSortCache *self, int32_t ord, size_t *size) {
     TextSortCacheIVARS *const ivars = TextSortCache_IVARS(self);
     if (ord == ivars->null_ord) {
         return NULL;
     }
-    InStream_Seek(ivars->ix_in, ord * sizeof(int64_t));
-    int64_t offset = InStream_Read_I64(ivars->ix_in);
+    if (ord < 0 || ord >= ivars->cardinality) {
+        THROW(ERR, "Ordinal %i32 out of range for field %o (cardinality "
+              "%i32)", ord, ivars->field, ivars->cardinality);
+    }
+    int64_t offset = SI_offset(ivars->offsets, ord);
     if (offset == NULL_SENTINEL) {
         return NULL;
     }
-    else {
-        uint32_t next_ord = ord + 1;
-        int64_t next_offset;
-        while (1) {
-            InStream_Seek(ivars->ix_in, next_ord * sizeof(int64_t));
-            next_offset = InStream_Read_I64(ivars->ix_in);
-            if (next_offset != NULL_SENTINEL) { break; }
-            next_ord++;
-        }
 
-        // Read character data into String.
-        size_t len = (size_t)(next_offset - offset);
-        char *ptr = (char*)MALLOCATE(len + 1);
-        InStream_Seek(ivars->dat_in, offset);
-        InStream_Read_Bytes(ivars->dat_in, ptr, len);
-        ptr[len] = '\0';
-        return (Obj*)Str_new_steal_utf8(ptr, len);
+    // Skip past any NULL entries to find where the value ends.
+    int32_t next_ord    = ord + 1;
+    int64_t next_offset = SI_offset(ivars->offsets, next_ord);
+    while (next_offset == NULL_SENTINEL && next_ord < ivars->cardinality) {
+        next_offset = SI_offset(ivars->offsets, ++next_ord);
     }
+    if (offset > next_offset || next_offset > ivars->dat_len) {
+        THROW(ERR, "Corrupt sort cache for field %o at ord %i32",
+              ivars->field, ord);
+    }
+
+    *size = (size_t)(next_offset - offset);
+    return ivars->dat ? ivars->dat + offset : "";
 }
 
+Obj*
+TextSortCache_Value_IMP(TextSortCache *self, int32_t ord) {
+    size_t size;
+    const char *ptr = TextSortCache_Value_Ptr(self, ord, &size);
+    if (!ptr) { return NULL; }
+    return (Obj*)Str_new_from_trusted_utf8(ptr, size);
+}
+
+int32_t
+TextSortCache_Find_IMP(TextSortCache *self, Obj *term) {
+    TextSortCacheIVARS *const ivars = TextSortCache_IVARS(self);
+    FieldType *const type       = ivars->type;
+    void      *const allocation = alloca(SStr_size());
+    int32_t          lo         = 0;
+    int32_t          hi         = ivars->cardinality - 1;
+    int32_t          result     = -100;
+
+    // Binary search, wrapping each probed value in place.
+    while (hi >= lo) {
+        const int32_t mid = lo + ((hi - lo) / 2);
+        size_t size;
+        const char *ptr = TextSortCache_Value_Ptr(self, mid, &size);
+        Obj *val = ptr ? (Obj*)SStr_wrap_str(allocation, ptr, size) : NULL;
+        int32_t comparison = FType_null_back_compare_values(type, term, val);
+        if (comparison < 0) {
+            hi = mid - 1;
+        }
+        else if (comparison > 0) {
+            lo = mid + 1;
+        }
+        else {
+            result = mid;
+            break;
+        }
+    }
+
+    if (hi < 0) {
+        // Target is "less than" the first cache entry.
+        return -1;
+    }
+    else if (result == -100) {
+        // If result is still -100, it wasn't set.
+        return hi;
+    }
+    else {
+        return result;
+    }
+}
 
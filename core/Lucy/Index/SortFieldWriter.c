@@ -50,11 +50,16 @@ S_write_files(SortFieldWriter *self, OutStream *ord_out, OutStream *ix_out,
               OutStream *dat_out);
 
 typedef struct lucy_SFWriterElem {
+    uint64_t key;
     Obj *value;
     int32_t doc_id;
 } lucy_SFWriterElem;
 #define SFWriterElem lucy_SFWriterElem
 
+// Derive an order-preserving key for a value.
+static uint64_t
+S_normalized_key(int8_t prim_id, Obj *value);
+
 SortFieldWriter*
 SortFieldWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
                     PolyReader *polyreader, String *field,
@@ -91,8 +96,10 @@ SortFieldWriter_init(SortFieldWriter *self, Schema *schema,
     ivars->sort_cache      = NULL;
     ivars->doc_map         = NULL;
     ivars->sorted_ids      = NULL;
-    ivars->run_ord         = 0;
+    ivars->num_sorted      = 0;
     ivars->run_tick        = 0;
+    ivars->num_spills      = 0;
+    ivars->bytes_spilled   = 0;
     ivars->ord_width       = 0;
     ivars->last_val        = NULL;
 
@@ -122,6 +129,23 @@ SortFieldWriter_init(SortFieldWriter *self, Schema *schema,
     }
     ivars->uniq_vals = (Hash*)ZKHash_new(memory_pool, ivars->prim_id);
 
+    // Keys can only stand in for values which sort the stock way.  Text keys
+    // hold just a prefix, so ties must be settled by comparing values.
+    FType_Compare_Values_t compare_values
+        = METHOD_PTR(FType_Get_VTable(type), LUCY_FType_Compare_Values);
+    switch (ivars->prim_id & FType_PRIMITIVE_ID_MASK) {
+        case FType_TEXT:
+        case FType_INT32:
+        case FType_INT64:
+        case FType_FLOAT32:
+        case FType_FLOAT64:
+            ivars->use_keys = compare_values == FType_Compare_Values_IMP;
+            break;
+        default:
+            ivars->use_keys = false;
+    }
+    ivars->exact_keys = ivars->use_keys && !ivars->var_width;
+
     return self;
 }
 
@@ -175,6 +199,57 @@ SortFieldWriter_Get_Ord_Width_IMP(SortFieldWriter *self) {
     return SortFieldWriter_IVARS(self)->ord_width;
 }
 
+int32_t
+SortFieldWriter_Get_Num_Spills_IMP(SortFieldWriter *self) {
+    return SortFieldWriter_IVARS(self)->num_spills;
+}
+
+int64_t
+SortFieldWriter_Get_Bytes_Spilled_IMP(SortFieldWriter *self) {
+    return SortFieldWriter_IVARS(self)->bytes_spilled;
+}
+
+size_t
+SortFieldWriter_Mem_Used_IMP(SortFieldWriter *self) {
+    SortFieldWriterIVARS *const ivars = SortFieldWriter_IVARS(self);
+    return ivars->cache_max * ivars->width;
+}
+
+static uint64_t
+S_normalized_key(int8_t prim_id, Obj *value) {
+    switch (prim_id & FType_PRIMITIVE_ID_MASK) {
+        case FType_TEXT: {
+                // Big-endian UTF-8 prefix, zero padded.  Byte order is code
+                // point order.
+                String *string = (String*)value;
+                const uint8_t *ptr = (const uint8_t*)Str_Get_Ptr8(string);
+                size_t size = Str_Get_Size(string);
+                uint64_t key = 0;
+                for (size_t i = 0; i < 8; i++) {
+                    key = (key << 8) | (i < size ? ptr[i] : 0);
+                }
+                return key;
+            }
+        case FType_INT32:
+        case FType_INT64:
+            // Flip the sign bit so that negatives sort first.
+            return (uint64_t)Obj_To_I64(value) ^ UINT64_C(0x8000000000000000);
+        case FType_FLOAT32:
+        case FType_FLOAT64: {
+                // Adding zero turns -0.0 into 0.0, which compares equal.
+                double   f64 = Obj_To_F64(value) + 0.0;
+                uint64_t bits;
+                memcpy(&bits, &f64, sizeof(bits));
+                return bits & UINT64_C(0x8000000000000000)
+                       ? ~bits
+                       : bits | UINT64_C(0x8000000000000000);
+            }
+        default:
+            THROW(ERR, "Unrecognized primitive id: %i32", (int32_t)prim_id);
+            UNREACHABLE_RETURN(uint64_t);
+    }
+}
+
 static Obj*
 S_find_unique_value(Hash *uniq_vals, Obj *val) {
     int32_t  hash_sum  = Obj_Hash_Sum(val);
@@ -192,7 +267,10 @@ SortFieldWriter_Add_IMP(SortFieldWriter *self, int32_t doc_id, Obj *value) {
 
     // Uniq-ify the value, and record it for this document.
     SFWriterElem elem;
-    elem.value = S_find_unique_value(ivars->uniq_vals, value);
+    elem.value  = S_find_unique_value(ivars->uniq_vals, value);
+    elem.key    = ivars->use_keys
+                  ? S_normalized_key(ivars->prim_id, elem.value)
+                  : 0;
     elem.doc_id = doc_id;
     SortFieldWriter_Feed(self, &elem);
     ivars->count++;
@@ -213,7 +291,6 @@ SortFieldWriter_Add_Segment_IMP(SortFieldWriter *self, SegReader *reader,
     run_ivars->run_max    = SegReader_Doc_Max(reader);
     run_ivars->run_cardinality = SortCache_Get_Cardinality(sort_cache);
     run_ivars->null_ord   = SortCache_Get_Null_Ord(sort_cache);
-    run_ivars->run_tick   = 1;
     SortFieldWriter_Add_Run(self, (SortExternal*)run);
 }
 
@@ -338,34 +415,144 @@ SortFieldWriter_Compare_IMP(SortFieldWriter *self, void *va, void *vb) {
     SortFieldWriterIVARS *const ivars = SortFieldWriter_IVARS(self);
     SFWriterElem *a = (SFWriterElem*)va;
     SFWriterElem *b = (SFWriterElem*)vb;
-    int32_t comparison
-        = FType_null_back_compare_values(ivars->type, a->value, b->value);
-    if (comparison == 0) { comparison = b->doc_id - a->doc_id; }
-    return comparison;
+    if (a->key != b->key) { return a->key < b->key ? -1 : 1; }
+    if (a->value != b->value && !ivars->exact_keys) {
+        int32_t comparison
+            = FType_null_back_compare_values(ivars->type, a->value, b->value);
+        if (comparison != 0) { return comparison; }
+    }
+    return a->doc_id - b->doc_id;
 }
 
-static int
-S_compare_doc_ids_by_ord_rev(void *context, const void *va, const void *vb) {
-    SortCache *sort_cache = (SortCache*)context;
-    int32_t a = *(int32_t*)va;
-    int32_t b = *(int32_t*)vb;
-    int32_t ord_a = SortCache_Ordinal(sort_cache, a);
-    int32_t ord_b = SortCache_Ordinal(sort_cache, b);
-    return ord_a - ord_b;
+// LSD radix sort on the keys, 8 bits at a time.  Byte positions where every
+// key agrees -- e.g. the high bytes of small integers -- are skipped.
+static void
+S_radix_sort(SortFieldWriterIVARS *ivars) {
+    SFWriterElem *elems   = (SFWriterElem*)ivars->cache;
+    SFWriterElem *scratch = (SFWriterElem*)ivars->scratch;
+    const uint32_t num_elems = ivars->cache_max;
+    uint32_t counts[8][256];
+
+    memset(counts, 0, sizeof(counts));
+    for (uint32_t i = 0; i < num_elems; i++) {
+        uint64_t key = elems[i].key;
+        for (uint32_t byte = 0; byte < 8; byte++) {
+            counts[byte][(key >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    for (uint32_t byte = 0; byte < 8; byte++) {
+        uint32_t *const starts = counts[byte];
+        const uint32_t  shift  = byte * 8;
+        if (starts[(elems[0].key >> shift) & 0xFF] == num_elems) { continue; }
+        for (uint32_t i = 0, total = 0; i < 256; i++) {
+            uint32_t count = starts[i];
+            starts[i] = total;
+            total += count;
+        }
+        for (uint32_t i = 0; i < num_elems; i++) {
+            scratch[starts[(elems[i].key >> shift) & 0xFF]++] = elems[i];
+        }
+        SFWriterElem *temp = elems;
+        elems   = scratch;
+        scratch = temp;
+    }
+
+    // After an odd number of passes the sorted elements are in the scratch
+    // buffer, so trade buffers.
+    if ((uint8_t*)elems != ivars->cache) {
+        uint32_t cache_cap = ivars->cache_cap;
+        ivars->scratch     = ivars->cache;
+        ivars->cache       = (uint8_t*)elems;
+        ivars->cache_cap   = ivars->scratch_cap;
+        ivars->scratch_cap = cache_cap;
+    }
+}
+
+void
+SortFieldWriter_Sort_Cache_IMP(SortFieldWriter *self) {
+    SortFieldWriterIVARS *const ivars = SortFieldWriter_IVARS(self);
+    if (!ivars->use_keys) {
+        SortFieldWriter_Sort_Cache_t super_sort_cache
+            = (SortFieldWriter_Sort_Cache_t)SUPER_METHOD_PTR(
+                  SORTFIELDWRITER, LUCY_SortFieldWriter_Sort_Cache);
+        super_sort_cache(self);
+        return;
+    }
+    if (ivars->cache_tick != 0) {
+        THROW(ERR, "Cant Sort_Cache() after fetching %u32 items",
+              ivars->cache_tick);
+    }
+    if (ivars->cache_max < 2) { return; }
+    if (ivars->scratch_cap < ivars->cache_cap) {
+        ivars->scratch_cap = ivars->cache_cap;
+        ivars->scratch
+            = (uint8_t*)REALLOCATE(ivars->scratch,
+                                   ivars->scratch_cap * ivars->width);
+    }
+    S_radix_sort(ivars);
+
+    // Put each stretch of tied keys in order, if it isn't already.  For
+    // numeric fields, tied keys mean equal values, and elements usually
+    // arrive in doc id order, so this is only a check.
+    CFISH_Sort_Compare_t compare
+        = (CFISH_Sort_Compare_t)METHOD_PTR(SortFieldWriter_Get_VTable(self),
+                                           LUCY_SortFieldWriter_Compare);
+    SFWriterElem *const elems = (SFWriterElem*)ivars->cache;
+    const uint32_t num_elems = ivars->cache_max;
+    for (uint32_t start = 0, end; start < num_elems; start = end) {
+        bool in_order = true;
+        for (end = start + 1;
+             end < num_elems && elems[end].key == elems[start].key;
+             end++
+            ) {
+            if (in_order && compare(self, elems + end - 1, elems + end) > 0) {
+                in_order = false;
+            }
+        }
+        if (!in_order) {
+            Sort_mergesort(elems + start, ivars->scratch, end - start,
+                           sizeof(SFWriterElem), compare, self);
+        }
+    }
 }
 
+// Order the doc ids of a run by ordinal with a counting sort, skipping NULL
+// values and deleted docs.  Doc ids ascend within each ordinal, matching
+// Compare().
 static void
 S_lazy_init_sorted_ids(SortFieldWriter *self) {
     SortFieldWriterIVARS *const ivars = SortFieldWriter_IVARS(self);
-    if (!ivars->sorted_ids) {
-        ivars->sorted_ids
-            = (int32_t*)MALLOCATE((ivars->run_max + 1) * sizeof(int32_t));
-        for (int32_t i = 0, max = ivars->run_max; i <= max; i++) {
-            ivars->sorted_ids[i] = i;
-        }
-        Sort_quicksort(ivars->sorted_ids + 1, ivars->run_max, sizeof(int32_t),
-                       S_compare_doc_ids_by_ord_rev, ivars->sort_cache);
+    if (ivars->sorted_ids) { return; }
+
+    SortCache *const sort_cache  = ivars->sort_cache;
+    I32Array  *const doc_map     = ivars->doc_map;
+    const int32_t    null_ord    = ivars->null_ord;
+    const int32_t    cardinality = ivars->run_cardinality;
+    const int32_t    run_max     = ivars->run_max;
+    int32_t *starts
+        = (int32_t*)CALLOCATE(cardinality + 1, sizeof(int32_t));
+
+    for (int32_t doc_id = 1; doc_id <= run_max; doc_id++) {
+        int32_t ord = SortCache_Ordinal(sort_cache, doc_id);
+        if (ord == null_ord) { continue; }
+        if (doc_map && !I32Arr_Get(doc_map, doc_id)) { continue; }
+        starts[ord + 1]++;
     }
+    for (int32_t ord = 0; ord < cardinality; ord++) {
+        starts[ord + 1] += starts[ord];
+    }
+
+    ivars->num_sorted = starts[cardinality];
+    ivars->sorted_ids
+        = (int32_t*)MALLOCATE((ivars->num_sorted + 1) * sizeof(int32_t));
+    for (int32_t doc_id = 1; doc_id <= run_max; doc_id++) {
+        int32_t ord = SortCache_Ordinal(sort_cache, doc_id);
+        if (ord == null_ord) { continue; }
+        if (doc_map && !I32Arr_Get(doc_map, doc_id)) { continue; }
+        ivars->sorted_ids[starts[ord]++] = doc_id;
+    }
+    FREEMEM(starts);
 }
 
 void
@@ -419,6 +606,12 @@ SortFieldWriter_Flush_IMP(SortFieldWriter *self) {
     }
     run_ivars->dat_end = OutStream_Tell(temp_dat_out);
 
+    // Account for the spill.
+    ivars->num_spills++;
+    ivars->bytes_spilled += (run_ivars->ord_end - run_ivars->ord_start)
+                            + (run_ivars->ix_end - run_ivars->ix_start)
+                            + (run_ivars->dat_end - run_ivars->dat_start);
+
     // Add the run to the array.
     SortFieldWriter_Add_Run(self, (SortExternal*)run);
 }
@@ -438,48 +631,49 @@ SortFieldWriter_Refill_IMP(SortFieldWriter *self) {
     MemPool_Release_All(ivars->mem_pool);
     S_lazy_init_sorted_ids(self);
 
-    const int32_t    null_ord   = ivars->null_ord;
+    const int8_t     prim_id    = ivars->prim_id;
+    const bool       use_keys   = ivars->use_keys;
+    const int32_t   *sorted_ids = ivars->sorted_ids;
     Hash *const      uniq_vals  = ivars->uniq_vals;
     I32Array *const  doc_map    = ivars->doc_map;
     SortCache *const sort_cache = ivars->sort_cache;
+    const size_t     width      = ivars->width;
 
-    while (ivars->run_ord < ivars->run_cardinality
-           && MemPool_Get_Consumed(ivars->mem_pool) < ivars->mem_thresh
-          ) {
-        Obj *val = SortCache_Value(sort_cache, ivars->run_ord);
-        if (val) {
-            Hash_Store(uniq_vals, val, (Obj*)CFISH_TRUE);
-            DECREF(val);
+    // Docs arrive grouped by ordinal, so each value is decoded once.  Stop
+    // once values and elements together reach the memory threshold.
+    uint32_t count    = 0;
+    int32_t  last_ord = -1;
+    SFWriterElem elem;
+    elem.value = NULL;
+    elem.key   = 0;
+    while (ivars->run_tick < ivars->num_sorted) {
+        if (count
+            && MemPool_Get_Consumed(ivars->mem_pool)
+               + ivars->cache_max * width >= ivars->mem_thresh
+           ) {
             break;
         }
-        ivars->run_ord++;
-    }
-    uint32_t count = 0;
-    while (ivars->run_tick <= ivars->run_max) {
-        int32_t raw_doc_id = ivars->sorted_ids[ivars->run_tick];
+        int32_t raw_doc_id = sorted_ids[ivars->run_tick];
         int32_t ord = SortCache_Ordinal(sort_cache, raw_doc_id);
-        if (ord != null_ord) {
-            int32_t remapped = doc_map
-                               ? I32Arr_Get(doc_map, raw_doc_id)
-                               : raw_doc_id;
-            if (remapped) {
-                Obj *val = SortCache_Value(sort_cache, ord);
-                SortFieldWriter_Add(self, remapped, val);
-                count++;
-                DECREF(val);
-            }
-        }
-        else if (ord > ivars->run_ord) {
-            break;
+        if (ord != last_ord) {
+            Obj *val = SortCache_Value(sort_cache, ord);
+            elem.value = S_find_unique_value(uniq_vals, val);
+            elem.key   = use_keys ? S_normalized_key(prim_id, elem.value) : 0;
+            DECREF(val);
+            last_ord = ord;
         }
+        elem.doc_id = doc_map ? I32Arr_Get(doc_map, raw_doc_id) : raw_doc_id;
+        SortFieldWriter_Feed(self, &elem);
+        count++;
         ivars->run_tick++;
     }
-    ivars->run_ord++;
     SortFieldWriter_Sort_Cache(self);
 
-    if (ivars->run_ord >= ivars->run_cardinality) {
+    if (ivars->run_tick >= ivars->num_sorted) {
         DECREF(ivars->sort_cache);
         ivars->sort_cache = NULL;
+        FREEMEM(ivars->sorted_ids);
+        ivars->sorted_ids = NULL;
     }
 
     return count;
@@ -65,6 +65,8 @@ SortWriter_init(SortWriter *self, Schema *schema, Snapshot *snapshot,
     ivars->mem_pool        = MemPool_new(0);
     ivars->mem_thresh      = default_mem_thresh;
     ivars->flush_at_finish = false;
+    ivars->num_spills      = 0;
+    ivars->bytes_spilled   = 0;
 
     return self;
 }
@@ -150,7 +152,17 @@ SortWriter_Add_Inverted_Doc_IMP(SortWriter *self, Inverter *inverter,
 
     // If our SortFieldWriters have collectively passed the memory threshold,
     // flush all of them, then release all unique values with a single action.
-    if (MemPool_Get_Consumed(ivars->mem_pool) > ivars->mem_thresh) {
+    // Both the unique values and the elements pointing at them count.
+    VArray *const field_writers = ivars->field_writers;
+    size_t mem_used = MemPool_Get_Consumed(ivars->mem_pool);
+    for (uint32_t i = 0, max = VA_Get_Size(field_writers); i < max; i++) {
+        SortFieldWriter *const field_writer
+            = (SortFieldWriter*)VA_Fetch(field_writers, i);
+        if (field_writer) {
+            mem_used += SortFieldWriter_Mem_Used(field_writer);
+        }
+    }
+    if (mem_used > ivars->mem_thresh) {
         for (uint32_t i = 0; i < VA_Get_Size(ivars->field_writers); i++) {
             SortFieldWriter *const field_writer
                 = (SortFieldWriter*)VA_Fetch(ivars->field_writers, i);
@@ -229,6 +241,9 @@ SortWriter_Finish_IMP(SortWriter *self) {
             int32_t ord_width = SortFieldWriter_Get_Ord_Width(field_writer);
             Hash_Store(ivars->ord_widths, (Obj*)field,
                        (Obj*)Str_newf("%i32", ord_width));
+            ivars->num_spills += SortFieldWriter_Get_Num_Spills(field_writer);
+            ivars->bytes_spilled
+                += SortFieldWriter_Get_Bytes_Spilled(field_writer);
         }
 
         DECREF(field_writer);
@@ -272,4 +287,14 @@ SortWriter_Format_IMP(SortWriter *self) {
     return SortWriter_current_file_format;
 }
 
+int32_t
+SortWriter_Get_Num_Spills_IMP(SortWriter *self) {
+    return SortWriter_IVARS(self)->num_spills;
+}
+
+int64_t
+SortWriter_Get_Bytes_Spilled_IMP(SortWriter *self) {
+    return SortWriter_IVARS(self)->bytes_spilled;
+}
+
 
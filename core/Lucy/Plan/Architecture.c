@@ -21,6 +21,7 @@
 #include "Lucy/Index/DeletionsReader.h"
 #include "Lucy/Index/DeletionsWriter.h"
 #include "Lucy/Index/DocReader.h"
+#include "Lucy/Index/DocValuesReader.h"
 #include "Lucy/Index/DocWriter.h"
 #include "Lucy/Index/HighlightReader.h"
 #include "Lucy/Index/HighlightWriter.h"
@@ -29,6 +30,12 @@
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Index/PostingListReader.h"
 #include "Lucy/Index/PostingListWriter.h"
+#include "Lucy/Index/PointReader.h"
+#include "Lucy/Index/PointWriter.h"
+#include "Lucy/Index/ImpactReader.h"
+#include "Lucy/Index/ImpactWriter.h"
+#include "Lucy/Index/KeyFilterReader.h"
+#include "Lucy/Index/KeyFilterWriter.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/SegWriter.h"
@@ -63,6 +70,9 @@ Arch_Init_Seg_Writer_IMP(Architecture *self, SegWriter *writer) {
     Arch_Register_Lexicon_Writer(self, writer);
     Arch_Register_Posting_List_Writer(self, writer);
     Arch_Register_Sort_Writer(self, writer);
+    Arch_Register_Point_Writer(self, writer);
+    Arch_Register_Impact_Writer(self, writer);
+    Arch_Register_Key_Filter_Writer(self, writer);
     Arch_Register_Doc_Writer(self, writer);
     Arch_Register_Highlight_Writer(self, writer);
     Arch_Register_Deletions_Writer(self, writer);
@@ -131,6 +141,48 @@ Arch_Register_Sort_Writer_IMP(Architecture *self, SegWriter *writer) {
     SegWriter_Add_Writer(writer, (DataWriter*)INCREF(sort_writer));
 }
 
+void
+Arch_Register_Point_Writer_IMP(Architecture *self, SegWriter *writer) {
+    Schema      *schema     = SegWriter_Get_Schema(writer);
+    Snapshot    *snapshot   = SegWriter_Get_Snapshot(writer);
+    Segment     *segment    = SegWriter_Get_Segment(writer);
+    PolyReader  *polyreader = SegWriter_Get_PolyReader(writer);
+    PointWriter *point_writer
+        = PointWriter_new(schema, snapshot, segment, polyreader);
+    UNUSED_VAR(self);
+    SegWriter_Register(writer, VTable_Get_Name(POINTWRITER),
+                       (DataWriter*)point_writer);
+    SegWriter_Add_Writer(writer, (DataWriter*)INCREF(point_writer));
+}
+
+void
+Arch_Register_Impact_Writer_IMP(Architecture *self, SegWriter *writer) {
+    Schema       *schema     = SegWriter_Get_Schema(writer);
+    Snapshot     *snapshot   = SegWriter_Get_Snapshot(writer);
+    Segment      *segment    = SegWriter_Get_Segment(writer);
+    PolyReader   *polyreader = SegWriter_Get_PolyReader(writer);
+    ImpactWriter *impact_writer
+        = ImpactWriter_new(schema, snapshot, segment, polyreader);
+    UNUSED_VAR(self);
+    SegWriter_Register(writer, VTable_Get_Name(IMPACTWRITER),
+                       (DataWriter*)impact_writer);
+    SegWriter_Add_Writer(writer, (DataWriter*)INCREF(impact_writer));
+}
+
+void
+Arch_Register_Key_Filter_Writer_IMP(Architecture *self, SegWriter *writer) {
+    Schema          *schema     = SegWriter_Get_Schema(writer);
+    Snapshot        *snapshot   = SegWriter_Get_Snapshot(writer);
+    Segment         *segment    = SegWriter_Get_Segment(writer);
+    PolyReader      *polyreader = SegWriter_Get_PolyReader(writer);
+    KeyFilterWriter *key_filter_writer
+        = KeyFilterWriter_new(schema, snapshot, segment, polyreader);
+    UNUSED_VAR(self);
+    SegWriter_Register(writer, VTable_Get_Name(KEYFILTERWRITER),
+                       (DataWriter*)key_filter_writer);
+    SegWriter_Add_Writer(writer, (DataWriter*)INCREF(key_filter_writer));
+}
+
 void
 Arch_Register_Highlight_Writer_IMP(Architecture *self, SegWriter *writer) {
     Schema     *schema     = SegWriter_Get_Schema(writer);
@@ -165,6 +217,10 @@ Arch_Init_Seg_Reader_IMP(Architecture *self, SegReader *reader) {
     Arch_Register_Lexicon_Reader(self, reader);
     Arch_Register_Posting_List_Reader(self, reader);
     Arch_Register_Sort_Reader(self, reader);
+    Arch_Register_Doc_Values_Reader(self, reader);
+    Arch_Register_Point_Reader(self, reader);
+    Arch_Register_Impact_Reader(self, reader);
+    Arch_Register_Key_Filter_Reader(self, reader);
     Arch_Register_Highlight_Reader(self, reader);
     Arch_Register_Deletions_Reader(self, reader);
 }
@@ -228,6 +284,65 @@ Arch_Register_Sort_Reader_IMP(Architecture *self, SegReader *reader) {
                        (DataReader*)sort_reader);
 }
 
+void
+Arch_Register_Doc_Values_Reader_IMP(Architecture *self, SegReader *reader) {
+    Schema     *schema   = SegReader_Get_Schema(reader);
+    Folder     *folder   = SegReader_Get_Folder(reader);
+    VArray     *segments = SegReader_Get_Segments(reader);
+    Snapshot   *snapshot = SegReader_Get_Snapshot(reader);
+    int32_t     seg_tick = SegReader_Get_Seg_Tick(reader);
+    SortReader *sort_reader = (SortReader*)SegReader_Fetch(
+                                  reader, VTable_Get_Name(SORTREADER));
+    DefaultDocValuesReader *doc_values_reader
+        = DefDocValuesReader_new(schema, folder, snapshot, segments, seg_tick,
+                                 sort_reader);
+    UNUSED_VAR(self);
+    SegReader_Register(reader, VTable_Get_Name(DOCVALUESREADER),
+                       (DataReader*)doc_values_reader);
+}
+
+void
+Arch_Register_Point_Reader_IMP(Architecture *self, SegReader *reader) {
+    Schema     *schema   = SegReader_Get_Schema(reader);
+    Folder     *folder   = SegReader_Get_Folder(reader);
+    VArray     *segments = SegReader_Get_Segments(reader);
+    Snapshot   *snapshot = SegReader_Get_Snapshot(reader);
+    int32_t     seg_tick = SegReader_Get_Seg_Tick(reader);
+    DefaultPointReader *point_reader
+        = DefPointReader_new(schema, folder, snapshot, segments, seg_tick);
+    UNUSED_VAR(self);
+    SegReader_Register(reader, VTable_Get_Name(POINTREADER),
+                       (DataReader*)point_reader);
+}
+
+void
+Arch_Register_Impact_Reader_IMP(Architecture *self, SegReader *reader) {
+    Schema     *schema   = SegReader_Get_Schema(reader);
+    Folder     *folder   = SegReader_Get_Folder(reader);
+    VArray     *segments = SegReader_Get_Segments(reader);
+    Snapshot   *snapshot = SegReader_Get_Snapshot(reader);
+    int32_t     seg_tick = SegReader_Get_Seg_Tick(reader);
+    DefaultImpactReader *impact_reader
+        = DefImpactReader_new(schema, folder, snapshot, segments, seg_tick);
+    UNUSED_VAR(self);
+    SegReader_Register(reader, VTable_Get_Name(IMPACTREADER),
+                       (DataReader*)impact_reader);
+}
+
+void
+Arch_Register_Key_Filter_Reader_IMP(Architecture *self, SegReader *reader) {
+    Schema     *schema   = SegReader_Get_Schema(reader);
+    Folder     *folder   = SegReader_Get_Folder(reader);
+    VArray     *segments = SegReader_Get_Segments(reader);
+    Snapshot   *snapshot = SegReader_Get_Snapshot(reader);
+    int32_t     seg_tick = SegReader_Get_Seg_Tick(reader);
+    DefaultKeyFilterReader *key_filter_reader
+        = DefKeyFilterReader_new(schema, folder, snapshot, segments, seg_tick);
+    UNUSED_VAR(self);
+    SegReader_Register(reader, VTable_Get_Name(KEYFILTERREADER),
+                       (DataReader*)key_filter_reader);
+}
+
 void
 Arch_Register_Highlight_Reader_IMP(Architecture *self, SegReader *reader) {
     Schema     *schema   = SegReader_Get_Schema(reader);
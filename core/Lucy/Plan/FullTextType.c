@@ -19,6 +19,7 @@
 
 #include "Lucy/Plan/FullTextType.h"
 #include "Lucy/Analysis/Analyzer.h"
+#include "Lucy/Analysis/CommonGramsFilter.h"
 #include "Lucy/Index/Posting/ScorePosting.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Util/Freezer.h"
@@ -48,6 +49,8 @@ FullTextType_init2(FullTextType *self, Analyzer *analyzer, float boost,
     ivars->sortable      = sortable;
     ivars->highlightable = highlightable;
     ivars->analyzer      = (Analyzer*)INCREF(analyzer);
+    ivars->common_grams  = NULL;
+    ivars->impacts       = false;
 
     return self;
 }
@@ -56,6 +59,7 @@ void
 FullTextType_Destroy_IMP(FullTextType *self) {
     FullTextTypeIVARS *const ivars = FullTextType_IVARS(self);
     DECREF(ivars->analyzer);
+    DECREF(ivars->common_grams);
     SUPER_DESTROY(self, FULLTEXTTYPE);
 }
 
@@ -71,9 +75,17 @@ FullTextType_Equals_IMP(FullTextType *self, Obj *other) {
     if (!super_equals(self, other))                       { return false; }
     if (!!ivars->sortable      != !!ovars->sortable)      { return false; }
     if (!!ivars->highlightable != !!ovars->highlightable) { return false; }
+    if (!!ivars->impacts       != !!ovars->impacts)       { return false; }
     if (!Analyzer_Equals(ivars->analyzer, (Obj*)ovars->analyzer)) {
         return false;
     }
+    if (!ivars->common_grams != !ovars->common_grams)     { return false; }
+    if (ivars->common_grams
+        && !CommonGrams_Equals(ivars->common_grams,
+                               (Obj*)ovars->common_grams)
+       ) {
+        return false;
+    }
     return true;
 }
 
@@ -99,6 +111,13 @@ FullTextType_Dump_For_Schema_IMP(FullTextType *self) {
     if (ivars->highlightable) {
         Hash_Store_Utf8(dump, "highlightable", 13, (Obj*)CFISH_TRUE);
     }
+    if (ivars->impacts) {
+        Hash_Store_Utf8(dump, "impacts", 7, (Obj*)CFISH_TRUE);
+    }
+    if (ivars->common_grams) {
+        Hash_Store_Utf8(dump, "common_grams", 12,
+                        CommonGrams_Dump(ivars->common_grams));
+    }
 
     return dump;
 }
@@ -158,6 +177,19 @@ FullTextType_Load_IMP(FullTextType *self, Obj *dump) {
     FullTextType_init2(loaded, analyzer, boost, indexed, stored,
                        sortable, hl);
     DECREF(analyzer);
+
+    Obj *impacts_dump = Hash_Fetch_Utf8(source, "impacts", 7);
+    if (impacts_dump) {
+        FullTextType_IVARS(loaded)->impacts = Obj_To_Bool(impacts_dump);
+    }
+
+    Obj *common_grams_dump = Hash_Fetch_Utf8(source, "common_grams", 12);
+    if (common_grams_dump) {
+        FullTextType_IVARS(loaded)->common_grams
+            = (CommonGramsFilter*)CERTIFY(Freezer_load(common_grams_dump),
+                                          COMMONGRAMSFILTER);
+    }
+
     return loaded;
 }
 
@@ -166,6 +198,30 @@ FullTextType_Set_Highlightable_IMP(FullTextType *self, bool highlightable) {
     FullTextType_IVARS(self)->highlightable = highlightable;
 }
 
+void
+FullTextType_Set_Impacts_IMP(FullTextType *self, bool impacts) {
+    FullTextType_IVARS(self)->impacts = impacts;
+}
+
+bool
+FullTextType_Impacts_IMP(FullTextType *self) {
+    return FullTextType_IVARS(self)->impacts;
+}
+
+void
+FullTextType_Set_Common_Grams_IMP(FullTextType *self,
+                                  CommonGramsFilter *common_grams) {
+    FullTextTypeIVARS *const ivars = FullTextType_IVARS(self);
+    CommonGramsFilter *temp = ivars->common_grams;
+    ivars->common_grams = (CommonGramsFilter*)INCREF(common_grams);
+    DECREF(temp);
+}
+
+CommonGramsFilter*
+FullTextType_Get_Common_Grams_IMP(FullTextType *self) {
+    return FullTextType_IVARS(self)->common_grams;
+}
+
 Analyzer*
 FullTextType_Get_Analyzer_IMP(FullTextType *self) {
     return FullTextType_IVARS(self)->analyzer;
@@ -33,6 +33,7 @@ NumType_init2(NumericType *self, float boost, bool indexed, bool stored,
     ivars->indexed    = indexed;
     ivars->stored     = stored;
     ivars->sortable   = sortable;
+    ivars->points     = false;
     return self;
 }
 
@@ -42,6 +43,28 @@ NumType_Binary_IMP(NumericType *self) {
     return true;
 }
 
+void
+NumType_Set_Points_IMP(NumericType *self, bool points) {
+    NumType_IVARS(self)->points = points;
+}
+
+bool
+NumType_Points_IMP(NumericType *self) {
+    return NumType_IVARS(self)->points;
+}
+
+bool
+NumType_Equals_IMP(NumericType *self, Obj *other) {
+    if ((NumericType*)other == self)    { return true; }
+    if (!Obj_Is_A(other, NUMERICTYPE)) { return false; }
+    NumType_Equals_t super_equals
+        = SUPER_METHOD_PTR(NUMERICTYPE, LUCY_NumType_Equals);
+    if (!super_equals(self, other)) { return false; }
+    NumericTypeIVARS *const ivars = NumType_IVARS(self);
+    NumericTypeIVARS *const ovars = NumType_IVARS((NumericType*)other);
+    return !!ivars->points == !!ovars->points;
+}
+
 Hash*
 NumType_Dump_For_Schema_IMP(NumericType *self) {
     NumericTypeIVARS *const ivars = NumType_IVARS(self);
@@ -61,6 +84,9 @@ NumType_Dump_For_Schema_IMP(NumericType *self) {
     if (ivars->sortable) {
         Hash_Store_Utf8(dump, "sortable", 8, (Obj*)CFISH_TRUE);
     }
+    if (ivars->points) {
+        Hash_Store_Utf8(dump, "points", 6, (Obj*)CFISH_TRUE);
+    }
 
     return dump;
 }
@@ -114,11 +140,15 @@ NumType_Load_IMP(NumericType *self, Obj *dump) {
     Obj *indexed_dump = Hash_Fetch_Utf8(source, "indexed", 7);
     Obj *stored_dump  = Hash_Fetch_Utf8(source, "stored", 6);
     Obj *sort_dump    = Hash_Fetch_Utf8(source, "sortable", 8);
+    Obj *points_dump  = Hash_Fetch_Utf8(source, "points", 6);
     bool indexed  = indexed_dump ? Obj_To_Bool(indexed_dump) : true;
     bool stored   = stored_dump  ? Obj_To_Bool(stored_dump)  : true;
     bool sortable = sort_dump    ? Obj_To_Bool(sort_dump)    : false;
+    bool points   = points_dump  ? Obj_To_Bool(points_dump)  : false;
 
-    return NumType_init2(loaded, boost, indexed, stored, sortable);
+    NumType_init2(loaded, boost, indexed, stored, sortable);
+    NumType_IVARS(loaded)->points = points;
+    return loaded;
 }
 
 /****************************************************************************/
@@ -28,6 +28,7 @@
 #include "Lucy/Plan/StringType.h"
 #include "Lucy/Plan/FullTextType.h"
 #include "Lucy/Plan/Architecture.h"
+#include "Lucy/Search/SortRule.h"
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Util/Freezer.h"
 #include "Lucy/Util/Json.h"
@@ -78,6 +79,7 @@ Schema_Destroy_IMP(Schema *self) {
     DECREF(ivars->types);
     DECREF(ivars->sims);
     DECREF(ivars->sim);
+    DECREF(ivars->index_sort);
     SUPER_DESTROY(self, SCHEMA);
 }
 
@@ -95,6 +97,13 @@ S_add_unique(VArray *array, Obj *elem) {
     VA_Push(array, INCREF(elem));
 }
 
+static bool
+S_index_sorts_equal(SortRule *a, SortRule *b) {
+    if (a == NULL || b == NULL) { return a == b; }
+    if (SortRule_Get_Reverse(a) != SortRule_Get_Reverse(b)) { return false; }
+    return Str_Equals(SortRule_Get_Field(a), (Obj*)SortRule_Get_Field(b));
+}
+
 bool
 Schema_Equals_IMP(Schema *self, Obj *other) {
     if ((Schema*)other == self)                         { return true; }
@@ -104,6 +113,9 @@ Schema_Equals_IMP(Schema *self, Obj *other) {
     if (!Arch_Equals(ivars->arch, (Obj*)ovars->arch))   { return false; }
     if (!Sim_Equals(ivars->sim, (Obj*)ovars->sim))      { return false; }
     if (!Hash_Equals(ivars->types, (Obj*)ovars->types)) { return false; }
+    if (!S_index_sorts_equal(ivars->index_sort, ovars->index_sort)) {
+        return false;
+    }
     return true;
 }
 
@@ -223,6 +235,22 @@ Schema_Get_Similarity_IMP(Schema *self) {
     return Schema_IVARS(self)->sim;
 }
 
+void
+Schema_Set_Index_Sort_IMP(Schema *self, SortRule *rule) {
+    SchemaIVARS *const ivars = Schema_IVARS(self);
+    if (rule && SortRule_Get_Type(rule) != SortRule_FIELD) {
+        THROW(ERR, "Index sort must be a SortRule of type FIELD");
+    }
+    SortRule *old = ivars->index_sort;
+    ivars->index_sort = (SortRule*)INCREF(rule);
+    DECREF(old);
+}
+
+SortRule*
+Schema_Get_Index_Sort_IMP(Schema *self) {
+    return Schema_IVARS(self)->index_sort;
+}
+
 VArray*
 Schema_All_Fields_IMP(Schema *self) {
     return Hash_Keys(Schema_IVARS(self)->types);
@@ -261,6 +289,17 @@ Schema_Dump_IMP(Schema *self) {
     Hash_Store_Utf8(dump, "analyzers", 9,
                     Freezer_dump((Obj*)ivars->uniq_analyzers));
 
+    // Dump the index sort, if any.
+    if (ivars->index_sort) {
+        Hash *sort_dump = Hash_new(2);
+        String *sort_field = SortRule_Get_Field(ivars->index_sort);
+        Hash_Store_Utf8(sort_dump, "field", 5, (Obj*)Str_Clone(sort_field));
+        Hash_Store_Utf8(sort_dump, "reverse", 7,
+                        (Obj*)Bool_singleton(
+                            SortRule_Get_Reverse(ivars->index_sort)));
+        Hash_Store_Utf8(dump, "index_sort", 10, (Obj*)sort_dump);
+    }
+
     // Dump FieldTypes.
     Hash_Store_Utf8(dump, "fields", 6, (Obj*)type_dumps);
     Hash_Iterate(ivars->types);
@@ -396,6 +435,19 @@ Schema_Load_IMP(Schema *self, Obj *dump) {
         }
     }
 
+    // Restore the index sort.
+    Hash *sort_dump = (Hash*)Hash_Fetch_Utf8(source, "index_sort", 10);
+    if (sort_dump) {
+        CERTIFY(sort_dump, HASH);
+        String *sort_field
+            = (String*)CERTIFY(Hash_Fetch_Utf8(sort_dump, "field", 5),
+                               STRING);
+        Obj *reverse = Hash_Fetch_Utf8(sort_dump, "reverse", 7);
+        loaded_ivars->index_sort
+            = SortRule_new(SortRule_FIELD, sort_field,
+                           reverse ? Obj_To_Bool(reverse) : false);
+    }
+
     DECREF(analyzers);
 
     return loaded;
@@ -415,6 +467,11 @@ Schema_Eat_IMP(Schema *self, Schema *other) {
     while (Hash_Next(ovars->types, (Obj**)&field, (Obj**)&type)) {
         Schema_Spec_Field(self, field, type);
     }
+
+    SchemaIVARS *const ivars = Schema_IVARS(self);
+    if (!ivars->index_sort && ovars->index_sort) {
+        ivars->index_sort = (SortRule*)INCREF(ovars->index_sort);
+    }
 }
 
 void
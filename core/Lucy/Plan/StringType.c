@@ -41,6 +41,7 @@ StringType_init2(StringType *self, float boost, bool indexed,
     ivars->indexed    = indexed;
     ivars->stored     = stored;
     ivars->sortable   = sortable;
+    ivars->key        = false;
     return self;
 }
 
@@ -51,6 +52,9 @@ StringType_Equals_IMP(StringType *self, Obj *other) {
         = (StringType_Equals_t)SUPER_METHOD_PTR(STRINGTYPE,
                                                 LUCY_StringType_Equals);
     if (!super_equals(self, other)) { return false; }
+    StringTypeIVARS *const ivars = StringType_IVARS(self);
+    StringTypeIVARS *const ovars = StringType_IVARS((StringType*)other);
+    if (!!ivars->key != !!ovars->key) { return false; }
     return true;
 }
 
@@ -73,6 +77,9 @@ StringType_Dump_For_Schema_IMP(StringType *self) {
     if (ivars->sortable) {
         Hash_Store_Utf8(dump, "sortable", 8, (Obj*)CFISH_TRUE);
     }
+    if (ivars->key) {
+        Hash_Store_Utf8(dump, "key", 3, (Obj*)CFISH_TRUE);
+    }
 
     return dump;
 }
@@ -106,7 +113,24 @@ StringType_Load_IMP(StringType *self, Obj *dump) {
     bool  stored   = stored_dump   ? Obj_To_Bool(stored_dump)      : true;
     bool  sortable = sortable_dump ? Obj_To_Bool(sortable_dump)    : false;
 
-    return StringType_init2(loaded, boost, indexed, stored, sortable);
+    StringType_init2(loaded, boost, indexed, stored, sortable);
+
+    Obj *key_dump = Hash_Fetch_Utf8(source, "key", 3);
+    if (key_dump) {
+        StringType_IVARS(loaded)->key = Obj_To_Bool(key_dump);
+    }
+
+    return loaded;
+}
+
+void
+StringType_Set_Key_IMP(StringType *self, bool key) {
+    StringType_IVARS(self)->key = key;
+}
+
+bool
+StringType_Key_IMP(StringType *self) {
+    return StringType_IVARS(self)->key;
 }
 
 Similarity*
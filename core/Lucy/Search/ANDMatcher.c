@@ -37,6 +37,7 @@ ANDMatcher_init(ANDMatcher *self, VArray *children, Similarity *sim) {
     // Assign.
     ivars->more         = ivars->num_kids ? true : false;
     ivars->kids         = (Matcher**)MALLOCATE(ivars->num_kids * sizeof(Matcher*));
+    ivars->kid_docs     = (int32_t*)MALLOCATE(ivars->num_kids * sizeof(int32_t));
     for (uint32_t i = 0; i < ivars->num_kids; i++) {
         Matcher *child = (Matcher*)VA_Fetch(children, i);
         ivars->kids[i] = child;
@@ -53,6 +54,7 @@ void
 ANDMatcher_Destroy_IMP(ANDMatcher *self) {
     ANDMatcherIVARS *const ivars = ANDMatcher_IVARS(self);
     FREEMEM(ivars->kids);
+    FREEMEM(ivars->kid_docs);
     SUPER_DESTROY(self, ANDMATCHER);
 }
 
@@ -163,3 +165,69 @@ ANDMatcher_Score_IMP(ANDMatcher *self) {
     return score;
 }
 
+
+// Find the first doc at or after `target` which all children agree on.
+// Every child must be positioned before `target` or at a doc recorded in
+// `kid_docs`.  Returns 0 once any child is exhausted.
+static int32_t
+S_leapfrog(Matcher **kids, int32_t *kid_docs, uint32_t num_kids,
+           int32_t target) {
+    int32_t doc_id = target;
+    while (true) {
+        uint32_t i = 0;
+        for (; i < num_kids; i++) {
+            if (kid_docs[i] < doc_id) {
+                kid_docs[i] = Matcher_Advance(kids[i], doc_id);
+                if (!kid_docs[i]) { return 0; }
+            }
+            if (kid_docs[i] > doc_id) {
+                // Raise the bar and make the earlier children catch up.
+                doc_id = kid_docs[i];
+                break;
+            }
+        }
+        if (i == num_kids) { return doc_id; }
+    }
+}
+
+uint32_t
+ANDMatcher_Next_Block_IMP(ANDMatcher *self, int32_t *doc_ids, float *scores,
+                          uint32_t max) {
+    ANDMatcherIVARS *const ivars = ANDMatcher_IVARS(self);
+    Matcher **const kids     = ivars->kids;
+    int32_t  *const kid_docs = ivars->kid_docs;
+    const uint32_t  num_kids = ivars->num_kids;
+    const float     coord    = ivars->coord_factors[ivars->matching_kids];
+    uint32_t        num_docs = 0;
+
+    if (!ivars->more || !max) { return 0; }
+
+    // All children sit on the current doc -- or, the first time through, on
+    // their first docs.
+    for (uint32_t i = 0; i < num_kids; i++) {
+        kid_docs[i] = Matcher_Get_Doc_ID(kids[i]);
+    }
+    int32_t target = ivars->first_time ? 1 : kid_docs[0] + 1;
+    ivars->first_time = false;
+
+    while (num_docs < max) {
+        int32_t doc_id = S_leapfrog(kids, kid_docs, num_kids, target);
+        if (!doc_id) {
+            ivars->more = false;
+            break;
+        }
+        doc_ids[num_docs] = doc_id;
+        if (scores) {
+            float score = 0.0f;
+            for (uint32_t i = 0; i < num_kids; i++) {
+                score += Matcher_Score(kids[i]);
+            }
+            scores[num_docs] = score * coord;
+        }
+        num_docs++;
+        target = doc_id + 1;
+    }
+
+    return num_docs;
+}
+
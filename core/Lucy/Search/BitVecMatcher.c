@@ -60,4 +60,9 @@ BitVecMatcher_Get_Doc_ID_IMP(BitVecMatcher *self) {
     return BitVecMatcher_IVARS(self)->doc_id;
 }
 
+float
+BitVecMatcher_Score_IMP(BitVecMatcher *self) {
+    UNUSED_VAR(self);
+    return 0.0f;
+}
 
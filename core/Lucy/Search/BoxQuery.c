@@ -0,0 +1,283 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_BOXQUERY
+#define C_LUCY_BOXCOMPILER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/BoxQuery.h"
+#include "Clownfish/CharBuf.h"
+#include "Lucy/Index/PointReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Plan/FieldType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/BitVecMatcher.h"
+#include "Lucy/Search/Searcher.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Util/Freezer.h"
+
+// Compare bounds by numeric value, since a Dump/Load round trip turns
+// numbers into strings.
+static bool
+S_bounds_equal(VArray *bounds, VArray *other_bounds);
+
+BoxQuery*
+BoxQuery_new(VArray *fields, VArray *lower_bounds, VArray *upper_bounds) {
+    BoxQuery *self = (BoxQuery*)VTable_Make_Obj(BOXQUERY);
+    return BoxQuery_init(self, fields, lower_bounds, upper_bounds);
+}
+
+BoxQuery*
+BoxQuery_init(BoxQuery *self, VArray *fields, VArray *lower_bounds,
+              VArray *upper_bounds) {
+    Query_init((Query*)self, 0.0f);
+    BoxQueryIVARS *const ivars = BoxQuery_IVARS(self);
+    uint32_t num_fields = VA_Get_Size(fields);
+    ivars->fields       = VA_Shallow_Copy(fields);
+    ivars->lower_bounds = VA_Shallow_Copy(lower_bounds);
+    ivars->upper_bounds = VA_Shallow_Copy(upper_bounds);
+    VA_Resize(ivars->lower_bounds, num_fields);
+    VA_Resize(ivars->upper_bounds, num_fields);
+    if (!num_fields) {
+        DECREF(self);
+        THROW(ERR, "Must supply at least one field");
+    }
+    if (VA_Get_Size(lower_bounds) > num_fields
+        || VA_Get_Size(upper_bounds) > num_fields
+       ) {
+        DECREF(self);
+        THROW(ERR, "More bounds than fields");
+    }
+    for (uint32_t i = 0; i < num_fields; i++) {
+        CERTIFY(VA_Fetch(fields, i), STRING);
+    }
+    return self;
+}
+
+void
+BoxQuery_Destroy_IMP(BoxQuery *self) {
+    BoxQueryIVARS *const ivars = BoxQuery_IVARS(self);
+    DECREF(ivars->fields);
+    DECREF(ivars->lower_bounds);
+    DECREF(ivars->upper_bounds);
+    SUPER_DESTROY(self, BOXQUERY);
+}
+
+VArray*
+BoxQuery_Get_Fields_IMP(BoxQuery *self) {
+    return BoxQuery_IVARS(self)->fields;
+}
+
+VArray*
+BoxQuery_Get_Lower_Bounds_IMP(BoxQuery *self) {
+    return BoxQuery_IVARS(self)->lower_bounds;
+}
+
+VArray*
+BoxQuery_Get_Upper_Bounds_IMP(BoxQuery *self) {
+    return BoxQuery_IVARS(self)->upper_bounds;
+}
+
+bool
+BoxQuery_Equals_IMP(BoxQuery *self, Obj *other) {
+    if ((BoxQuery*)other == self)                     { return true; }
+    if (!Obj_Is_A(other, BOXQUERY))                   { return false; }
+    BoxQueryIVARS *const ivars = BoxQuery_IVARS(self);
+    BoxQueryIVARS *const ovars = BoxQuery_IVARS((BoxQuery*)other);
+    if (ivars->boost != ovars->boost)                 { return false; }
+    if (!VA_Equals(ivars->fields, (Obj*)ovars->fields)) { return false; }
+    if (!S_bounds_equal(ivars->lower_bounds, ovars->lower_bounds)) {
+        return false;
+    }
+    if (!S_bounds_equal(ivars->upper_bounds, ovars->upper_bounds)) {
+        return false;
+    }
+    return true;
+}
+
+static bool
+S_bounds_equal(VArray *bounds, VArray *other_bounds) {
+    uint32_t size = VA_Get_Size(bounds);
+    if (VA_Get_Size(other_bounds) != size) { return false; }
+    for (uint32_t i = 0; i < size; i++) {
+        Obj *bound       = VA_Fetch(bounds, i);
+        Obj *other_bound = VA_Fetch(other_bounds, i);
+        if (!bound != !other_bound) { return false; }
+        if (bound
+            && (Obj_To_F64(bound) != Obj_To_F64(other_bound)
+                || Obj_To_I64(bound) != Obj_To_I64(other_bound))
+           ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+String*
+BoxQuery_To_String_IMP(BoxQuery *self) {
+    BoxQueryIVARS *const ivars = BoxQuery_IVARS(self);
+    CharBuf *buf = CB_new(0);
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->fields); i < max; i++) {
+        Obj *lower_bound = VA_Fetch(ivars->lower_bounds, i);
+        Obj *upper_bound = VA_Fetch(ivars->upper_bounds, i);
+        String *lower_str = lower_bound
+                            ? Obj_To_String(lower_bound)
+                            : Str_new_from_trusted_utf8("*", 1);
+        String *upper_str = upper_bound
+                            ? Obj_To_String(upper_bound)
+                            : Str_new_from_trusted_utf8("*", 1);
+        if (i > 0) { CB_Cat_Trusted_Utf8(buf, " AND ", 5); }
+        CB_catf(buf, "%o:[%o TO %o]", VA_Fetch(ivars->fields, i),
+                lower_str, upper_str);
+        DECREF(upper_str);
+        DECREF(lower_str);
+    }
+    String *retval = CB_Yield_String(buf);
+    DECREF(buf);
+    return retval;
+}
+
+void
+BoxQuery_Serialize_IMP(BoxQuery *self, OutStream *outstream) {
+    BoxQueryIVARS *const ivars = BoxQuery_IVARS(self);
+    OutStream_Write_F32(outstream, ivars->boost);
+    Freezer_serialize_varray(ivars->fields, outstream);
+    Freezer_serialize_varray(ivars->lower_bounds, outstream);
+    Freezer_serialize_varray(ivars->upper_bounds, outstream);
+}
+
+BoxQuery*
+BoxQuery_Deserialize_IMP(BoxQuery *self, InStream *instream) {
+    float   boost        = InStream_Read_F32(instream);
+    VArray *fields       = Freezer_read_varray(instream);
+    VArray *lower_bounds = Freezer_read_varray(instream);
+    VArray *upper_bounds = Freezer_read_varray(instream);
+    BoxQuery_init(self, fields, lower_bounds, upper_bounds);
+    BoxQuery_Set_Boost(self, boost);
+    DECREF(upper_bounds);
+    DECREF(lower_bounds);
+    DECREF(fields);
+    return self;
+}
+
+Obj*
+BoxQuery_Dump_IMP(BoxQuery *self) {
+    BoxQueryIVARS *ivars = BoxQuery_IVARS(self);
+    BoxQuery_Dump_t super_dump
+        = SUPER_METHOD_PTR(BOXQUERY, LUCY_BoxQuery_Dump);
+    Hash *dump = (Hash*)CERTIFY(super_dump(self), HASH);
+    Hash_Store_Utf8(dump, "fields", 6, Freezer_dump((Obj*)ivars->fields));
+    Hash_Store_Utf8(dump, "lower_bounds", 12,
+                    Freezer_dump((Obj*)ivars->lower_bounds));
+    Hash_Store_Utf8(dump, "upper_bounds", 12,
+                    Freezer_dump((Obj*)ivars->upper_bounds));
+    return (Obj*)dump;
+}
+
+Obj*
+BoxQuery_Load_IMP(BoxQuery *self, Obj *dump) {
+    Hash *source = (Hash*)CERTIFY(dump, HASH);
+    BoxQuery_Load_t super_load
+        = SUPER_METHOD_PTR(BOXQUERY, LUCY_BoxQuery_Load);
+    BoxQuery *loaded = (BoxQuery*)super_load(self, dump);
+    BoxQueryIVARS *loaded_ivars = BoxQuery_IVARS(loaded);
+    Obj *fields = CERTIFY(Hash_Fetch_Utf8(source, "fields", 6), OBJ);
+    loaded_ivars->fields = (VArray*)CERTIFY(Freezer_load(fields), VARRAY);
+    Obj *lower_bounds
+        = CERTIFY(Hash_Fetch_Utf8(source, "lower_bounds", 12), OBJ);
+    loaded_ivars->lower_bounds
+        = (VArray*)CERTIFY(Freezer_load(lower_bounds), VARRAY);
+    Obj *upper_bounds
+        = CERTIFY(Hash_Fetch_Utf8(source, "upper_bounds", 12), OBJ);
+    loaded_ivars->upper_bounds
+        = (VArray*)CERTIFY(Freezer_load(upper_bounds), VARRAY);
+    // Trailing missing bounds don't survive the dump.
+    uint32_t num_fields = VA_Get_Size(loaded_ivars->fields);
+    VA_Resize(loaded_ivars->lower_bounds, num_fields);
+    VA_Resize(loaded_ivars->upper_bounds, num_fields);
+    return (Obj*)loaded;
+}
+
+BoxCompiler*
+BoxQuery_Make_Compiler_IMP(BoxQuery *self, Searcher *searcher, float boost,
+                           bool subordinate) {
+    BoxCompiler *compiler = BoxCompiler_new(self, searcher, boost);
+    if (!subordinate) {
+        BoxCompiler_Normalize(compiler);
+    }
+    return compiler;
+}
+
+/**********************************************************************/
+
+BoxCompiler*
+BoxCompiler_new(BoxQuery *parent, Searcher *searcher, float boost) {
+    BoxCompiler *self = (BoxCompiler*)VTable_Make_Obj(BOXCOMPILER);
+    return BoxCompiler_init(self, parent, searcher, boost);
+}
+
+BoxCompiler*
+BoxCompiler_init(BoxCompiler *self, BoxQuery *parent, Searcher *searcher,
+                 float boost) {
+    return (BoxCompiler*)Compiler_init((Compiler*)self, (Query*)parent,
+                                       searcher, NULL, boost);
+}
+
+Matcher*
+BoxCompiler_Make_Matcher_IMP(BoxCompiler *self, SegReader *reader,
+                             bool need_score) {
+    BoxQuery *parent = (BoxQuery*)BoxCompiler_IVARS(self)->parent;
+    VArray   *fields = BoxQuery_Get_Fields(parent);
+    VArray   *lower_bounds = BoxQuery_Get_Lower_Bounds(parent);
+    VArray   *upper_bounds = BoxQuery_Get_Upper_Bounds(parent);
+    PointReader *point_reader
+        = (PointReader*)SegReader_Fetch(reader, VTable_Get_Name(POINTREADER));
+    UNUSED_VAR(need_score);
+    if (!point_reader) { return NULL; }
+
+    // Convert the bounds to inclusive keys in each field's own type.
+    Schema   *schema     = SegReader_Get_Schema(reader);
+    uint32_t  num_fields = VA_Get_Size(fields);
+    uint64_t *lower = (uint64_t*)MALLOCATE(num_fields * sizeof(uint64_t));
+    uint64_t *upper = (uint64_t*)MALLOCATE(num_fields * sizeof(uint64_t));
+    bool      possible = true;
+    for (uint32_t i = 0; i < num_fields && possible; i++) {
+        String    *field = (String*)VA_Fetch(fields, i);
+        FieldType *type  = Schema_Fetch_Type(schema, field);
+        possible = type != NULL
+                   && PointReader_Has_Field(point_reader, field)
+                   && PointReader_encode_bound(type,
+                                               VA_Fetch(lower_bounds, i),
+                                               false, true, &lower[i])
+                   && PointReader_encode_bound(type,
+                                               VA_Fetch(upper_bounds, i),
+                                               true, true, &upper[i]);
+    }
+    BitVector *bit_vec = possible
+                         ? PointReader_Find_Box(point_reader, fields, lower,
+                                                upper)
+                         : NULL;
+    FREEMEM(lower);
+    FREEMEM(upper);
+    if (!bit_vec) { return NULL; }
+
+    Matcher *matcher = (Matcher*)BitVecMatcher_new(bit_vec);
+    DECREF(bit_vec);
+    return matcher;
+}
+
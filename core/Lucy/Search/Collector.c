@@ -41,6 +41,29 @@ Coll_Destroy_IMP(Collector *self) {
     SUPER_DESTROY(self, COLLECTOR);
 }
 
+void
+Coll_Collect_Block_IMP(Collector *self, int32_t *doc_ids, float *scores,
+                       uint32_t num_docs) {
+    Coll_Collect_t collect
+        = (Coll_Collect_t)METHOD_PTR(Coll_Get_VTable(self), LUCY_Coll_Collect);
+    UNUSED_VAR(scores);
+    for (uint32_t i = 0; i < num_docs; i++) {
+        collect(self, doc_ids[i]);
+    }
+}
+
+bool
+Coll_Uses_Block_Scores_IMP(Collector *self) {
+    UNUSED_VAR(self);
+    return false;
+}
+
+int32_t
+Coll_Next_Wanted_IMP(Collector *self) {
+    UNUSED_VAR(self);
+    return 0;
+}
+
 void
 Coll_Set_Reader_IMP(Collector *self, SegReader *reader) {
     CollectorIVARS *const ivars = Coll_IVARS(self);
@@ -89,6 +112,18 @@ BitColl_Collect_IMP(BitCollector *self, int32_t doc_id) {
     BitVec_Set(ivars->bit_vec, (ivars->base + doc_id));
 }
 
+void
+BitColl_Collect_Block_IMP(BitCollector *self, int32_t *doc_ids,
+                          float *scores, uint32_t num_docs) {
+    BitCollectorIVARS *const ivars = BitColl_IVARS(self);
+    BitVector *const bit_vec = ivars->bit_vec;
+    const int32_t    base    = ivars->base;
+    UNUSED_VAR(scores);
+    for (uint32_t i = 0; i < num_docs; i++) {
+        BitVec_Set(bit_vec, base + doc_ids[i]);
+    }
+}
+
 bool
 BitColl_Need_Score_IMP(BitCollector *self) {
     UNUSED_VAR(self);
@@ -108,6 +143,9 @@ OffsetColl_init(OffsetCollector *self, Collector *inner_coll, int32_t offset) {
     Coll_init((Collector*)self);
     ivars->offset     = offset;
     ivars->inner_coll = (Collector*)INCREF(inner_coll);
+    // The offset is applied through the inner Collector's base, so that it
+    // keeps receiving segment doc ids.
+    Coll_Set_Base(inner_coll, offset);
     return self;
 }
 
@@ -127,7 +165,7 @@ OffsetColl_Set_Reader_IMP(OffsetCollector *self, SegReader *reader) {
 void
 OffsetColl_Set_Base_IMP(OffsetCollector *self, int32_t base) {
     OffsetCollectorIVARS *const ivars = OffsetColl_IVARS(self);
-    Coll_Set_Base(ivars->inner_coll, base);
+    Coll_Set_Base(ivars->inner_coll, base + ivars->offset);
 }
 
 void
@@ -139,7 +177,7 @@ OffsetColl_Set_Matcher_IMP(OffsetCollector *self, Matcher *matcher) {
 void
 OffsetColl_Collect_IMP(OffsetCollector *self, int32_t doc_id) {
     OffsetCollectorIVARS *const ivars = OffsetColl_IVARS(self);
-    Coll_Collect(ivars->inner_coll, (doc_id + ivars->offset));
+    Coll_Collect(ivars->inner_coll, doc_id);
 }
 
 bool
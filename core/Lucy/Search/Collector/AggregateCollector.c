@@ -0,0 +1,611 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_AGGREGATECOLLECTOR
+#define C_LUCY_STATSCOLLECTOR
+#define C_LUCY_HISTOGRAMCOLLECTOR
+#define C_LUCY_CARDINALITYCOLLECTOR
+#include "Lucy/Util/ToolSet.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "Lucy/Search/Collector/AggregateCollector.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortCache/NumericSortCache.h"
+#include "Lucy/Index/SortCache/TextSortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Util/Freezer.h"
+
+// HyperLogLog precision: the sketch has 2**HLL_PRECISION registers.
+#define HLL_PRECISION     14
+#define HLL_NUM_REGISTERS (1 << HLL_PRECISION)
+
+AggregateCollector*
+AggColl_init(AggregateCollector *self, String *field) {
+    Coll_init((Collector*)self);
+    AggregateCollectorIVARS *const ivars = AggColl_IVARS(self);
+    ABSTRACT_CLASS_CHECK(self, AGGREGATECOLLECTOR);
+    ivars->field        = Str_Clone(field);
+    ivars->num_missing  = 0;
+    ivars->sort_cache   = NULL;
+    ivars->ord_counts   = NULL;
+    ivars->cardinality  = 0;
+    ivars->numeric_only = false;
+    return self;
+}
+
+void
+AggColl_Destroy_IMP(AggregateCollector *self) {
+    AggregateCollectorIVARS *const ivars = AggColl_IVARS(self);
+    DECREF(ivars->field);
+    DECREF(ivars->sort_cache);
+    FREEMEM(ivars->ord_counts);
+    SUPER_DESTROY(self, AGGREGATECOLLECTOR);
+}
+
+void
+AggColl_Set_Reader_IMP(AggregateCollector *self, SegReader *reader) {
+    AggregateCollectorIVARS *const ivars = AggColl_IVARS(self);
+
+    // Wrap up the previous segment before its sort cache goes away.
+    AggColl_Flush(self);
+
+    SortReader *sort_reader = reader
+                              ? (SortReader*)SegReader_Fetch(
+                                    reader, VTable_Get_Name(SORTREADER))
+                              : NULL;
+    SortCache *sort_cache = sort_reader
+                            ? SortReader_Fetch_Sort_Cache(sort_reader,
+                                                          ivars->field)
+                            : NULL;
+    if (sort_cache) {
+        if (ivars->numeric_only
+            && !SortCache_Is_A(sort_cache, NUMERICSORTCACHE)
+           ) {
+            THROW(ERR, "'%o' isn't a numeric field", ivars->field);
+        }
+        ivars->sort_cache  = (SortCache*)INCREF(sort_cache);
+        ivars->cardinality = SortCache_Get_Cardinality(sort_cache);
+        ivars->ord_counts
+            = (int32_t*)CALLOCATE(ivars->cardinality, sizeof(int32_t));
+    }
+
+    AggColl_Set_Reader_t super_set_reader
+        = (AggColl_Set_Reader_t)SUPER_METHOD_PTR(AGGREGATECOLLECTOR,
+                                                 LUCY_AggColl_Set_Reader);
+    super_set_reader(self, reader);
+}
+
+void
+AggColl_Collect_IMP(AggregateCollector *self, int32_t doc_id) {
+    AggregateCollectorIVARS *const ivars = AggColl_IVARS(self);
+    if (ivars->sort_cache) {
+        ivars->ord_counts[SortCache_Ordinal(ivars->sort_cache, doc_id)]++;
+    }
+    else {
+        // The segment holds no values for the field.
+        ivars->num_missing++;
+    }
+}
+
+void
+AggColl_Collect_Block_IMP(AggregateCollector *self, int32_t *doc_ids,
+                          float *scores, uint32_t num_docs) {
+    AggregateCollectorIVARS *const ivars = AggColl_IVARS(self);
+    SortCache *const sort_cache = ivars->sort_cache;
+    int32_t   *const ord_counts = ivars->ord_counts;
+    UNUSED_VAR(scores);
+    if (sort_cache) {
+        for (uint32_t i = 0; i < num_docs; i++) {
+            ord_counts[SortCache_Ordinal(sort_cache, doc_ids[i])]++;
+        }
+    }
+    else {
+        ivars->num_missing += num_docs;
+    }
+}
+
+bool
+AggColl_Need_Score_IMP(AggregateCollector *self) {
+    UNUSED_VAR(self);
+    return false;
+}
+
+void
+AggColl_Flush_IMP(AggregateCollector *self) {
+    AggregateCollectorIVARS *const ivars = AggColl_IVARS(self);
+    if (!ivars->sort_cache) { return; }
+
+    int32_t null_ord = SortCache_Get_Null_Ord(ivars->sort_cache);
+    if (null_ord >= 0 && null_ord < ivars->cardinality) {
+        ivars->num_missing += ivars->ord_counts[null_ord];
+        ivars->ord_counts[null_ord] = 0;
+    }
+    AggColl_Tally(self, ivars->sort_cache, ivars->ord_counts);
+
+    DECREF(ivars->sort_cache);
+    FREEMEM(ivars->ord_counts);
+    ivars->sort_cache  = NULL;
+    ivars->ord_counts  = NULL;
+    ivars->cardinality = 0;
+}
+
+void
+AggColl_Merge_IMP(AggregateCollector *self, AggregateCollector *other) {
+    AggregateCollectorIVARS *const ivars = AggColl_IVARS(self);
+    AggregateCollectorIVARS *const ovars = AggColl_IVARS(other);
+    if (AggColl_Get_VTable(self) != AggColl_Get_VTable(other)) {
+        THROW(ERR, "Can't merge a %o into a %o",
+              AggColl_Get_Class_Name(other), AggColl_Get_Class_Name(self));
+    }
+    if (!Str_Equals(ivars->field, (Obj*)ovars->field)) {
+        THROW(ERR, "Can't merge aggregates of '%o' into '%o'", ovars->field,
+              ivars->field);
+    }
+    AggColl_Flush(self);
+    AggColl_Flush(other);
+    ivars->num_missing += ovars->num_missing;
+}
+
+int64_t
+AggColl_Get_Num_Missing_IMP(AggregateCollector *self) {
+    AggColl_Flush(self);
+    return AggColl_IVARS(self)->num_missing;
+}
+
+String*
+AggColl_Get_Field_IMP(AggregateCollector *self) {
+    return AggColl_IVARS(self)->field;
+}
+
+void
+AggColl_Serialize_IMP(AggregateCollector *self, OutStream *outstream) {
+    AggregateCollectorIVARS *const ivars = AggColl_IVARS(self);
+    AggColl_Flush(self);
+    Freezer_serialize_string(ivars->field, outstream);
+    OutStream_Write_C64(outstream, (uint64_t)ivars->num_missing);
+}
+
+AggregateCollector*
+AggColl_Deserialize_IMP(AggregateCollector *self, InStream *instream) {
+    String *field = Freezer_read_string(instream);
+    AggColl_init(self, field);
+    DECREF(field);
+    AggColl_IVARS(self)->num_missing = (int64_t)InStream_Read_C64(instream);
+    return self;
+}
+
+/***************************************************************************/
+
+StatsCollector*
+StatsColl_new(String *field) {
+    StatsCollector *self = (StatsCollector*)VTable_Make_Obj(STATSCOLLECTOR);
+    return StatsColl_init(self, field);
+}
+
+StatsCollector*
+StatsColl_init(StatsCollector *self, String *field) {
+    AggColl_init((AggregateCollector*)self, field);
+    StatsCollectorIVARS *const ivars = StatsColl_IVARS(self);
+    ivars->numeric_only = true;
+    ivars->count = 0;
+    ivars->sum   = 0.0;
+    ivars->min   = 0.0;
+    ivars->max   = 0.0;
+    return self;
+}
+
+static void
+S_add_stats(StatsCollectorIVARS *ivars, int64_t count, double sum,
+            double min, double max) {
+    if (!count) { return; }
+    if (!ivars->count || min < ivars->min) { ivars->min = min; }
+    if (!ivars->count || max > ivars->max) { ivars->max = max; }
+    ivars->count += count;
+    ivars->sum   += sum;
+}
+
+void
+StatsColl_Tally_IMP(StatsCollector *self, SortCache *sort_cache,
+                    int32_t *ord_counts) {
+    StatsCollectorIVARS *const ivars = StatsColl_IVARS(self);
+    const int32_t cardinality = SortCache_Get_Cardinality(sort_cache);
+    for (int32_t ord = 0; ord < cardinality; ord++) {
+        if (!ord_counts[ord]) { continue; }
+        Obj *value = SortCache_Value(sort_cache, ord);
+        if (!value) { continue; }
+        double f64 = Obj_To_F64(value);
+        S_add_stats(ivars, ord_counts[ord], f64 * ord_counts[ord], f64, f64);
+        DECREF(value);
+    }
+}
+
+void
+StatsColl_Merge_IMP(StatsCollector *self, AggregateCollector *other) {
+    StatsColl_Merge_t super_merge
+        = (StatsColl_Merge_t)SUPER_METHOD_PTR(STATSCOLLECTOR,
+                                              LUCY_StatsColl_Merge);
+    super_merge(self, other);
+    StatsCollectorIVARS *const ovars = StatsColl_IVARS((StatsCollector*)other);
+    S_add_stats(StatsColl_IVARS(self), ovars->count, ovars->sum, ovars->min,
+                ovars->max);
+}
+
+int64_t
+StatsColl_Get_Count_IMP(StatsCollector *self) {
+    StatsColl_Flush(self);
+    return StatsColl_IVARS(self)->count;
+}
+
+double
+StatsColl_Get_Sum_IMP(StatsCollector *self) {
+    StatsColl_Flush(self);
+    return StatsColl_IVARS(self)->sum;
+}
+
+double
+StatsColl_Get_Min_IMP(StatsCollector *self) {
+    StatsColl_Flush(self);
+    return StatsColl_IVARS(self)->min;
+}
+
+double
+StatsColl_Get_Max_IMP(StatsCollector *self) {
+    StatsColl_Flush(self);
+    return StatsColl_IVARS(self)->max;
+}
+
+double
+StatsColl_Get_Mean_IMP(StatsCollector *self) {
+    StatsCollectorIVARS *const ivars = StatsColl_IVARS(self);
+    StatsColl_Flush(self);
+    return ivars->count ? ivars->sum / ivars->count : 0.0;
+}
+
+void
+StatsColl_Serialize_IMP(StatsCollector *self, OutStream *outstream) {
+    StatsColl_Serialize_t super_serialize
+        = (StatsColl_Serialize_t)SUPER_METHOD_PTR(STATSCOLLECTOR,
+                                                  LUCY_StatsColl_Serialize);
+    super_serialize(self, outstream);
+    StatsCollectorIVARS *const ivars = StatsColl_IVARS(self);
+    OutStream_Write_C64(outstream, (uint64_t)ivars->count);
+    OutStream_Write_F64(outstream, ivars->sum);
+    OutStream_Write_F64(outstream, ivars->min);
+    OutStream_Write_F64(outstream, ivars->max);
+}
+
+StatsCollector*
+StatsColl_Deserialize_IMP(StatsCollector *self, InStream *instream) {
+    StatsColl_Deserialize_t super_deserialize
+        = (StatsColl_Deserialize_t)SUPER_METHOD_PTR(
+              STATSCOLLECTOR, LUCY_StatsColl_Deserialize);
+    self = super_deserialize(self, instream);
+    StatsCollectorIVARS *const ivars = StatsColl_IVARS(self);
+    ivars->numeric_only = true;
+    ivars->count = (int64_t)InStream_Read_C64(instream);
+    ivars->sum   = InStream_Read_F64(instream);
+    ivars->min   = InStream_Read_F64(instream);
+    ivars->max   = InStream_Read_F64(instream);
+    return self;
+}
+
+/***************************************************************************/
+
+HistogramCollector*
+HistoColl_new(String *field, double interval, double offset) {
+    HistogramCollector *self
+        = (HistogramCollector*)VTable_Make_Obj(HISTOGRAMCOLLECTOR);
+    return HistoColl_init(self, field, interval, offset);
+}
+
+HistogramCollector*
+HistoColl_init(HistogramCollector *self, String *field, double interval,
+               double offset) {
+    AggColl_init((AggregateCollector*)self, field);
+    HistogramCollectorIVARS *const ivars = HistoColl_IVARS(self);
+    ivars->numeric_only = true;
+    ivars->counts = Hash_new(0);
+    if (!(interval > 0.0)) {
+        DECREF(self);
+        THROW(ERR, "Interval must be positive: %f64", interval);
+    }
+    ivars->interval = interval;
+    ivars->offset   = offset;
+    return self;
+}
+
+void
+HistoColl_Destroy_IMP(HistogramCollector *self) {
+    HistogramCollectorIVARS *const ivars = HistoColl_IVARS(self);
+    DECREF(ivars->counts);
+    SUPER_DESTROY(self, HISTOGRAMCOLLECTOR);
+}
+
+// Buckets are keyed by their number rather than their starting value, so
+// that lookups never depend on floating point equality.
+static int64_t
+S_bucket_num(HistogramCollectorIVARS *ivars, double value) {
+    return (int64_t)floor((value - ivars->offset) / ivars->interval);
+}
+
+static void
+S_add_bucket_count(Hash *counts, int64_t bucket_num, int64_t addend) {
+    Integer64 *key   = Int64_new(bucket_num);
+    Integer64 *count = (Integer64*)Hash_Fetch(counts, (Obj*)key);
+    if (count) {
+        Int64_Set_Value(count, Int64_Get_Value(count) + addend);
+    }
+    else {
+        Hash_Store(counts, (Obj*)key, (Obj*)Int64_new(addend));
+    }
+    DECREF(key);
+}
+
+void
+HistoColl_Tally_IMP(HistogramCollector *self, SortCache *sort_cache,
+                    int32_t *ord_counts) {
+    HistogramCollectorIVARS *const ivars = HistoColl_IVARS(self);
+    const int32_t cardinality = SortCache_Get_Cardinality(sort_cache);
+    for (int32_t ord = 0; ord < cardinality; ord++) {
+        if (!ord_counts[ord]) { continue; }
+        Obj *value = SortCache_Value(sort_cache, ord);
+        if (!value) { continue; }
+        int64_t bucket_num = S_bucket_num(ivars, Obj_To_F64(value));
+        S_add_bucket_count(ivars->counts, bucket_num, ord_counts[ord]);
+        DECREF(value);
+    }
+}
+
+void
+HistoColl_Merge_IMP(HistogramCollector *self, AggregateCollector *other) {
+    // Check the class before looking at the other collector's ivars.
+    if (HistoColl_Get_VTable(self) != AggColl_Get_VTable(other)) {
+        THROW(ERR, "Can't merge a %o into a %o",
+              AggColl_Get_Class_Name(other), HistoColl_Get_Class_Name(self));
+    }
+    HistogramCollectorIVARS *const ivars = HistoColl_IVARS(self);
+    HistogramCollectorIVARS *const ovars
+        = HistoColl_IVARS((HistogramCollector*)other);
+    if (ivars->interval != ovars->interval
+        || ivars->offset != ovars->offset
+       ) {
+        THROW(ERR, "Can't merge HistogramCollectors with different buckets");
+    }
+    HistoColl_Merge_t super_merge
+        = (HistoColl_Merge_t)SUPER_METHOD_PTR(HISTOGRAMCOLLECTOR,
+                                              LUCY_HistoColl_Merge);
+    super_merge(self, other);
+    Obj *key;
+    Obj *count;
+    Hash_Iterate(ovars->counts);
+    while (Hash_Next(ovars->counts, &key, &count)) {
+        S_add_bucket_count(ivars->counts, Obj_To_I64(key),
+                           Obj_To_I64(count));
+    }
+}
+
+static int
+S_compare_i64_keys(void *context, const void *va, const void *vb) {
+    int64_t a = Obj_To_I64(*(Obj**)va);
+    int64_t b = Obj_To_I64(*(Obj**)vb);
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+VArray*
+HistoColl_Get_Buckets_IMP(HistogramCollector *self) {
+    HistogramCollectorIVARS *const ivars = HistoColl_IVARS(self);
+    HistoColl_Flush(self);
+    VArray *bucket_nums = Hash_Keys(ivars->counts);
+    VA_Sort(bucket_nums, S_compare_i64_keys, NULL);
+    uint32_t num_buckets = VA_Get_Size(bucket_nums);
+    VArray *starts = VA_new(num_buckets);
+    for (uint32_t i = 0; i < num_buckets; i++) {
+        int64_t bucket_num = Obj_To_I64(VA_Fetch(bucket_nums, i));
+        double  start      = ivars->offset + bucket_num * ivars->interval;
+        VA_Push(starts, (Obj*)Float64_new(start));
+    }
+    DECREF(bucket_nums);
+    return starts;
+}
+
+int64_t
+HistoColl_Count_IMP(HistogramCollector *self, double value) {
+    HistogramCollectorIVARS *const ivars = HistoColl_IVARS(self);
+    HistoColl_Flush(self);
+    Integer64 *key   = Int64_new(S_bucket_num(ivars, value));
+    Obj       *count = Hash_Fetch(ivars->counts, (Obj*)key);
+    DECREF(key);
+    return count ? Obj_To_I64(count) : 0;
+}
+
+void
+HistoColl_Serialize_IMP(HistogramCollector *self, OutStream *outstream) {
+    HistoColl_Serialize_t super_serialize
+        = (HistoColl_Serialize_t)SUPER_METHOD_PTR(HISTOGRAMCOLLECTOR,
+                                                  LUCY_HistoColl_Serialize);
+    super_serialize(self, outstream);
+    HistogramCollectorIVARS *const ivars = HistoColl_IVARS(self);
+    OutStream_Write_F64(outstream, ivars->interval);
+    OutStream_Write_F64(outstream, ivars->offset);
+    Freezer_serialize_hash(ivars->counts, outstream);
+}
+
+HistogramCollector*
+HistoColl_Deserialize_IMP(HistogramCollector *self, InStream *instream) {
+    HistoColl_Deserialize_t super_deserialize
+        = (HistoColl_Deserialize_t)SUPER_METHOD_PTR(
+              HISTOGRAMCOLLECTOR, LUCY_HistoColl_Deserialize);
+    self = super_deserialize(self, instream);
+    HistogramCollectorIVARS *const ivars = HistoColl_IVARS(self);
+    ivars->numeric_only = true;
+    ivars->interval = InStream_Read_F64(instream);
+    ivars->offset   = InStream_Read_F64(instream);
+    ivars->counts   = Freezer_read_hash(instream);
+    return self;
+}
+
+/***************************************************************************/
+
+CardinalityCollector*
+CardColl_new(String *field) {
+    CardinalityCollector *self
+        = (CardinalityCollector*)VTable_Make_Obj(CARDINALITYCOLLECTOR);
+    return CardColl_init(self, field);
+}
+
+CardinalityCollector*
+CardColl_init(CardinalityCollector *self, String *field) {
+    AggColl_init((AggregateCollector*)self, field);
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    ivars->registers = (uint8_t*)CALLOCATE(HLL_NUM_REGISTERS, sizeof(uint8_t));
+    return self;
+}
+
+void
+CardColl_Destroy_IMP(CardinalityCollector *self) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    FREEMEM(ivars->registers);
+    SUPER_DESTROY(self, CARDINALITYCOLLECTOR);
+}
+
+// 64-bit FNV-1a, followed by the MurmurHash3 finalizer to spread the bits
+// of short keys across the whole word.
+static uint64_t
+S_hash_bytes(const char *ptr, size_t size) {
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)ptr[i];
+        hash *= UINT64_C(0x100000001b3);
+    }
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static void
+S_hll_add(uint8_t *registers, uint64_t hash) {
+    uint32_t index = (uint32_t)(hash >> (64 - HLL_PRECISION));
+    uint64_t rest  = hash << HLL_PRECISION;
+    uint8_t  rank  = 1;
+    while (rank <= 64 - HLL_PRECISION && !(rest >> 63)) {
+        rest <<= 1;
+        rank++;
+    }
+    if (rank > registers[index]) { registers[index] = rank; }
+}
+
+void
+CardColl_Tally_IMP(CardinalityCollector *self, SortCache *sort_cache,
+                   int32_t *ord_counts) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    const int32_t cardinality = SortCache_Get_Cardinality(sort_cache);
+    if (SortCache_Is_A(sort_cache, TEXTSORTCACHE)) {
+        TextSortCache *text_cache = (TextSortCache*)sort_cache;
+        for (int32_t ord = 0; ord < cardinality; ord++) {
+            if (!ord_counts[ord]) { continue; }
+            size_t size;
+            const char *ptr = TextSortCache_Value_Ptr(text_cache, ord, &size);
+            if (!ptr) { continue; }
+            S_hll_add(ivars->registers, S_hash_bytes(ptr, size));
+        }
+    }
+    else {
+        for (int32_t ord = 0; ord < cardinality; ord++) {
+            if (!ord_counts[ord]) { continue; }
+            Obj *value = SortCache_Value(sort_cache, ord);
+            if (!value) { continue; }
+            char bytes[sizeof(int64_t)];
+            if (Obj_Is_A(value, FLOATNUM)) {
+                double f64 = Obj_To_F64(value);
+                memcpy(bytes, &f64, sizeof(bytes));
+            }
+            else {
+                int64_t i64 = Obj_To_I64(value);
+                memcpy(bytes, &i64, sizeof(bytes));
+            }
+            S_hll_add(ivars->registers, S_hash_bytes(bytes, sizeof(bytes)));
+            DECREF(value);
+        }
+    }
+}
+
+void
+CardColl_Merge_IMP(CardinalityCollector *self, AggregateCollector *other) {
+    CardColl_Merge_t super_merge
+        = (CardColl_Merge_t)SUPER_METHOD_PTR(CARDINALITYCOLLECTOR,
+                                             LUCY_CardColl_Merge);
+    super_merge(self, other);
+    uint8_t *registers = CardColl_IVARS(self)->registers;
+    uint8_t *others
+        = CardColl_IVARS((CardinalityCollector*)other)->registers;
+    for (uint32_t i = 0; i < HLL_NUM_REGISTERS; i++) {
+        if (others[i] > registers[i]) { registers[i] = others[i]; }
+    }
+}
+
+int64_t
+CardColl_Estimate_IMP(CardinalityCollector *self) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    const double num_registers = HLL_NUM_REGISTERS;
+    CardColl_Flush(self);
+
+    double   sum       = 0.0;
+    uint32_t num_zeros = 0;
+    for (uint32_t i = 0; i < HLL_NUM_REGISTERS; i++) {
+        sum += ldexp(1.0, -ivars->registers[i]);
+        if (!ivars->registers[i]) { num_zeros++; }
+    }
+    double alpha    = 0.7213 / (1.0 + 1.079 / num_registers);
+    double estimate = alpha * num_registers * num_registers / sum;
+
+    // Small cardinalities are estimated more accurately by linear counting.
+    // With a 64-bit hash, no large range correction is needed.
+    if (estimate <= 2.5 * num_registers && num_zeros) {
+        estimate = num_registers * log(num_registers / num_zeros);
+    }
+    return (int64_t)(estimate + 0.5);
+}
+
+void
+CardColl_Serialize_IMP(CardinalityCollector *self, OutStream *outstream) {
+    CardColl_Serialize_t super_serialize
+        = (CardColl_Serialize_t)SUPER_METHOD_PTR(CARDINALITYCOLLECTOR,
+                                                 LUCY_CardColl_Serialize);
+    super_serialize(self, outstream);
+    OutStream_Write_Bytes(outstream, (char*)CardColl_IVARS(self)->registers,
+                          HLL_NUM_REGISTERS);
+}
+
+CardinalityCollector*
+CardColl_Deserialize_IMP(CardinalityCollector *self, InStream *instream) {
+    CardColl_Deserialize_t super_deserialize
+        = (CardColl_Deserialize_t)SUPER_METHOD_PTR(CARDINALITYCOLLECTOR,
+                                                   LUCY_CardColl_Deserialize);
+    self = super_deserialize(self, instream);
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    ivars->registers = (uint8_t*)MALLOCATE(HLL_NUM_REGISTERS);
+    InStream_Read_Bytes(instream, (char*)ivars->registers, HLL_NUM_REGISTERS);
+    return self;
+}
@@ -0,0 +1,285 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_FACETCOLLECTOR
+#define C_LUCY_RANGEFACETCOLLECTOR
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/Collector/FacetCollector.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Util/Freezer.h"
+
+FacetCollector*
+FacetColl_new(String *field) {
+    FacetCollector *self = (FacetCollector*)VTable_Make_Obj(FACETCOLLECTOR);
+    return FacetColl_init(self, field);
+}
+
+FacetCollector*
+FacetColl_init(FacetCollector *self, String *field) {
+    AggColl_init((AggregateCollector*)self, field);
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    ivars->counts = Hash_new(0);
+    return self;
+}
+
+void
+FacetColl_Destroy_IMP(FacetCollector *self) {
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    DECREF(ivars->counts);
+    SUPER_DESTROY(self, FACETCOLLECTOR);
+}
+
+static void
+S_add_count(Hash *counts, Obj *value, int64_t addend) {
+    Integer64 *count = (Integer64*)Hash_Fetch(counts, value);
+    if (count) {
+        Int64_Set_Value(count, Int64_Get_Value(count) + addend);
+    }
+    else {
+        Hash_Store(counts, value, (Obj*)Int64_new(addend));
+    }
+}
+
+void
+FacetColl_Tally_IMP(FacetCollector *self, SortCache *sort_cache,
+                    int32_t *ord_counts) {
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    const int32_t cardinality = SortCache_Get_Cardinality(sort_cache);
+    for (int32_t ord = 0; ord < cardinality; ord++) {
+        if (!ord_counts[ord]) { continue; }
+        Obj *value = SortCache_Value(sort_cache, ord);
+        if (!value) { continue; }
+        S_add_count(ivars->counts, value, ord_counts[ord]);
+        DECREF(value);
+    }
+}
+
+void
+FacetColl_Merge_IMP(FacetCollector *self, AggregateCollector *other) {
+    FacetColl_Merge_t super_merge
+        = (FacetColl_Merge_t)SUPER_METHOD_PTR(FACETCOLLECTOR,
+                                              LUCY_FacetColl_Merge);
+    super_merge(self, other);
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    Hash *other_counts = FacetColl_IVARS((FacetCollector*)other)->counts;
+    Obj *value;
+    Obj *count;
+    Hash_Iterate(other_counts);
+    while (Hash_Next(other_counts, &value, &count)) {
+        S_add_count(ivars->counts, value, Obj_To_I64(count));
+    }
+}
+
+Hash*
+FacetColl_Get_Counts_IMP(FacetCollector *self) {
+    FacetColl_Flush(self);
+    return FacetColl_IVARS(self)->counts;
+}
+
+int64_t
+FacetColl_Count_IMP(FacetCollector *self, Obj *value) {
+    Hash *counts = FacetColl_Get_Counts(self);
+    Obj  *count  = Hash_Fetch(counts, value);
+    return count ? Obj_To_I64(count) : 0;
+}
+
+static int
+S_compare_by_count(void *context, const void *va, const void *vb) {
+    Hash *counts = (Hash*)context;
+    Obj  *a      = *(Obj**)va;
+    Obj  *b      = *(Obj**)vb;
+    int64_t count_a = Obj_To_I64(Hash_Fetch(counts, a));
+    int64_t count_b = Obj_To_I64(Hash_Fetch(counts, b));
+    if (count_a != count_b) { return count_a > count_b ? -1 : 1; }
+    return Obj_Compare_To(a, b);
+}
+
+VArray*
+FacetColl_Top_Values_IMP(FacetCollector *self, uint32_t num_wanted) {
+    Hash   *counts = FacetColl_Get_Counts(self);
+    VArray *values = Hash_Keys(counts);
+    VA_Sort(values, S_compare_by_count, counts);
+    if (VA_Get_Size(values) > num_wanted) {
+        VA_Excise(values, num_wanted, VA_Get_Size(values) - num_wanted);
+    }
+    return values;
+}
+
+void
+FacetColl_Serialize_IMP(FacetCollector *self, OutStream *outstream) {
+    FacetColl_Serialize_t super_serialize
+        = (FacetColl_Serialize_t)SUPER_METHOD_PTR(FACETCOLLECTOR,
+                                                  LUCY_FacetColl_Serialize);
+    super_serialize(self, outstream);
+    Freezer_serialize_hash(FacetColl_IVARS(self)->counts, outstream);
+}
+
+FacetCollector*
+FacetColl_Deserialize_IMP(FacetCollector *self, InStream *instream) {
+    FacetColl_Deserialize_t super_deserialize
+        = (FacetColl_Deserialize_t)SUPER_METHOD_PTR(
+              FACETCOLLECTOR, LUCY_FacetColl_Deserialize);
+    self = super_deserialize(self, instream);
+    FacetColl_IVARS(self)->counts = Freezer_read_hash(instream);
+    return self;
+}
+
+/***************************************************************************/
+
+RangeFacetCollector*
+RangeFacetColl_new(String *field, VArray *bounds) {
+    RangeFacetCollector *self
+        = (RangeFacetCollector*)VTable_Make_Obj(RANGEFACETCOLLECTOR);
+    return RangeFacetColl_init(self, field, bounds);
+}
+
+RangeFacetCollector*
+RangeFacetColl_init(RangeFacetCollector *self, String *field,
+                    VArray *bounds) {
+    FacetColl_init((FacetCollector*)self, field);
+    RangeFacetCollectorIVARS *const ivars = RangeFacetColl_IVARS(self);
+    const uint32_t num_bounds = VA_Get_Size(bounds);
+    for (uint32_t i = 0; i < num_bounds; i++) {
+        Obj *bound = VA_Fetch(bounds, i);
+        if (!bound) {
+            DECREF(self);
+            THROW(ERR, "Missing bound at tick %u32", i);
+        }
+        if (i && Obj_Compare_To(VA_Fetch(bounds, i - 1), bound) >= 0) {
+            DECREF(self);
+            THROW(ERR, "Bounds must be in ascending order");
+        }
+    }
+    ivars->bounds = VA_Shallow_Copy(bounds);
+    ivars->bucket_counts
+        = (int64_t*)CALLOCATE(num_bounds + 1, sizeof(int64_t));
+    return self;
+}
+
+void
+RangeFacetColl_Destroy_IMP(RangeFacetCollector *self) {
+    RangeFacetCollectorIVARS *const ivars = RangeFacetColl_IVARS(self);
+    DECREF(ivars->bounds);
+    FREEMEM(ivars->bucket_counts);
+    SUPER_DESTROY(self, RANGEFACETCOLLECTOR);
+}
+
+// Return the bucket for a value: the number of bounds at or below it.
+static uint32_t
+S_find_bucket(VArray *bounds, Obj *value) {
+    uint32_t lo = 0;
+    uint32_t hi = VA_Get_Size(bounds);
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (Obj_Compare_To(VA_Fetch(bounds, mid), value) <= 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void
+RangeFacetColl_Tally_IMP(RangeFacetCollector *self, SortCache *sort_cache,
+                         int32_t *ord_counts) {
+    RangeFacetCollectorIVARS *const ivars = RangeFacetColl_IVARS(self);
+    const int32_t cardinality = SortCache_Get_Cardinality(sort_cache);
+    for (int32_t ord = 0; ord < cardinality; ord++) {
+        if (!ord_counts[ord]) { continue; }
+        Obj *value = SortCache_Value(sort_cache, ord);
+        if (!value) { continue; }
+        uint32_t tick = S_find_bucket(ivars->bounds, value);
+        ivars->bucket_counts[tick] += ord_counts[ord];
+        DECREF(value);
+    }
+}
+
+void
+RangeFacetColl_Merge_IMP(RangeFacetCollector *self,
+                         AggregateCollector *other) {
+    // Check the class before looking at the other collector's ivars.
+    if (RangeFacetColl_Get_VTable(self) != AggColl_Get_VTable(other)) {
+        THROW(ERR, "Can't merge a %o into a %o",
+              AggColl_Get_Class_Name(other),
+              RangeFacetColl_Get_Class_Name(self));
+    }
+    RangeFacetCollectorIVARS *const ivars = RangeFacetColl_IVARS(self);
+    RangeFacetCollectorIVARS *const ovars
+        = RangeFacetColl_IVARS((RangeFacetCollector*)other);
+    if (!VA_Equals(ivars->bounds, (Obj*)ovars->bounds)) {
+        THROW(ERR, "Can't merge RangeFacetCollectors with different bounds");
+    }
+    RangeFacetColl_Merge_t super_merge
+        = (RangeFacetColl_Merge_t)SUPER_METHOD_PTR(RANGEFACETCOLLECTOR,
+                                                   LUCY_RangeFacetColl_Merge);
+    super_merge(self, other);
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->bounds); i <= max; i++) {
+        ivars->bucket_counts[i] += ovars->bucket_counts[i];
+    }
+}
+
+uint32_t
+RangeFacetColl_Num_Buckets_IMP(RangeFacetCollector *self) {
+    return VA_Get_Size(RangeFacetColl_IVARS(self)->bounds) + 1;
+}
+
+int64_t
+RangeFacetColl_Bucket_Count_IMP(RangeFacetCollector *self, uint32_t tick) {
+    RangeFacetCollectorIVARS *const ivars = RangeFacetColl_IVARS(self);
+    if (tick > VA_Get_Size(ivars->bounds)) {
+        THROW(ERR, "Bucket out of range: %u32 > %u32", tick,
+              VA_Get_Size(ivars->bounds));
+    }
+    RangeFacetColl_Flush(self);
+    return ivars->bucket_counts[tick];
+}
+
+void
+RangeFacetColl_Serialize_IMP(RangeFacetCollector *self,
+                             OutStream *outstream) {
+    RangeFacetColl_Serialize_t super_serialize
+        = (RangeFacetColl_Serialize_t)SUPER_METHOD_PTR(
+              RANGEFACETCOLLECTOR, LUCY_RangeFacetColl_Serialize);
+    super_serialize(self, outstream);
+    RangeFacetCollectorIVARS *const ivars = RangeFacetColl_IVARS(self);
+    Freezer_serialize_varray(ivars->bounds, outstream);
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->bounds); i <= max; i++) {
+        OutStream_Write_C64(outstream, (uint64_t)ivars->bucket_counts[i]);
+    }
+}
+
+RangeFacetCollector*
+RangeFacetColl_Deserialize_IMP(RangeFacetCollector *self,
+                               InStream *instream) {
+    RangeFacetColl_Deserialize_t super_deserialize
+        = (RangeFacetColl_Deserialize_t)SUPER_METHOD_PTR(
+              RANGEFACETCOLLECTOR, LUCY_RangeFacetColl_Deserialize);
+    self = super_deserialize(self, instream);
+    RangeFacetCollectorIVARS *const ivars = RangeFacetColl_IVARS(self);
+    ivars->bounds = Freezer_read_varray(instream);
+    const uint32_t num_buckets = VA_Get_Size(ivars->bounds) + 1;
+    ivars->bucket_counts
+        = (int64_t*)MALLOCATE(num_buckets * sizeof(int64_t));
+    for (uint32_t i = 0; i < num_buckets; i++) {
+        ivars->bucket_counts[i] = (int64_t)InStream_Read_C64(instream);
+    }
+    return self;
+}
@@ -0,0 +1,399 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_GROUPCOLLECTOR
+#define C_LUCY_GROUPDOCSCOLLECTOR
+#define C_LUCY_MATCHDOC
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/Collector/GroupCollector.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Search/HitQueue.h"
+#include "Lucy/Search/MatchDoc.h"
+#include "Lucy/Search/Matcher.h"
+#include "Lucy/Search/TopDocs.h"
+
+static SortCache*
+S_fetch_sort_cache(SegReader *reader, String *field) {
+    SortReader *sort_reader = reader
+                              ? (SortReader*)SegReader_Fetch(
+                                    reader, VTable_Get_Name(SORTREADER))
+                              : NULL;
+    return sort_reader
+           ? SortReader_Fetch_Sort_Cache(sort_reader, field)
+           : NULL;
+}
+
+GroupCollector*
+GroupColl_new(String *field, uint32_t num_groups) {
+    GroupCollector *self = (GroupCollector*)VTable_Make_Obj(GROUPCOLLECTOR);
+    return GroupColl_init(self, field, num_groups);
+}
+
+GroupCollector*
+GroupColl_init(GroupCollector *self, String *field, uint32_t num_groups) {
+    Coll_init((Collector*)self);
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+    if (!num_groups) {
+        DECREF(self);
+        THROW(ERR, "num_groups must be at least 1");
+    }
+    ivars->field       = Str_Clone(field);
+    ivars->num_groups  = num_groups;
+    ivars->total_hits  = 0;
+    ivars->groups      = Hash_new(0);
+    ivars->threshold   = F32_NEGINF;
+    ivars->sort_cache  = NULL;
+    ivars->null_ord    = -1;
+    ivars->cardinality = 0;
+    ivars->best_scores = NULL;
+    ivars->best_docs   = NULL;
+    return self;
+}
+
+void
+GroupColl_Destroy_IMP(GroupCollector *self) {
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+    DECREF(ivars->field);
+    DECREF(ivars->groups);
+    DECREF(ivars->sort_cache);
+    FREEMEM(ivars->best_scores);
+    FREEMEM(ivars->best_docs);
+    SUPER_DESTROY(self, GROUPCOLLECTOR);
+}
+
+void
+GroupColl_Set_Reader_IMP(GroupCollector *self, SegReader *reader) {
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+
+    // Resolve the previous segment's groups while its sort cache is still in
+    // place.
+    GroupColl_Flush(self);
+
+    SortCache *sort_cache = S_fetch_sort_cache(reader, ivars->field);
+    if (sort_cache) {
+        ivars->sort_cache  = (SortCache*)INCREF(sort_cache);
+        ivars->null_ord    = SortCache_Get_Null_Ord(sort_cache);
+        ivars->cardinality = SortCache_Get_Cardinality(sort_cache);
+        ivars->best_scores
+            = (float*)MALLOCATE(ivars->cardinality * sizeof(float));
+        ivars->best_docs
+            = (int32_t*)MALLOCATE(ivars->cardinality * sizeof(int32_t));
+        for (int32_t i = 0; i < ivars->cardinality; i++) {
+            ivars->best_docs[i] = -1;
+        }
+    }
+
+    GroupColl_Set_Reader_t super_set_reader
+        = (GroupColl_Set_Reader_t)SUPER_METHOD_PTR(GROUPCOLLECTOR,
+                                                   LUCY_GroupColl_Set_Reader);
+    super_set_reader(self, reader);
+}
+
+static CFISH_INLINE void
+SI_group_collect(GroupCollectorIVARS *ivars, int32_t doc_id,
+                 const float *score_ptr) {
+    ivars->total_hits++;
+    if (!ivars->sort_cache) { return; }
+
+    const int32_t ord = SortCache_Ordinal(ivars->sort_cache, doc_id);
+    if (ord == ivars->null_ord) { return; }
+
+    // Doc ids only ascend, so a later hit must beat an earlier one outright
+    // -- both within the segment and against groups from prior segments.
+    const float score = score_ptr ? *score_ptr : Matcher_Score(ivars->matcher);
+    if (score <= ivars->threshold) { return; }
+    // Record the doc id for the larger index right away: an OffsetCollector
+    // may change the base before the segment is flushed.
+    if (ivars->best_docs[ord] < 0 || score > ivars->best_scores[ord]) {
+        ivars->best_scores[ord] = score;
+        ivars->best_docs[ord]   = doc_id + ivars->base;
+    }
+}
+
+void
+GroupColl_Collect_IMP(GroupCollector *self, int32_t doc_id) {
+    SI_group_collect(GroupColl_IVARS(self), doc_id, NULL);
+}
+
+void
+GroupColl_Collect_Block_IMP(GroupCollector *self, int32_t *doc_ids,
+                            float *scores, uint32_t num_docs) {
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+    for (uint32_t i = 0; i < num_docs; i++) {
+        SI_group_collect(ivars, doc_ids[i], scores ? scores + i : NULL);
+    }
+}
+
+bool
+GroupColl_Uses_Block_Scores_IMP(GroupCollector *self) {
+    UNUSED_VAR(self);
+    return true;
+}
+
+bool
+GroupColl_Need_Score_IMP(GroupCollector *self) {
+    UNUSED_VAR(self);
+    return true;
+}
+
+// Rank the best hit of every group, keeping at most `num_groups`.
+static VArray*
+S_rank_groups(GroupCollectorIVARS *ivars) {
+    HitQueue *queue = HitQ_new(NULL, NULL, ivars->num_groups);
+    Obj *key;
+    Obj *match_doc;
+    Hash_Iterate(ivars->groups);
+    while (Hash_Next(ivars->groups, &key, &match_doc)) {
+        HitQ_Insert(queue, INCREF(match_doc));
+    }
+    VArray *ranked = HitQ_Pop_All(queue);
+    DECREF(queue);
+    return ranked;
+}
+
+void
+GroupColl_Flush_IMP(GroupCollector *self) {
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+    if (!ivars->sort_cache) { return; }
+
+    for (int32_t ord = 0; ord < ivars->cardinality; ord++) {
+        if (ivars->best_docs[ord] < 0) { continue; }
+        Obj *value = SortCache_Value(ivars->sort_cache, ord);
+        if (!value) { continue; }
+        int32_t doc_id = ivars->best_docs[ord];
+        float   score  = ivars->best_scores[ord];
+        MatchDoc *existing = (MatchDoc*)Hash_Fetch(ivars->groups, value);
+
+        // A group's hit from an earlier segment wins a tie.
+        if (!existing || score > MatchDoc_IVARS(existing)->score) {
+            VArray *values = VA_new(1);
+            VA_Push(values, INCREF(value));
+            Hash_Store(ivars->groups, value,
+                       (Obj*)MatchDoc_new(doc_id, score, values));
+            DECREF(values);
+        }
+        DECREF(value);
+    }
+
+    // Trim to the top groups.  Once there are enough of them, the weakest
+    // group's score becomes the bar for hits in later segments.
+    if (Hash_Get_Size(ivars->groups) >= ivars->num_groups) {
+        VArray *ranked = S_rank_groups(ivars);
+        Hash_Clear(ivars->groups);
+        for (uint32_t i = 0, max = VA_Get_Size(ranked); i < max; i++) {
+            MatchDoc *match_doc = (MatchDoc*)VA_Fetch(ranked, i);
+            Obj *value = VA_Fetch(MatchDoc_IVARS(match_doc)->values, 0);
+            Hash_Store(ivars->groups, value, INCREF(match_doc));
+        }
+        MatchDoc *weakest = (MatchDoc*)VA_Fetch(ranked, ivars->num_groups - 1);
+        ivars->threshold = MatchDoc_IVARS(weakest)->score;
+        DECREF(ranked);
+    }
+
+    DECREF(ivars->sort_cache);
+    FREEMEM(ivars->best_scores);
+    FREEMEM(ivars->best_docs);
+    ivars->sort_cache  = NULL;
+    ivars->best_scores = NULL;
+    ivars->best_docs   = NULL;
+    ivars->cardinality = 0;
+    ivars->null_ord    = -1;
+}
+
+VArray*
+GroupColl_Top_Group_Docs_IMP(GroupCollector *self) {
+    GroupColl_Flush(self);
+    return S_rank_groups(GroupColl_IVARS(self));
+}
+
+VArray*
+GroupColl_Top_Groups_IMP(GroupCollector *self) {
+    VArray *ranked = GroupColl_Top_Group_Docs(self);
+    uint32_t num_groups = VA_Get_Size(ranked);
+    VArray *values = VA_new(num_groups);
+    for (uint32_t i = 0; i < num_groups; i++) {
+        MatchDoc *match_doc = (MatchDoc*)VA_Fetch(ranked, i);
+        Obj *value = VA_Fetch(MatchDoc_IVARS(match_doc)->values, 0);
+        VA_Push(values, INCREF(value));
+    }
+    DECREF(ranked);
+    return values;
+}
+
+uint32_t
+GroupColl_Get_Total_Hits_IMP(GroupCollector *self) {
+    return GroupColl_IVARS(self)->total_hits;
+}
+
+String*
+GroupColl_Get_Field_IMP(GroupCollector *self) {
+    return GroupColl_IVARS(self)->field;
+}
+
+/***************************************************************************/
+
+GroupDocsCollector*
+GroupDocsColl_new(String *field, VArray *groups, uint32_t docs_per_group) {
+    GroupDocsCollector *self
+        = (GroupDocsCollector*)VTable_Make_Obj(GROUPDOCSCOLLECTOR);
+    return GroupDocsColl_init(self, field, groups, docs_per_group);
+}
+
+GroupDocsCollector*
+GroupDocsColl_init(GroupDocsCollector *self, String *field, VArray *groups,
+                   uint32_t docs_per_group) {
+    Coll_init((Collector*)self);
+    GroupDocsCollectorIVARS *const ivars = GroupDocsColl_IVARS(self);
+    if (!docs_per_group) {
+        DECREF(self);
+        THROW(ERR, "docs_per_group must be at least 1");
+    }
+    uint32_t num_groups = VA_Get_Size(groups);
+    ivars->field          = Str_Clone(field);
+    ivars->groups         = (VArray*)INCREF(groups);
+    ivars->docs_per_group = docs_per_group;
+    ivars->queues         = VA_new(num_groups);
+    ivars->group_hits
+        = (uint32_t*)CALLOCATE(num_groups + 1, sizeof(uint32_t));
+    ivars->top_docs       = NULL;
+    ivars->sort_cache     = NULL;
+    ivars->ord_groups     = NULL;
+    for (uint32_t i = 0; i < num_groups; i++) {
+        VA_Push(ivars->queues, (Obj*)HitQ_new(NULL, NULL, docs_per_group));
+    }
+    return self;
+}
+
+void
+GroupDocsColl_Destroy_IMP(GroupDocsCollector *self) {
+    GroupDocsCollectorIVARS *const ivars = GroupDocsColl_IVARS(self);
+    DECREF(ivars->field);
+    DECREF(ivars->groups);
+    DECREF(ivars->queues);
+    DECREF(ivars->top_docs);
+    DECREF(ivars->sort_cache);
+    FREEMEM(ivars->group_hits);
+    FREEMEM(ivars->ord_groups);
+    SUPER_DESTROY(self, GROUPDOCSCOLLECTOR);
+}
+
+void
+GroupDocsColl_Set_Reader_IMP(GroupDocsCollector *self, SegReader *reader) {
+    GroupDocsCollectorIVARS *const ivars = GroupDocsColl_IVARS(self);
+    DECREF(ivars->sort_cache);
+    FREEMEM(ivars->ord_groups);
+    ivars->sort_cache = NULL;
+    ivars->ord_groups = NULL;
+
+    SortCache *sort_cache = S_fetch_sort_cache(reader, ivars->field);
+    if (sort_cache) {
+        // Map each ordinal in the segment to a group tick, or -1.
+        int32_t cardinality = SortCache_Get_Cardinality(sort_cache);
+        ivars->sort_cache = (SortCache*)INCREF(sort_cache);
+        ivars->ord_groups
+            = (int32_t*)MALLOCATE(cardinality * sizeof(int32_t));
+        for (int32_t ord = 0; ord < cardinality; ord++) {
+            ivars->ord_groups[ord] = -1;
+        }
+        for (uint32_t i = 0, max = VA_Get_Size(ivars->groups); i < max; i++) {
+            Obj *group = VA_Fetch(ivars->groups, i);
+            if (!group) { continue; }
+            int32_t ord = SortCache_Find(sort_cache, group);
+            if (ord < 0) { continue; }
+            Obj *value = SortCache_Value(sort_cache, ord);
+            if (value && Obj_Equals(value, group)) {
+                ivars->ord_groups[ord] = (int32_t)i;
+            }
+            DECREF(value);
+        }
+    }
+
+    GroupDocsColl_Set_Reader_t super_set_reader
+        = (GroupDocsColl_Set_Reader_t)SUPER_METHOD_PTR(
+              GROUPDOCSCOLLECTOR, LUCY_GroupDocsColl_Set_Reader);
+    super_set_reader(self, reader);
+}
+
+static CFISH_INLINE void
+SI_group_docs_collect(GroupDocsCollectorIVARS *ivars, int32_t doc_id,
+                      const float *score_ptr) {
+    if (!ivars->ord_groups) { return; }
+    const int32_t ord  = SortCache_Ordinal(ivars->sort_cache, doc_id);
+    const int32_t tick = ivars->ord_groups[ord];
+    if (tick < 0) { return; }
+    ivars->group_hits[tick]++;
+
+    // Skip the allocation unless the hit beats the weakest one held.  Doc
+    // ids only ascend, so a tie loses.
+    HitQueue *queue = (HitQueue*)VA_Fetch(ivars->queues, (uint32_t)tick);
+    const float score = score_ptr ? *score_ptr : Matcher_Score(ivars->matcher);
+    if (HitQ_Get_Size(queue) == ivars->docs_per_group) {
+        MatchDoc *weakest = (MatchDoc*)HitQ_Peek(queue);
+        if (score <= MatchDoc_IVARS(weakest)->score) { return; }
+    }
+    HitQ_Insert(queue, (Obj*)MatchDoc_new(doc_id + ivars->base, score, NULL));
+}
+
+void
+GroupDocsColl_Collect_IMP(GroupDocsCollector *self, int32_t doc_id) {
+    SI_group_docs_collect(GroupDocsColl_IVARS(self), doc_id, NULL);
+}
+
+void
+GroupDocsColl_Collect_Block_IMP(GroupDocsCollector *self, int32_t *doc_ids,
+                                float *scores, uint32_t num_docs) {
+    GroupDocsCollectorIVARS *const ivars = GroupDocsColl_IVARS(self);
+    for (uint32_t i = 0; i < num_docs; i++) {
+        SI_group_docs_collect(ivars, doc_ids[i], scores ? scores + i : NULL);
+    }
+}
+
+bool
+GroupDocsColl_Uses_Block_Scores_IMP(GroupDocsCollector *self) {
+    UNUSED_VAR(self);
+    return true;
+}
+
+bool
+GroupDocsColl_Need_Score_IMP(GroupDocsCollector *self) {
+    UNUSED_VAR(self);
+    return true;
+}
+
+VArray*
+GroupDocsColl_Get_Top_Docs_IMP(GroupDocsCollector *self) {
+    GroupDocsCollectorIVARS *const ivars = GroupDocsColl_IVARS(self);
+    if (!ivars->top_docs) {
+        uint32_t num_groups = VA_Get_Size(ivars->queues);
+        ivars->top_docs = VA_new(num_groups);
+        for (uint32_t i = 0; i < num_groups; i++) {
+            HitQueue *queue = (HitQueue*)VA_Fetch(ivars->queues, i);
+            VArray *match_docs = HitQ_Pop_All(queue);
+            VA_Push(ivars->top_docs,
+                    (Obj*)TopDocs_new(match_docs, ivars->group_hits[i]));
+            DECREF(match_docs);
+        }
+    }
+    return ivars->top_docs;
+}
+
+VArray*
+GroupDocsColl_Get_Groups_IMP(GroupDocsCollector *self) {
+    return GroupDocsColl_IVARS(self)->groups;
+}
@@ -20,6 +20,7 @@
 
 #include "Lucy/Search/Collector/SortCollector.h"
 #include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
 #include "Lucy/Index/SortCache.h"
 #include "Lucy/Index/SortCache/NumericSortCache.h"
 #include "Lucy/Index/SortCache/TextSortCache.h"
@@ -61,9 +62,29 @@
 static int8_t
 S_derive_action(SortRule *rule, SortCache *sort_cache);
 
-// Decide whether a doc should be inserted into the HitQueue.
+// Decide whether a doc should be inserted into the HitQueue.  If `score` is
+// NULL, the score will be fetched from the Matcher on demand.
 static CFISH_INLINE bool
-SI_competitive(SortCollectorIVARS *ivars, int32_t doc_id);
+SI_competitive(SortCollectorIVARS *ivars, int32_t doc_id, const float *score);
+
+// Shared implementation of Collect() and Collect_Block().
+static CFISH_INLINE void
+SI_collect(SortCollectorIVARS *ivars, int32_t doc_id, const float *score);
+
+// Return a String which wraps the value for `ord` in place, or NULL if the
+// value is NULL.  `old_val` is consumed; if nothing else holds it, it gets
+// pointed at the new value instead of allocating a fresh String.
+static String*
+S_wrap_text_value(TextSortCache *cache, int32_t ord, Obj *old_val);
+
+// Load the sorted runs of an index-sorted segment, if they line up with the
+// first SortRule.
+static void
+S_load_runs(SortCollector *self, SegReader *reader);
+
+// Called when a doc in a sorted run fails to make the queue.
+static void
+S_maybe_skip_run(SortCollectorIVARS *ivars, int32_t doc_id);
 
 SortCollector*
 SortColl_new(Schema *schema, SortSpec *sort_spec, uint32_t wanted) {
@@ -112,6 +133,8 @@ SortColl_init(SortCollector *self, Schema *schema, SortSpec *sort_spec,
     ivars->rules         = rules; // absorb refcount.
     ivars->num_rules     = num_rules;
     ivars->sort_caches   = (SortCache**)CALLOCATE(num_rules, sizeof(SortCache*));
+    ivars->text_caches   = (TextSortCache**)CALLOCATE(num_rules,
+                                                      sizeof(TextSortCache*));
     ivars->ord_arrays    = (void**)CALLOCATE(num_rules, sizeof(void*));
     ivars->actions       = (uint8_t*)CALLOCATE(num_rules, sizeof(uint8_t));
 
@@ -169,9 +192,11 @@ SortColl_Destroy_IMP(SortCollector *self) {
     DECREF(ivars->rules);
     DECREF(ivars->bumped);
     FREEMEM(ivars->sort_caches);
+    FREEMEM(ivars->text_caches);
     FREEMEM(ivars->ord_arrays);
     FREEMEM(ivars->auto_actions);
     FREEMEM(ivars->derived_actions);
+    FREEMEM(ivars->run_starts);
     SUPER_DESTROY(self, SORTCOLLECTOR);
 }
 
@@ -244,22 +269,120 @@ SortColl_Set_Reader_IMP(SortCollector *self, SegReader *reader) {
                                ? SortReader_Fetch_Sort_Cache(sort_reader, field)
                                : NULL;
             ivars->sort_caches[i] = cache;
+            ivars->text_caches[i] = cache && SortCache_Is_A(cache, TEXTSORTCACHE)
+                                    ? (TextSortCache*)cache
+                                    : NULL;
             ivars->derived_actions[i] = S_derive_action(rule, cache);
             if (cache) { ivars->ord_arrays[i] = SortCache_Get_Ords(cache); }
             else       { ivars->ord_arrays[i] = NULL; }
         }
     }
     ivars->seg_doc_max = reader ? SegReader_Doc_Max(reader) : 0;
+    S_load_runs(self, reader);
     SortColl_Set_Reader_t super_set_reader
         = (SortColl_Set_Reader_t)SUPER_METHOD_PTR(SORTCOLLECTOR,
                                                   LUCY_SortColl_Set_Reader);
     super_set_reader(self, reader);
 }
 
+static void
+S_load_runs(SortCollector *self, SegReader *reader) {
+    SortCollectorIVARS *const ivars = SortColl_IVARS(self);
+    ivars->next_wanted   = 0;
+    ivars->run_tick      = 0;
+    ivars->num_runs      = 0;
+    ivars->can_terminate = false;
+    if (!ivars->early_termination || !ivars->wanted || !reader
+        || !ivars->sort_caches[0]
+       ) {
+        return;
+    }
+
+    // The segment must be sorted by the same field in the same direction as
+    // the first SortRule.
+    SortRule *rule = (SortRule*)VA_Fetch(ivars->rules, 0);
+    Hash *metadata
+        = (Hash*)Seg_Fetch_Metadata_Utf8(SegReader_Get_Segment(reader),
+                                         "index_sort", 10);
+    if (!metadata) { return; }
+    Obj    *field   = Hash_Fetch_Utf8(metadata, "field", 5);
+    Obj    *reverse = Hash_Fetch_Utf8(metadata, "reverse", 7);
+    VArray *runs    = (VArray*)Hash_Fetch_Utf8(metadata, "runs", 4);
+    if (!field || !reverse || !runs
+        || !Str_Equals(SortRule_Get_Field(rule), field)
+        || !!Obj_To_I64(reverse) != !!SortRule_Get_Reverse(rule)
+       ) {
+        return;
+    }
+
+    CERTIFY(runs, VARRAY);
+    ivars->num_runs   = VA_Get_Size(runs);
+    ivars->run_starts = (int32_t*)REALLOCATE(
+                            ivars->run_starts,
+                            (ivars->num_runs + 1) * sizeof(int32_t));
+    for (uint32_t i = 0; i < ivars->num_runs; i++) {
+        ivars->run_starts[i] = (int32_t)Obj_To_I64(VA_Fetch(runs, i));
+    }
+    ivars->run_starts[ivars->num_runs] = INT32_MAX;
+    ivars->can_terminate = ivars->num_runs > 0;
+}
+
+static void
+S_maybe_skip_run(SortCollectorIVARS *ivars, int32_t doc_id) {
+    // Later docs in this doc's run sort no better on the first rule.  If
+    // that's the only rule, they lose ties by doc id.  Otherwise they can
+    // only be written off when this doc lost outright on the first rule.
+    if (ivars->num_actions > 1) {
+        SortCache *cache = ivars->sort_caches[0];
+        int32_t comparison = SortCache_Ordinal(cache, doc_id)
+                             - SortCache_Ordinal(cache, ivars->bubble_doc);
+        if (SortRule_Get_Reverse((SortRule*)VA_Fetch(ivars->rules, 0))) {
+            comparison = -comparison;
+        }
+        if (comparison <= 0) { return; }
+    }
+
+    // Skip to the start of the next run.
+    while (ivars->run_starts[ivars->run_tick + 1] <= doc_id) {
+        ivars->run_tick++;
+    }
+    ivars->next_wanted = ivars->run_starts[ivars->run_tick + 1];
+}
+
+int32_t
+SortColl_Next_Wanted_IMP(SortCollector *self) {
+    return SortColl_IVARS(self)->next_wanted;
+}
+
+void
+SortColl_Set_Early_Termination_IMP(SortCollector *self,
+                                   bool early_termination) {
+    SortColl_IVARS(self)->early_termination = early_termination;
+}
+
 VArray*
 SortColl_Pop_Match_Docs_IMP(SortCollector *self) {
     SortCollectorIVARS *const ivars = SortColl_IVARS(self);
-    return HitQ_Pop_All(ivars->hit_q);
+    VArray *match_docs = HitQ_Pop_All(ivars->hit_q);
+
+    // Text values were wrapped in place within the sort caches.  Give each
+    // surviving hit its own copy, so that it may outlive the IndexReader.
+    if (ivars->need_values) {
+        for (uint32_t i = 0, max = VA_Get_Size(match_docs); i < max; i++) {
+            MatchDoc *match_doc = (MatchDoc*)VA_Fetch(match_docs, i);
+            VArray   *values    = MatchDoc_IVARS(match_doc)->values;
+            for (uint32_t j = 0, num = VA_Get_Size(values); j < num; j++) {
+                String *val = (String*)VA_Fetch(values, j);
+                if (val && Str_Is_A(val, STRING)) {
+                    String *copy = Str_new_from_trusted_utf8(
+                                       Str_Get_Ptr8(val), Str_Get_Size(val));
+                    VA_Store(values, j, (Obj*)copy);
+                }
+            }
+        }
+    }
+
+    return match_docs;
 }
 
 uint32_t
@@ -274,19 +397,69 @@ SortColl_Need_Score_IMP(SortCollector *self) {
 
 void
 SortColl_Collect_IMP(SortCollector *self, int32_t doc_id) {
+    SI_collect(SortColl_IVARS(self), doc_id, NULL);
+}
+
+void
+SortColl_Collect_Block_IMP(SortCollector *self, int32_t *doc_ids,
+                           float *scores, uint32_t num_docs) {
     SortCollectorIVARS *const ivars = SortColl_IVARS(self);
+    if (scores) {
+        for (uint32_t i = 0; i < num_docs; i++) {
+            SI_collect(ivars, doc_ids[i], scores + i);
+        }
+    }
+    else {
+        for (uint32_t i = 0; i < num_docs; i++) {
+            SI_collect(ivars, doc_ids[i], NULL);
+        }
+    }
+}
+
+bool
+SortColl_Uses_Block_Scores_IMP(SortCollector *self) {
+    UNUSED_VAR(self);
+    return true;
+}
+
+static String*
+S_wrap_text_value(TextSortCache *cache, int32_t ord, Obj *old_val) {
+    size_t size;
+    const char *ptr = TextSortCache_Value_Ptr(cache, ord, &size);
+    if (!ptr) {
+        DECREF(old_val);
+        return NULL;
+    }
+    // Every String in a MatchDoc's values was created here as a wrapper, so
+    // one held only by the values array may be safely re-pointed.
+    if (old_val
+        && Obj_Is_A(old_val, STRING)
+        && Obj_Get_RefCount(old_val) == 1
+       ) {
+        return Str_init_wrap_trusted_utf8((String*)old_val, ptr, size);
+    }
+    DECREF(old_val);
+    return Str_new_wrap_trusted_utf8(ptr, size);
+}
+
+static CFISH_INLINE void
+SI_collect(SortCollectorIVARS *ivars, int32_t doc_id, const float *score) {
+    // Ignore docs in a sorted run which has already been written off.
+    if (doc_id < ivars->next_wanted) { return; }
 
     // Add to the total number of hits.
     ivars->total_hits++;
 
     // Collect this hit if it's competitive.
-    if (SI_competitive(ivars, doc_id)) {
+    if (SI_competitive(ivars, doc_id, score)) {
         MatchDoc *const match_doc = ivars->bumped;
         MatchDocIVARS *const match_doc_ivars = MatchDoc_IVARS(match_doc);
         match_doc_ivars->doc_id = doc_id + ivars->base;
 
         if (ivars->need_score && match_doc_ivars->score == F32_NEGINF) {
-            match_doc_ivars->score = Matcher_Score(ivars->matcher);
+            match_doc_ivars->score = score
+                                     ? *score
+                                     : Matcher_Score(ivars->matcher);
         }
 
         // Fetch values so that cross-segment sorting can work.
@@ -296,12 +469,20 @@ SortColl_Collect_IMP(SortCollector *self, int32_t doc_id) {
             for (uint32_t i = 0, max = ivars->num_rules; i < max; i++) {
                 SortCache *cache   = ivars->sort_caches[i];
                 Obj       *old_val = VA_Delete(values, i);
-                DECREF(old_val);
-                if (cache) {
+                if (ivars->text_caches[i]) {
                     int32_t ord = SortCache_Ordinal(cache, doc_id);
-                    Obj *val = SortCache_Value(cache, ord);
+                    String *val = S_wrap_text_value(ivars->text_caches[i],
+                                                    ord, old_val);
                     if (val) { VA_Store(values, i, (Obj*)val); }
                 }
+                else {
+                    DECREF(old_val);
+                    if (cache) {
+                        int32_t ord = SortCache_Ordinal(cache, doc_id);
+                        Obj *val = SortCache_Value(cache, ord);
+                        if (val) { VA_Store(values, i, (Obj*)val); }
+                    }
+                }
             }
         }
 
@@ -317,6 +498,7 @@ SortColl_Collect_IMP(SortCollector *self, int32_t doc_id) {
                 ivars->bubble_score  = match_doc_ivars->score;
                 ivars->bubble_doc    = doc_id;
                 ivars->actions       = ivars->derived_actions;
+                if (ivars->can_terminate) { S_maybe_skip_run(ivars, doc_id); }
             }
 
             // Recycle.
@@ -335,6 +517,9 @@ SortColl_Collect_IMP(SortCollector *self, int32_t doc_id) {
         }
 
     }
+    else if (ivars->can_terminate) {
+        S_maybe_skip_run(ivars, doc_id);
+    }
 }
 
 static CFISH_INLINE int32_t
@@ -417,7 +602,8 @@ SI_validate_doc_id(SortCollectorIVARS *ivars, int32_t doc_id) {
 }
 
 static CFISH_INLINE bool
-SI_competitive(SortCollectorIVARS *ivars, int32_t doc_id) {
+SI_competitive(SortCollectorIVARS *ivars, int32_t doc_id,
+               const float *precomputed) {
     /* Ordinarily, we would cache local copies of more member variables in
      * const automatic variables in order to improve code clarity and provide
      * more hints to the compiler about what variables are actually invariant
@@ -449,7 +635,9 @@ SI_competitive(SortCollectorIVARS *ivars, int32_t doc_id) {
             case AUTO_TIE:
                 break;
             case COMPARE_BY_SCORE: {
-                    float score = Matcher_Score(ivars->matcher);
+                    float score = precomputed
+                                  ? *precomputed
+                                  : Matcher_Score(ivars->matcher);
                     if (*(int32_t*)&score == *(int32_t*)&ivars->bubble_score) {
                         break;
                     }
@@ -463,7 +651,9 @@ SI_competitive(SortCollectorIVARS *ivars, int32_t doc_id) {
                 }
                 break;
             case COMPARE_BY_SCORE_REV: {
-                    float score = Matcher_Score(ivars->matcher);
+                    float score = precomputed
+                                  ? *precomputed
+                                  : Matcher_Score(ivars->matcher);
                     if (*(int32_t*)&score == *(int32_t*)&ivars->bubble_score) {
                         break;
                     }
@@ -0,0 +1,480 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_IMPACTMATCHER
+#include "Lucy/Util/ToolSet.h"
+
+#include <math.h>
+
+#include "Lucy/Search/ImpactMatcher.h"
+#include "Lucy/Index/DeletionsReader.h"
+#include "Lucy/Index/ImpactReader.h"
+#include "Lucy/Index/ImpactWriter.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Similarity.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/Compiler.h"
+#include "Lucy/Search/ORQuery.h"
+#include "Lucy/Search/PolyQuery.h"
+#include "Lucy/Search/TermQuery.h"
+
+// The bounds accumulated for one doc.  `key` is the doc's lower bound with
+// the coord factor applied, which is what the top k are ranked on.
+typedef struct {
+    int32_t  doc_id;
+    uint32_t count;
+    float    lower;
+    float    upper;
+    float    key;
+    int32_t  heap_pos;
+    bool     deleted;
+} Candidate;
+
+// The docs seen so far, held sparsely: an array of Candidates plus an
+// open-addressing table mapping doc ids to array positions, and a min-heap
+// on `key` over the best `wanted` of them.  Memory grows with the number of
+// postings read rather than with the size of the segment.
+typedef struct {
+    Candidate *entries;
+    uint32_t   num_entries;
+    uint32_t   entries_cap;
+    uint32_t  *slots;
+    uint32_t   mask;
+    uint32_t  *heap;
+    uint32_t   heap_size;
+    uint32_t   heap_cap;
+    uint32_t   wanted;
+} CandidateSet;
+
+static void
+S_cands_init(CandidateSet *cands, uint32_t wanted);
+
+static void
+S_cands_destroy(CandidateSet *cands);
+
+// Return the position of `doc_id`'s entry, adding one if need be.
+static uint32_t
+S_cands_fetch(CandidateSet *cands, int32_t doc_id);
+
+// Restore the heap after the key of entry `tick` has changed, admitting the
+// entry if it now ranks among the best `wanted`.
+static void
+S_cands_update(CandidateSet *cands, uint32_t tick);
+
+// Return the `wanted`th best key, or 0 if fewer docs have been seen.
+static float
+S_cands_threshold(CandidateSet *cands);
+
+// Return the lower edge of the impact bucket whose maximum is `max_impact`.
+static float
+S_bucket_floor(float max_impact);
+
+// Open an ImpactList for a TermCompiler, or return NULL and set `*usable`
+// to false if the term's field has no impact-ordered postings.
+static ImpactList*
+S_open_list(ImpactReader *impact_reader, Schema *schema,
+            TermCompiler *compiler, bool *usable);
+
+BitVector*
+ImpactMatcher_find_candidates(Compiler *compiler, SegReader *reader,
+                              uint32_t wanted) {
+    ImpactReader *impact_reader
+        = (ImpactReader*)SegReader_Fetch(reader,
+                                         VTable_Get_Name(IMPACTREADER));
+    if (!impact_reader || !wanted) { return NULL; }
+
+    // Only TermQueries and ORQueries over TermQueries are supported.
+    VArray *children;
+    if (Compiler_Is_A(compiler, TERMCOMPILER)) {
+        children = VA_new(1);
+        VA_Push(children, INCREF(compiler));
+    }
+    else if (Compiler_Is_A(compiler, ORCOMPILER)) {
+        children = (VArray*)INCREF(
+                       PolyCompiler_Get_Children((PolyCompiler*)compiler));
+    }
+    else {
+        return NULL;
+    }
+    const uint32_t num_terms = VA_Get_Size(children);
+    if (!num_terms) {
+        DECREF(children);
+        return NULL;
+    }
+
+    // Gather each term's postings and weight.  ORCompiler doesn't apply the
+    // coord factor when it has only a single child.
+    Schema      *schema  = SegReader_Get_Schema(reader);
+    ImpactList **lists   = (ImpactList**)CALLOCATE(num_terms,
+                                                   sizeof(ImpactList*));
+    float       *weights = (float*)MALLOCATE(num_terms * sizeof(float));
+    float       *coords  = (float*)MALLOCATE((num_terms + 1) * sizeof(float));
+    bool         usable  = true;
+    for (uint32_t i = 0; i < num_terms && usable; i++) {
+        Compiler *child = (Compiler*)VA_Fetch(children, i);
+        if (!child || !Compiler_Is_A(child, TERMCOMPILER)) {
+            usable = false;
+            break;
+        }
+        weights[i] = TermCompiler_Get_Weight((TermCompiler*)child);
+        if (weights[i] < 0.0f) { usable = false; }
+        lists[i] = S_open_list(impact_reader, schema, (TermCompiler*)child,
+                               &usable);
+    }
+    if (num_terms > 1) {
+        Similarity *sim = Compiler_Get_Similarity(compiler);
+        for (uint32_t i = 0; i <= num_terms; i++) {
+            coords[i] = Sim_Coord(sim, i, num_terms);
+        }
+    }
+    else {
+        coords[0] = coords[1] = 1.0f;
+    }
+    DECREF(children);
+
+    BitVector *candidates = NULL;
+    if (usable) {
+        CandidateSet cands;
+        S_cands_init(&cands, wanted);
+
+        // Deleted docs don't compete for a place in the top k.  Mark them
+        // in the candidate set, so that the cost follows the number of
+        // deletions rather than the size of the segment.
+        DeletionsReader *del_reader = (DeletionsReader*)SegReader_Fetch(
+                                          reader,
+                                          VTable_Get_Name(DELETIONSREADER));
+        Matcher *deletions = del_reader && DelReader_Del_Count(del_reader)
+                             ? DelReader_Iterator(del_reader)
+                             : NULL;
+        if (deletions) {
+            int32_t del;
+            while (0 != (del = Matcher_Next(deletions))) {
+                cands.entries[S_cands_fetch(&cands, del)].deleted = true;
+            }
+            DECREF(deletions);
+        }
+
+        const int32_t doc_max = SegReader_Doc_Max(reader);
+        const float coord_max = coords[num_terms];
+        float remaining = 0.0f;
+
+        while (true) {
+            // Find the bucket with the highest weighted impact.  Its bound,
+            // summed over all terms, caps the score of any unseen doc.
+            uint32_t best = 0;
+            float    best_bound = 0.0f;
+            remaining = 0.0f;
+            for (uint32_t i = 0; i < num_terms; i++) {
+                float bound = lists[i]
+                              ? weights[i] * ImpactList_Next_Max_Impact(lists[i])
+                              : 0.0f;
+                remaining += bound;
+                if (bound > best_bound) {
+                    best_bound = bound;
+                    best = i;
+                }
+            }
+            if (best_bound <= 0.0f) { break; }
+
+            // Stop once no unseen doc could displace the kth best.
+            if (remaining * coord_max * (1.0f + IMPACTMATCHER_SLACK)
+                < S_cands_threshold(&cands)
+               ) {
+                break;
+            }
+
+            // Accumulate the bucket.
+            float    floor_impact = weights[best]
+                                    * S_bucket_floor(
+                                        ImpactList_Next_Max_Impact(lists[best]));
+            uint32_t count;
+            int32_t *doc_ids = ImpactList_Next_Bucket(lists[best], &count);
+            for (uint32_t i = 0; i < count; i++) {
+                int32_t doc_id = doc_ids[i];
+                if (doc_id > doc_max) { continue; }
+                uint32_t   tick  = S_cands_fetch(&cands, doc_id);
+                Candidate *entry = cands.entries + tick;
+                if (entry->deleted) { continue; }
+                entry->count++;
+                entry->lower += floor_impact;
+                entry->upper += best_bound;
+                entry->key    = entry->lower * coords[entry->count];
+                S_cands_update(&cands, tick);
+            }
+        }
+
+        // Keep every seen doc whose upper bound reaches the threshold.
+        // Only bounds from buckets not yet read can still be added.
+        const float threshold = S_cands_threshold(&cands);
+        int32_t last_doc = 0;
+        for (uint32_t i = 0; i < cands.num_entries; i++) {
+            if (cands.entries[i].doc_id > last_doc) {
+                last_doc = cands.entries[i].doc_id;
+            }
+        }
+        candidates = BitVec_new((uint32_t)last_doc + 1);
+        for (uint32_t i = 0; i < cands.num_entries; i++) {
+            Candidate *entry = cands.entries + i;
+            if (entry->deleted || !entry->count) { continue; }
+            float bound = (entry->upper + remaining) * coord_max;
+            if (bound * (1.0f + IMPACTMATCHER_SLACK) >= threshold) {
+                BitVec_Set(candidates, (uint32_t)entry->doc_id);
+            }
+        }
+
+        S_cands_destroy(&cands);
+    }
+
+    for (uint32_t i = 0; i < num_terms; i++) {
+        DECREF(lists[i]);
+    }
+    FREEMEM(coords);
+    FREEMEM(weights);
+    FREEMEM(lists);
+    return candidates;
+}
+
+static void
+S_cands_init(CandidateSet *cands, uint32_t wanted) {
+    cands->num_entries = 0;
+    cands->entries_cap = 64;
+    cands->entries
+        = (Candidate*)MALLOCATE(cands->entries_cap * sizeof(Candidate));
+    cands->mask  = 127;
+    cands->slots = (uint32_t*)CALLOCATE(cands->mask + 1, sizeof(uint32_t));
+    cands->heap_size = 0;
+    cands->wanted    = wanted;
+    cands->heap_cap  = wanted < 64 ? wanted : 64;
+    cands->heap      = (uint32_t*)MALLOCATE(cands->heap_cap * sizeof(uint32_t));
+}
+
+static void
+S_cands_destroy(CandidateSet *cands) {
+    FREEMEM(cands->heap);
+    FREEMEM(cands->slots);
+    FREEMEM(cands->entries);
+}
+
+static uint32_t
+S_slot_for(uint32_t doc_id, uint32_t mask) {
+    return (doc_id * 2654435761u) & mask;
+}
+
+static uint32_t
+S_cands_fetch(CandidateSet *cands, int32_t doc_id) {
+    uint32_t slot = S_slot_for((uint32_t)doc_id, cands->mask);
+    while (cands->slots[slot]) {
+        uint32_t tick = cands->slots[slot] - 1;
+        if (cands->entries[tick].doc_id == doc_id) { return tick; }
+        slot = (slot + 1) & cands->mask;
+    }
+
+    // Add a new entry, keeping the table at most half full.
+    if (cands->num_entries == cands->entries_cap) {
+        cands->entries_cap *= 2;
+        cands->entries = (Candidate*)REALLOCATE(
+                             cands->entries,
+                             cands->entries_cap * sizeof(Candidate));
+    }
+    uint32_t tick = cands->num_entries++;
+    Candidate *entry = cands->entries + tick;
+    entry->doc_id   = doc_id;
+    entry->count    = 0;
+    entry->lower    = 0.0f;
+    entry->upper    = 0.0f;
+    entry->key      = 0.0f;
+    entry->heap_pos = -1;
+    entry->deleted  = false;
+    cands->slots[slot] = tick + 1;
+
+    if (cands->num_entries * 2 > cands->mask + 1) {
+        uint32_t new_mask = cands->mask * 2 + 1;
+        FREEMEM(cands->slots);
+        cands->slots = (uint32_t*)CALLOCATE(new_mask + 1, sizeof(uint32_t));
+        cands->mask  = new_mask;
+        for (uint32_t i = 0; i < cands->num_entries; i++) {
+            uint32_t s = S_slot_for((uint32_t)cands->entries[i].doc_id,
+                                    new_mask);
+            while (cands->slots[s]) { s = (s + 1) & new_mask; }
+            cands->slots[s] = i + 1;
+        }
+    }
+    return tick;
+}
+
+static void
+S_heap_place(CandidateSet *cands, uint32_t pos, uint32_t tick) {
+    cands->heap[pos] = tick;
+    cands->entries[tick].heap_pos = (int32_t)pos;
+}
+
+static void
+S_heap_sift_up(CandidateSet *cands, uint32_t pos) {
+    uint32_t tick = cands->heap[pos];
+    float    key  = cands->entries[tick].key;
+    while (pos > 0) {
+        uint32_t parent = (pos - 1) / 2;
+        if (cands->entries[cands->heap[parent]].key <= key) { break; }
+        S_heap_place(cands, pos, cands->heap[parent]);
+        pos = parent;
+    }
+    S_heap_place(cands, pos, tick);
+}
+
+static void
+S_heap_sift_down(CandidateSet *cands, uint32_t pos) {
+    uint32_t tick = cands->heap[pos];
+    float    key  = cands->entries[tick].key;
+    while (true) {
+        uint32_t child = pos * 2 + 1;
+        if (child >= cands->heap_size) { break; }
+        if (child + 1 < cands->heap_size
+            && cands->entries[cands->heap[child + 1]].key
+               < cands->entries[cands->heap[child]].key
+           ) {
+            child++;
+        }
+        if (cands->entries[cands->heap[child]].key >= key) { break; }
+        S_heap_place(cands, pos, cands->heap[child]);
+        pos = child;
+    }
+    S_heap_place(cands, pos, tick);
+}
+
+static void
+S_cands_update(CandidateSet *cands, uint32_t tick) {
+    Candidate *entry = cands->entries + tick;
+    if (entry->heap_pos >= 0) {
+        S_heap_sift_down(cands, (uint32_t)entry->heap_pos);
+        S_heap_sift_up(cands, (uint32_t)entry->heap_pos);
+    }
+    else if (cands->heap_size < cands->wanted) {
+        if (cands->heap_size == cands->heap_cap) {
+            cands->heap_cap = cands->heap_cap * 2 < cands->wanted
+                              ? cands->heap_cap * 2
+                              : cands->wanted;
+            cands->heap = (uint32_t*)REALLOCATE(
+                              cands->heap, cands->heap_cap * sizeof(uint32_t));
+        }
+        S_heap_place(cands, cands->heap_size++, tick);
+        S_heap_sift_up(cands, (uint32_t)entry->heap_pos);
+    }
+    else if (entry->key > cands->entries[cands->heap[0]].key) {
+        cands->entries[cands->heap[0]].heap_pos = -1;
+        S_heap_place(cands, 0, tick);
+        S_heap_sift_down(cands, 0);
+    }
+}
+
+static float
+S_cands_threshold(CandidateSet *cands) {
+    return cands->heap_size < cands->wanted
+           ? 0.0f
+           : cands->entries[cands->heap[0]].key;
+}
+
+static ImpactList*
+S_open_list(ImpactReader *impact_reader, Schema *schema,
+            TermCompiler *compiler, bool *usable) {
+    TermQuery *parent = (TermQuery*)TermCompiler_Get_Parent(compiler);
+    String    *field  = TermQuery_Get_Field(parent);
+    FieldType *type   = Schema_Fetch_Type(schema, field);
+    if (!type
+        || !FType_Is_A(type, FULLTEXTTYPE)
+        || !FullTextType_Impacts((FullTextType*)type)
+        || !ImpactReader_Has_Field(impact_reader, field)
+       ) {
+        *usable = false;
+        return NULL;
+    }
+    return ImpactReader_Impact_List(impact_reader, field,
+                                    TermQuery_Get_Term(parent));
+}
+
+static float
+S_bucket_floor(float max_impact) {
+    int32_t level = ImpactWriter_level(max_impact);
+    return (float)pow(2.0, (double)level / IMPACTWRITER_LEVELS_PER_DOUBLING);
+}
+
+ImpactMatcher*
+ImpactMatcher_new(Matcher *inner, BitVector *candidates) {
+    ImpactMatcher *self = (ImpactMatcher*)VTable_Make_Obj(IMPACTMATCHER);
+    return ImpactMatcher_init(self, inner, candidates);
+}
+
+ImpactMatcher*
+ImpactMatcher_init(ImpactMatcher *self, Matcher *inner,
+                   BitVector *candidates) {
+    ImpactMatcherIVARS *const ivars = ImpactMatcher_IVARS(self);
+    Matcher_init((Matcher*)self);
+    ivars->inner        = (Matcher*)INCREF(inner);
+    ivars->candidates   = (BitVector*)INCREF(candidates);
+    ivars->doc_id       = 0;
+    ivars->inner_doc_id = 0;
+    return self;
+}
+
+void
+ImpactMatcher_Destroy_IMP(ImpactMatcher *self) {
+    ImpactMatcherIVARS *const ivars = ImpactMatcher_IVARS(self);
+    DECREF(ivars->inner);
+    DECREF(ivars->candidates);
+    SUPER_DESTROY(self, IMPACTMATCHER);
+}
+
+int32_t
+ImpactMatcher_Next_IMP(ImpactMatcher *self) {
+    return ImpactMatcher_Advance_IMP(self, ImpactMatcher_IVARS(self)->doc_id + 1);
+}
+
+int32_t
+ImpactMatcher_Advance_IMP(ImpactMatcher *self, int32_t target) {
+    ImpactMatcherIVARS *const ivars = ImpactMatcher_IVARS(self);
+    while (true) {
+        int32_t candidate
+            = BitVec_Next_Hit(ivars->candidates, (uint32_t)target);
+        if (candidate == -1) {
+            ivars->doc_id = 0;
+            return 0;
+        }
+        if (ivars->inner_doc_id < candidate) {
+            ivars->inner_doc_id = Matcher_Advance(ivars->inner, candidate);
+            if (!ivars->inner_doc_id) {
+                ivars->doc_id = 0;
+                return 0;
+            }
+        }
+        if (ivars->inner_doc_id == candidate) {
+            ivars->doc_id = candidate;
+            return candidate;
+        }
+        target = ivars->inner_doc_id;
+    }
+}
+
+int32_t
+ImpactMatcher_Get_Doc_ID_IMP(ImpactMatcher *self) {
+    return ImpactMatcher_IVARS(self)->doc_id;
+}
+
+float
+ImpactMatcher_Score_IMP(ImpactMatcher *self) {
+    return Matcher_Score(ImpactMatcher_IVARS(self)->inner);
+}
+
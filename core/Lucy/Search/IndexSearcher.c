@@ -27,12 +27,14 @@
 #include "Lucy/Index/LexiconReader.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/SortCache.h"
+#include "Lucy/Object/BitVector.h"
 #include "Lucy/Index/HighlightReader.h"
 #include "Lucy/Plan/FieldType.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Search/Collector.h"
 #include "Lucy/Search/Collector/SortCollector.h"
 #include "Lucy/Search/HitQueue.h"
+#include "Lucy/Search/ImpactMatcher.h"
 #include "Lucy/Search/MatchDoc.h"
 #include "Lucy/Search/Matcher.h"
 #include "Lucy/Search/Query.h"
@@ -111,6 +113,54 @@ IxSearcher_Doc_Freq_IMP(IndexSearcher *self, String *field, Obj *term) {
     return lex_reader ? LexReader_Doc_Freq(lex_reader, field, term) : 0;
 }
 
+void
+IxSearcher_Set_Early_Termination_IMP(IndexSearcher *self,
+                                     bool early_termination) {
+    IxSearcher_IVARS(self)->early_termination = early_termination;
+}
+
+// Collect like Collect(), but visit only the docs which the impact-ordered
+// postings say could make the top `wanted` hits.
+static void
+S_collect_impacts(IndexSearcher *self, Query *query, Collector *collector,
+                  uint32_t wanted) {
+    IndexSearcherIVARS *const ivars = IxSearcher_IVARS(self);
+    VArray   *const seg_readers = ivars->seg_readers;
+    I32Array *const seg_starts  = ivars->seg_starts;
+    Compiler *compiler = Query_Is_A(query, COMPILER)
+                         ? (Compiler*)INCREF(query)
+                         : Query_Make_Compiler(query, (Searcher*)self,
+                                               Query_Get_Boost(query), false);
+
+    for (uint32_t i = 0, max = VA_Get_Size(seg_readers); i < max; i++) {
+        SegReader *seg_reader = (SegReader*)VA_Fetch(seg_readers, i);
+        DeletionsReader *del_reader = (DeletionsReader*)SegReader_Fetch(
+                                          seg_reader,
+                                          VTable_Get_Name(DELETIONSREADER));
+        Matcher *matcher = Compiler_Make_Matcher(compiler, seg_reader, true);
+        if (matcher) {
+            BitVector *candidates
+                = ImpactMatcher_find_candidates(compiler, seg_reader, wanted);
+            if (candidates) {
+                Matcher *inner = matcher;
+                matcher = (Matcher*)ImpactMatcher_new(inner, candidates);
+                DECREF(inner);
+                DECREF(candidates);
+            }
+            int32_t  seg_start = I32Arr_Get(seg_starts, i);
+            Matcher *deletions = DelReader_Iterator(del_reader);
+            Coll_Set_Reader(collector, seg_reader);
+            Coll_Set_Base(collector, seg_start);
+            Coll_Set_Matcher(collector, matcher);
+            Matcher_Collect(matcher, collector, deletions);
+            DECREF(deletions);
+            DECREF(matcher);
+        }
+    }
+
+    DECREF(compiler);
+}
+
 TopDocs*
 IxSearcher_Top_Docs_IMP(IndexSearcher *self, Query *query, uint32_t num_wanted,
                         SortSpec *sort_spec) {
@@ -118,7 +168,14 @@ IxSearcher_Top_Docs_IMP(IndexSearcher *self, Query *query, uint32_t num_wanted,
     uint32_t       doc_max   = IxSearcher_Doc_Max(self);
     uint32_t       wanted    = num_wanted > doc_max ? doc_max : num_wanted;
     SortCollector *collector = SortColl_new(schema, sort_spec, wanted);
-    IxSearcher_Collect(self, query, (Collector*)collector);
+    SortColl_Set_Early_Termination(collector,
+                                   IxSearcher_IVARS(self)->early_termination);
+    if (IxSearcher_IVARS(self)->early_termination && !sort_spec) {
+        S_collect_impacts(self, query, (Collector*)collector, wanted);
+    }
+    else {
+        IxSearcher_Collect(self, query, (Collector*)collector);
+    }
     VArray  *match_docs = SortColl_Pop_Match_Docs(collector);
     int32_t  total_hits = SortColl_Get_Total_Hits(collector);
     TopDocs *retval     = TopDocs_new(match_docs, total_hits);
@@ -40,6 +40,90 @@ Matcher_Advance_IMP(Matcher *self, int32_t target) {
     }
 }
 
+uint32_t
+Matcher_Next_Block_IMP(Matcher *self, int32_t *doc_ids, float *scores,
+                       uint32_t max) {
+    VTable *const vtable = Matcher_Get_VTable(self);
+    Matcher_Next_t next
+        = (Matcher_Next_t)METHOD_PTR(vtable, LUCY_Matcher_Next);
+    Matcher_Score_t score
+        = (Matcher_Score_t)METHOD_PTR(vtable, LUCY_Matcher_Score);
+    uint32_t num_docs = 0;
+
+    while (num_docs < max) {
+        int32_t doc_id = next(self);
+        if (!doc_id) { break; }
+        doc_ids[num_docs] = doc_id;
+        if (scores) { scores[num_docs] = score(self); }
+        num_docs++;
+    }
+
+    return num_docs;
+}
+
+// Squeeze deleted docs out of a block of hits, returning the number kept.
+static uint32_t
+S_squeeze_deletions(Matcher *deletions, int32_t *next_deletion,
+                    int32_t *doc_ids, float *scores, uint32_t num_docs) {
+    uint32_t num_kept = 0;
+    for (uint32_t i = 0; i < num_docs; i++) {
+        int32_t doc_id = doc_ids[i];
+        if (doc_id > *next_deletion) {
+            *next_deletion = Matcher_Advance(deletions, doc_id);
+            if (*next_deletion == 0) { *next_deletion = INT32_MAX; }
+        }
+        if (doc_id != *next_deletion) {
+            doc_ids[num_kept] = doc_id;
+            if (scores) { scores[num_kept] = scores[i]; }
+            num_kept++;
+        }
+    }
+    return num_kept;
+}
+
+// Feed the Collector a block of hits at a time.  Deleted docs are squeezed
+// out of each block before it is handed over.  If the Collector loses
+// interest in a range of docs, skip past it.
+static void
+S_collect_blocks(Matcher *self, Collector *collector, Matcher *deletions) {
+    int32_t   doc_ids[MATCHER_BLOCK_SIZE];
+    float     score_buf[MATCHER_BLOCK_SIZE];
+    float    *scores        = Coll_Need_Score(collector) ? score_buf : NULL;
+    int32_t   next_deletion = deletions ? 0 : INT32_MAX;
+    uint32_t  num_docs;
+
+    while (1) {
+        num_docs = Matcher_Next_Block(self, doc_ids, scores,
+                                      MATCHER_BLOCK_SIZE);
+        if (!num_docs) { break; }
+        int32_t  last_doc = doc_ids[num_docs - 1];
+        uint32_t num_kept = deletions
+                            ? S_squeeze_deletions(deletions, &next_deletion,
+                                                  doc_ids, scores, num_docs)
+                            : num_docs;
+        if (num_kept) {
+            Coll_Collect_Block(collector, doc_ids, scores, num_kept);
+        }
+
+        // Stop once the Matcher or the Collector is done with the segment.
+        int32_t wanted = Coll_Next_Wanted(collector);
+        if (wanted == INT32_MAX || num_docs < MATCHER_BLOCK_SIZE) { break; }
+        if (wanted > last_doc + 1) {
+            // Jump ahead, then feed the doc we land on by itself.
+            doc_ids[0] = Matcher_Advance(self, wanted);
+            if (!doc_ids[0]) { break; }
+            if (scores) { scores[0] = Matcher_Score(self); }
+            num_kept = deletions
+                       ? S_squeeze_deletions(deletions, &next_deletion,
+                                             doc_ids, scores, 1)
+                       : 1;
+            if (num_kept) {
+                Coll_Collect_Block(collector, doc_ids, scores, 1);
+            }
+        }
+    }
+}
+
 void
 Matcher_Collect_IMP(Matcher *self, Collector *collector, Matcher *deletions) {
     int32_t doc_id        = 0;
@@ -47,6 +131,14 @@ Matcher_Collect_IMP(Matcher *self, Collector *collector, Matcher *deletions) {
 
     Coll_Set_Matcher(collector, self);
 
+    // A Collector which calls Score() on the Matcher can't be fed blocks,
+    // since by then the Matcher has moved past the doc being collected.
+    if (!Coll_Need_Score(collector) || Coll_Uses_Block_Scores(collector)) {
+        S_collect_blocks(self, collector, deletions);
+        Coll_Set_Matcher(collector, NULL);
+        return;
+    }
+
     // Execute scoring loop.
     while (1) {
         if (doc_id > next_deletion) {
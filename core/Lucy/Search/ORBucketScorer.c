@@ -0,0 +1,267 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_ORBUCKETSCORER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/ORBucketScorer.h"
+#include "Lucy/Index/Similarity.h"
+
+#define WINDOW_SIZE ORBUCKETSCORER_WINDOW_SIZE
+#define NUM_BYTES   (WINDOW_SIZE / 8)
+
+// Return the first occupied slot at or after `tick`, or WINDOW_SIZE if the
+// rest of the window is empty.
+static uint32_t
+S_next_occupied(const uint8_t *bits, uint32_t tick);
+
+// Advance all children to at least `target` and fill a new window starting
+// at the least of their doc ids.  The current window must be empty.  Return
+// false once all children are exhausted.
+static bool
+S_refill(ORBucketScorerIVARS *ivars, int32_t target);
+
+// Return the first hit at or after `target`, refilling the window as
+// needed, or 0 once exhausted.  Hits before `target` are discarded.
+static int32_t
+S_next_from(ORBucketScorerIVARS *ivars, int32_t target);
+
+ORBucketScorer*
+ORBucketScorer_new(VArray *children, Similarity *sim) {
+    ORBucketScorer *self
+        = (ORBucketScorer*)VTable_Make_Obj(ORBUCKETSCORER);
+    return ORBucketScorer_init(self, children, sim);
+}
+
+ORBucketScorer*
+ORBucketScorer_init(ORBucketScorer *self, VArray *children,
+                    Similarity *sim) {
+    PolyMatcher_init((PolyMatcher*)self, children, sim);
+    ORBucketScorerIVARS *const ivars = ORBucketScorer_IVARS(self);
+    const uint32_t num_kids = ivars->num_kids;
+
+    // Init.
+    ivars->num_subs = 0;
+    ivars->base     = 0;
+    ivars->tick     = WINDOW_SIZE;
+    ivars->doc_id   = 0;
+    ivars->score    = 0.0f;
+
+    // Allocate.  The window arrays start out zeroed and are kept that way by
+    // clearing each slot as it is consumed.
+    ivars->kids     = (Matcher**)CALLOCATE(num_kids + 1, sizeof(Matcher*));
+    ivars->kid_docs = (int32_t*)CALLOCATE(num_kids + 1, sizeof(int32_t));
+    ivars->scores   = (float*)CALLOCATE(WINDOW_SIZE, sizeof(float));
+    ivars->counts   = (uint32_t*)CALLOCATE(WINDOW_SIZE, sizeof(uint32_t));
+    ivars->bits     = (uint8_t*)CALLOCATE(NUM_BYTES, sizeof(uint8_t));
+
+    // Prime each child, skipping any which are empty from the start.
+    for (uint32_t i = 0; i < num_kids; i++) {
+        Matcher *kid = (Matcher*)VA_Fetch(children, i);
+        if (kid) {
+            int32_t doc_id = Matcher_Next(kid);
+            if (doc_id) {
+                ivars->kids[ivars->num_subs]     = (Matcher*)INCREF(kid);
+                ivars->kid_docs[ivars->num_subs] = doc_id;
+                ivars->num_subs++;
+            }
+        }
+    }
+
+    return self;
+}
+
+void
+ORBucketScorer_Destroy_IMP(ORBucketScorer *self) {
+    ORBucketScorerIVARS *const ivars = ORBucketScorer_IVARS(self);
+    for (uint32_t i = 0; i < ivars->num_subs; i++) {
+        DECREF(ivars->kids[i]);
+    }
+    FREEMEM(ivars->kids);
+    FREEMEM(ivars->kid_docs);
+    FREEMEM(ivars->scores);
+    FREEMEM(ivars->counts);
+    FREEMEM(ivars->bits);
+    SUPER_DESTROY(self, ORBUCKETSCORER);
+}
+
+int32_t
+ORBucketScorer_Next_IMP(ORBucketScorer *self) {
+    return S_next_from(ORBucketScorer_IVARS(self), 0);
+}
+
+int32_t
+ORBucketScorer_Advance_IMP(ORBucketScorer *self, int32_t target) {
+    ORBucketScorerIVARS *const ivars = ORBucketScorer_IVARS(self);
+
+    // Succeed if we're already past and still on a valid doc.
+    if (target <= ivars->doc_id) {
+        return ivars->doc_id;
+    }
+
+    return S_next_from(ivars, target);
+}
+
+uint32_t
+ORBucketScorer_Next_Block_IMP(ORBucketScorer *self, int32_t *doc_ids,
+                              float *scores, uint32_t max) {
+    ORBucketScorerIVARS *const ivars = ORBucketScorer_IVARS(self);
+    uint32_t num_docs = 0;
+
+    while (num_docs < max) {
+        int32_t doc_id = S_next_from(ivars, 0);
+        if (!doc_id) { break; }
+        doc_ids[num_docs] = doc_id;
+        if (scores) { scores[num_docs] = ivars->score; }
+        num_docs++;
+    }
+
+    return num_docs;
+}
+
+int32_t
+ORBucketScorer_Get_Doc_ID_IMP(ORBucketScorer *self) {
+    return ORBucketScorer_IVARS(self)->doc_id;
+}
+
+float
+ORBucketScorer_Score_IMP(ORBucketScorer *self) {
+    return ORBucketScorer_IVARS(self)->score;
+}
+
+static int32_t
+S_next_from(ORBucketScorerIVARS *ivars, int32_t target) {
+    float    *const scores = ivars->scores;
+    uint32_t *const counts = ivars->counts;
+    uint8_t  *const bits   = ivars->bits;
+
+    while (true) {
+        uint32_t slot = S_next_occupied(bits, ivars->tick);
+
+        // Discard hits which precede the target.
+        while (slot < WINDOW_SIZE && ivars->base + (int32_t)slot < target) {
+            scores[slot] = 0.0f;
+            counts[slot] = 0;
+            bits[slot >> 3] &= ~(1 << (slot & 0x7));
+            slot = S_next_occupied(bits, slot + 1);
+        }
+
+        if (slot < WINDOW_SIZE) {
+            // Pop the hit, clearing its slot for the next window.
+            const uint32_t count = counts[slot];
+            ivars->doc_id        = ivars->base + (int32_t)slot;
+            ivars->matching_kids = count;
+            ivars->score         = scores[slot] * ivars->coord_factors[count];
+            ivars->tick          = slot + 1;
+            scores[slot] = 0.0f;
+            counts[slot] = 0;
+            bits[slot >> 3] &= ~(1 << (slot & 0x7));
+            return ivars->doc_id;
+        }
+
+        ivars->tick = WINDOW_SIZE;
+        if (!S_refill(ivars, target)) {
+            ivars->doc_id = 0;
+            return 0;
+        }
+    }
+}
+
+static bool
+S_refill(ORBucketScorerIVARS *ivars, int32_t target) {
+    Matcher  **const kids     = ivars->kids;
+    int32_t   *const kid_docs = ivars->kid_docs;
+    float     *const scores   = ivars->scores;
+    uint32_t  *const counts   = ivars->counts;
+    uint8_t   *const bits     = ivars->bits;
+    int32_t    min_doc        = INT32_MAX;
+    uint32_t   i              = 0;
+
+    // Catch up lagging children and drop exhausted ones.
+    while (i < ivars->num_subs) {
+        if (kid_docs[i] != 0 && kid_docs[i] < target) {
+            kid_docs[i] = Matcher_Advance(kids[i], target);
+        }
+        if (kid_docs[i] == 0) {
+            DECREF(kids[i]);
+            ivars->num_subs--;
+            kids[i]     = kids[ivars->num_subs];
+            kid_docs[i] = kid_docs[ivars->num_subs];
+            continue;
+        }
+        if (kid_docs[i] < min_doc) { min_doc = kid_docs[i]; }
+        i++;
+    }
+    if (!ivars->num_subs) { return false; }
+
+    // Drain each child through the window, accumulating scores and counts.
+    const int32_t base  = min_doc;
+    const int32_t limit = base > INT32_MAX - WINDOW_SIZE
+                          ? INT32_MAX
+                          : base + WINDOW_SIZE;
+    for (i = 0; i < ivars->num_subs; i++) {
+        Matcher *const kid = kids[i];
+        VTable  *const vtable = Matcher_Get_VTable(kid);
+        Matcher_Next_t next
+            = (Matcher_Next_t)METHOD_PTR(vtable, LUCY_Matcher_Next);
+        Matcher_Score_t score
+            = (Matcher_Score_t)METHOD_PTR(vtable, LUCY_Matcher_Score);
+        int32_t doc_id = kid_docs[i];
+        while (doc_id != 0 && doc_id < limit) {
+            const uint32_t slot = (uint32_t)(doc_id - base);
+            if (counts[slot]++ == 0) {
+                bits[slot >> 3] |= 1 << (slot & 0x7);
+            }
+            scores[slot] += score(kid);
+            doc_id = next(kid);
+        }
+        kid_docs[i] = doc_id;
+    }
+
+    ivars->base = base;
+    ivars->tick = 0;
+    return true;
+}
+
+static CFISH_INLINE uint32_t
+S_first_bit_in_nonzero_byte(unsigned int num) {
+    uint32_t first_bit = 0;
+    if ((num & 0xF) == 0) { first_bit += 4; num >>= 4; }
+    if ((num & 0x3) == 0) { first_bit += 2; num >>= 2; }
+    if ((num & 0x1) == 0) { first_bit += 1; }
+    return first_bit;
+}
+
+static uint32_t
+S_next_occupied(const uint8_t *bits, uint32_t tick) {
+    if (tick >= WINDOW_SIZE) { return WINDOW_SIZE; }
+
+    // Special case the first byte.
+    uint32_t byte_tick = tick >> 3;
+    unsigned int byte = bits[byte_tick] >> (tick & 0x7);
+    if (byte) {
+        return tick + S_first_bit_in_nonzero_byte(byte);
+    }
+
+    for (byte_tick++; byte_tick < NUM_BYTES; byte_tick++) {
+        if (bits[byte_tick]) {
+            return (byte_tick << 3) + S_first_bit_in_nonzero_byte(bits[byte_tick]);
+        }
+    }
+
+    return WINDOW_SIZE;
+}
+
@@ -63,6 +63,11 @@ S_bubble_up(ORMatcher *self, ORMatcherIVARS *ivars);
 static void
 S_sift_down(ORMatcher *self, ORMatcherIVARS *ivars);
 
+// Restore the heap property throughout, after the doc ids of any number of
+// nodes have changed.
+static void
+S_heapify(ORMatcherIVARS *ivars);
+
 ORMatcher*
 ORMatcher_new(VArray *children) {
     ORMatcher *self = (ORMatcher*)VTable_Make_Obj(ORMATCHER);
@@ -281,6 +286,26 @@ S_sift_down(ORMatcher *self, ORMatcherIVARS *ivars) {
     ivars->top_hmd = heap[1];
 }
 
+static void
+S_heapify(ORMatcherIVARS *ivars) {
+    HeapedMatcherDoc **const heap = ivars->heap;
+    const uint32_t size = ivars->size;
+    for (uint32_t start = size >> 1; start > 0; start--) {
+        HeapedMatcherDoc *const node = heap[start];
+        uint32_t i = start;
+        uint32_t j = i << 1;
+        while (j <= size) {
+            if (j + 1 <= size && heap[j + 1]->doc < heap[j]->doc) { j++; }
+            if (heap[j]->doc >= node->doc) { break; }
+            heap[i] = heap[j];
+            i = j;
+            j = i << 1;
+        }
+        heap[i] = node;
+    }
+    ivars->top_hmd = heap[1];
+}
+
 /***************************************************************************/
 
 /* When this is called, all children are past the current ivars->doc_id.  The
@@ -409,3 +434,85 @@ ORScorer_Score_IMP(ORScorer *self) {
     return score;
 }
 
+
+uint32_t
+ORScorer_Next_Block_IMP(ORScorer *self, int32_t *doc_ids, float *scores,
+                        uint32_t max) {
+    ORScorerIVARS *const ivars = ORScorer_IVARS(self);
+    HeapedMatcherDoc **const heap = ivars->heap;
+    uint32_t num_docs = 0;
+
+    while (num_docs < max && ivars->size) {
+        // The window starts at the least doc id in the queue and holds no
+        // more doc ids than there are free slots, so every hit in it fits.
+        // The free slots of the caller's arrays serve as its accumulators,
+        // with match counts stashed in `doc_ids`.
+        const int32_t  base   = ivars->top_hmd->doc;
+        const uint32_t width  = max - num_docs;
+        const int32_t  limit  = width > (uint32_t)(INT32_MAX - base)
+                                ? INT32_MAX
+                                : base + (int32_t)width;
+        int32_t *const counts = doc_ids + num_docs;
+        float   *const sums   = scores ? scores + num_docs : NULL;
+        for (uint32_t i = 0; i < width; i++) { counts[i] = 0; }
+        if (sums) {
+            for (uint32_t i = 0; i < width; i++) { sums[i] = 0.0f; }
+        }
+
+        // Drain every child through the window.  Exhausted children are
+        // replaced by the last node, which still needs draining.
+        for (uint32_t i = 1; i <= ivars->size;) {
+            HeapedMatcherDoc *const hmd = heap[i];
+            Matcher *const child = hmd->matcher;
+            int32_t doc_id = hmd->doc;
+            while (doc_id && doc_id < limit) {
+                const uint32_t slot = (uint32_t)(doc_id - base);
+                counts[slot]++;
+                if (sums) { sums[slot] += Matcher_Score(child); }
+                doc_id = Matcher_Next(child);
+            }
+            hmd->doc = doc_id;
+            if (doc_id) {
+                i++;
+            }
+            else {
+                HeapedMatcherDoc *const last_hmd = heap[ivars->size];
+                DECREF(child);
+                hmd->matcher = last_hmd->matcher;
+                hmd->doc     = last_hmd->doc;
+                heap[ivars->size] = NULL;
+                ivars->pool[ivars->size] = last_hmd;
+                ivars->size--;
+            }
+        }
+        if (ivars->size) { S_heapify((ORMatcherIVARS*)ivars); }
+
+        // Squeeze the window's hits down into doc id order.  The write
+        // position never passes the read position, so this works in place.
+        uint32_t last_count = 0;
+        float    last_sum   = 0.0f;
+        for (uint32_t slot = 0; slot < width; slot++) {
+            const int32_t count = counts[slot];
+            if (!count) { continue; }
+            doc_ids[num_docs] = base + (int32_t)slot;
+            if (sums) {
+                last_sum = sums[slot];
+                scores[num_docs] = last_sum * ivars->coord_factors[count];
+            }
+            last_count = (uint32_t)count;
+            num_docs++;
+        }
+
+        // Leave the state Next() and Advance() expect: positioned on the
+        // last hit with all children beyond it.  Only the sum of the cached
+        // scores matters to Score().
+        ivars->doc_id        = doc_ids[num_docs - 1];
+        ivars->matching_kids = last_count;
+        ivars->scores[0]     = last_sum;
+        for (uint32_t i = 1; i < last_count; i++) {
+            ivars->scores[i] = 0.0f;
+        }
+    }
+
+    return num_docs;
+}
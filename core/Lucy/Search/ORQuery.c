@@ -23,11 +23,16 @@
 #include "Clownfish/CharBuf.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Similarity.h"
+#include "Lucy/Search/ORBucketScorer.h"
 #include "Lucy/Search/ORMatcher.h"
 #include "Lucy/Search/Searcher.h"
 #include "Lucy/Store/InStream.h"
 #include "Lucy/Store/OutStream.h"
 
+// Minimum number of scoring clauses for which ORCompiler switches from
+// ORScorer to ORBucketScorer.
+#define ORCOMPILER_BUCKET_THRESHOLD 16
+
 ORQuery*
 ORQuery_new(VArray *children) {
     ORQuery *self = (ORQuery*)VTable_Make_Obj(ORQUERY);
@@ -132,9 +137,18 @@ ORCompiler_Make_Matcher_IMP(ORCompiler *self, SegReader *reader,
         }
         else {
             Similarity *sim    = ORCompiler_Get_Similarity(self);
-            Matcher    *retval = need_score
-                                 ? (Matcher*)ORScorer_new(submatchers, sim)
-                                 : (Matcher*)ORMatcher_new(submatchers);
+            Matcher    *retval;
+            if (!need_score) {
+                retval = (Matcher*)ORMatcher_new(submatchers);
+            }
+            else if (num_submatchers >= ORCOMPILER_BUCKET_THRESHOLD) {
+                // With many clauses, scoring a window of docs at a time
+                // beats merging the children through a priority queue.
+                retval = (Matcher*)ORBucketScorer_new(submatchers, sim);
+            }
+            else {
+                retval = (Matcher*)ORScorer_new(submatchers, sim);
+            }
             DECREF(submatchers);
             return retval;
         }
@@ -26,15 +26,16 @@
 #include "Lucy/Search/Compiler.h"
 
 PhraseMatcher*
-PhraseMatcher_new(Similarity *sim, VArray *plists, Compiler *compiler) {
+PhraseMatcher_new(Similarity *sim, VArray *plists, Compiler *compiler,
+                  bool need_score) {
     PhraseMatcher *self = (PhraseMatcher*)VTable_Make_Obj(PHRASEMATCHER);
-    return PhraseMatcher_init(self, sim, plists, compiler);
+    return PhraseMatcher_init(self, sim, plists, compiler, need_score);
 
 }
 
 PhraseMatcher*
 PhraseMatcher_init(PhraseMatcher *self, Similarity *similarity, VArray *plists,
-                   Compiler *compiler) {
+                   Compiler *compiler, bool need_score) {
     Matcher_init((Matcher*)self);
     PhraseMatcherIVARS *const ivars = PhraseMatcher_IVARS(self);
 
@@ -44,6 +45,7 @@ PhraseMatcher_init(PhraseMatcher *self, Similarity *similarity, VArray *plists,
     ivars->phrase_boost     = 0.0;
     ivars->first_time       = true;
     ivars->more             = true;
+    ivars->need_score       = need_score;
 
     // Extract PostingLists out of VArray into local C array for quick access.
     ivars->num_elements = VA_Get_Size(plists);
@@ -58,6 +60,27 @@ PhraseMatcher_init(PhraseMatcher *self, Similarity *similarity, VArray *plists,
         ivars->plists[i] = (PostingList*)INCREF(plist);
     }
 
+    // Order the terms from rarest to most common.  The rarest term drives
+    // the search for candidate docs and supplies the initial anchor set.
+    ivars->order = (uint32_t*)MALLOCATE(
+                       ivars->num_elements * sizeof(uint32_t));
+    for (uint32_t i = 0; i < ivars->num_elements; i++) {
+        uint32_t doc_freq = PList_Get_Doc_Freq(ivars->plists[i]);
+        uint32_t j = i;
+        while (j > 0
+               && PList_Get_Doc_Freq(ivars->plists[ivars->order[j - 1]])
+                  > doc_freq
+              ) {
+            ivars->order[j] = ivars->order[j - 1];
+            j--;
+        }
+        ivars->order[j] = i;
+    }
+    ivars->cursors = (uint32_t**)MALLOCATE(
+                         ivars->num_elements * sizeof(uint32_t*));
+    ivars->cursor_ends = (uint32_t**)MALLOCATE(
+                             ivars->num_elements * sizeof(uint32_t*));
+
     // Assign.
     ivars->sim       = (Similarity*)INCREF(similarity);
     ivars->compiler  = (Compiler*)INCREF(compiler);
@@ -75,6 +98,9 @@ PhraseMatcher_Destroy_IMP(PhraseMatcher *self) {
         }
         FREEMEM(ivars->plists);
     }
+    FREEMEM(ivars->order);
+    FREEMEM(ivars->cursors);
+    FREEMEM(ivars->cursor_ends);
     DECREF(ivars->sim);
     DECREF(ivars->anchor_set);
     DECREF(ivars->compiler);
@@ -88,8 +114,8 @@ PhraseMatcher_Next_IMP(PhraseMatcher *self) {
         return PhraseMatcher_Advance(self, 1);
     }
     else if (ivars->more) {
-        const int32_t target = PList_Get_Doc_ID(ivars->plists[0]) + 1;
-        return PhraseMatcher_Advance(self, target);
+        PostingList *const lead = ivars->plists[ivars->order[0]];
+        return PhraseMatcher_Advance(self, PList_Get_Doc_ID(lead) + 1);
     }
     else {
         return 0;
@@ -100,145 +126,112 @@ int32_t
 PhraseMatcher_Advance_IMP(PhraseMatcher *self, int32_t target) {
     PhraseMatcherIVARS *const ivars  = PhraseMatcher_IVARS(self);
     PostingList **const plists       = ivars->plists;
+    const uint32_t     *order        = ivars->order;
     const uint32_t      num_elements = ivars->num_elements;
-    int32_t             highest      = 0;
+    PostingList  *const lead         = plists[order[0]];
 
     // Reset match variables to indicate no match.  New values will be
     // assigned if a match succeeds.
     ivars->phrase_freq = 0.0;
     ivars->doc_id      = 0;
-
-    // Find the lowest possible matching doc ID greater than the current doc
-    // ID.  If any one of the PostingLists is exhausted, we're done.
-    if (ivars->first_time) {
-        ivars->first_time = false;
-
-        // On the first call to Advance(), advance all PostingLists.
-        for (size_t i = 0, max = ivars->num_elements; i < max; i++) {
-            int32_t candidate = PList_Advance(plists[i], target);
-            if (!candidate) {
-                ivars->more = false;
-                return 0;
-            }
-            else if (candidate > highest) {
-                // Remember the highest doc ID so far.
-                highest = candidate;
-            }
-        }
-    }
-    else {
-        // On subsequent iters, advance only one PostingList.  Its new doc ID
-        // becomes the minimum target which all the others must move up to.
-        highest = PList_Advance(plists[0], target);
-        if (highest == 0) {
-            ivars->more = false;
-            return 0;
-        }
-    }
-
-    // Find a doc which contains all the terms.
-    while (1) {
+    ivars->first_time  = false;
+    if (!ivars->more) { return 0; }
+
+    // Only the rarest term's PostingList proposes candidates.  The others,
+    // from rarest to most common, are advanced to confirm each candidate;
+    // any that overshoots hands its doc ID back to the lead as the new
+    // target, so the common terms skip rather than iterate.
+    int32_t candidate = PList_Advance(lead, target);
+    while (candidate) {
         bool agreement = true;
-
-        // Scoot all posting lists up to at least the current minimum.
-        for (uint32_t i = 0; i < num_elements; i++) {
-            PostingList *const plist = plists[i];
-            int32_t candidate = PList_Get_Doc_ID(plist);
-
-            // Is this PostingList already beyond the minimum?  Then raise the
-            // bar for everyone else.
-            if (highest < candidate) { highest = candidate; }
-            if (target < highest)    { target = highest; }
-
-            // Scoot this posting list up.
-            if (candidate < target) {
-                candidate = PList_Advance(plist, target);
-
-                // If this PostingList is exhausted, we're done.
-                if (candidate == 0) {
+        for (uint32_t i = 1; i < num_elements; i++) {
+            PostingList *const plist = plists[order[i]];
+            int32_t doc_id = PList_Get_Doc_ID(plist);
+            if (doc_id < candidate) {
+                doc_id = PList_Advance(plist, candidate);
+                if (!doc_id) {
                     ivars->more = false;
                     return 0;
                 }
-
-                // After calling PList_Advance(), we are guaranteed to be
-                // either at or beyond the minimum, so we can assign without
-                // checking and the minumum will either go up or stay the
-                // same.
-                highest = candidate;
             }
-        }
-
-        // See whether all the PostingLists have managed to converge on a
-        // single doc ID.
-        for (uint32_t i = 0; i < num_elements; i++) {
-            const int32_t candidate = PList_Get_Doc_ID(plists[i]);
-            if (candidate != highest) { agreement = false; }
+            if (doc_id > candidate) {
+                candidate = PList_Advance(lead, doc_id);
+                agreement = false;
+                break;
+            }
         }
 
         // If we've found a doc with all terms in it, see if they form a
         // phrase.
-        if (agreement && highest >= target) {
+        if (agreement) {
             ivars->phrase_freq = PhraseMatcher_Calc_Phrase_Freq(self);
-            if (ivars->phrase_freq == 0.0) {
-                // No phrase.  Move on to another doc.
-                target += 1;
-            }
-            else {
+            if (ivars->phrase_freq != 0.0) {
                 // Success!
-                ivars->doc_id = highest;
-                return highest;
+                ivars->doc_id = candidate;
+                return candidate;
             }
+            // No phrase.  Move on to another doc.
+            candidate = PList_Next(lead);
         }
     }
+
+    // The lead PostingList is exhausted, so we're done.
+    ivars->more = false;
+    return 0;
+}
+
+// Return the first element at or after `ptr` which is not less than
+// `target`, or `end`.  The search gallops -- probing 1, 2, 4, 8...
+// elements ahead before bisecting -- so that skipping a long run of small
+// positions costs O(log n) rather than O(n).
+static CFISH_INLINE uint32_t*
+SI_gallop(uint32_t *ptr, const uint32_t *const end, uint32_t target) {
+    if (ptr == end || *ptr >= target) { return ptr; }
+
+    // Invariant: *lo < target, and either hi == end or *hi >= target.
+    uint32_t *lo   = ptr;
+    uint32_t *hi   = ptr + 1;
+    size_t    step = 1;
+    while (hi < end && *hi < target) {
+        lo = hi;
+        step <<= 1;
+        hi = (size_t)(end - lo) > step ? lo + step : (uint32_t*)end;
+    }
+    lo++;
+    while (lo < hi) {
+        uint32_t *mid = lo + (hi - lo) / 2;
+        if (*mid < target) { lo = mid + 1; }
+        else               { hi = mid; }
+    }
+    return lo;
 }
 
-static CFISH_INLINE uint32_t
-SI_winnow_anchors(uint32_t *anchors_start, const uint32_t *const anchors_end,
-                  const uint32_t *candidates, const uint32_t *const candidates_end,
-                  uint32_t offset) {
-    uint32_t *anchors = anchors_start;
+static uint32_t
+S_winnow_anchors(uint32_t *anchors_start, const uint32_t *const anchors_end,
+                 uint32_t *candidates, const uint32_t *const candidates_end,
+                 uint32_t offset) {
+    uint32_t *anchors       = anchors_start;
     uint32_t *anchors_found = anchors_start;
-    uint32_t target_anchor;
-    uint32_t target_candidate;
 
-    // Safety check, so there's no chance of a bad dereference.
-    if (anchors_start == anchors_end || candidates == candidates_end) {
-        return 0;
+    /* Find anchors which the candidates can continue, overwriting the
+     * anchors in place and returning the number remaining.  The two position
+     * lists leapfrog one another: each side gallops up to the other's current
+     * value, so a short list intersected against a long one only touches
+     * O(short * log(long)) elements. */
+    while (anchors < anchors_end) {
+        const uint32_t target_candidate = *anchors + offset;
+        candidates = SI_gallop(candidates, candidates_end, target_candidate);
+        if (candidates == candidates_end) { break; }
+        if (*candidates == target_candidate) {
+            *anchors_found++ = *anchors++;
+            candidates++;
+        }
+        else {
+            // No underflow: *candidates > *anchors + offset.
+            anchors = SI_gallop(anchors, anchors_end, *candidates - offset);
+        }
     }
 
-    /* This function is a loop that finds terms that can continue a phrase.
-     * It overwrites the anchors in place, and returns the number remaining.
-     * The basic algorithm is to alternately increment the candidates' pointer
-     * until it is at or beyond its target position, and then increment the
-     * anchors' pointer until it is at or beyond its target.  The non-standard
-     * form is to avoid unnecessary comparisons.  This loop has not been
-     * tested for speed, but glancing at the object code produced (objdump -S)
-     * it appears to be significantly faster than the nested loop alternative.
-     * But given the vagaries of modern processors, it merits actual
-     * testing.*/
-
-SPIN_CANDIDATES:
-    target_candidate = *anchors + offset;
-    while (*candidates < target_candidate) {
-        if (++candidates == candidates_end) { goto DONE; }
-    }
-    if (*candidates == target_candidate) { goto MATCH; }
-    goto SPIN_ANCHORS;
-
-SPIN_ANCHORS:
-    target_anchor = *candidates - offset;
-    while (*anchors < target_anchor) {
-        if (++anchors == anchors_end) { goto DONE; }
-    };
-    if (*anchors == target_anchor) { goto MATCH; }
-    goto SPIN_CANDIDATES;
-
-MATCH:
-    *anchors_found++ = *anchors;
-    if (++anchors == anchors_end) { goto DONE; }
-    goto SPIN_CANDIDATES;
-
-DONE:
     // Return number of anchors remaining.
     return anchors_found - anchors_start;
 }
@@ -247,50 +240,87 @@ float
 PhraseMatcher_Calc_Phrase_Freq_IMP(PhraseMatcher *self) {
     PhraseMatcherIVARS *const ivars = PhraseMatcher_IVARS(self);
     PostingList **const plists = ivars->plists;
+    const uint32_t *order = ivars->order;
+    const uint32_t num_elements = ivars->num_elements;
 
-    /* Create a overwriteable "anchor set" from the first posting.
+    /* Create a overwriteable "anchor set" from the rarest term's posting.
      *
-     * Each "anchor" is a position, measured in tokens, corresponding to a a
-     * term which might start a phrase.  We start off with an "anchor set"
-     * comprised of all positions at which the first term in the phrase occurs
-     * in the field.
+     * Each "anchor" is a position, measured in tokens, at which a phrase
+     * might start.  We start off with an "anchor set" derived from all
+     * positions at which the rarest term in the phrase occurs in the field,
+     * shifted back by that term's offset within the phrase.
      *
-     * There can never be more phrase matches than instances of this first
+     * There can never be more phrase matches than instances of this rarest
      * term.  There may be fewer however, which we will determine by seeing
-     * whether all the other terms line up at subsequent position slots.
+     * whether all the other terms line up at their position slots.
      *
      * Every time we eliminate an anchor from the anchor set, we splice it out
      * of the array.  So if we begin with an anchor set of (15, 51, 72) and we
-     * discover that phrases occur at the first and last instances of the
-     * first term but not the middle one, the final array will be (15, 72).
+     * discover that phrases occur at the first and last anchors but not the
+     * middle one, the final array will be (15, 72).
      *
      * The number of elements in the anchor set when we are finished winnowing
      * is our phrase freq.
      */
-    ScorePosting *posting = (ScorePosting*)PList_Get_Posting(plists[0]);
+    const uint32_t lead_offset = order[0];
+    ScorePosting *posting
+        = (ScorePosting*)PList_Get_Posting(plists[lead_offset]);
     ScorePostingIVARS *const post_ivars = ScorePost_IVARS(posting);
     uint32_t anchors_remaining = post_ivars->freq;
     if (!anchors_remaining) { return 0.0f; }
 
     size_t    amount        = anchors_remaining * sizeof(uint32_t);
     uint32_t *anchors_start = (uint32_t*)BB_Grow(ivars->anchor_set, amount);
-    uint32_t *anchors_end   = anchors_start + anchors_remaining;
-    memcpy(anchors_start, post_ivars->prox, amount);
-
-    // Match the positions of other terms against the anchor set.
-    for (uint32_t i = 1, max = ivars->num_elements; i < max; i++) {
-        // Get the array of positions for the next term.  Unlike the anchor
-        // set (which is a copy), these won't be overwritten.
-        ScorePosting *next_post = (ScorePosting*)PList_Get_Posting(plists[i]);
-        ScorePostingIVARS *const next_post_ivars = ScorePost_IVARS(next_post);
-        uint32_t *candidates_start = next_post_ivars->prox;
-        uint32_t *candidates_end   = candidates_start + next_post_ivars->freq;
+    uint32_t *anchors_end   = anchors_start;
+    uint32_t *lead_prox     = ScorePost_Get_Prox(posting);
+    for (uint32_t i = 0; i < anchors_remaining; i++) {
+        // Positions too early to be preceded by the rest of the phrase can't
+        // anchor a match.
+        if (lead_prox[i] >= lead_offset) {
+            *anchors_end++ = lead_prox[i] - lead_offset;
+        }
+    }
+    anchors_remaining = anchors_end - anchors_start;
+    if (!anchors_remaining) { return 0.0f; }
+
+    // Gather the position arrays of the other terms.  Unlike the anchor set
+    // (which is a copy), these won't be overwritten.
+    uint32_t **const cursors     = ivars->cursors;
+    uint32_t **const cursor_ends = ivars->cursor_ends;
+    for (uint32_t i = 1; i < num_elements; i++) {
+        ScorePosting *next_post
+            = (ScorePosting*)PList_Get_Posting(plists[order[i]]);
+        cursors[i]     = ScorePost_Get_Prox(next_post);
+        cursor_ends[i] = cursors[i] + ScorePost_IVARS(next_post)->freq;
+    }
+
+    if (!ivars->need_score) {
+        // Any single occurrence will do, so test anchors one at a time and
+        // stop at the first which every term confirms.
+        for (uint32_t *anchor = anchors_start; anchor < anchors_end; anchor++) {
+            bool match = true;
+            for (uint32_t i = 1; i < num_elements; i++) {
+                const uint32_t target = *anchor + order[i];
+                cursors[i] = SI_gallop(cursors[i], cursor_ends[i], target);
+                if (cursors[i] == cursor_ends[i]) { return 0.0f; }
+                if (*cursors[i] != target) {
+                    match = false;
+                    break;
+                }
+            }
+            if (match) { return 1.0f; }
+        }
+        return 0.0f;
+    }
 
+    // Match the positions of other terms against the anchor set, rarest
+    // first so that the set shrinks as quickly as possible.
+    for (uint32_t i = 1; i < num_elements; i++) {
         // Splice out anchors that don't match the next term.  Bail out if
         // we've eliminated all possible anchors.
         anchors_remaining
-            = SI_winnow_anchors(anchors_start, anchors_end,
-                                candidates_start, candidates_end, i);
+            = S_winnow_anchors(anchors_start, anchors_end, cursors[i],
+                               cursor_ends[i], order[i]);
         if (!anchors_remaining) { return 0.0f; }
 
         // Adjust end for number of anchors that remain.
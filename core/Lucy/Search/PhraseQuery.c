@@ -22,6 +22,7 @@
 #include "Lucy/Search/PhraseQuery.h"
 
 #include "Clownfish/CharBuf.h"
+#include "Lucy/Analysis/CommonGramsFilter.h"
 #include "Lucy/Index/DocVector.h"
 #include "Lucy/Index/Posting.h"
 #include "Lucy/Index/Posting/ScorePosting.h"
@@ -31,6 +32,7 @@
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Index/TermVector.h"
+#include "Lucy/Plan/FullTextType.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Search/PhraseMatcher.h"
 #include "Lucy/Search/Searcher.h"
@@ -294,11 +296,10 @@ PhraseCompiler_Apply_Norm_Factor_IMP(PhraseCompiler *self, float factor) {
 Matcher*
 PhraseCompiler_Make_Matcher_IMP(PhraseCompiler *self, SegReader *reader,
                                 bool need_score) {
-    UNUSED_VAR(need_score);
     PhraseCompilerIVARS *const ivars = PhraseCompiler_IVARS(self);
     PhraseQueryIVARS *const parent_ivars
         = PhraseQuery_IVARS((PhraseQuery*)ivars->parent);
-    VArray *const      terms     = parent_ivars->terms;
+    VArray            *terms     = parent_ivars->terms;
     uint32_t           num_terms = VA_Get_Size(terms);
 
     // Bail if there are no terms.
@@ -319,6 +320,18 @@ PhraseCompiler_Make_Matcher_IMP(PhraseCompiler *self, SegReader *reader,
               reader, VTable_Get_Name(POSTINGLISTREADER));
     if (!plist_reader) { return NULL; }
 
+    // If the field indexes grams for common words, match those instead.
+    Schema    *schema = SegReader_Get_Schema(reader);
+    FieldType *type   = Schema_Fetch_Type(schema, parent_ivars->field);
+    CommonGramsFilter *common_grams
+        = type && FType_Is_A(type, FULLTEXTTYPE)
+          ? FullTextType_Get_Common_Grams((FullTextType*)type)
+          : NULL;
+    terms = common_grams
+            ? CommonGrams_Rewrite_Phrase(common_grams, terms)
+            : (VArray*)INCREF(terms);
+    num_terms = VA_Get_Size(terms);
+
     // Look up each term.
     VArray  *plists = VA_new(num_terms);
     for (uint32_t i = 0; i < num_terms; i++) {
@@ -330,13 +343,16 @@ PhraseCompiler_Make_Matcher_IMP(PhraseCompiler *self, SegReader *reader,
         if (!plist || !PList_Get_Doc_Freq(plist)) {
             DECREF(plist);
             DECREF(plists);
+            DECREF(terms);
             return NULL;
         }
         VA_Push(plists, (Obj*)plist);
     }
+    DECREF(terms);
 
     Matcher *retval
-        = (Matcher*)PhraseMatcher_new(sim, plists, (Compiler*)self);
+        = (Matcher*)PhraseMatcher_new(sim, plists, (Compiler*)self,
+                                      need_score);
     DECREF(plists);
     return retval;
 }
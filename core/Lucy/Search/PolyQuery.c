@@ -183,6 +183,11 @@ PolyCompiler_Apply_Norm_Factor_IMP(PolyCompiler *self, float factor) {
     }
 }
 
+VArray*
+PolyCompiler_Get_Children_IMP(PolyCompiler *self) {
+    return PolyCompiler_IVARS(self)->children;
+}
+
 VArray*
 PolyCompiler_Highlight_Spans_IMP(PolyCompiler *self, Searcher *searcher,
                                  DocVector *doc_vec, String *field) {
@@ -33,6 +33,12 @@
 #include "Lucy/Search/TopDocs.h"
 #include "Lucy/Search/Compiler.h"
 
+PolySearcher*
+PolySearcher_new(Schema *schema, VArray *searchers) {
+    PolySearcher *self = (PolySearcher*)VTable_Make_Obj(POLYSEARCHER);
+    return PolySearcher_init(self, schema, searchers);
+}
+
 PolySearcher*
 PolySearcher_init(PolySearcher *self, Schema *schema, VArray *searchers) {
     const uint32_t num_searchers = VA_Get_Size(searchers);
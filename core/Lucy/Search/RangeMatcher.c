@@ -20,6 +20,23 @@
 #include "Lucy/Search/RangeMatcher.h"
 #include "Lucy/Index/SortCache.h"
 
+// Number of docs examined per pass over the ord array.
+#define BLOCK_SIZE 64
+
+// Test every doc in the block of BLOCK_SIZE docs starting at `block_start`
+// against the range, returning a bitmask of the docs which fall within it.
+static uint64_t
+S_match_block(RangeMatcherIVARS *ivars, int32_t block_start);
+
+// Return the index of the lowest set bit in a non-zero mask.
+static CFISH_INLINE uint32_t
+SI_lowest_bit(uint64_t mask);
+
+// Pop the lowest doc out of the current block's mask, scanning forward
+// through subsequent blocks as needed.  Return 0 once exhausted.
+static CFISH_INLINE int32_t
+SI_next_hit(RangeMatcherIVARS *ivars);
+
 RangeMatcher*
 RangeMatcher_new(int32_t lower_bound, int32_t upper_bound, SortCache *sort_cache,
                  int32_t doc_max) {
@@ -36,6 +53,8 @@ RangeMatcher_init(RangeMatcher *self, int32_t lower_bound, int32_t upper_bound,
 
     // Init.
     ivars->doc_id       = 0;
+    ivars->mask         = 0;
+    ivars->block_start  = -BLOCK_SIZE;
 
     // Assign.
     ivars->lower_bound  = lower_bound;
@@ -43,7 +62,23 @@ RangeMatcher_init(RangeMatcher *self, int32_t lower_bound, int32_t upper_bound,
     ivars->sort_cache   = (SortCache*)INCREF(sort_cache);
     ivars->doc_max      = doc_max;
 
-    // Derive.
+    // Derive.  Work directly on the raw ord array rather than calling
+    // SortCache_Ordinal() for every doc.
+    ivars->ords         = SortCache_Get_Ords(sort_cache);
+    ivars->ord_width    = SortCache_Get_Ord_Width(sort_cache);
+    ivars->native_ords  = SortCache_Get_Native_Ords(sort_cache);
+    ivars->span         = (uint64_t)((int64_t)upper_bound - lower_bound);
+    if (upper_bound < lower_bound) {
+        // Empty range: start out exhausted.
+        ivars->block_start = doc_max;
+    }
+    switch (ivars->ord_width) {
+        case 1: case 2: case 4: case 8: case 16: case 32:
+            break;
+        default:
+            DECREF(self);
+            THROW(ERR, "Invalid ord width: %i32", ivars->ord_width);
+    }
 
     return self;
 }
@@ -57,30 +92,51 @@ RangeMatcher_Destroy_IMP(RangeMatcher *self) {
 
 int32_t
 RangeMatcher_Next_IMP(RangeMatcher* self) {
-    RangeMatcherIVARS *const ivars = RangeMatcher_IVARS(self);
-    while (1) {
-        if (++ivars->doc_id > ivars->doc_max) {
-            ivars->doc_id--;
-            return 0;
-        }
-        else {
-            // Check if ord for this document is within the specied range.
-            // TODO: Unroll? i.e. use SortCache_Get_Ords at constructor time
-            // and save ourselves some method call overhead.
-            const int32_t ord
-                = SortCache_Ordinal(ivars->sort_cache, ivars->doc_id);
-            if (ord >= ivars->lower_bound && ord <= ivars->upper_bound) {
-                break;
-            }
-        }
-    }
-    return ivars->doc_id;
+    return SI_next_hit(RangeMatcher_IVARS(self));
 }
 
 int32_t
 RangeMatcher_Advance_IMP(RangeMatcher* self, int32_t target) {
-    RangeMatcher_IVARS(self)->doc_id = target - 1;
-    return RangeMatcher_Next_IMP(self);
+    RangeMatcherIVARS *const ivars = RangeMatcher_IVARS(self);
+    if (target > ivars->doc_max) {
+        ivars->doc_id = ivars->doc_max;
+        ivars->mask   = 0;
+        ivars->block_start = ivars->doc_max;
+        return 0;
+    }
+    if (target < 1) { target = 1; }
+
+    // Jump straight to the block containing the target, then discard any
+    // hits which precede it.
+    const int32_t block_start = target & ~(BLOCK_SIZE - 1);
+    if (block_start != ivars->block_start
+        && ivars->upper_bound >= ivars->lower_bound
+       ) {
+        ivars->block_start = block_start;
+        ivars->mask        = S_match_block(ivars, block_start);
+    }
+    ivars->mask &= ~(((uint64_t)1 << (target - block_start)) - 1);
+
+    return SI_next_hit(ivars);
+}
+
+uint32_t
+RangeMatcher_Next_Block_IMP(RangeMatcher *self, int32_t *doc_ids,
+                            float *scores, uint32_t max) {
+    RangeMatcherIVARS *const ivars = RangeMatcher_IVARS(self);
+    uint32_t num_docs = 0;
+
+    while (num_docs < max) {
+        int32_t doc_id = SI_next_hit(ivars);
+        if (!doc_id) { break; }
+        doc_ids[num_docs++] = doc_id;
+    }
+
+    if (scores) {
+        for (uint32_t i = 0; i < num_docs; i++) { scores[i] = 0.0f; }
+    }
+
+    return num_docs;
 }
 
 float
@@ -94,4 +150,119 @@ RangeMatcher_Get_Doc_ID_IMP(RangeMatcher* self) {
     return RangeMatcher_IVARS(self)->doc_id;
 }
 
+static CFISH_INLINE int32_t
+SI_next_hit(RangeMatcherIVARS *ivars) {
+    while (ivars->mask == 0) {
+        if (ivars->block_start + BLOCK_SIZE > ivars->doc_max) {
+            ivars->doc_id = ivars->doc_max;
+            return 0;
+        }
+        ivars->block_start += BLOCK_SIZE;
+        ivars->mask = S_match_block(ivars, ivars->block_start);
+    }
+
+    const uint32_t bit = SI_lowest_bit(ivars->mask);
+    ivars->mask &= ivars->mask - 1;
+    ivars->doc_id = ivars->block_start + (int32_t)bit;
+    return ivars->doc_id;
+}
+
+/* The kernels below are branch-free: each ord is tested against the range
+ * with a single unsigned comparison and the result shifted into the mask,
+ * which lets the compiler vectorize the loops where the ord width permits.
+ */
+#define IN_RANGE(_ord) \
+    ((uint64_t)((uint64_t)((int64_t)(_ord) - lower) <= span))
+
+static uint64_t
+S_match_block(RangeMatcherIVARS *ivars, int32_t block_start) {
+    const int64_t  lower = ivars->lower_bound;
+    const uint64_t span  = ivars->span;
+    void *const    ords  = ivars->ords;
+    const int32_t  remaining = ivars->doc_max - block_start + 1;
+    const int32_t  count = remaining < BLOCK_SIZE ? remaining : BLOCK_SIZE;
+    uint64_t mask = 0;
+
+    switch (ivars->ord_width) {
+        case 1:
+            for (int32_t i = 0; i < count; i++) {
+                uint32_t ord = NumUtil_u1get(ords, block_start + i);
+                mask |= IN_RANGE(ord) << i;
+            }
+            break;
+        case 2:
+            for (int32_t i = 0; i < count; i++) {
+                uint32_t ord = NumUtil_u2get(ords, block_start + i);
+                mask |= IN_RANGE(ord) << i;
+            }
+            break;
+        case 4:
+            for (int32_t i = 0; i < count; i++) {
+                uint32_t ord = NumUtil_u4get(ords, block_start + i);
+                mask |= IN_RANGE(ord) << i;
+            }
+            break;
+        case 8: {
+                const uint8_t *ints = (uint8_t*)ords + block_start;
+                for (int32_t i = 0; i < count; i++) {
+                    mask |= IN_RANGE(ints[i]) << i;
+                }
+            }
+            break;
+        case 16:
+            if (ivars->native_ords) {
+                const uint16_t *ints = (uint16_t*)ords + block_start;
+                for (int32_t i = 0; i < count; i++) {
+                    mask |= IN_RANGE(ints[i]) << i;
+                }
+            }
+            else {
+                uint8_t *bytes
+                    = (uint8_t*)ords + block_start * sizeof(uint16_t);
+                for (int32_t i = 0; i < count; i++) {
+                    uint32_t ord = NumUtil_decode_bigend_u16(bytes);
+                    mask |= IN_RANGE(ord) << i;
+                    bytes += sizeof(uint16_t);
+                }
+            }
+            break;
+        case 32:
+            if (ivars->native_ords) {
+                const int32_t *ints = (int32_t*)ords + block_start;
+                for (int32_t i = 0; i < count; i++) {
+                    mask |= IN_RANGE(ints[i]) << i;
+                }
+            }
+            else {
+                uint8_t *bytes
+                    = (uint8_t*)ords + block_start * sizeof(uint32_t);
+                for (int32_t i = 0; i < count; i++) {
+                    int32_t ord = (int32_t)NumUtil_decode_bigend_u32(bytes);
+                    mask |= IN_RANGE(ord) << i;
+                    bytes += sizeof(uint32_t);
+                }
+            }
+            break;
+        default:
+            THROW(ERR, "Invalid ord width: %i32", ivars->ord_width);
+    }
+
+    // Doc id 0 is never valid.
+    if (block_start == 0) { mask &= ~(uint64_t)1; }
+
+    return mask;
+}
+
+static CFISH_INLINE uint32_t
+SI_lowest_bit(uint64_t mask) {
+    // De Bruijn multiplication on the isolated lowest bit.
+    static const uint8_t positions[64] = {
+         0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+        62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+        63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+        46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+    };
+    const uint64_t lowest = mask & (~mask + 1);
+    return positions[(lowest * UINT64_C(0x03F79D71B4CB0A89)) >> 58];
+}
 
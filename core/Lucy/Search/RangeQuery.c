@@ -20,11 +20,15 @@
 
 #include "Lucy/Search/RangeQuery.h"
 #include "Lucy/Index/DocVector.h"
+#include "Lucy/Index/PointReader.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Index/SortReader.h"
 #include "Lucy/Index/SortCache.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Plan/FieldType.h"
 #include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/BitVecMatcher.h"
 #include "Lucy/Search/RangeMatcher.h"
 #include "Lucy/Search/Searcher.h"
 #include "Lucy/Search/Span.h"
@@ -40,6 +44,11 @@ S_find_lower_bound(RangeCompiler *self, SortCache *sort_cache);
 static int32_t
 S_find_upper_bound(RangeCompiler *self, SortCache *sort_cache);
 
+// Search the segment's point index, if it covers the field.
+static Matcher*
+S_make_point_matcher(RangeCompiler *self, PointReader *point_reader,
+                     bool *handled);
+
 RangeQuery*
 RangeQuery_new(String *field, Obj *lower_term, Obj *upper_term,
                bool include_lower, bool include_upper) {
@@ -241,6 +250,14 @@ RangeCompiler_Make_Matcher_IMP(RangeCompiler *self, SegReader *reader,
                                bool need_score) {
     RangeQuery *parent = (RangeQuery*)RangeCompiler_IVARS(self)->parent;
     String *field = RangeQuery_IVARS(parent)->field;
+    PointReader *point_reader
+        = (PointReader*)SegReader_Fetch(reader, VTable_Get_Name(POINTREADER));
+    if (point_reader) {
+        bool handled = false;
+        Matcher *matcher = S_make_point_matcher(self, point_reader, &handled);
+        if (handled) { return matcher; }
+    }
+
     SortReader *sort_reader
         = (SortReader*)SegReader_Fetch(reader, VTable_Get_Name(SORTREADER));
     SortCache *sort_cache = sort_reader
@@ -266,6 +283,42 @@ RangeCompiler_Make_Matcher_IMP(RangeCompiler *self, SegReader *reader,
     }
 }
 
+static Matcher*
+S_make_point_matcher(RangeCompiler *self, PointReader *point_reader,
+                     bool *handled) {
+    RangeQuery *parent = (RangeQuery*)RangeCompiler_IVARS(self)->parent;
+    RangeQueryIVARS *const parent_ivars = RangeQuery_IVARS(parent);
+    if (!PointReader_Has_Field(point_reader, parent_ivars->field)) {
+        *handled = false;
+        return NULL;
+    }
+    *handled = true;
+
+    // Convert to inclusive keys in the field's own type.
+    Schema    *schema = PointReader_Get_Schema(point_reader);
+    FieldType *type   = Schema_Fetch_Type(schema, parent_ivars->field);
+    uint64_t   lower;
+    uint64_t   upper;
+    if (!type
+        || !PointReader_encode_bound(type, parent_ivars->lower_term, false,
+                                     parent_ivars->include_lower, &lower)
+        || !PointReader_encode_bound(type, parent_ivars->upper_term, true,
+                                     parent_ivars->include_upper, &upper)
+       ) {
+        return NULL;
+    }
+
+    VArray *fields = VA_new(1);
+    VA_Push(fields, INCREF(parent_ivars->field));
+    BitVector *bit_vec = PointReader_Find_Box(point_reader, fields, &lower,
+                                              &upper);
+    DECREF(fields);
+    if (!bit_vec) { return NULL; }
+    Matcher *matcher = (Matcher*)BitVecMatcher_new(bit_vec);
+    DECREF(bit_vec);
+    return matcher;
+}
+
 static int32_t
 S_find_lower_bound(RangeCompiler *self, SortCache *sort_cache) {
     RangeQuery *parent      = (RangeQuery*)RangeCompiler_IVARS(self)->parent;
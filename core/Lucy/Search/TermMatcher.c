@@ -90,6 +90,38 @@ TermMatcher_Advance_IMP(TermMatcher *self, int32_t target) {
     return 0;
 }
 
+uint32_t
+TermMatcher_Next_Block_IMP(TermMatcher *self, int32_t *doc_ids, float *scores,
+                           uint32_t max) {
+    TermMatcherIVARS *const ivars = TermMatcher_IVARS(self);
+    PostingList *const plist = ivars->plist;
+    uint32_t num_docs = 0;
+    if (!plist) { return 0; }
+
+    PList_Next_t next
+        = (PList_Next_t)METHOD_PTR(PList_Get_VTable(plist), LUCY_PList_Next);
+    TermMatcher_Score_t score
+        = scores
+          ? (TermMatcher_Score_t)METHOD_PTR(TermMatcher_Get_VTable(self),
+                                            LUCY_TermMatcher_Score)
+          : NULL;
+    ivars->posting = PList_Get_Posting(plist);
+    while (num_docs < max) {
+        int32_t doc_id = next(plist);
+        if (!doc_id) {
+            // Reclaim resources a little early.
+            DECREF(plist);
+            ivars->plist = NULL;
+            break;
+        }
+        doc_ids[num_docs] = doc_id;
+        if (scores) { scores[num_docs] = score(self); }
+        num_docs++;
+    }
+
+    return num_docs;
+}
+
 int32_t
 TermMatcher_Get_Doc_ID_IMP(TermMatcher* self) {
     TermMatcherIVARS *const ivars = TermMatcher_IVARS(self);
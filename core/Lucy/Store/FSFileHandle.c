@@ -56,6 +56,12 @@ SI_posix_flags(uint32_t fh_flags) {
 
 #define IS_64_BIT (SIZEOF_PTR == 8 ? 1 : 0)
 
+// copy_file_range() is available from glibc 2.27 (Linux 4.5).
+#if defined(__linux__) && defined(__GLIBC__) \
+    && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+  #define LUCY_HAS_COPY_FILE_RANGE
+#endif
+
 // Memory map a region of the file with shared (read-only) permissions.  If
 // the requested length is 0, return NULL.  If an error occurs, return NULL
 // and set Err_error.
@@ -218,6 +224,52 @@ FSFH_Length_IMP(FSFileHandle *self) {
     return FSFH_IVARS(self)->len;
 }
 
+int64_t
+FSFH_Copy_From_IMP(FSFileHandle *self, FileHandle *source, int64_t offset,
+                   int64_t len) {
+#ifdef LUCY_HAS_COPY_FILE_RANGE
+    FSFileHandleIVARS *const ivars = FSFH_IVARS(self);
+    int64_t copied = 0;
+
+    if (!(ivars->flags & FH_WRITE_ONLY)
+        || !ivars->fd
+        || !FH_Is_A(source, FSFILEHANDLE)
+       ) {
+        return 0;
+    }
+    FSFileHandleIVARS *const source_ivars = FSFH_IVARS((FSFileHandle*)source);
+    if (!(source_ivars->flags & FH_READ_ONLY)
+        || !source_ivars->fd
+        || offset < 0
+        || offset + len > source_ivars->len
+       ) {
+        return 0;
+    }
+
+    // Append at the current position of our own descriptor, reading from an
+    // explicit offset so that the source's descriptor is left untouched.
+    // Stop at the first failure (e.g. EXDEV or ENOSYS) and let the caller
+    // copy whatever remains.
+    loff_t in_pos = (loff_t)offset;
+    while (copied < len) {
+        ssize_t check_val
+            = copy_file_range(source_ivars->fd, &in_pos, ivars->fd, NULL,
+                              (size_t)(len - copied), 0);
+        if (check_val <= 0) { break; }
+        copied     += check_val;
+        ivars->len += check_val;
+    }
+
+    return copied;
+#else
+    UNUSED_VAR(self);
+    UNUSED_VAR(source);
+    UNUSED_VAR(offset);
+    UNUSED_VAR(len);
+    return 0;
+#endif
+}
+
 bool
 FSFH_Window_IMP(FSFileHandle *self, FileWindow *window, int64_t offset,
                 int64_t len) {
@@ -78,6 +78,21 @@ S_absolutify(String *path);
 static bool
 S_hard_link(char *from_path, char *to_path);
 
+// Sync a file, or merely start writeback of its dirty pages if `wait` is
+// false.  Set Err_error and return false on failure.
+static bool
+S_sync_file(String *path, bool wait);
+
+// Make the entries of a directory durable.  Set Err_error and return false
+// on failure.
+static bool
+S_sync_dir(String *path);
+
+// Apply S_sync_file() to a file -- or, if `path` is a directory, to every
+// file directly inside it, followed by S_sync_dir() on the directory itself.
+static bool
+S_sync_entry(String *path, bool wait);
+
 FSFolder*
 FSFolder_new(String *path) {
     FSFolder *self = (FSFolder*)VTable_Make_Obj(FSFOLDER);
@@ -198,6 +213,48 @@ FSFolder_Hard_Link_IMP(FSFolder *self, String *from,
     return retval;
 }
 
+bool
+FSFolder_Sync_IMP(FSFolder *self, VArray *paths) {
+    // Get every file moving towards the device before waiting on any one
+    // of them.
+    FSFolder_Start_Sync(self, paths);
+
+    for (uint32_t i = 0, max = VA_Get_Size(paths); i < max; i++) {
+        String *path     = (String*)VA_Fetch(paths, i);
+        String *fullpath = S_fullpath(self, path);
+        bool    success  = S_sync_entry(fullpath, true);
+        DECREF(fullpath);
+        if (!success) {
+            ERR_ADD_FRAME(Err_get_error());
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+FSFolder_Start_Sync_IMP(FSFolder *self, VArray *paths) {
+    for (uint32_t i = 0, max = VA_Get_Size(paths); i < max; i++) {
+        String *path     = (String*)VA_Fetch(paths, i);
+        String *fullpath = S_fullpath(self, path);
+        // Failures here will resurface during Sync().
+        S_sync_entry(fullpath, false);
+        DECREF(fullpath);
+    }
+}
+
+bool
+FSFolder_Sync_Dir_IMP(FSFolder *self, String *path) {
+    FSFolderIVARS *const ivars = FSFolder_IVARS(self);
+    String *fullpath = Str_Get_Size(path)
+                       ? S_fullpath(self, path)
+                       : (String*)INCREF(ivars->path);
+    bool success = S_sync_dir(fullpath);
+    if (!success) { ERR_ADD_FRAME(Err_get_error()); }
+    DECREF(fullpath);
+    return success;
+}
+
 bool
 FSFolder_Local_Delete_IMP(FSFolder *self, String *name) {
     FSFolderIVARS *const ivars = FSFolder_IVARS(self);
@@ -332,6 +389,32 @@ S_create_dir(String *path) {
     return retval;
 }
 
+static bool
+S_sync_entry(String *path, bool wait) {
+    if (!S_dir_ok(path)) {
+        return S_sync_file(path, wait);
+    }
+
+    DirHandle *dh = (DirHandle*)FSDH_open(path);
+    if (!dh) { return false; }
+    bool success = true;
+    while (success && DH_Next(dh)) {
+        if (DH_Entry_Is_Dir(dh) || DH_Entry_Is_Symlink(dh)) { continue; }
+        String *entry = DH_Get_Entry(dh);
+        String *file  = Str_newf("%o%s%o", path, DIR_SEP, entry);
+        success = S_sync_file(file, wait);
+        DECREF(file);
+        DECREF(entry);
+    }
+    DH_Close(dh);
+    DECREF(dh);
+
+    if (success && wait) {
+        success = S_sync_dir(path);
+    }
+    return success;
+}
+
 static bool
 S_is_local_entry(String *path) {
     return Str_Find_Utf8(path, "/", 1) == -1;
@@ -347,6 +430,7 @@ S_is_local_entry(String *path) {
 #undef DECREF
 
 #include <windows.h>
+#include <io.h>
 
 static bool
 S_is_absolute(String *path) {
@@ -391,6 +475,32 @@ S_hard_link(char *from8, char *to8) {
     }
 }
 
+static bool
+S_sync_file(String *path, bool wait) {
+    // Windows has no way to merely start writeback.
+    if (!wait) { return true; }
+
+    // _commit() requires a handle opened for writing.
+    char *path_ptr = Str_To_Utf8(path);
+    int   fd       = _open(path_ptr, _O_RDWR | _O_BINARY);
+    bool  success  = fd != -1 && _commit(fd) == 0;
+    if (!success) {
+        Err_set_error(Err_new(Str_newf("Failed to sync '%s': %s", path_ptr,
+                                       strerror(errno))));
+    }
+    if (fd != -1) { _close(fd); }
+    FREEMEM(path_ptr);
+    return success;
+}
+
+static bool
+S_sync_dir(String *path) {
+    // Directories can't be opened as files on Windows; NTFS journals
+    // directory updates itself.
+    UNUSED_VAR(path);
+    return true;
+}
+
 #elif (defined(CHY_HAS_UNISTD_H))
 
 static bool
@@ -422,6 +532,67 @@ S_hard_link(char *from8, char *to8) {
     }
 }
 
+// Flush a file's data -- and only as much metadata as is needed to read it
+// back -- to the device.
+static CFISH_INLINE int
+SI_fdatasync(int fd) {
+#if defined(F_FULLFSYNC)
+    // Darwin's fsync() doesn't flush the drive's write cache.
+    if (fcntl(fd, F_FULLFSYNC) == 0) { return 0; }
+    return fsync(fd);
+#elif defined(__linux__)
+    return fdatasync(fd);
+#else
+    return fsync(fd);
+#endif
+}
+
+static bool
+S_sync_file(String *path, bool wait) {
+#ifndef SYNC_FILE_RANGE_WRITE
+    if (!wait) { return true; }
+#endif
+    char *path_ptr = Str_To_Utf8(path);
+    int   fd       = open(path_ptr, O_RDONLY);
+    bool  success  = fd != -1;
+    if (success) {
+        if (wait) {
+            success = SI_fdatasync(fd) == 0;
+        }
+#ifdef SYNC_FILE_RANGE_WRITE
+        else {
+            // Best effort: a failure here only costs overlap.
+            sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+        }
+#endif
+    }
+    if (!success) {
+        Err_set_error(Err_new(Str_newf("Failed to sync '%s': %s", path_ptr,
+                                       strerror(errno))));
+    }
+    if (fd != -1) { close(fd); }
+    FREEMEM(path_ptr);
+    return success;
+}
+
+static bool
+S_sync_dir(String *path) {
+    char *path_ptr = Str_To_Utf8(path);
+    int   fd       = open(path_ptr, O_RDONLY);
+    bool  success  = fd != -1;
+    // Some file systems refuse to fsync a directory; they don't need it.
+    if (success && fsync(fd) != 0 && errno != EINVAL) {
+        success = false;
+    }
+    if (!success) {
+        Err_set_error(Err_new(Str_newf("Failed to sync directory '%s': %s",
+                                       path_ptr, strerror(errno))));
+    }
+    if (fd != -1) { close(fd); }
+    FREEMEM(path_ptr);
+    return success;
+}
+
 #else
   #error "Need either windows.h or unistd.h"
 #endif /* CHY_HAS_UNISTD_H vs. CHY_HAS_WINDOWS_H */
@@ -52,6 +52,16 @@ FH_Grow_IMP(FileHandle *self, int64_t length) {
     return true;
 }
 
+int64_t
+FH_Copy_From_IMP(FileHandle *self, FileHandle *source, int64_t offset,
+                 int64_t len) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(source);
+    UNUSED_VAR(offset);
+    UNUSED_VAR(len);
+    return 0;
+}
+
 void
 FH_Set_Path_IMP(FileHandle *self, String *path) {
     FileHandleIVARS *const ivars = FH_IVARS(self);
@@ -392,6 +392,26 @@ Folder_Slurp_File_IMP(Folder *self, String *path) {
     return retval;
 }
 
+bool
+Folder_Sync_IMP(Folder *self, VArray *paths) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(paths);
+    return true;
+}
+
+void
+Folder_Start_Sync_IMP(Folder *self, VArray *paths) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(paths);
+}
+
+bool
+Folder_Sync_Dir_IMP(Folder *self, String *path) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(path);
+    return true;
+}
+
 String*
 Folder_Get_Path_IMP(Folder *self) {
     return Folder_IVARS(self)->path;
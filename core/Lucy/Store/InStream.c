@@ -154,6 +154,11 @@ InStream_Clone_IMP(InStream *self) {
     VTable *vtable = InStream_Get_VTable(self);
     InStream *twin = (InStream*)VTable_Make_Obj(vtable);
     InStream_do_open(twin, (Obj*)ivars->file_handle);
+    InStreamIVARS *const twin_ivars = InStream_IVARS(twin);
+    DECREF(twin_ivars->filename);
+    twin_ivars->filename = Str_Clone(ivars->filename);
+    twin_ivars->offset   = ivars->offset;
+    twin_ivars->len      = ivars->len;
     InStream_Seek(twin, SI_tell(self));
     return twin;
 }
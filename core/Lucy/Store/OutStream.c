@@ -15,6 +15,7 @@
  */
 
 #define C_LUCY_OUTSTREAM
+#define C_LUCY_INSTREAM
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Store/OutStream.h"
@@ -25,6 +26,9 @@
 #include "Lucy/Store/RAMFile.h"
 #include "Lucy/Store/RAMFileHandle.h"
 
+// Maximum number of bytes OutStream_Absorb requests from an InStream at once.
+#define ABSORB_CHUNK_SIZE 0x10000
+
 // Inlined version of OutStream_Write_Bytes.
 static CFISH_INLINE void
 SI_write_bytes(OutStream *self, OutStreamIVARS *ivars,
@@ -106,21 +110,45 @@ OutStream_Get_Path_IMP(OutStream *self) {
 void
 OutStream_Absorb_IMP(OutStream *self, InStream *instream) {
     OutStreamIVARS *const ivars = OutStream_IVARS(self);
-    char buf[IO_STREAM_BUF_SIZE];
+    InStreamIVARS *const in_ivars = InStream_IVARS(instream);
     int64_t bytes_left = InStream_Length(instream);
 
-    // Read blocks of content into an intermediate buffer, than write them to
-    // the OutStream.
-    //
-    // TODO: optimize by utilizing OutStream's buffer directly, while still
-    // not flushing too frequently and keeping code complexity under control.
     OutStream_Grow(self, OutStream_Tell(self) + bytes_left);
+
+    // Give the FileHandle a chance to copy the content without routing it
+    // through our buffers -- on some file systems, without copying it at all.
+    if (bytes_left) {
+        const int64_t in_pos = InStream_Tell(instream);
+        S_flush(self, ivars);
+        int64_t copied
+            = FH_Copy_From(ivars->file_handle, in_ivars->file_handle,
+                           in_ivars->offset + in_pos, bytes_left);
+        if (copied) {
+            ivars->buf_start += copied;
+            bytes_left       -= copied;
+            InStream_Seek(instream, in_pos + copied);
+        }
+    }
+
+    // Copy whatever remains straight out of the InStream's window.  Chunks
+    // larger than our own buffer bypass it and go directly to the
+    // FileHandle.
     while (bytes_left) {
-        const size_t bytes_this_iter = bytes_left < IO_STREAM_BUF_SIZE
-                                       ? (size_t)bytes_left
-                                       : IO_STREAM_BUF_SIZE;
-        InStream_Read_Bytes(instream, buf, bytes_this_iter);
+        const size_t request = bytes_left < ABSORB_CHUNK_SIZE
+                               ? (size_t)bytes_left
+                               : ABSORB_CHUNK_SIZE;
+        char *buf = InStream_Buf(instream, request);
+        const int64_t available = PTR_TO_I64(in_ivars->limit)
+                                  - PTR_TO_I64(buf);
+        if (available <= 0) {
+            THROW(ERR, "Unexpected EOF absorbing '%o'",
+                  InStream_Get_Filename(instream));
+        }
+        const size_t bytes_this_iter = available < (int64_t)request
+                                       ? (size_t)available
+                                       : request;
         SI_write_bytes(self, ivars, buf, bytes_this_iter);
+        InStream_Advance_Buf(instream, buf + bytes_this_iter);
         bytes_left -= bytes_this_iter;
     }
 }
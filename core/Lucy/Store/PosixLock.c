@@ -0,0 +1,517 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_POSIXLOCK
+#define C_LUCY_POSIXLOCKENTRY
+#include "Lucy/Util/ToolSet.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#ifdef CHY_HAS_FCNTL_H
+  #include <fcntl.h>
+#endif
+#ifdef CHY_HAS_UNISTD_H
+  #include <unistd.h>
+#endif
+#ifdef CHY_HAS_SYS_STAT_H
+  #include <sys/stat.h>
+#endif
+#if defined(CHY_HAS_PTHREAD_H) && !defined(CFISH_NOTHREADS)
+  #include <pthread.h>
+#endif
+
+#include "Lucy/Store/PosixLock.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Util/Json.h"
+#include "Lucy/Util/ProcessID.h"
+#include "Lucy/Util/Sleep.h"
+
+#if defined(F_SETLK) && defined(CHY_HAS_UNISTD_H) && defined(CHY_HAS_SYS_STAT_H)
+  #define LUCY_HAS_POSIX_LOCKS
+#endif
+
+// Lock files held by this process, keyed by absolute path.  The table only
+// exists while at least one lock is held.  Every look at the table, and
+// every descriptor opened on a lock file, must happen under the table's
+// mutex: closing a stray descriptor would drop another thread's lock.
+static Hash *lock_table = NULL;
+
+#if defined(CHY_HAS_PTHREAD_H) && !defined(CFISH_NOTHREADS)
+static pthread_mutex_t lock_table_mutex = PTHREAD_MUTEX_INITIALIZER;
+  #define LOCK_TABLE()   pthread_mutex_lock(&lock_table_mutex)
+  #define UNLOCK_TABLE() pthread_mutex_unlock(&lock_table_mutex)
+#else
+  #define LOCK_TABLE()
+  #define UNLOCK_TABLE()
+#endif
+
+// Obtain the lock on behalf of PosixLock_Request(), with the table locked.
+static bool
+S_request(PosixLockIVARS *ivars);
+
+// Check for a lock held by anyone, with the table locked.
+static bool
+S_is_locked(PosixLockIVARS *ivars);
+
+// Create the "locks" subdirectory if necessary.
+static bool
+S_make_lock_dir(PosixLockIVARS *ivars);
+
+// Open the lock file and acquire a record lock on it.  Return the file
+// descriptor, or set Err_error and return -1.
+static int
+S_open_and_lock(PosixLockIVARS *ivars);
+
+// Overwrite the lock file's content with our pid, host and lock name.  On
+// failure, close the descriptor, set Err_error and return false.
+static bool
+S_write_lock_data(PosixLockIVARS *ivars, int fd);
+
+// Return true if the lock file's JSON content names our host and lock name
+// along with a pid which is no longer active.
+static bool
+S_lock_data_is_stale(PosixLockIVARS *ivars, int fd);
+
+// Make one non-blocking attempt to acquire a record lock.
+static bool
+S_try_lock(int fd, short type);
+
+PosixLock*
+PosixLock_new(Folder *folder, String *name, String *host, int32_t timeout,
+              int32_t interval, bool shared) {
+    PosixLock *self = (PosixLock*)VTable_Make_Obj(POSIXLOCK);
+    return PosixLock_init(self, folder, name, host, timeout, interval, shared);
+}
+
+PosixLock*
+PosixLock_init(PosixLock *self, Folder *folder, String *name, String *host,
+               int32_t timeout, int32_t interval, bool shared) {
+    Lock_init((Lock*)self, folder, name, host, timeout, interval);
+    PosixLockIVARS *const ivars = PosixLock_IVARS(self);
+    if (!Folder_Is_A(folder, FSFOLDER)) {
+        DECREF(self);
+        THROW(ERR, "PosixLock requires an FSFolder, not a %o",
+              Folder_Get_Class_Name(folder));
+    }
+    ivars->file_path = Str_newf("%o/%o", Folder_Get_Path(folder),
+                                ivars->lock_path);
+    ivars->shared    = shared;
+    ivars->held      = false;
+    return self;
+}
+
+bool
+PosixLock_supported() {
+#ifdef LUCY_HAS_POSIX_LOCKS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+PosixLock_Destroy_IMP(PosixLock *self) {
+    PosixLockIVARS *const ivars = PosixLock_IVARS(self);
+    if (ivars->held) { PosixLock_Release(self); }
+    DECREF(ivars->file_path);
+    SUPER_DESTROY(self, POSIXLOCK);
+}
+
+bool
+PosixLock_Shared_IMP(PosixLock *self) {
+    return PosixLock_IVARS(self)->shared;
+}
+
+bool
+PosixLock_Obtain_IMP(PosixLock *self) {
+    PosixLockIVARS *const ivars = PosixLock_IVARS(self);
+    int32_t time_left = ivars->timeout;
+    int32_t sleep_ms  = 1;
+    bool locked = PosixLock_Request(self);
+
+    while (!locked && time_left > 0) {
+        if (sleep_ms > ivars->interval) { sleep_ms = ivars->interval; }
+        if (sleep_ms > time_left)       { sleep_ms = time_left; }
+        Sleep_millisleep((uint32_t)sleep_ms);
+        time_left -= sleep_ms;
+        sleep_ms  *= 2;
+        locked = PosixLock_Request(self);
+    }
+
+    if (!locked) { ERR_ADD_FRAME(Err_get_error()); }
+    return locked;
+}
+
+bool
+PosixLock_Request_IMP(PosixLock *self) {
+    PosixLockIVARS *const ivars = PosixLock_IVARS(self);
+
+    if (ivars->held) {
+        Err_set_error((Err*)LockErr_new(Str_newf("Lock already obtained via '%o'",
+                                                 ivars->lock_path)));
+        return false;
+    }
+
+    LOCK_TABLE();
+    bool locked = S_request(ivars);
+    UNLOCK_TABLE();
+    return locked;
+}
+
+static bool
+S_request(PosixLockIVARS *ivars) {
+    // Consult the in-process table before going to the file system.
+    PosixLockEntry *entry
+        = lock_table
+          ? (PosixLockEntry*)Hash_Fetch(lock_table, (Obj*)ivars->file_path)
+          : NULL;
+    if (entry) {
+        PosixLockEntryIVARS *const entry_ivars = PLEntry_IVARS(entry);
+        if (ivars->shared && entry_ivars->shared) {
+            entry_ivars->holders++;
+            ivars->held = true;
+            return true;
+        }
+        Err_set_error((Err*)LockErr_new(Str_newf("Can't obtain lock: '%o' is held by this process",
+                                                 ivars->lock_path)));
+        return false;
+    }
+
+    if (!S_make_lock_dir(ivars)) { return false; }
+    int fd = S_open_and_lock(ivars);
+    if (fd == -1) { return false; }
+    if (!ivars->shared && !S_write_lock_data(ivars, fd)) { return false; }
+
+    if (!lock_table) { lock_table = Hash_new(0); }
+    entry = PLEntry_new(fd, ivars->shared);
+    Hash_Store(lock_table, (Obj*)ivars->file_path, (Obj*)entry);
+    ivars->held = true;
+    return true;
+}
+
+void
+PosixLock_Release_IMP(PosixLock *self) {
+    PosixLockIVARS *const ivars = PosixLock_IVARS(self);
+    if (!ivars->held) { return; }
+    ivars->held = false;
+
+    LOCK_TABLE();
+    PosixLockEntry *entry
+        = lock_table
+          ? (PosixLockEntry*)Hash_Fetch(lock_table, (Obj*)ivars->file_path)
+          : NULL;
+    if (!entry) {
+        UNLOCK_TABLE();
+        return;
+    }
+    PosixLockEntryIVARS *const entry_ivars = PLEntry_IVARS(entry);
+    if (--entry_ivars->holders > 0) {
+        UNLOCK_TABLE();
+        return;
+    }
+
+    // We're the last holder within this process.  Remove the lock file
+    // unless another process still holds a shared lock on it.  Waiters which
+    // opened the file before it was unlinked notice and start over.
+#ifdef LUCY_HAS_POSIX_LOCKS
+    if (!entry_ivars->shared || S_try_lock(entry_ivars->fd, F_WRLCK)) {
+        char *path_ptr = Str_To_Utf8(ivars->file_path);
+        unlink(path_ptr);
+        FREEMEM(path_ptr);
+    }
+#endif
+
+    // Closing the descriptor releases the record lock.
+    DECREF(Hash_Delete(lock_table, (Obj*)ivars->file_path));
+    if (Hash_Get_Size(lock_table) == 0) {
+        DECREF(lock_table);
+        lock_table = NULL;
+    }
+    UNLOCK_TABLE();
+}
+
+bool
+PosixLock_Is_Locked_IMP(PosixLock *self) {
+    PosixLockIVARS *const ivars = PosixLock_IVARS(self);
+    if (ivars->held) { return true; }
+    LOCK_TABLE();
+    bool locked = S_is_locked(ivars);
+    UNLOCK_TABLE();
+    return locked;
+}
+
+static bool
+S_is_locked(PosixLockIVARS *ivars) {
+    if (lock_table && Hash_Fetch(lock_table, (Obj*)ivars->file_path)) {
+        return true;
+    }
+
+#ifdef LUCY_HAS_POSIX_LOCKS
+    // Since this process holds no lock on the file, it's safe to open and
+    // close another descriptor for it.
+    char *path_ptr = Str_To_Utf8(ivars->file_path);
+    int fd = open(path_ptr, O_RDONLY);
+    FREEMEM(path_ptr);
+    if (fd == -1) { return false; }
+
+    struct flock lock_info;
+    memset(&lock_info, 0, sizeof(lock_info));
+    lock_info.l_type   = F_WRLCK;
+    lock_info.l_whence = SEEK_SET;
+    bool locked = fcntl(fd, F_GETLK, &lock_info) == -1
+                  || lock_info.l_type != F_UNLCK;
+    close(fd);
+    return locked;
+#else
+    return false;
+#endif
+}
+
+void
+PosixLock_Clear_Stale_IMP(PosixLock *self) {
+    PosixLockIVARS *const ivars = PosixLock_IVARS(self);
+    LOCK_TABLE();
+    if (lock_table && Hash_Fetch(lock_table, (Obj*)ivars->file_path)) {
+        UNLOCK_TABLE();
+        return;
+    }
+
+#ifdef LUCY_HAS_POSIX_LOCKS
+    char *path_ptr = Str_To_Utf8(ivars->file_path);
+    int fd = open(path_ptr, O_RDWR);
+    if (fd != -1) {
+        // Only a file which nobody holds a lock on can be stale.
+        if (S_try_lock(fd, F_WRLCK)) {
+            if (ivars->shared || S_lock_data_is_stale(ivars, fd)) {
+                if (unlink(path_ptr) != 0 && errno != ENOENT) {
+                    String *mess = MAKE_MESS("Can't delete '%o': %s",
+                                             ivars->lock_path,
+                                             strerror(errno));
+                    close(fd);
+                    UNLOCK_TABLE();
+                    FREEMEM(path_ptr);
+                    Err_throw_mess(ERR, mess);
+                }
+            }
+        }
+        close(fd);
+    }
+    FREEMEM(path_ptr);
+#endif
+    UNLOCK_TABLE();
+}
+
+static bool
+S_make_lock_dir(PosixLockIVARS *ivars) {
+    String *lock_dir_name = (String*)SSTR_WRAP_UTF8("locks", 5);
+    if (!Folder_Exists(ivars->folder, lock_dir_name)) {
+        if (!Folder_MkDir(ivars->folder, lock_dir_name)) {
+            Err *mkdir_err = (Err*)CERTIFY(Err_get_error(), ERR);
+            LockErr *err = LockErr_new(Str_newf("Can't create 'locks' directory: %o",
+                                                Err_Get_Mess(mkdir_err)));
+            // Maybe our attempt failed because another process succeeded.
+            if (Folder_Find_Folder(ivars->folder, lock_dir_name)) {
+                DECREF(err);
+            }
+            else {
+                Err_set_error((Err*)err);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+#ifdef LUCY_HAS_POSIX_LOCKS
+
+static int
+S_open_and_lock(PosixLockIVARS *ivars) {
+    char *path_ptr = Str_To_Utf8(ivars->file_path);
+    short type = ivars->shared ? F_RDLCK : F_WRLCK;
+
+    // If the holder we were waiting on unlinked the file between our open()
+    // and our fcntl(), we've locked an orphan; start over.
+    for (int attempt = 0; attempt < 10; attempt++) {
+        int fd = open(path_ptr, O_RDWR | O_CREAT, 0666);
+        if (fd == -1) {
+            Err_set_error((Err*)LockErr_new(Str_newf("Failed to obtain lock at '%o': %s",
+                                                     ivars->lock_path,
+                                                     strerror(errno))));
+            FREEMEM(path_ptr);
+            return -1;
+        }
+        if (!S_try_lock(fd, type)) {
+            if (errno == EACCES || errno == EAGAIN) {
+                Err_set_error((Err*)LockErr_new(Str_newf("Can't obtain lock: '%o' is locked",
+                                                         ivars->lock_path)));
+            }
+            else {
+                Err_set_error((Err*)LockErr_new(Str_newf("Failed to obtain lock at '%o': %s",
+                                                         ivars->lock_path,
+                                                         strerror(errno))));
+            }
+            close(fd);
+            FREEMEM(path_ptr);
+            return -1;
+        }
+
+        struct stat fd_stat, path_stat;
+        if (fstat(fd, &fd_stat) == 0
+            && stat(path_ptr, &path_stat) == 0
+            && fd_stat.st_dev == path_stat.st_dev
+            && fd_stat.st_ino == path_stat.st_ino
+           ) {
+            FREEMEM(path_ptr);
+            return fd;
+        }
+        close(fd);
+    }
+
+    Err_set_error((Err*)LockErr_new(Str_newf("Can't obtain lock: '%o' keeps disappearing",
+                                             ivars->lock_path)));
+    FREEMEM(path_ptr);
+    return -1;
+}
+
+static bool
+S_write_lock_data(PosixLockIVARS *ivars, int fd) {
+    Hash *file_data = Hash_new(3);
+    Hash_Store_Utf8(file_data, "pid", 3,
+                    (Obj*)Str_newf("%i32", (int32_t)PID_getpid()));
+    Hash_Store_Utf8(file_data, "host", 4, INCREF(ivars->host));
+    Hash_Store_Utf8(file_data, "name", 4, INCREF(ivars->name));
+    String *json = Json_to_json((Obj*)file_data);
+    DECREF(file_data);
+
+    const char *ptr  = Str_Get_Ptr8(json);
+    const size_t len = Str_Get_Size(json);
+    bool success = ftruncate(fd, 0) == 0
+                   && pwrite(fd, ptr, len, 0) == (ssize_t)len;
+    if (!success) {
+        Err_set_error((Err*)LockErr_new(Str_newf("Failed to write lock file '%o': %s",
+                                                 ivars->lock_path,
+                                                 strerror(errno))));
+        close(fd);
+    }
+    DECREF(json);
+    return success;
+}
+
+static bool
+S_lock_data_is_stale(PosixLockIVARS *ivars, int fd) {
+    struct stat fd_stat;
+    if (fstat(fd, &fd_stat) != 0) { return false; }
+
+    // An empty file belongs to a process which died before writing to it.
+    if (fd_stat.st_size == 0) { return true; }
+
+    size_t  len = (size_t)fd_stat.st_size;
+    char   *buf = (char*)MALLOCATE(len);
+    if (pread(fd, buf, len, 0) != (ssize_t)len) {
+        FREEMEM(buf);
+        return false;
+    }
+    String *json = Str_new_from_utf8(buf, len);
+    FREEMEM(buf);
+    Hash *hash = (Hash*)Json_from_json(json);
+    DECREF(json);
+
+    bool stale = false;
+    if (hash != NULL && Obj_Is_A((Obj*)hash, HASH)) {
+        String *pid_buf = (String*)Hash_Fetch_Utf8(hash, "pid", 3);
+        String *host    = (String*)Hash_Fetch_Utf8(hash, "host", 4);
+        String *name    = (String*)Hash_Fetch_Utf8(hash, "name", 4);
+
+        // Match hostname and lock name, then verify that pid is dead.
+        if (host != NULL
+            && Str_Equals(host, (Obj*)ivars->host)
+            && name != NULL
+            && Str_Equals(name, (Obj*)ivars->name)
+            && pid_buf != NULL
+           ) {
+            int pid = (int)Str_To_I64(pid_buf);
+            stale = !PID_active(pid);
+        }
+    }
+    DECREF(hash);
+    return stale;
+}
+
+static bool
+S_try_lock(int fd, short type) {
+    struct flock lock_info;
+    memset(&lock_info, 0, sizeof(lock_info));
+    lock_info.l_type   = type;
+    lock_info.l_whence = SEEK_SET;
+    return fcntl(fd, F_SETLK, &lock_info) == 0;
+}
+
+#else // No POSIX record locks.
+
+static int
+S_open_and_lock(PosixLockIVARS *ivars) {
+    Err_set_error((Err*)LockErr_new(Str_newf("Can't obtain lock at '%o': POSIX locks not supported on this platform",
+                                             ivars->lock_path)));
+    return -1;
+}
+
+static bool
+S_write_lock_data(PosixLockIVARS *ivars, int fd) {
+    UNUSED_VAR(ivars);
+    UNUSED_VAR(fd);
+    return false;
+}
+
+static bool
+S_lock_data_is_stale(PosixLockIVARS *ivars, int fd) {
+    UNUSED_VAR(ivars);
+    UNUSED_VAR(fd);
+    return false;
+}
+
+static bool
+S_try_lock(int fd, short type) {
+    UNUSED_VAR(fd);
+    UNUSED_VAR(type);
+    return false;
+}
+
+#endif // LUCY_HAS_POSIX_LOCKS
+
+/***************************************************************************/
+
+PosixLockEntry*
+PLEntry_new(int fd, bool shared) {
+    PosixLockEntry *self = (PosixLockEntry*)VTable_Make_Obj(POSIXLOCKENTRY);
+    PosixLockEntryIVARS *const ivars = PLEntry_IVARS(self);
+    ivars->fd      = fd;
+    ivars->shared  = shared;
+    ivars->holders = 1;
+    return self;
+}
+
+void
+PLEntry_Destroy_IMP(PosixLockEntry *self) {
+    PosixLockEntryIVARS *const ivars = PLEntry_IVARS(self);
+#ifdef CHY_HAS_UNISTD_H
+    if (ivars->fd != -1) { close(ivars->fd); }
+#endif
+    SUPER_DESTROY(self, POSIXLOCKENTRY);
+}
+
@@ -0,0 +1,70 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_POSIXLOCKFACTORY
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Store/PosixLockFactory.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Store/PosixLock.h"
+
+PosixLockFactory*
+PosixLockFact_new(Folder *folder, String *host) {
+    PosixLockFactory *self
+        = (PosixLockFactory*)VTable_Make_Obj(POSIXLOCKFACTORY);
+    return PosixLockFact_init(self, folder, host);
+}
+
+PosixLockFactory*
+PosixLockFact_init(PosixLockFactory *self, Folder *folder, String *host) {
+    LockFact_init((LockFactory*)self, folder, host);
+    return self;
+}
+
+static bool
+S_use_posix_locks(PosixLockFactory *self) {
+    return PosixLock_supported()
+           && Folder_Is_A(PosixLockFact_IVARS(self)->folder, FSFOLDER);
+}
+
+Lock*
+PosixLockFact_Make_Lock_IMP(PosixLockFactory *self, String *name,
+                            int32_t timeout, int32_t interval) {
+    if (!S_use_posix_locks(self)) {
+        PosixLockFact_Make_Lock_t super_make_lock
+            = SUPER_METHOD_PTR(POSIXLOCKFACTORY, LUCY_PosixLockFact_Make_Lock);
+        return super_make_lock(self, name, timeout, interval);
+    }
+    PosixLockFactoryIVARS *const ivars = PosixLockFact_IVARS(self);
+    return (Lock*)PosixLock_new(ivars->folder, name, ivars->host, timeout,
+                                interval, false);
+}
+
+Lock*
+PosixLockFact_Make_Shared_Lock_IMP(PosixLockFactory *self, String *name,
+                                   int32_t timeout, int32_t interval) {
+    if (!S_use_posix_locks(self)) {
+        PosixLockFact_Make_Shared_Lock_t super_make_shared_lock
+            = SUPER_METHOD_PTR(POSIXLOCKFACTORY,
+                               LUCY_PosixLockFact_Make_Shared_Lock);
+        return super_make_shared_lock(self, name, timeout, interval);
+    }
+    PosixLockFactoryIVARS *const ivars = PosixLockFact_IVARS(self);
+    return (Lock*)PosixLock_new(ivars->folder, name, ivars->host, timeout,
+                                interval, true);
+}
+
@@ -24,6 +24,7 @@
 
 #include "Lucy/Test/Analysis/TestAnalyzer.h"
 #include "Lucy/Test/Analysis/TestCaseFolder.h"
+#include "Lucy/Test/Analysis/TestCommonGramsFilter.h"
 #include "Lucy/Test/Analysis/TestNormalizer.h"
 #include "Lucy/Test/Analysis/TestPolyAnalyzer.h"
 #include "Lucy/Test/Analysis/TestRegexTokenizer.h"
@@ -32,14 +33,20 @@
 #include "Lucy/Test/Analysis/TestStandardTokenizer.h"
 #include "Lucy/Test/Highlight/TestHeatMap.h"
 #include "Lucy/Test/Highlight/TestHighlighter.h"
+#include "Lucy/Test/Index/TestCommitGroup.h"
+#include "Lucy/Test/Index/TestDeletions.h"
+#include "Lucy/Test/Index/TestDocValuesReader.h"
 #include "Lucy/Test/Index/TestDocWriter.h"
 #include "Lucy/Test/Index/TestHighlightWriter.h"
 #include "Lucy/Test/Index/TestIndexManager.h"
+#include "Lucy/Test/Index/TestKeyFilter.h"
+#include "Lucy/Test/Index/TestNearRealTime.h"
 #include "Lucy/Test/Index/TestPolyReader.h"
 #include "Lucy/Test/Index/TestPostingListWriter.h"
 #include "Lucy/Test/Index/TestSegWriter.h"
 #include "Lucy/Test/Index/TestSegment.h"
 #include "Lucy/Test/Index/TestSnapshot.h"
+#include "Lucy/Test/Index/TestSortWriter.h"
 #include "Lucy/Test/Index/TestTermInfo.h"
 #include "Lucy/Test/Object/TestBitVector.h"
 #include "Lucy/Test/Object/TestI32Array.h"
@@ -48,6 +55,11 @@
 #include "Lucy/Test/Plan/TestFieldType.h"
 #include "Lucy/Test/Plan/TestFullTextType.h"
 #include "Lucy/Test/Plan/TestNumericType.h"
+#include "Lucy/Test/Search/TestAggregateCollector.h"
+#include "Lucy/Test/Search/TestBoxQuery.h"
+#include "Lucy/Test/Search/TestFacetCollector.h"
+#include "Lucy/Test/Search/TestGroupCollector.h"
+#include "Lucy/Test/Search/TestImpactMatcher.h"
 #include "Lucy/Test/Search/TestLeafQuery.h"
 #include "Lucy/Test/Search/TestMatchAllQuery.h"
 #include "Lucy/Test/Search/TestNOTQuery.h"
@@ -72,6 +84,7 @@
 #include "Lucy/Test/Store/TestIOChunks.h"
 #include "Lucy/Test/Store/TestIOPrimitives.h"
 #include "Lucy/Test/Store/TestInStream.h"
+#include "Lucy/Test/Store/TestPosixLock.h"
 #include "Lucy/Test/Store/TestRAMDirHandle.h"
 #include "Lucy/Test/Store/TestRAMFileHandle.h"
 #include "Lucy/Test/Store/TestRAMFolder.h"
@@ -102,6 +115,7 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestFSFolder_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestRAMFolder_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestFolder_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestPosixLock_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestIxManager_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestCFWriter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestCFReader_new());
@@ -110,17 +124,24 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestCaseFolder_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestRegexTokenizer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSnowStop_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestCommonGrams_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSnowStemmer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNormalizer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestStandardTokenizer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSnapshot_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestTermInfo_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestKeyFilter_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestDeletions_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestNearRealTime_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestCommitGroup_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestDocValuesReader_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestFieldMisc_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestBatchSchema_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestDocWriter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestHLWriter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestPListWriter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSegWriter_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestSortWriter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestPolyReader_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestFullTextType_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestBlobType_new());
@@ -133,7 +154,12 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestTermQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestPhraseQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSortSpec_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestFacetColl_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestAggColl_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestGroupColl_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestRangeQuery_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestBoxQuery_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestImpactMatcher_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestANDQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestMatchAllQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNOTQuery_new());
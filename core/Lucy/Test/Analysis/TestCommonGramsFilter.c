@@ -0,0 +1,195 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTCOMMONGRAMSFILTER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/TestUtils.h"
+#include "Lucy/Test/Analysis/TestCommonGramsFilter.h"
+#include "Lucy/Analysis/CommonGramsFilter.h"
+#include "Lucy/Analysis/Inversion.h"
+#include "Lucy/Analysis/PolyAnalyzer.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Analysis/Token.h"
+
+TestCommonGramsFilter*
+TestCommonGrams_new() {
+    return (TestCommonGramsFilter*)VTable_Make_Obj(TESTCOMMONGRAMSFILTER);
+}
+
+static CommonGramsFilter*
+S_make_filter(void *unused, ...) {
+    va_list args;
+    Hash *common_words = Hash_new(0);
+    char *word;
+
+    va_start(args, unused);
+    while (NULL != (word = va_arg(args, char*))) {
+        Hash_Store_Utf8(common_words, word, strlen(word),
+                        (Obj*)Str_newf(""));
+    }
+    va_end(args);
+
+    CommonGramsFilter *self = CommonGrams_new(common_words);
+    DECREF(common_words);
+    return self;
+}
+
+static VArray*
+S_make_terms(void *unused, ...) {
+    va_list args;
+    VArray *terms = VA_new(0);
+    char *term;
+
+    va_start(args, unused);
+    while (NULL != (term = va_arg(args, char*))) {
+        VA_Push(terms, (Obj*)Str_newf(term));
+    }
+    va_end(args);
+
+    return terms;
+}
+
+static void
+test_Dump_Load_and_Equals(TestBatchRunner *runner) {
+    CommonGramsFilter *filter = S_make_filter(NULL, "the", "of", NULL);
+    CommonGramsFilter *other  = S_make_filter(NULL, "the", NULL);
+    Obj *dump = CommonGrams_Dump(filter);
+    CommonGramsFilter *clone
+        = (CommonGramsFilter*)CommonGrams_Load(other, dump);
+
+    TEST_FALSE(runner, CommonGrams_Equals(filter, (Obj*)other),
+               "Equals() false with different common words");
+    TEST_TRUE(runner, CommonGrams_Equals(filter, (Obj*)clone),
+              "Dump => Load round trip");
+
+    DECREF(filter);
+    DECREF(other);
+    DECREF(dump);
+    DECREF(clone);
+}
+
+static void
+test_Transform(TestBatchRunner *runner) {
+    CommonGramsFilter *filter    = S_make_filter(NULL, "the", "of", NULL);
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    VArray *analyzers = VA_new(2);
+    VA_Push(analyzers, (Obj*)tokenizer);
+    VA_Push(analyzers, INCREF(filter));
+    PolyAnalyzer *polyanalyzer = PolyAnalyzer_new(NULL, analyzers);
+
+    String *source = Str_newf("the who sang of love");
+    VArray *wanted = S_make_terms(NULL, "the who", "the", "who",
+                                  "sang of", "sang", "of love", "of", "love",
+                                  NULL);
+    TestUtils_test_analyzer(runner, (Analyzer*)polyanalyzer, source, wanted,
+                            "grams for pairs with common words");
+
+    // Each gram shares the position of its first word.
+    Inversion *inversion = PolyAnalyzer_Transform_Text(polyanalyzer, source);
+    Inversion_Invert(inversion);
+    int32_t positions[5] = { -1, -1, -1, -1, -1 };
+    Token **tokens;
+    uint32_t count;
+    bool grams_ok = true;
+    while (NULL != (tokens = Inversion_Next_Cluster(inversion, &count))) {
+        Token *token = tokens[0];
+        const char *text = Token_Get_Text(token);
+        size_t len = Token_Get_Len(token);
+        if (len == 7 && memcmp(text, "the who", 7) == 0) {
+            positions[0] = Token_Get_Pos(token);
+        }
+        else if (len == 3 && memcmp(text, "the", 3) == 0) {
+            positions[1] = Token_Get_Pos(token);
+        }
+        else if (len == 7 && memcmp(text, "of love", 7) == 0) {
+            positions[2] = Token_Get_Pos(token);
+        }
+        else if (len == 2 && memcmp(text, "of", 2) == 0) {
+            positions[3] = Token_Get_Pos(token);
+        }
+        else if (len == 4 && memcmp(text, "love", 4) == 0) {
+            positions[4] = Token_Get_Pos(token);
+        }
+        if (count != 1) { grams_ok = false; }
+    }
+    TEST_TRUE(runner,
+              grams_ok
+              && positions[0] == 0 && positions[1] == 0
+              && positions[2] == 3 && positions[3] == 3
+              && positions[4] == 4,
+              "Grams share the position of their first word");
+
+    DECREF(inversion);
+    DECREF(wanted);
+    DECREF(source);
+    DECREF(polyanalyzer);
+    DECREF(analyzers);
+    DECREF(filter);
+}
+
+static void
+S_test_rewrite(TestBatchRunner *runner, CommonGramsFilter *filter,
+               VArray *phrase, VArray *wanted, const char *message) {
+    VArray *got = CommonGrams_Rewrite_Phrase(filter, phrase);
+    TEST_TRUE(runner, VA_Equals(wanted, (Obj*)got), "Rewrite_Phrase(): %s",
+              message);
+    DECREF(got);
+    DECREF(wanted);
+    DECREF(phrase);
+}
+
+static void
+test_Rewrite_Phrase(TestBatchRunner *runner) {
+    CommonGramsFilter *filter
+        = S_make_filter(NULL, "of", "the", "to", "be", "or", "not", NULL);
+
+    S_test_rewrite(runner, filter,
+                   S_make_terms(NULL, "the", "who", NULL),
+                   S_make_terms(NULL, "the who", NULL),
+                   "trailing word covered by gram");
+    S_test_rewrite(runner, filter,
+                   S_make_terms(NULL, "to", "be", "or", "not", "to", "be",
+                                NULL),
+                   S_make_terms(NULL, "to be", "be or", "or not", "not to",
+                                "to be", NULL),
+                   "all common words");
+    S_test_rewrite(runner, filter,
+                   S_make_terms(NULL, "of", "the", "united", "states", NULL),
+                   S_make_terms(NULL, "of the", "the united", "united",
+                                "states", NULL),
+                   "common words then rare words");
+    S_test_rewrite(runner, filter,
+                   S_make_terms(NULL, "united", "states", NULL),
+                   S_make_terms(NULL, "united", "states", NULL),
+                   "no common words");
+
+    DECREF(filter);
+}
+
+void
+TestCommonGrams_Run_IMP(TestCommonGramsFilter *self,
+                        TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 10);
+    test_Dump_Load_and_Equals(runner);
+    test_Transform(runner);
+    test_Rewrite_Phrase(runner);
+}
+
+
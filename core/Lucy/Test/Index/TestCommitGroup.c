@@ -0,0 +1,375 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTCOMMITGROUP
+#define C_TESTLUCY_SYNCLOGFOLDER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestCommitGroup.h"
+#include "Lucy/Index/CommitGroup.h"
+
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Store/DirHandle.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestCommitGroup*
+TestCommitGroup_new() {
+    return (TestCommitGroup*)VTable_Make_Obj(TESTCOMMITGROUP);
+}
+
+SyncLogFolder*
+SyncLogFolder_new() {
+    SyncLogFolder *self = (SyncLogFolder*)VTable_Make_Obj(SYNCLOGFOLDER);
+    RAMFolder_init((RAMFolder*)self, NULL);
+    SyncLogFolder_IVARS(self)->log = VA_new(0);
+    return self;
+}
+
+VArray*
+SyncLogFolder_Get_Log_IMP(SyncLogFolder *self) {
+    return SyncLogFolder_IVARS(self)->log;
+}
+
+bool
+SyncLogFolder_Delete_IMP(SyncLogFolder *self, String *path) {
+    VA_Push(SyncLogFolder_IVARS(self)->log,
+            (Obj*)Str_newf("delete %o", path));
+    SyncLogFolder_Delete_t super_delete
+        = SUPER_METHOD_PTR(SYNCLOGFOLDER, TESTLUCY_SyncLogFolder_Delete);
+    return super_delete(self, path);
+}
+
+bool
+SyncLogFolder_Rename_IMP(SyncLogFolder *self, String *from, String *to) {
+    VA_Push(SyncLogFolder_IVARS(self)->log,
+            (Obj*)Str_newf("rename %o", to));
+    SyncLogFolder_Rename_t super_rename
+        = SUPER_METHOD_PTR(SYNCLOGFOLDER, TESTLUCY_SyncLogFolder_Rename);
+    return super_rename(self, from, to);
+}
+
+bool
+SyncLogFolder_Sync_Dir_IMP(SyncLogFolder *self, String *path) {
+    VA_Push(SyncLogFolder_IVARS(self)->log,
+            (Obj*)Str_newf("sync_dir %o", path));
+    return true;
+}
+
+void
+SyncLogFolder_Destroy_IMP(SyncLogFolder *self) {
+    DECREF(SyncLogFolder_IVARS(self)->log);
+    SUPER_DESTROY(self, SYNCLOGFOLDER);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema = Schema_new();
+    StringType *type   = StringType_new();
+    String     *field  = Str_newf("id");
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+    DECREF(field);
+    DECREF(type);
+    return schema;
+}
+
+// Remove a directory and everything inside it.  Folder_Delete_Tree() won't
+// do, since it sees compound files rather than the files on disk.
+static void
+S_zap_dir(String *path) {
+    FSFolder  *folder = FSFolder_new(path);
+    DirHandle *dh     = FSFolder_Local_Open_Dir(folder);
+    if (dh) {
+        while (DH_Next(dh)) {
+            String *entry = DH_Get_Entry(dh);
+            if (DH_Entry_Is_Dir(dh) && !DH_Entry_Is_Symlink(dh)) {
+                String *subdir = Str_newf("%o/%o", path, entry);
+                S_zap_dir(subdir);
+                DECREF(subdir);
+            }
+            else {
+                FSFolder_Local_Delete(folder, entry);
+            }
+            DECREF(entry);
+        }
+        DH_Close(dh);
+        DECREF(dh);
+    }
+    DECREF(folder);
+
+    Folder *parent = (Folder*)FSFolder_new((String*)SSTR_WRAP_UTF8(".", 1));
+    Folder_Delete(parent, path);
+    DECREF(parent);
+}
+
+static Folder*
+S_create_test_folder(const char *name) {
+    String   *test_dir = Str_newf("%s", name);
+    S_zap_dir(test_dir);
+    FSFolder *folder   = FSFolder_new(test_dir);
+    FSFolder_Initialize(folder);
+    if (!FSFolder_Check(folder)) {
+        RETHROW(INCREF(Err_get_error()));
+    }
+    DECREF(test_dir);
+    return (Folder*)folder;
+}
+
+static void
+S_destroy_test_folder(Folder *folder, const char *name) {
+    String *test_dir = Str_newf("%s", name);
+    DECREF(folder);
+    S_zap_dir(test_dir);
+    DECREF(test_dir);
+}
+
+static void
+S_add_docs(Indexer *indexer, int32_t count) {
+    String *field = Str_newf("id");
+    for (int32_t i = 0; i < count; i++) {
+        Doc    *doc = Doc_new(NULL, 0);
+        String *id  = Str_newf("%i32", i);
+        Doc_Store(doc, field, (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(doc);
+    }
+    DECREF(field);
+}
+
+static int32_t
+S_committed_doc_count(Folder *folder) {
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    int32_t doc_count = PolyReader_Doc_Count(reader);
+    DECREF(reader);
+    return doc_count;
+}
+
+static void
+S_commit(void *context) {
+    Indexer_Commit((Indexer*)context);
+}
+
+static void
+test_Sync(TestBatchRunner *runner) {
+    Folder *folder = S_create_test_folder("_commitgrouptest_a");
+    String *dir    = (String*)SSTR_WRAP_UTF8("dir", 3);
+    String *file   = (String*)SSTR_WRAP_UTF8("file", 4);
+    String *nested = (String*)SSTR_WRAP_UTF8("dir/nested", 10);
+    String *root   = (String*)SSTR_WRAP_UTF8("", 0);
+    String *bogus  = (String*)SSTR_WRAP_UTF8("bogus", 5);
+
+    Folder_MkDir(folder, dir);
+    OutStream *outstream = Folder_Open_Out(folder, file);
+    OutStream_Write_Bytes(outstream, "foo", 3);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    outstream = Folder_Open_Out(folder, nested);
+    OutStream_Write_Bytes(outstream, "bar", 3);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+
+    VArray *paths = VA_new(2);
+    VA_Push(paths, INCREF(file));
+    VA_Push(paths, INCREF(dir));
+    TEST_TRUE(runner, Folder_Sync(folder, paths), "Sync files and dirs");
+    TEST_TRUE(runner, Folder_Sync_Dir(folder, root), "Sync_Dir root");
+    TEST_TRUE(runner, Folder_Sync_Dir(folder, dir), "Sync_Dir subdir");
+
+    VA_Push(paths, INCREF(bogus));
+    Err_set_error(NULL);
+    TEST_FALSE(runner, Folder_Sync(folder, paths),
+               "Sync fails for missing file");
+    TEST_TRUE(runner, Err_get_error() != NULL, "... and sets Err_error");
+    DECREF(paths);
+
+    RAMFolder *ram_folder = RAMFolder_new(NULL);
+    paths = VA_new(1);
+    VA_Push(paths, INCREF(bogus));
+    TEST_TRUE(runner, RAMFolder_Sync(ram_folder, paths),
+              "RAMFolder Sync is a no-op");
+    DECREF(paths);
+    DECREF(ram_folder);
+
+    S_destroy_test_folder(folder, "_commitgrouptest_a");
+}
+
+static void
+test_durable_Indexer(TestBatchRunner *runner) {
+    Folder *folder = S_create_test_folder("_commitgrouptest_a");
+    Schema *schema = S_create_schema();
+
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL,
+                                   Indexer_DURABLE);
+    S_add_docs(indexer, 20);
+    Indexer_Prepare_Commit(indexer);
+    VArray *paths = Indexer_Sync_Paths(indexer);
+    TEST_INT_EQ(runner, paths ? VA_Get_Size(paths) : 0, 3,
+                "Sync_Paths lists segment, schema and snapshot");
+    String *snapfile = paths ? (String*)VA_Fetch(paths, 2) : NULL;
+    TEST_TRUE(runner,
+              snapfile && Str_Ends_With_Utf8(snapfile, ".json.temp", 10),
+              "Sync_Paths includes temp snapshot file");
+    Indexer_Commit(indexer);
+    TEST_INT_EQ(runner, S_committed_doc_count(folder), 20,
+                "durable Commit publishes docs");
+    Err *error = Err_trap(S_commit, indexer);
+    TEST_TRUE(runner, error != NULL, "can't Commit twice");
+    DECREF(error);
+    DECREF(indexer);
+
+    // A session which changes nothing has nothing to sync.
+    indexer = Indexer_new(schema, (Obj*)folder, NULL, Indexer_DURABLE);
+    TEST_TRUE(runner, Indexer_Sync_Paths(indexer) == NULL,
+              "no Sync_Paths without changes");
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    DECREF(schema);
+    S_destroy_test_folder(folder, "_commitgrouptest_a");
+}
+
+// Return the position of the first log entry at or after `tick` which
+// starts with `prefix`, or -1 if there is none.
+static int32_t
+S_find_entry(VArray *log, int32_t tick, const char *prefix) {
+    size_t prefix_len = strlen(prefix);
+    for (uint32_t i = (uint32_t)tick, max = VA_Get_Size(log); i < max; i++) {
+        String *entry = (String*)VA_Fetch(log, i);
+        if (Str_Starts_With_Utf8(entry, prefix, prefix_len)) {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+static void
+test_publish_order(TestBatchRunner *runner) {
+    SyncLogFolder *folder = SyncLogFolder_new();
+    Schema        *schema = S_create_schema();
+    VArray        *log    = SyncLogFolder_Get_Log(folder);
+
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    S_add_docs(indexer, 10);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    // Replace the first segment, so that the durable commit has both an
+    // old snapshot and an old segment to purge.
+    indexer = Indexer_new(schema, (Obj*)folder, NULL, Indexer_DURABLE);
+    S_add_docs(indexer, 10);
+    Indexer_Optimize(indexer);
+    VA_Clear(log);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    int32_t rename_tick = S_find_entry(log, 0, "rename snapshot_2.json");
+    int32_t tick        = rename_tick < 0 ? 0 : rename_tick;
+    int32_t sync_tick   = S_find_entry(log, tick, "sync_dir");
+    int32_t delete_tick = S_find_entry(log, tick, "delete ");
+    int32_t purge_tick  = S_find_entry(log, tick, "delete snapshot_1.json");
+    int32_t unlock_tick = S_find_entry(log, tick, "delete locks/write.lock");
+    TEST_TRUE(runner, rename_tick >= 0 && sync_tick > rename_tick,
+              "durable Commit syncs the directory after renaming snapshot");
+    TEST_TRUE(runner, delete_tick > sync_tick,
+              "... before deleting anything");
+    TEST_TRUE(runner, purge_tick > sync_tick,
+              "... and the old snapshot is purged afterwards");
+    TEST_TRUE(runner, unlock_tick > sync_tick,
+              "... and the write lock is released afterwards");
+    TEST_INT_EQ(runner, S_committed_doc_count((Folder*)folder), 20,
+                "durable Commit on logging folder publishes docs");
+
+    DECREF(schema);
+    DECREF(folder);
+}
+
+static void
+test_group(TestBatchRunner *runner) {
+    Folder    *folder_a = S_create_test_folder("_commitgrouptest_a");
+    Folder    *folder_b = S_create_test_folder("_commitgrouptest_b");
+    RAMFolder *folder_c = RAMFolder_new(NULL);
+    Schema    *schema   = S_create_schema();
+
+    CommitGroup *group = CommitGroup_new();
+    Indexer *indexer_a = Indexer_new(schema, (Obj*)folder_a, NULL, 0);
+    Indexer *indexer_b = Indexer_new(schema, (Obj*)folder_b, NULL, 0);
+    Indexer *indexer_c = Indexer_new(schema, (Obj*)folder_c, NULL, 0);
+    S_add_docs(indexer_a, 10);
+    S_add_docs(indexer_b, 15);
+    S_add_docs(indexer_c, 5);
+    Indexer_Prepare_Commit(indexer_b);
+    CommitGroup_Add(group, indexer_a);
+    CommitGroup_Add(group, indexer_b);
+    CommitGroup_Add(group, indexer_c);
+
+    TEST_INT_EQ(runner, S_committed_doc_count(folder_b), 0,
+                "nothing visible before group Commit");
+    CommitGroup_Commit(group);
+    TEST_INT_EQ(runner, S_committed_doc_count(folder_a), 10,
+                "group Commit publishes first index");
+    TEST_INT_EQ(runner, S_committed_doc_count(folder_b), 15,
+                "group Commit publishes prepared index");
+    TEST_INT_EQ(runner, S_committed_doc_count((Folder*)folder_c), 5,
+                "group Commit publishes RAM index");
+    TEST_INT_EQ(runner, CommitGroup_Get_Num_Commits(group), 3,
+                "Get_Num_Commits");
+    TEST_INT_EQ(runner, CommitGroup_Get_Num_Syncs(group), 1,
+                "one sync covers the whole group");
+    TEST_TRUE(runner,
+              CommitGroup_Get_Max_Sync_Micros(group) >= 0
+              && CommitGroup_Get_Max_Sync_Micros(group)
+                 <= CommitGroup_Get_Sync_Micros(group),
+              "sync latency counters");
+    DECREF(indexer_a);
+    DECREF(indexer_b);
+    DECREF(indexer_c);
+
+    // The group empties itself and can be reused.
+    indexer_a = Indexer_new(schema, (Obj*)folder_a, NULL, 0);
+    S_add_docs(indexer_a, 10);
+    CommitGroup_Add(group, indexer_a);
+    CommitGroup_Commit(group);
+    TEST_INT_EQ(runner, S_committed_doc_count(folder_a), 20,
+                "reused group publishes");
+    TEST_INT_EQ(runner, CommitGroup_Get_Num_Syncs(group), 2,
+                "reused group syncs again");
+    DECREF(indexer_a);
+
+    DECREF(group);
+    DECREF(schema);
+    DECREF(folder_c);
+    S_destroy_test_folder(folder_a, "_commitgrouptest_a");
+    S_destroy_test_folder(folder_b, "_commitgrouptest_b");
+}
+
+void
+TestCommitGroup_Run_IMP(TestCommitGroup *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 25);
+    test_Sync(runner);
+    test_durable_Indexer(runner);
+    test_publish_order(runner);
+    test_group(runner);
+}
+
@@ -0,0 +1,216 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_TESTLUCY_TESTDELETIONS
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestDeletions.h"
+#include "Lucy/Index/DeletionsReader.h"
+#include "Lucy/Index/DeletionsWriter.h"
+
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Matcher.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS 2000
+
+TestDeletions*
+TestDeletions_new() {
+    return (TestDeletions*)VTable_Make_Obj(TESTDELETIONS);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema  = Schema_new();
+    StringType *type    = StringType_new();
+    String     *field   = Str_newf("id");
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+    DECREF(field);
+    DECREF(type);
+    return schema;
+}
+
+static void
+S_add_docs(Indexer *indexer, int32_t start, int32_t end) {
+    String *field = Str_newf("id");
+    for (int32_t i = start; i < end; i++) {
+        Doc    *doc = Doc_new(NULL, 0);
+        String *id  = Str_newf("id%i32", i);
+        Doc_Store(doc, field, (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(doc);
+    }
+    DECREF(field);
+}
+
+// Delete docs `start` through `end - 1`, noting them in `deleted`.
+static void
+S_delete_docs(RAMFolder *folder, bool *deleted, int32_t start, int32_t end,
+              int32_t num_new) {
+    Indexer *indexer = Indexer_new(NULL, (Obj*)folder, NULL, 0);
+    String  *field   = Str_newf("id");
+    for (int32_t i = start; i < end; i++) {
+        String *term = Str_newf("id%i32", i);
+        Indexer_Delete_By_Term(indexer, field, (Obj*)term);
+        deleted[i] = true;
+        DECREF(term);
+    }
+    S_add_docs(indexer, NUM_DOCS, NUM_DOCS + num_new);
+    Indexer_Commit(indexer);
+    DECREF(field);
+    DECREF(indexer);
+}
+
+static int64_t
+S_file_length(RAMFolder *folder, String *filename) {
+    InStream *instream = RAMFolder_Open_In(folder, filename);
+    if (!instream) { return -1; }
+    int64_t len = InStream_Length(instream);
+    DECREF(instream);
+    return len;
+}
+
+// Verify the deletions of the first segment, which holds docs 0 through
+// NUM_DOCS - 1 as doc ids 1 through NUM_DOCS.  Return its file metadata.
+static Hash*
+S_check(TestBatchRunner *runner, RAMFolder *folder, bool *deleted,
+        const char *stage) {
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    SegReader  *seg_reader
+        = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    DeletionsReader *del_reader
+        = (DeletionsReader*)SegReader_Fetch(
+              seg_reader, VTable_Get_Name(DELETIONSREADER));
+    Matcher *iter     = DelReader_Iterator(del_reader);
+    int32_t  expected = 0;
+    bool     ok       = true;
+
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        if (deleted[i]) { expected++; }
+    }
+    for (int32_t i = 0, doc_id = Matcher_Next(iter); i < NUM_DOCS; i++) {
+        if (deleted[i]) {
+            if (doc_id != i + 1) { ok = false; }
+            doc_id = Matcher_Next(iter);
+        }
+        else if (doc_id == i + 1) {
+            ok = false;
+        }
+    }
+    TEST_TRUE(runner, ok && DelReader_Del_Count(del_reader) == expected,
+              "Deletions read back %s", stage);
+
+    Hash *file_meta = DefDelReader_Get_File_Meta(
+                          (DefaultDeletionsReader*)del_reader);
+    file_meta = (Hash*)INCREF(file_meta);
+    DECREF(iter);
+    DECREF(reader);
+    return file_meta;
+}
+
+static void
+test_deltas(TestBatchRunner *runner) {
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Schema    *schema  = S_create_schema();
+    bool      *deleted = (bool*)CALLOCATE(NUM_DOCS, sizeof(bool));
+    Hash      *meta;
+    String    *base;
+    String    *delta;
+
+    {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        S_add_docs(indexer, 0, NUM_DOCS);
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+
+    // A few deletions go into a delta file.
+    S_delete_docs(folder, deleted, 10, 13, 0);
+    meta  = S_check(runner, folder, deleted, "after first delta");
+    base  = (String*)Hash_Fetch_Utf8(meta, "filename", 8);
+    delta = (String*)Hash_Fetch_Utf8(meta, "delta", 5);
+    TEST_TRUE(runner, !base && delta, "Small commit writes only a delta");
+    TEST_TRUE(runner, delta && S_file_length(folder, delta) < 16,
+              "Delta file is a few bytes");
+    DECREF(meta);
+
+    // Deltas are cumulative, so recycling the old one loses nothing.
+    S_delete_docs(folder, deleted, 500, 502, 3);
+    meta  = S_check(runner, folder, deleted, "after second delta");
+    base  = (String*)Hash_Fetch_Utf8(meta, "filename", 8);
+    delta = (String*)Hash_Fetch_Utf8(meta, "delta", 5);
+    TEST_TRUE(runner, !base && delta, "Second commit writes only a delta");
+    DECREF(meta);
+
+    // Past the threshold, the delta gets folded into a bitmap.
+    S_delete_docs(folder, deleted, 1000, 1010, 0);
+    meta  = S_check(runner, folder, deleted, "after fold");
+    base  = (String*)Hash_Fetch_Utf8(meta, "filename", 8);
+    delta = (String*)Hash_Fetch_Utf8(meta, "delta", 5);
+    TEST_TRUE(runner, base && !delta, "Large delta folded into bitmap");
+    String *base_copy = base ? Str_Clone(base) : NULL;
+    DECREF(meta);
+
+    // Later deltas build on the bitmap, which stays put across commits.
+    S_delete_docs(folder, deleted, 1999, 2000, 5);
+    S_delete_docs(folder, deleted, 0, 1, 5);
+    meta  = S_check(runner, folder, deleted, "after delta on bitmap");
+    base  = (String*)Hash_Fetch_Utf8(meta, "filename", 8);
+    delta = (String*)Hash_Fetch_Utf8(meta, "delta", 5);
+    TEST_TRUE(runner, base && base_copy && Str_Equals(base, (Obj*)base_copy)
+                      && delta,
+              "Delta refers to existing bitmap");
+    TEST_TRUE(runner, base_copy && S_file_length(folder, base_copy) > 0,
+              "Bitmap survives recycling of small segments");
+    DECREF(meta);
+    DECREF(base_copy);
+
+    // Collapsing the index applies all deletions.
+    {
+        Indexer *indexer = Indexer_new(NULL, (Obj*)folder, NULL, 0);
+        Indexer_Optimize(indexer);
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+        PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+        TEST_TRUE(runner, PolyReader_Del_Count(reader) == 0
+                          && PolyReader_Doc_Count(reader)
+                             == NUM_DOCS - 17 + 13,
+                  "Optimize() purges deleted docs");
+        DECREF(reader);
+    }
+
+    FREEMEM(deleted);
+    DECREF(schema);
+    DECREF(folder);
+}
+
+void
+TestDeletions_Run_IMP(TestDeletions *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 11);
+    test_deltas(runner);
+}
+
@@ -0,0 +1,287 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTDOCVALUESREADER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestDocValuesReader.h"
+#include "Lucy/Index/DocValuesReader.h"
+
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/DocReader.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Object/I32Array.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Search/TopDocs.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestDocValuesReader*
+TestDocValuesReader_new() {
+    return (TestDocValuesReader*)VTable_Make_Obj(TESTDOCVALUESREADER);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema   = Schema_new();
+    StringType *category = StringType_new();
+    StringType *title    = StringType_new();
+    Int32Type  *price    = Int32Type_new();
+    FType_Set_Sortable((FieldType*)category, true);
+    FType_Set_Sortable((FieldType*)price, true);
+    FType_Set_Indexed((FieldType*)price, false);
+    String *field = Str_newf("category");
+    Schema_Spec_Field(schema, field, (FieldType*)category);
+    DECREF(field);
+    field = Str_newf("title");
+    Schema_Spec_Field(schema, field, (FieldType*)title);
+    DECREF(field);
+    field = Str_newf("price");
+    Schema_Spec_Field(schema, field, (FieldType*)price);
+    DECREF(field);
+    DECREF(price);
+    DECREF(title);
+    DECREF(category);
+    return schema;
+}
+
+// Add docs numbered from `start`.  Every third doc has no price.
+static void
+S_add_docs(RAMFolder *folder, Schema *schema, int32_t start, int32_t count) {
+    Indexer *indexer  = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    String  *category = Str_newf("category");
+    String  *title    = Str_newf("title");
+    String  *price    = Str_newf("price");
+    for (int32_t i = start; i < start + count; i++) {
+        Doc    *doc         = Doc_new(NULL, 0);
+        String *cat_value   = Str_newf(i % 2 ? "odd" : "even");
+        String *title_value = Str_newf("title %i32", i);
+        Doc_Store(doc, category, (Obj*)cat_value);
+        Doc_Store(doc, title, (Obj*)title_value);
+        DECREF(title_value);
+        DECREF(cat_value);
+        if (i % 3) {
+            Integer32 *price_value = Int32_new(i * 10);
+            Doc_Store(doc, price, (Obj*)price_value);
+            DECREF(price_value);
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(price);
+    DECREF(title);
+    DECREF(category);
+    DECREF(indexer);
+}
+
+static DocValuesReader*
+S_fetch_reader(IndexReader *reader) {
+    return (DocValuesReader*)IxReader_Fetch(
+               reader, VTable_Get_Name(DOCVALUESREADER));
+}
+
+static bool
+S_matches_stored(Obj *value, HitDoc *hit_doc, const char *field_name) {
+    String *field  = Str_newf(field_name);
+    Obj    *stored = HitDoc_Extract(hit_doc, field);
+    bool    equal  = (stored && value) ? Obj_Equals(value, stored)
+                                       : stored == value;
+    DECREF(stored);
+    DECREF(field);
+    return equal;
+}
+
+static void
+S_fetch_bad_field(void *context) {
+    String *field = Str_newf("title");
+    Obj *value = DocValuesReader_Fetch_Value((DocValuesReader*)context,
+                                             field, 1);
+    DECREF(value);
+    DECREF(field);
+}
+
+static void
+test_Fetch_Value(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+    Schema    *schema = S_create_schema();
+    S_add_docs(folder, schema, 1, 15);
+    S_add_docs(folder, schema, 16, 5);
+
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    DocValuesReader *values_reader = S_fetch_reader((IndexReader*)reader);
+    DocReader *doc_reader
+        = (DocReader*)PolyReader_Fetch(reader, VTable_Get_Name(DOCREADER));
+    TEST_TRUE(runner, VA_Get_Size(PolyReader_Get_Seg_Readers(reader)) == 2
+                      && values_reader
+                      && DocValuesReader_Is_A(values_reader,
+                                              POLYDOCVALUESREADER),
+              "PolyReader aggregates DocValuesReaders");
+
+    String *category = Str_newf("category");
+    String *price    = Str_newf("price");
+    bool    all_match = true;
+    for (int32_t doc_id = 1; doc_id <= 20; doc_id++) {
+        HitDoc *hit_doc = DocReader_Fetch_Doc(doc_reader, doc_id);
+        Obj *cat_value
+            = DocValuesReader_Fetch_Value(values_reader, category, doc_id);
+        Obj *price_value
+            = DocValuesReader_Fetch_Value(values_reader, price, doc_id);
+        if (!cat_value
+            || !S_matches_stored(cat_value, hit_doc, "category")
+            || !S_matches_stored(price_value, hit_doc, "price")
+           ) {
+            all_match = false;
+        }
+        DECREF(price_value);
+        DECREF(cat_value);
+        DECREF(hit_doc);
+    }
+    TEST_TRUE(runner, all_match,
+              "Fetch_Value() agrees with stored fields across segments");
+
+    {
+        Obj *value = DocValuesReader_Fetch_Value(values_reader, price, 3);
+        TEST_TRUE(runner, value == NULL, "Missing value comes back NULL");
+        DECREF(value);
+    }
+
+    {
+        VArray *seg_readers = PolyReader_Get_Seg_Readers(reader);
+        SegReader *seg_reader = (SegReader*)VA_Fetch(seg_readers, 1);
+        DocValuesReader *seg_values
+            = S_fetch_reader((IndexReader*)seg_reader);
+        Obj *value = DocValuesReader_Fetch_Value(seg_values, price, 1);
+        TEST_INT_EQ(runner, value ? Obj_To_I64(value) : 0, 160,
+                    "SegReader exposes a DocValuesReader with local doc ids");
+        DECREF(value);
+    }
+
+    Err *error = Err_trap(S_fetch_bad_field, values_reader);
+    TEST_TRUE(runner, error != NULL, "Unsortable field throws");
+    DECREF(error);
+
+    DECREF(price);
+    DECREF(category);
+    DECREF(reader);
+    DECREF(schema);
+    DECREF(folder);
+}
+
+static void
+test_batch(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+    Schema    *schema = S_create_schema();
+    S_add_docs(folder, schema, 1, 15);
+    S_add_docs(folder, schema, 16, 5);
+
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    DocValuesReader *values_reader = S_fetch_reader((IndexReader*)reader);
+    String *price = Str_newf("price");
+
+    {
+        int32_t *ints = (int32_t*)MALLOCATE(4 * sizeof(int32_t));
+        ints[0] = 11;
+        ints[1] = 2;
+        ints[2] = 3;
+        ints[3] = 19;
+        I32Array *doc_ids = I32Arr_new_steal(ints, 4);
+        VArray *values
+            = DocValuesReader_Fetch_Values(values_reader, price, doc_ids);
+        Obj *first  = VA_Fetch(values, 0);
+        Obj *second = VA_Fetch(values, 1);
+        Obj *fourth = VA_Fetch(values, 3);
+        TEST_TRUE(runner, VA_Get_Size(values) == 4
+                          && first && Obj_To_I64(first) == 110
+                          && second && Obj_To_I64(second) == 20
+                          && VA_Fetch(values, 2) == NULL
+                          && fourth && Obj_To_I64(fourth) == 190,
+                  "Fetch_Values() keeps input order and NULL slots");
+        DECREF(values);
+        DECREF(doc_ids);
+    }
+
+    {
+        // Docs from both segments, interleaved and in reverse.
+        int32_t *ints = (int32_t*)MALLOCATE(20 * sizeof(int32_t));
+        for (int32_t i = 0; i < 20; i++) {
+            ints[i] = i % 2 ? 20 - i / 2 : 1 + i / 2;
+        }
+        I32Array *doc_ids = I32Arr_new_steal(ints, 20);
+        VArray *values
+            = DocValuesReader_Fetch_Values(values_reader, price, doc_ids);
+        bool all_match = VA_Get_Size(values) == 20;
+        for (uint32_t i = 0; i < 20 && all_match; i++) {
+            Obj *expected = DocValuesReader_Fetch_Value(
+                                values_reader, price, I32Arr_Get(doc_ids, i));
+            Obj *got = VA_Fetch(values, i);
+            if (expected ? !got || !Obj_Equals(expected, got) : got != NULL) {
+                all_match = false;
+            }
+            DECREF(expected);
+        }
+        TEST_TRUE(runner, all_match,
+                  "Fetch_Values() across segments agrees with Fetch_Value()");
+        DECREF(values);
+        DECREF(doc_ids);
+    }
+
+    {
+        IndexSearcher *searcher = IxSearcher_new((Obj*)reader);
+        String    *field    = Str_newf("category");
+        String    *term     = Str_newf("odd");
+        TermQuery *query    = TermQuery_new(field, (Obj*)term);
+        TopDocs   *top_docs = IxSearcher_Top_Docs(searcher, (Query*)query,
+                                                  10, NULL);
+        VArray    *values   = DocValuesReader_Fetch_Hit_Values(values_reader,
+                                                               field,
+                                                               top_docs);
+        bool all_odd = VA_Get_Size(values) == 10;
+        for (uint32_t i = 0, max = VA_Get_Size(values); i < max; i++) {
+            Obj *value = VA_Fetch(values, i);
+            if (!value || !Str_Equals(term, value)) { all_odd = false; }
+        }
+        TEST_TRUE(runner, all_odd, "Fetch_Hit_Values() covers a TopDocs");
+        DECREF(values);
+        DECREF(top_docs);
+        DECREF(query);
+        DECREF(term);
+        DECREF(field);
+        DECREF(searcher);
+    }
+
+    DECREF(price);
+    DECREF(reader);
+    DECREF(schema);
+    DECREF(folder);
+}
+
+void
+TestDocValuesReader_Run_IMP(TestDocValuesReader *self,
+                            TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 8);
+    test_Fetch_Value(runner);
+    test_batch(runner);
+}
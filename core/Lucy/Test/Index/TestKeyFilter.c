@@ -0,0 +1,314 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_TESTLUCY_TESTKEYFILTER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestKeyFilter.h"
+#include "Lucy/Index/KeyFilterReader.h"
+
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchDoc.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Search/TopDocs.h"
+#include "Lucy/Store/RAMFolder.h"
+#include "Lucy/Util/Freezer.h"
+
+#define DOCS_PER_SEG 200
+#define NUM_SEGS     3
+
+TestKeyFilter*
+TestKeyFilter_new() {
+    return (TestKeyFilter*)VTable_Make_Obj(TESTKEYFILTER);
+}
+
+static void
+test_Dump_Load_and_Equals(TestBatchRunner *runner) {
+    StringType *type     = StringType_new();
+    StringType *key_type = StringType_new();
+    StringType_Set_Key(key_type, true);
+    Obj *dump        = (Obj*)StringType_Dump(key_type);
+    Obj *clone       = Freezer_load(dump);
+    Obj *schema_dump = (Obj*)StringType_Dump_For_Schema(key_type);
+    StringType *schema_clone = StringType_Load(type, schema_dump);
+
+    TEST_FALSE(runner, StringType_Equals(type, (Obj*)key_type),
+               "Equals() false with key => true");
+    TEST_TRUE(runner, StringType_Equals(key_type, clone),
+              "Dump => Load round trip with key");
+    TEST_TRUE(runner, StringType_Key(schema_clone)
+                      && StringType_Equals(key_type, (Obj*)schema_clone),
+              "Dump_For_Schema => Load round trip with key");
+
+    DECREF(schema_clone);
+    DECREF(schema_dump);
+    DECREF(clone);
+    DECREF(dump);
+    DECREF(key_type);
+    DECREF(type);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema   = Schema_new();
+    StringType *id_type  = StringType_new();
+    StringType *val_type = StringType_new();
+    String     *id_field  = Str_newf("id");
+    String     *alt_field = Str_newf("alt");
+    String     *val_field = Str_newf("val");
+    StringType_Set_Key(id_type, true);
+    Schema_Spec_Field(schema, id_field, (FieldType*)id_type);
+    Schema_Spec_Field(schema, alt_field, (FieldType*)val_type);
+    Schema_Spec_Field(schema, val_field, (FieldType*)val_type);
+    DECREF(val_field);
+    DECREF(alt_field);
+    DECREF(id_field);
+    DECREF(val_type);
+    DECREF(id_type);
+    return schema;
+}
+
+// Add docs with keys from `start` to `end`, or replace them if `key_field`
+// is supplied.  The "alt" field duplicates "id", but lacks a key filter.
+static void
+S_index_docs(Indexer *indexer, int32_t start, int32_t end, const char *val,
+             const char *key_field) {
+    String *id_field  = Str_newf("id");
+    String *alt_field = Str_newf("alt");
+    String *val_field = Str_newf("val");
+    for (int32_t i = start; i < end; i++) {
+        Doc    *doc   = Doc_new(NULL, 0);
+        String *key   = Str_newf("key%i32", i);
+        String *value = Str_newf(val);
+        Doc_Store(doc, id_field, (Obj*)key);
+        Doc_Store(doc, alt_field, (Obj*)key);
+        Doc_Store(doc, val_field, (Obj*)value);
+        DECREF(value);
+        DECREF(key);
+        if (key_field) {
+            String *field = Str_newf(key_field);
+            Indexer_Update_Doc(indexer, field, doc, 1.0f);
+            DECREF(field);
+        }
+        else {
+            Indexer_Add_Doc(indexer, doc, 1.0f);
+        }
+        DECREF(doc);
+    }
+    DECREF(val_field);
+    DECREF(alt_field);
+    DECREF(id_field);
+}
+
+static uint32_t
+S_count_hits(IndexSearcher *searcher, const char *field_name,
+             const char *value) {
+    String    *field = Str_newf(field_name);
+    String    *term  = Str_newf(value);
+    TermQuery *query = TermQuery_new(field, (Obj*)term);
+    TopDocs   *top_docs = IxSearcher_Top_Docs(searcher, (Query*)query, 10,
+                                              NULL);
+    uint32_t   num_hits = TopDocs_Get_Total_Hits(top_docs);
+    DECREF(top_docs);
+    DECREF(query);
+    DECREF(term);
+    DECREF(field);
+    return num_hits;
+}
+
+static void
+test_filters(TestBatchRunner *runner, RAMFolder *folder) {
+    String     *id_field    = Str_newf("id");
+    String     *val_field   = Str_newf("val");
+    PolyReader *reader      = PolyReader_open((Obj*)folder, NULL, NULL);
+    VArray     *seg_readers = PolyReader_Get_Seg_Readers(reader);
+    uint32_t    num_segs    = VA_Get_Size(seg_readers);
+    uint32_t    num_readers = 0;
+    uint32_t    num_missed  = 0;
+    uint32_t    num_false_positives = 0;
+    uint32_t    num_probes  = 0;
+    bool        other_field_passes = true;
+    bool        out_of_range_rejected = true;
+
+    for (uint32_t i = 0; i < num_segs; i++) {
+        SegReader *seg_reader = (SegReader*)VA_Fetch(seg_readers, i);
+        KeyFilterReader *filter
+            = (KeyFilterReader*)SegReader_Fetch(
+                  seg_reader, VTable_Get_Name(KEYFILTERREADER));
+        if (!filter) { continue; }
+        num_readers++;
+
+        for (int32_t key = 0; key < NUM_SEGS * DOCS_PER_SEG; key++) {
+            String *term = Str_newf("key%i32", key);
+            bool in_seg = key / DOCS_PER_SEG == (int32_t)i;
+            bool might  = KeyFilterReader_Might_Contain(filter, id_field,
+                                                        (Obj*)term);
+            if (in_seg && !might) { num_missed++; }
+            DECREF(term);
+        }
+        for (int32_t key = 0; key < 1000; key++) {
+            // Sorts between "key0" and "key99" so min/max can't help.
+            String *term = Str_newf("key1%i32x", key);
+            num_false_positives
+                += KeyFilterReader_Might_Contain(filter, id_field,
+                                                 (Obj*)term);
+            num_probes++;
+            DECREF(term);
+        }
+
+        String *absent = Str_newf("zzz");
+        if (KeyFilterReader_Might_Contain(filter, id_field, (Obj*)absent)) {
+            out_of_range_rejected = false;
+        }
+        if (!KeyFilterReader_Might_Contain(filter, val_field, (Obj*)absent)) {
+            other_field_passes = false;
+        }
+        DECREF(absent);
+    }
+
+    TEST_INT_EQ(runner, num_readers, num_segs,
+                "Every segment has a KeyFilterReader");
+    TEST_INT_EQ(runner, num_missed, 0,
+                "Might_Contain() true for every key in the segment");
+    TEST_TRUE(runner, num_false_positives * 20 < num_probes,
+              "Few false positives: %u32 of %u32", num_false_positives,
+              num_probes);
+    TEST_TRUE(runner, out_of_range_rejected,
+              "Might_Contain() false for key outside min/max");
+    TEST_TRUE(runner, other_field_passes,
+              "Might_Contain() true for field without key filter");
+
+    DECREF(reader);
+    DECREF(val_field);
+    DECREF(id_field);
+}
+
+static void
+test_Update_Doc(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+    Schema    *schema = S_create_schema();
+    const int32_t num_docs = NUM_SEGS * DOCS_PER_SEG;
+
+    for (int32_t i = 0; i < NUM_SEGS; i++) {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        S_index_docs(indexer, i * DOCS_PER_SEG, (i + 1) * DOCS_PER_SEG,
+                     "original", NULL);
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+    test_filters(runner, folder);
+
+    // Replace a few keys from each segment, plus some new ones.
+    {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        S_index_docs(indexer, 5, 10, "updated", "id");
+        S_index_docs(indexer, 390, 410, "updated", "id");
+        S_index_docs(indexer, num_docs, num_docs + 5, "updated", "id");
+        // Update one of those keys again before committing.
+        S_index_docs(indexer, 7, 8, "twice", "id");
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+    {
+        IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+        TEST_INT_EQ(runner, S_count_hits(searcher, "val", "updated"), 29,
+                    "Update_Doc() adds new docs");
+        TEST_INT_EQ(runner, S_count_hits(searcher, "val", "twice"), 1,
+                    "Second Update_Doc() in a session replaces the first");
+        TEST_INT_EQ(runner, S_count_hits(searcher, "val", "original"),
+                    num_docs - 25, "Update_Doc() deletes replaced docs");
+        TEST_INT_EQ(runner, S_count_hits(searcher, "id", "key7"), 1,
+                    "Only one doc per key after update");
+        DECREF(searcher);
+    }
+
+    // Replace keys again, this time while collapsing the index.
+    {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        S_index_docs(indexer, 0, 10, "again", "id");
+        Indexer_Optimize(indexer);
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+    {
+        IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+        TEST_INT_EQ(runner, S_count_hits(searcher, "val", "again"), 10,
+                    "Update_Doc() before Optimize() adds new docs");
+        TEST_INT_EQ(runner, S_count_hits(searcher, "val", "updated"), 25,
+                    "Update_Doc() before Optimize() deletes replaced docs");
+        TEST_INT_EQ(runner, IxSearcher_Doc_Max(searcher), num_docs + 5,
+                    "Replaced docs are purged by merge");
+        DECREF(searcher);
+    }
+    test_filters(runner, folder);
+
+    // Keys not present anywhere leave the index alone.
+    {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        String  *id_field = Str_newf("id");
+        String  *absent   = Str_newf("nope");
+        Indexer_Delete_By_Term(indexer, id_field, (Obj*)absent);
+        Indexer_Commit(indexer);
+        DECREF(absent);
+        DECREF(id_field);
+        DECREF(indexer);
+    }
+    {
+        IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+        TEST_INT_EQ(runner, S_count_hits(searcher, "val", "original"),
+                    num_docs - 30, "Deleting absent key changes nothing");
+        DECREF(searcher);
+    }
+
+    // Without a key filter, absent keys which sort between present ones
+    // must not stop the lookup of later keys.
+    {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        S_index_docs(indexer, 1000, 1004, "alt", "alt");
+        S_index_docs(indexer, 20, 26, "alt", "alt");
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+    {
+        IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+        TEST_INT_EQ(runner, S_count_hits(searcher, "val", "original"),
+                    num_docs - 36,
+                    "Update_Doc() on field without key filter");
+        DECREF(searcher);
+    }
+
+    DECREF(schema);
+    DECREF(folder);
+}
+
+void
+TestKeyFilter_Run_IMP(TestKeyFilter *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 22);
+    test_Dump_Load_and_Equals(runner);
+    test_Update_Doc(runner);
+}
+
@@ -0,0 +1,179 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_TESTLUCY_TESTNEARREALTIME
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestNearRealTime.h"
+#include "Lucy/Index/Indexer.h"
+
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Search/TopDocs.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestNearRealTime*
+TestNearRealTime_new() {
+    return (TestNearRealTime*)VTable_Make_Obj(TESTNEARREALTIME);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema = Schema_new();
+    StringType *type   = StringType_new();
+    String     *field  = Str_newf("id");
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+    DECREF(field);
+    DECREF(type);
+    return schema;
+}
+
+static void
+S_add_docs(Indexer *indexer, const char *prefix, int32_t count) {
+    String *field = Str_newf("id");
+    for (int32_t i = 0; i < count; i++) {
+        Doc    *doc = Doc_new(NULL, 0);
+        String *id  = Str_newf("%s%i32", prefix, i);
+        Doc_Store(doc, field, (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(doc);
+    }
+    DECREF(field);
+}
+
+static uint32_t
+S_count_hits(IndexReader *reader, const char *value) {
+    IndexSearcher *searcher = IxSearcher_new((Obj*)reader);
+    String    *field    = Str_newf("id");
+    String    *term     = Str_newf(value);
+    TermQuery *query    = TermQuery_new(field, (Obj*)term);
+    TopDocs   *top_docs = IxSearcher_Top_Docs(searcher, (Query*)query, 10,
+                                              NULL);
+    uint32_t   num_hits = TopDocs_Get_Total_Hits(top_docs);
+    DECREF(top_docs);
+    DECREF(query);
+    DECREF(term);
+    DECREF(field);
+    DECREF(searcher);
+    return num_hits;
+}
+
+static int32_t
+S_committed_doc_count(RAMFolder *folder) {
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    int32_t doc_count = PolyReader_Doc_Count(reader);
+    DECREF(reader);
+    return doc_count;
+}
+
+static void
+S_open_reader_without_flag(void *context) {
+    PolyReader *reader = Indexer_Open_Reader((Indexer*)context);
+    DECREF(reader);
+}
+
+static void
+test_Open_Reader(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+    Schema    *schema = S_create_schema();
+    String    *field  = Str_newf("id");
+
+    {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        S_add_docs(indexer, "old", 10);
+        Indexer_Commit(indexer);
+        Err *error = Err_trap(S_open_reader_without_flag, indexer);
+        TEST_TRUE(runner, error != NULL,
+                  "Open_Reader() requires NEAR_REAL_TIME");
+        DECREF(error);
+        DECREF(indexer);
+    }
+
+    Indexer *indexer = Indexer_new(NULL, (Obj*)folder, NULL,
+                                   Indexer_NEAR_REAL_TIME);
+    S_add_docs(indexer, "new", 5);
+    String *old1 = Str_newf("old1");
+    String *old2 = Str_newf("old2");
+    Indexer_Delete_By_Term(indexer, field, (Obj*)old1);
+    Indexer_Delete_By_Term(indexer, field, (Obj*)old2);
+
+    PolyReader *first = Indexer_Open_Reader(indexer);
+    TEST_INT_EQ(runner, PolyReader_Doc_Count(first), 13,
+                "Reader sees added docs and pending deletions");
+    TEST_TRUE(runner, S_count_hits((IndexReader*)first, "new3") == 1
+                      && S_count_hits((IndexReader*)first, "old1") == 0
+                      && S_count_hits((IndexReader*)first, "old3") == 1,
+              "Searches see uncommitted changes");
+    TEST_INT_EQ(runner, S_committed_doc_count(folder), 10,
+                "Open_Reader() doesn't commit");
+
+    S_add_docs(indexer, "more", 3);
+    {
+        // Replace a doc which an earlier reader has already seen, twice.
+        Doc    *doc = Doc_new(NULL, 0);
+        String *id  = Str_newf("new3");
+        Doc_Store(doc, field, (Obj*)id);
+        Indexer_Update_Doc(indexer, field, doc, 1.0f);
+        Indexer_Update_Doc(indexer, field, doc, 1.0f);
+        DECREF(id);
+        DECREF(doc);
+    }
+    PolyReader *second = Indexer_Open_Reader(indexer);
+    TEST_TRUE(runner, PolyReader_Doc_Count(second) == 16
+                      && PolyReader_Doc_Count(first) == 13
+                      && S_count_hits((IndexReader*)first, "more1") == 0,
+              "Reopening sees new docs; earlier reader unchanged");
+    TEST_INT_EQ(runner, S_count_hits((IndexReader*)second, "new3"), 1,
+                "Update_Doc() replaces docs buffered for near-real-time");
+
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    TEST_INT_EQ(runner, S_committed_doc_count(folder), 16,
+                "Commit() absorbs buffered docs");
+    TEST_INT_EQ(runner, S_count_hits((IndexReader*)second, "more2"), 1,
+                "Reader remains usable after Commit()");
+    {
+        PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+        TEST_TRUE(runner, S_count_hits((IndexReader*)reader, "new4") == 1
+                          && S_count_hits((IndexReader*)reader, "old2") == 0,
+                  "Committed index matches near-real-time view");
+        DECREF(reader);
+    }
+
+    DECREF(second);
+    DECREF(first);
+    DECREF(old2);
+    DECREF(old1);
+    DECREF(field);
+    DECREF(schema);
+    DECREF(folder);
+}
+
+void
+TestNearRealTime_Run_IMP(TestNearRealTime *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 9);
+    test_Open_Reader(runner);
+}
+
@@ -22,15 +22,129 @@
 #include "Lucy/Test.h"
 #include "Lucy/Test/Index/TestPostingListWriter.h"
 
+#include "Clownfish/CharBuf.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/Lexicon.h"
+#include "Lucy/Index/LexiconReader.h"
+#include "Lucy/Index/PostingList.h"
+#include "Lucy/Index/PostingListReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_WORDS 40
+#define NUM_DOCS  50
+
 TestPostingListWriter*
 TestPListWriter_new() {
     return (TestPostingListWriter*)VTable_Make_Obj(TESTPOSTINGLISTWRITER);
 }
 
+// Build a vocabulary where many terms share their first eight bytes, so that
+// PostingPool has to break prefix ties when sorting its cache.
+static String*
+S_make_word(uint32_t i) {
+    switch (i % 4) {
+        case 0:  return Str_newf("abcdefgh%u32", i);
+        case 1:  return Str_newf("abcdefgh%u32x", i);
+        case 2:  return Str_newf("ab%u32", i);
+        default: return Str_newf("z%u32", NUM_WORDS - i);
+    }
+}
+
+static void
+test_sorted_postings(TestBatchRunner *runner) {
+    Schema            *schema    = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType      *type      = FullTextType_new((Analyzer*)tokenizer);
+    String            *field     = Str_newf("content");
+    RAMFolder         *folder    = RAMFolder_new(NULL);
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+
+    // Every doc holds every word, in a different order each time.
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (uint32_t doc_num = 0; doc_num < NUM_DOCS; doc_num++) {
+        CharBuf *content = CB_new(0);
+        for (uint32_t i = 0; i < NUM_WORDS; i++) {
+            String *word = S_make_word((i * 7 + doc_num * 3) % NUM_WORDS);
+            CB_Cat(content, word);
+            CB_Cat_Trusted_Utf8(content, " ", 1);
+            DECREF(word);
+        }
+        String *content_str = CB_Yield_String(content);
+        Doc *doc = Doc_new(NULL, 0);
+        Doc_Store(doc, field, (Obj*)content_str);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+        DECREF(content_str);
+        DECREF(content);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    IndexReader *reader = IxReader_open((Obj*)folder, NULL, NULL);
+    VArray *seg_readers = IxReader_Seg_Readers(reader);
+    SegReader *seg_reader = (SegReader*)VA_Fetch(seg_readers, 0);
+    LexiconReader *lex_reader
+        = (LexiconReader*)SegReader_Fetch(seg_reader,
+                                          VTable_Get_Name(LEXICONREADER));
+    PostingListReader *plist_reader
+        = (PostingListReader*)SegReader_Fetch(
+              seg_reader, VTable_Get_Name(POSTINGLISTREADER));
+    Lexicon *lexicon = LexReader_Lexicon(lex_reader, field, NULL);
+
+    uint32_t  num_terms     = 0;
+    bool      terms_sorted  = true;
+    bool      doc_freqs_ok  = true;
+    bool      docs_sorted   = true;
+    String   *last_term     = NULL;
+    while (Lex_Next(lexicon)) {
+        String *term = (String*)Lex_Get_Term(lexicon);
+        if (last_term && Str_Compare_To(last_term, (Obj*)term) >= 0) {
+            terms_sorted = false;
+        }
+        if (Lex_Doc_Freq(lexicon) != NUM_DOCS) { doc_freqs_ok = false; }
+
+        PostingList *plist
+            = PListReader_Posting_List(plist_reader, field, (Obj*)term);
+        int32_t last_doc_id = 0;
+        int32_t doc_id;
+        while (0 != (doc_id = PList_Next(plist))) {
+            if (doc_id <= last_doc_id) { docs_sorted = false; }
+            last_doc_id = doc_id;
+        }
+        if (last_doc_id != NUM_DOCS) { docs_sorted = false; }
+        DECREF(plist);
+
+        DECREF(last_term);
+        last_term = Str_Clone(term);
+        num_terms++;
+    }
+
+    TEST_INT_EQ(runner, num_terms, NUM_WORDS, "All terms indexed");
+    TEST_TRUE(runner, terms_sorted, "Terms written in sorted order");
+    TEST_TRUE(runner, doc_freqs_ok, "Doc freqs correct");
+    TEST_TRUE(runner, docs_sorted, "Postings written in doc id order");
+
+    DECREF(last_term);
+    DECREF(lexicon);
+    DECREF(seg_readers);
+    DECREF(reader);
+    DECREF(folder);
+    DECREF(field);
+    DECREF(type);
+    DECREF(tokenizer);
+    DECREF(schema);
+}
+
 void
 TestPListWriter_Run_IMP(TestPostingListWriter *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 1);
-    PASS(runner, "Placeholder");
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 4);
+    test_sorted_postings(runner);
 }
 
 
@@ -0,0 +1,226 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTSORTWRITER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestSortWriter.h"
+#include "Lucy/Index/SortWriter.h"
+
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/DocReader.h"
+#include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SegWriter.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Plan/FieldType.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestSortWriter*
+TestSortWriter_new() {
+    return (TestSortWriter*)VTable_Make_Obj(TESTSORTWRITER);
+}
+
+static Schema*
+S_create_schema() {
+    Schema      *schema = Schema_new();
+    StringType  *url    = StringType_new();
+    Int32Type   *num    = Int32Type_new();
+    Float64Type *real   = Float64Type_new();
+    FType_Set_Sortable((FieldType*)url, true);
+    FType_Set_Sortable((FieldType*)num, true);
+    FType_Set_Sortable((FieldType*)real, true);
+    FType_Set_Indexed((FieldType*)num, false);
+    FType_Set_Indexed((FieldType*)real, false);
+    String *field = Str_newf("url");
+    Schema_Spec_Field(schema, field, (FieldType*)url);
+    DECREF(field);
+    field = Str_newf("num");
+    Schema_Spec_Field(schema, field, (FieldType*)num);
+    DECREF(field);
+    field = Str_newf("real");
+    Schema_Spec_Field(schema, field, (FieldType*)real);
+    DECREF(field);
+    DECREF(real);
+    DECREF(num);
+    DECREF(url);
+    return schema;
+}
+
+// URLs share a long prefix, so their keys tie often.  Numbers repeat, run
+// negative, and include both -0.0 and 0.0.  Some docs lack each field.
+static void
+S_add_docs(Indexer *indexer, int32_t start, int32_t end) {
+    String *url  = Str_newf("url");
+    String *num  = Str_newf("num");
+    String *real = Str_newf("real");
+    for (int32_t i = start; i < end; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        int32_t scrambled = (i * 7919) % 1000;
+        if (i % 17) {
+            String *url_value
+                = Str_newf("http://example.com/page/%i32", scrambled);
+            Doc_Store(doc, url, (Obj*)url_value);
+            DECREF(url_value);
+        }
+        if (i % 13) {
+            Integer32 *num_value = Int32_new(scrambled % 50 - 25);
+            Doc_Store(doc, num, (Obj*)num_value);
+            DECREF(num_value);
+        }
+        if (i % 11) {
+            double value = (scrambled % 9) * 0.5 - 2.0;
+            if (value == 0.0 && i % 2) { value = -0.0; }
+            Float64 *real_value = Float64_new(value);
+            Doc_Store(doc, real, (Obj*)real_value);
+            DECREF(real_value);
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    DECREF(real);
+    DECREF(num);
+    DECREF(url);
+}
+
+// Verify that every live doc's ordinal leads to its stored value, that
+// docs without a value get the NULL ordinal, and that values ascend with
+// ordinals.
+static bool
+S_check_field(IndexReader *reader, Schema *schema, const char *name) {
+    String    *field   = Str_newf(name);
+    FieldType *type    = Schema_Fetch_Type(schema, field);
+    VArray    *readers = IxReader_Seg_Readers(reader);
+    bool       ok      = VA_Get_Size(readers) > 0;
+
+    for (uint32_t i = 0, max = VA_Get_Size(readers); ok && i < max; i++) {
+        SegReader *seg_reader = (SegReader*)VA_Fetch(readers, i);
+        SortReader *sort_reader = (SortReader*)SegReader_Fetch(
+                                      seg_reader, VTable_Get_Name(SORTREADER));
+        DocReader *doc_reader = (DocReader*)SegReader_Fetch(
+                                    seg_reader, VTable_Get_Name(DOCREADER));
+        SortCache *cache = SortReader_Fetch_Sort_Cache(sort_reader, field);
+        int32_t null_ord = SortCache_Get_Null_Ord(cache);
+
+        for (int32_t doc_id = 1, doc_max = SegReader_Doc_Max(seg_reader);
+             ok && doc_id <= doc_max;
+             doc_id++
+            ) {
+            HitDoc *hit_doc  = DocReader_Fetch_Doc(doc_reader, doc_id);
+            Obj    *expected = HitDoc_Extract(hit_doc, field);
+            int32_t ord      = SortCache_Ordinal(cache, doc_id);
+            Obj    *value    = SortCache_Value(cache, ord);
+            if (!expected) {
+                ok = ord == null_ord && value == NULL;
+            }
+            else {
+                ok = value != NULL
+                     && FType_Compare_Values(type, expected, value) == 0;
+            }
+            DECREF(value);
+            DECREF(hit_doc);
+        }
+
+        Obj *prev = NULL;
+        for (int32_t ord = 0, card = SortCache_Get_Cardinality(cache);
+             ok && ord < card;
+             ord++
+            ) {
+            Obj *value = SortCache_Value(cache, ord);
+            if (value && prev) {
+                ok = FType_Compare_Values(type, prev, value) < 0;
+            }
+            DECREF(prev);
+            prev = value;
+        }
+        DECREF(prev);
+    }
+
+    DECREF(field);
+    return ok;
+}
+
+static bool
+S_check_fields(Folder *folder, Schema *schema) {
+    IndexReader *reader = IxReader_open((Obj*)folder, NULL, NULL);
+    bool ok = S_check_field(reader, schema, "url")
+              && S_check_field(reader, schema, "num")
+              && S_check_field(reader, schema, "real");
+    DECREF(reader);
+    return ok;
+}
+
+static void
+test_flushed_runs(TestBatchRunner *runner, Folder *folder, Schema *schema) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    S_add_docs(indexer, 0, 300);
+    Indexer_Prepare_Commit(indexer);
+    SegWriter  *seg_writer  = Indexer_Get_Seg_Writer(indexer);
+    SortWriter *sort_writer = (SortWriter*)SegWriter_Fetch(
+                                  seg_writer, VTable_Get_Name(SORTWRITER));
+    TEST_TRUE(runner, SortWriter_Get_Num_Spills(sort_writer) > 3
+                      && SortWriter_Get_Bytes_Spilled(sort_writer) > 0,
+              "Spills are accounted for");
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    TEST_TRUE(runner, S_check_fields(folder, schema),
+              "Sort caches correct after merging spilled runs");
+}
+
+static void
+test_merged_segments(TestBatchRunner *runner, Folder *folder,
+                     Schema *schema) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    S_add_docs(indexer, 300, 400);
+    String *field = Str_newf("url");
+    for (int32_t i = 0; i < 1000; i += 7) {
+        String *url = Str_newf("http://example.com/page/%i32", i);
+        Indexer_Delete_By_Term(indexer, field, (Obj*)url);
+        DECREF(url);
+    }
+    DECREF(field);
+    Indexer_Optimize(indexer);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    TEST_TRUE(runner, S_check_fields(folder, schema),
+              "Sort caches correct after merging segments with deletions");
+}
+
+void
+TestSortWriter_Run_IMP(TestSortWriter *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 3);
+
+    // Force frequent flushes.
+    SortWriter_set_default_mem_thresh(100);
+    Schema    *schema = S_create_schema();
+    RAMFolder *folder = RAMFolder_new(NULL);
+    test_flushed_runs(runner, (Folder*)folder, schema);
+    test_merged_segments(runner, (Folder*)folder, schema);
+    DECREF(folder);
+    DECREF(schema);
+    SortWriter_set_default_mem_thresh(0x400000);
+}
@@ -42,6 +42,7 @@ test_Dump_Load_and_Equals(TestBatchRunner *runner) {
     FullTextType      *not_indexed   = FullTextType_new((Analyzer*)tokenizer);
     FullTextType      *not_stored    = FullTextType_new((Analyzer*)tokenizer);
     FullTextType      *highlightable = FullTextType_new((Analyzer*)tokenizer);
+    FullTextType      *impacts       = FullTextType_new((Analyzer*)tokenizer);
     Obj               *dump          = (Obj*)FullTextType_Dump(type);
     Obj               *clone         = Freezer_load(dump);
     Obj               *another_dump  = (Obj*)FullTextType_Dump_For_Schema(type);
@@ -50,6 +51,9 @@ test_Dump_Load_and_Equals(TestBatchRunner *runner) {
     FullTextType_Set_Indexed(not_indexed, false);
     FullTextType_Set_Stored(not_stored, false);
     FullTextType_Set_Highlightable(highlightable, true);
+    FullTextType_Set_Impacts(impacts, true);
+    Obj *impacts_dump  = (Obj*)FullTextType_Dump(impacts);
+    Obj *impacts_clone = Freezer_load(impacts_dump);
 
     // (This step is normally performed by Schema_Load() internally.)
     Hash_Store_Utf8((Hash*)another_dump, "analyzer", 8, INCREF(tokenizer));
@@ -65,6 +69,10 @@ test_Dump_Load_and_Equals(TestBatchRunner *runner) {
                "Equals() false with stored => false");
     TEST_FALSE(runner, FullTextType_Equals(type, (Obj*)highlightable),
                "Equals() false with highlightable => true");
+    TEST_FALSE(runner, FullTextType_Equals(type, (Obj*)impacts),
+               "Equals() false with impacts => true");
+    TEST_TRUE(runner, FullTextType_Equals(impacts, (Obj*)impacts_clone),
+              "Dump => Load round trip with impacts");
     TEST_TRUE(runner, FullTextType_Equals(type, (Obj*)clone),
               "Dump => Load round trip");
     TEST_TRUE(runner, FullTextType_Equals(type, (Obj*)another_clone),
@@ -74,6 +82,9 @@ test_Dump_Load_and_Equals(TestBatchRunner *runner) {
     DECREF(dump);
     DECREF(clone);
     DECREF(another_dump);
+    DECREF(impacts_clone);
+    DECREF(impacts_dump);
+    DECREF(impacts);
     DECREF(highlightable);
     DECREF(not_stored);
     DECREF(not_indexed);
@@ -107,7 +118,7 @@ test_Compare_Values(TestBatchRunner *runner) {
 
 void
 TestFullTextType_Run_IMP(TestFullTextType *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 10);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 12);
     test_Dump_Load_and_Equals(runner);
     test_Compare_Values(runner);
 }
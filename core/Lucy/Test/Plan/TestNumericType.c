@@ -94,6 +94,20 @@ test_Dump_Load_and_Equals(TestBatchRunner *runner) {
         DECREF(other);
     }
 
+    {
+        Float64Type *points_f64 = Float64Type_new();
+        Float64Type_Set_Points(points_f64, true);
+        TEST_FALSE(runner, Float64Type_Equals(f64, (Obj*)points_f64),
+                   "Float64Type_Equals() false with different points");
+        Obj *dump = (Obj*)Float64Type_Dump(points_f64);
+        Obj *other = Freezer_load(dump);
+        TEST_TRUE(runner, Float64Type_Equals(points_f64, other),
+                  "Dump => Load round trip preserves points");
+        DECREF(dump);
+        DECREF(other);
+        DECREF(points_f64);
+    }
+
     DECREF(i32);
     DECREF(i64);
     DECREF(f32);
@@ -102,7 +116,7 @@ test_Dump_Load_and_Equals(TestBatchRunner *runner) {
 
 void
 TestNumericType_Run_IMP(TestNumericType *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 12);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 14);
     test_Dump_Load_and_Equals(runner);
 }
 
@@ -0,0 +1,335 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTAGGREGATECOLLECTOR
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+#include <math.h>
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestAggregateCollector.h"
+#include "Lucy/Search/Collector/AggregateCollector.h"
+
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Collector/FacetCollector.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchAllQuery.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFile.h"
+#include "Lucy/Store/RAMFolder.h"
+#include "Lucy/Util/Freezer.h"
+
+TestAggregateCollector*
+TestAggColl_new() {
+    return (TestAggregateCollector*)VTable_Make_Obj(TESTAGGREGATECOLLECTOR);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema   = Schema_new();
+    StringType *category = StringType_new();
+    StringType *user     = StringType_new();
+    Int32Type  *price    = Int32Type_new();
+    FType_Set_Sortable((FieldType*)category, true);
+    FType_Set_Sortable((FieldType*)user, true);
+    FType_Set_Sortable((FieldType*)price, true);
+    FType_Set_Indexed((FieldType*)price, false);
+    String *field = Str_newf("category");
+    Schema_Spec_Field(schema, field, (FieldType*)category);
+    DECREF(field);
+    field = Str_newf("user");
+    Schema_Spec_Field(schema, field, (FieldType*)user);
+    DECREF(field);
+    field = Str_newf("price");
+    Schema_Spec_Field(schema, field, (FieldType*)price);
+    DECREF(field);
+    DECREF(price);
+    DECREF(user);
+    DECREF(category);
+    return schema;
+}
+
+// Docs numbered `start` through `end`.  The price is the doc number, except
+// that every tenth doc has none.  Users repeat every 1500 docs.
+static RAMFolder*
+S_create_index(Schema *schema, int32_t start, int32_t end) {
+    RAMFolder *folder   = RAMFolder_new(NULL);
+    Indexer   *indexer  = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    String    *category = Str_newf("category");
+    String    *user     = Str_newf("user");
+    String    *price    = Str_newf("price");
+    for (int32_t i = start; i <= end; i++) {
+        Doc    *doc        = Doc_new(NULL, 0);
+        String *cat_value  = Str_newf(i % 2 ? "odd" : "even");
+        String *user_value = Str_newf("user%i32", i % 1500);
+        Doc_Store(doc, category, (Obj*)cat_value);
+        Doc_Store(doc, user, (Obj*)user_value);
+        DECREF(user_value);
+        DECREF(cat_value);
+        if (i % 10) {
+            Integer32 *price_value = Int32_new(i);
+            Doc_Store(doc, price, (Obj*)price_value);
+            DECREF(price_value);
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(price);
+    DECREF(user);
+    DECREF(category);
+    DECREF(indexer);
+    return folder;
+}
+
+static void
+S_collect_all(RAMFolder *folder, Collector *collector) {
+    IndexSearcher *searcher  = IxSearcher_new((Obj*)folder);
+    MatchAllQuery *match_all = MatchAllQuery_new();
+    IxSearcher_Collect(searcher, (Query*)match_all, collector);
+    DECREF(match_all);
+    DECREF(searcher);
+}
+
+// Simulate shipping a partial result from a remote shard.
+static Obj*
+S_freeze_thaw(Obj *object) {
+    RAMFile *ram_file = RAMFile_new(NULL, false);
+    OutStream *outstream = OutStream_open((Obj*)ram_file);
+    FREEZE(object, outstream);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+
+    InStream *instream = InStream_open((Obj*)ram_file);
+    Obj *retval = THAW(instream);
+    DECREF(instream);
+    DECREF(ram_file);
+    return retval;
+}
+
+static void
+test_stats(TestBatchRunner *runner, RAMFolder *shard_a, RAMFolder *shard_b) {
+    String *price = Str_newf("price");
+
+    StatsCollector *stats = StatsColl_new(price);
+    S_collect_all(shard_a, (Collector*)stats);
+    TEST_TRUE(runner, StatsColl_Get_Count(stats) == 900
+                      && StatsColl_Get_Sum(stats) == 450000.0
+                      && StatsColl_Get_Min(stats) == 1.0
+                      && StatsColl_Get_Max(stats) == 999.0
+                      && StatsColl_Get_Mean(stats) == 500.0
+                      && StatsColl_Get_Num_Missing(stats) == 100,
+              "StatsCollector");
+
+    StatsCollector *remote = StatsColl_new(price);
+    S_collect_all(shard_b, (Collector*)remote);
+    StatsCollector *thawed = (StatsCollector*)S_freeze_thaw((Obj*)remote);
+    StatsColl_Merge(stats, (AggregateCollector*)thawed);
+    TEST_TRUE(runner, StatsColl_Get_Count(stats) == 1800
+                      && StatsColl_Get_Sum(stats) == 1800000.0
+                      && StatsColl_Get_Min(stats) == 1.0
+                      && StatsColl_Get_Max(stats) == 1999.0
+                      && StatsColl_Get_Num_Missing(stats) == 200,
+              "Merge StatsCollector thawed from another shard");
+
+    DECREF(thawed);
+    DECREF(remote);
+    DECREF(stats);
+    DECREF(price);
+}
+
+static void
+test_histogram(TestBatchRunner *runner, RAMFolder *shard_a,
+               RAMFolder *shard_b) {
+    String *price = Str_newf("price");
+
+    HistogramCollector *histo  = HistoColl_new(price, 500.0, 0.0);
+    HistogramCollector *remote = HistoColl_new(price, 500.0, 0.0);
+    S_collect_all(shard_a, (Collector*)histo);
+    S_collect_all(shard_b, (Collector*)remote);
+    HistogramCollector *thawed
+        = (HistogramCollector*)S_freeze_thaw((Obj*)remote);
+    HistoColl_Merge(histo, (AggregateCollector*)thawed);
+
+    VArray *buckets = HistoColl_Get_Buckets(histo);
+    bool buckets_ok = VA_Get_Size(buckets) == 4;
+    for (uint32_t i = 0; buckets_ok && i < 4; i++) {
+        double start = Obj_To_F64(VA_Fetch(buckets, i));
+        if (start != i * 500.0 || HistoColl_Count(histo, start) != 450) {
+            buckets_ok = false;
+        }
+    }
+    TEST_TRUE(runner, buckets_ok, "HistogramCollector buckets");
+    TEST_TRUE(runner, HistoColl_Count(histo, 1234.5) == 450
+                      && HistoColl_Count(histo, 2500.0) == 0,
+              "Count() finds the bucket holding a value");
+
+    DECREF(buckets);
+    DECREF(thawed);
+    DECREF(remote);
+    DECREF(histo);
+    DECREF(price);
+}
+
+static bool
+S_close_enough(int64_t estimate, int64_t actual) {
+    return fabs((double)(estimate - actual)) <= actual * 0.02;
+}
+
+static void
+test_cardinality(TestBatchRunner *runner, RAMFolder *shard_a,
+                 RAMFolder *shard_b) {
+    String *user = Str_newf("user");
+
+    CardinalityCollector *card   = CardColl_new(user);
+    CardinalityCollector *remote = CardColl_new(user);
+    S_collect_all(shard_a, (Collector*)card);
+    S_collect_all(shard_b, (Collector*)remote);
+    TEST_TRUE(runner, S_close_enough(CardColl_Estimate(card), 1000),
+              "CardinalityCollector estimate");
+
+    CardinalityCollector *thawed
+        = (CardinalityCollector*)S_freeze_thaw((Obj*)remote);
+    CardColl_Merge(card, (AggregateCollector*)thawed);
+    TEST_TRUE(runner, S_close_enough(CardColl_Estimate(card), 1500),
+              "Merged sketches count shared values once");
+
+    DECREF(thawed);
+    DECREF(remote);
+    DECREF(card);
+    DECREF(user);
+}
+
+static void
+test_facet_merge(TestBatchRunner *runner, RAMFolder *shard_a,
+                 RAMFolder *shard_b) {
+    String *category = Str_newf("category");
+    String *odd      = Str_newf("odd");
+
+    FacetCollector *facets = FacetColl_new(category);
+    FacetCollector *remote = FacetColl_new(category);
+    S_collect_all(shard_a, (Collector*)facets);
+    S_collect_all(shard_b, (Collector*)remote);
+    FacetCollector *thawed = (FacetCollector*)S_freeze_thaw((Obj*)remote);
+    FacetColl_Merge(facets, (AggregateCollector*)thawed);
+    TEST_INT_EQ(runner, FacetColl_Count(facets, (Obj*)odd), 1000,
+                "Merge FacetCollector thawed from another shard");
+
+    DECREF(thawed);
+    DECREF(remote);
+    DECREF(facets);
+    DECREF(odd);
+    DECREF(category);
+}
+
+static void
+S_merge_mismatched_class(void *context) {
+    String *price = (String*)context;
+    StatsCollector *stats = StatsColl_new(price);
+    CardinalityCollector *card = CardColl_new(price);
+    StatsColl_Merge(stats, (AggregateCollector*)card);
+    DECREF(card);
+    DECREF(stats);
+}
+
+static void
+S_merge_into_histogram(void *context) {
+    String *price = (String*)context;
+    HistogramCollector *histo = HistoColl_new(price, 500.0, 0.0);
+    StatsCollector *stats = StatsColl_new(price);
+    HistoColl_Merge(histo, (AggregateCollector*)stats);
+    DECREF(stats);
+    DECREF(histo);
+}
+
+static void
+S_merge_into_range_facets(void *context) {
+    String *price = (String*)context;
+    VArray *bounds = VA_new(1);
+    VA_Push(bounds, (Obj*)Int32_new(500));
+    RangeFacetCollector *ranges = RangeFacetColl_new(price, bounds);
+    StatsCollector *stats = StatsColl_new(price);
+    RangeFacetColl_Merge(ranges, (AggregateCollector*)stats);
+    DECREF(stats);
+    DECREF(ranges);
+    DECREF(bounds);
+}
+
+static void
+S_merge_mismatched_field(void *context) {
+    String *price = (String*)context;
+    String *other = Str_newf("other");
+    StatsCollector *stats = StatsColl_new(price);
+    StatsCollector *other_stats = StatsColl_new(other);
+    StatsColl_Merge(stats, (AggregateCollector*)other_stats);
+    DECREF(other_stats);
+    DECREF(stats);
+    DECREF(other);
+}
+
+static void
+S_stats_on_text(void *context) {
+    String *category = Str_newf("category");
+    StatsCollector *stats = StatsColl_new(category);
+    S_collect_all((RAMFolder*)context, (Collector*)stats);
+    DECREF(stats);
+    DECREF(category);
+}
+
+static void
+test_errors(TestBatchRunner *runner, RAMFolder *shard_a) {
+    String *price = Str_newf("price");
+    Err *error = Err_trap(S_merge_mismatched_class, price);
+    TEST_TRUE(runner, error != NULL, "Merge() rejects another class");
+    DECREF(error);
+    error = Err_trap(S_merge_into_histogram, price);
+    TEST_TRUE(runner, error != NULL,
+              "HistogramCollector Merge() rejects another class");
+    DECREF(error);
+    error = Err_trap(S_merge_into_range_facets, price);
+    TEST_TRUE(runner, error != NULL,
+              "RangeFacetCollector Merge() rejects another class");
+    DECREF(error);
+    error = Err_trap(S_merge_mismatched_field, price);
+    TEST_TRUE(runner, error != NULL, "Merge() rejects another field");
+    DECREF(error);
+    error = Err_trap(S_stats_on_text, shard_a);
+    TEST_TRUE(runner, error != NULL, "StatsCollector requires numbers");
+    DECREF(error);
+    DECREF(price);
+}
+
+void
+TestAggColl_Run_IMP(TestAggregateCollector *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 12);
+    Schema    *schema  = S_create_schema();
+    RAMFolder *shard_a = S_create_index(schema, 1, 1000);
+    RAMFolder *shard_b = S_create_index(schema, 1001, 2000);
+    test_stats(runner, shard_a, shard_b);
+    test_histogram(runner, shard_a, shard_b);
+    test_cardinality(runner, shard_a, shard_b);
+    test_facet_merge(runner, shard_a, shard_b);
+    test_errors(runner, shard_a);
+    DECREF(shard_b);
+    DECREF(shard_a);
+    DECREF(schema);
+}
@@ -0,0 +1,467 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTBOXQUERY
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+#include <math.h>
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/TestUtils.h"
+#include "Lucy/Test/Search/TestBoxQuery.h"
+#include "Lucy/Search/BoxQuery.h"
+
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PointWriter.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/RangeQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+// Enough docs to spread the first segment across several leaves.
+#define NUM_DOCS     1500
+#define FIRST_COMMIT 1000
+
+#define NUM_BIG_DOCS 600
+
+TestBoxQuery*
+TestBoxQuery_new() {
+    return (TestBoxQuery*)VTable_Make_Obj(TESTBOXQUERY);
+}
+
+static BoxQuery*
+S_make_box_query(const char *field, Obj *lower, Obj *upper) {
+    VArray *fields       = VA_new(1);
+    VArray *lower_bounds = VA_new(1);
+    VArray *upper_bounds = VA_new(1);
+    VA_Push(fields, (Obj*)Str_newf(field));
+    VA_Store(lower_bounds, 0, lower);
+    VA_Store(upper_bounds, 0, upper);
+    BoxQuery *query = BoxQuery_new(fields, lower_bounds, upper_bounds);
+    DECREF(fields);
+    DECREF(lower_bounds);
+    DECREF(upper_bounds);
+    return query;
+}
+
+static void
+test_Dump_Load_and_Equals(TestBatchRunner *runner) {
+    BoxQuery *query
+        = S_make_box_query("x", (Obj*)Float64_new(1.5), NULL);
+    BoxQuery *field_differs
+        = S_make_box_query("y", (Obj*)Float64_new(1.5), NULL);
+    BoxQuery *bounds_differ
+        = S_make_box_query("x", NULL, (Obj*)Float64_new(1.5));
+    Obj      *dump  = (Obj*)BoxQuery_Dump(query);
+    BoxQuery *clone = (BoxQuery*)BoxQuery_Load(field_differs, dump);
+
+    TEST_FALSE(runner, BoxQuery_Equals(query, (Obj*)field_differs),
+               "Equals() false with different field");
+    TEST_FALSE(runner, BoxQuery_Equals(query, (Obj*)bounds_differ),
+               "Equals() false with different bounds");
+    TEST_TRUE(runner, BoxQuery_Equals(query, (Obj*)clone),
+              "Dump => Load round trip");
+
+    DECREF(query);
+    DECREF(field_differs);
+    DECREF(bounds_differ);
+    DECREF(dump);
+    DECREF(clone);
+}
+
+// Values for doc number `i`: x is missing from every eleventh doc and y
+// from every thirteenth.
+static bool
+S_value(int32_t i, int dim, double *value) {
+    if (dim == 0) {
+        *value = ((i * 37) % 1000) / 10.0;
+        return i % 11 != 5;
+    }
+    else {
+        *value = (double)((i * 91) % 500 - 250);
+        return i % 13 != 7;
+    }
+}
+
+typedef struct {
+    const char *label;
+    bool        use[2];
+    double      lower[2];
+    double      upper[2];
+} Box;
+
+static bool
+S_in_box(const Box *box, double *values, bool *present) {
+    for (int dim = 0; dim < 2; dim++) {
+        if (!box->use[dim]) { continue; }
+        if (!present[dim])  { return false; }
+        if (values[dim] < box->lower[dim] || values[dim] > box->upper[dim]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+S_deleted(int32_t i) {
+    double value;
+    return S_value(i, 1, &value) && value >= 0.0 && value <= 10.0;
+}
+
+static BoxQuery*
+S_box_to_query(const Box *box) {
+    static const char *names[2] = { "x", "y" };
+    VArray *fields       = VA_new(2);
+    VArray *lower_bounds = VA_new(2);
+    VArray *upper_bounds = VA_new(2);
+    for (int dim = 0; dim < 2; dim++) {
+        if (!box->use[dim]) { continue; }
+        uint32_t tick = VA_Get_Size(fields);
+        VA_Push(fields, (Obj*)Str_newf(names[dim]));
+        if (box->lower[dim] != -INFINITY) {
+            VA_Store(lower_bounds, tick, (Obj*)Float64_new(box->lower[dim]));
+        }
+        if (box->upper[dim] != INFINITY) {
+            VA_Store(upper_bounds, tick, (Obj*)Float64_new(box->upper[dim]));
+        }
+    }
+    BoxQuery *query = BoxQuery_new(fields, lower_bounds, upper_bounds);
+    DECREF(fields);
+    DECREF(lower_bounds);
+    DECREF(upper_bounds);
+    return query;
+}
+
+// Run `query` and verify that it matches exactly the live docs inside `box`.
+static bool
+S_check(IndexSearcher *searcher, Query *query, const Box *box,
+        bool deletions) {
+    static const char *names[2] = { "x", "y" };
+    int32_t expected = 0;
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        double values[2];
+        bool   present[2];
+        present[0] = S_value(i, 0, &values[0]);
+        present[1] = S_value(i, 1, &values[1]);
+        if (deletions && S_deleted(i)) { continue; }
+        if (S_in_box(box, values, present)) { expected++; }
+    }
+
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, NUM_DOCS, NULL);
+    bool  ok   = Hits_Total_Hits(hits) == (uint32_t)expected;
+    HitDoc *hit_doc;
+    while (ok && NULL != (hit_doc = Hits_Next(hits))) {
+        double values[2];
+        bool   present[2];
+        for (int dim = 0; dim < 2; dim++) {
+            String *name  = Str_newf(names[dim]);
+            Obj    *value = HitDoc_Extract(hit_doc, name);
+            present[dim] = value != NULL;
+            values[dim]  = value ? Obj_To_F64(value) : 0.0;
+            DECREF(value);
+            DECREF(name);
+        }
+        if (!S_in_box(box, values, present)) { ok = false; }
+        DECREF(hit_doc);
+    }
+    DECREF(hits);
+    return ok;
+}
+
+static void
+S_check_boxes(TestBatchRunner *runner, RAMFolder *folder, bool deletions,
+              const char *stage) {
+    static const Box boxes[] = {
+        { "2-d box",       { true, true },   { 10.0, -100.0 }, { 40.0, 100.0 } },
+        { "x upper only",  { true, false },  { -INFINITY, 0 }, { 5.5, 0 } },
+        { "y lower only",  { false, true },  { 0, 200.0 },     { 0, INFINITY } },
+        { "all values",    { true, true },   { 0.0, -250.0 },  { 99.9, 249.0 } },
+        { "single point",  { true, true },   { 3.7, -250.0 },  { 3.7, 250.0 } },
+        { "empty",         { true, false },  { 50.0, 0 },      { 49.0, 0 } },
+    };
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+
+    for (uint32_t b = 0; b < sizeof(boxes) / sizeof(boxes[0]); b++) {
+        BoxQuery *query = S_box_to_query(&boxes[b]);
+        TEST_TRUE(runner, S_check(searcher, (Query*)query, &boxes[b],
+                                  deletions),
+                  "BoxQuery %s, %s", boxes[b].label, stage);
+        DECREF(query);
+    }
+
+    // RangeQuery on a point field uses the point index, with exclusive
+    // bounds nudged inwards.
+    String  *field = Str_newf("x");
+    Float64 *lower = Float64_new(10.0);
+    Float64 *upper = Float64_new(40.0);
+    RangeQuery *range_query = RangeQuery_new(field, (Obj*)lower,
+                                             (Obj*)upper, false, false);
+    Box range_box = { "", { true, false },
+                      { nextafter(10.0, INFINITY), 0 },
+                      { nextafter(40.0, -INFINITY), 0 } };
+    TEST_TRUE(runner, S_check(searcher, (Query*)range_query, &range_box,
+                              deletions),
+              "RangeQuery on point field, %s", stage);
+    DECREF(range_query);
+    DECREF(upper);
+    DECREF(lower);
+    DECREF(field);
+
+    DECREF(searcher);
+}
+
+static void
+S_add_docs(RAMFolder *folder, Schema *schema, int32_t start, int32_t end) {
+    String  *x_field = Str_newf("x");
+    String  *y_field = Str_newf("y");
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t i = start; i < end; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        double value;
+        if (S_value(i, 0, &value)) {
+            Float64 *x = Float64_new(value);
+            Doc_Store(doc, x_field, (Obj*)x);
+            DECREF(x);
+        }
+        if (S_value(i, 1, &value)) {
+            Integer32 *y = Int32_new((int32_t)value);
+            Doc_Store(doc, y_field, (Obj*)y);
+            DECREF(y);
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(y_field);
+    DECREF(x_field);
+}
+
+static void
+test_point_index(TestBatchRunner *runner) {
+    Schema      *schema = Schema_new();
+    Float64Type *x_type = Float64Type_new();
+    Int32Type   *y_type = Int32Type_new();
+    RAMFolder   *folder = RAMFolder_new(NULL);
+    String      *x_field = Str_newf("x");
+    String      *y_field = Str_newf("y");
+    Float64Type_Set_Indexed(x_type, false);
+    Int32Type_Set_Indexed(y_type, false);
+    Float64Type_Set_Points(x_type, true);
+    Int32Type_Set_Points(y_type, true);
+    Schema_Spec_Field(schema, x_field, (FieldType*)x_type);
+    Schema_Spec_Field(schema, y_field, (FieldType*)y_type);
+
+    S_add_docs(folder, schema, 0, FIRST_COMMIT);
+    S_add_docs(folder, schema, FIRST_COMMIT, NUM_DOCS);
+    S_check_boxes(runner, folder, false, "two segments");
+
+    {
+        Indexer  *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        BoxQuery *query
+            = S_make_box_query("y", (Obj*)Float64_new(0.0),
+                               (Obj*)Float64_new(10.0));
+        Indexer_Delete_By_Query(indexer, (Query*)query);
+        Indexer_Commit(indexer);
+        DECREF(query);
+        DECREF(indexer);
+    }
+    S_check_boxes(runner, folder, true, "with deletions");
+
+    {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        Indexer_Optimize(indexer);
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+    S_check_boxes(runner, folder, true, "after merge");
+
+    DECREF(y_field);
+    DECREF(x_field);
+    DECREF(folder);
+    DECREF(y_type);
+    DECREF(x_type);
+    DECREF(schema);
+}
+
+// Values close together near 2^53 and near the ends of the int64 range,
+// where doubles can't tell neighbours apart.
+static int64_t
+S_big_value(int32_t i) {
+    switch (i % 3) {
+        case 0:  return INT64_C(9007199254740992) + i;
+        case 1:  return INT64_MIN + i;
+        default: return INT64_MAX - i;
+    }
+}
+
+typedef struct {
+    const char *label;
+    bool        has_lower;
+    int64_t     lower;
+    bool        include_lower;
+    bool        has_upper;
+    int64_t     upper;
+    bool        include_upper;
+} BigRange;
+
+static uint32_t
+S_count_big(const BigRange *range) {
+    uint32_t count = 0;
+    for (int32_t i = 0; i < NUM_BIG_DOCS; i++) {
+        int64_t value = S_big_value(i);
+        if (range->has_lower
+            && (range->include_lower ? value < range->lower
+                                     : value <= range->lower)
+           ) {
+            continue;
+        }
+        if (range->has_upper
+            && (range->include_upper ? value > range->upper
+                                     : value >= range->upper)
+           ) {
+            continue;
+        }
+        count++;
+    }
+    return count;
+}
+
+static void
+S_check_big(TestBatchRunner *runner, RAMFolder *folder, const char *stage) {
+    static const BigRange ranges[] = {
+        { "inclusive range above 2^53",
+          true, INT64_C(9007199254740992) + 10, true,
+          true, INT64_C(9007199254740992) + 20, true },
+        { "exclusive range above 2^53",
+          true, INT64_C(9007199254740992) + 9, false,
+          true, INT64_C(9007199254740992) + 21, false },
+        { "single value above 2^53",
+          true, INT64_C(9007199254740992) + 3, true,
+          true, INT64_C(9007199254740992) + 3, true },
+        { "upper bound near INT64_MIN",
+          false, 0, false, true, INT64_MIN + 30, true },
+        { "exclusive lower bound near INT64_MAX",
+          true, INT64_MAX - 30, false, false, 0, false },
+    };
+    String        *field    = Str_newf("big");
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+
+    for (uint32_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        const BigRange *range = &ranges[r];
+        Obj *lower = range->has_lower ? (Obj*)Int64_new(range->lower) : NULL;
+        Obj *upper = range->has_upper ? (Obj*)Int64_new(range->upper) : NULL;
+        RangeQuery *query = RangeQuery_new(field, lower, upper,
+                                           range->include_lower,
+                                           range->include_upper);
+        Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+        TEST_INT_EQ(runner, Hits_Total_Hits(hits), S_count_big(range),
+                    "RangeQuery %s, %s", range->label, stage);
+        DECREF(hits);
+        DECREF(query);
+        DECREF(upper);
+        DECREF(lower);
+    }
+
+    {
+        // A fractional bound on an integer field rounds inwards.
+        RangeQuery *query
+            = RangeQuery_new(field, (Obj*)Float64_new(-0.5),
+                             (Obj*)Float64_new(1e300), false, true);
+        Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+        BigRange range = { "", true, 0, true, false, 0, false };
+        TEST_INT_EQ(runner, Hits_Total_Hits(hits), S_count_big(&range),
+                    "RangeQuery with float bounds on int field, %s", stage);
+        DECREF(hits);
+        DECREF(query);
+    }
+
+    DECREF(searcher);
+    DECREF(field);
+}
+
+static void
+test_large_ints(TestBatchRunner *runner) {
+    Schema    *schema = Schema_new();
+    Int64Type *type   = Int64Type_new();
+    RAMFolder *folder = RAMFolder_new(NULL);
+    String    *field  = Str_newf("big");
+    Int64Type_Set_Indexed(type, false);
+    Int64Type_Set_Points(type, true);
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+
+    // Force the buffered points out as several trees per segment.
+    PointWriter_set_default_mem_thresh(2000);
+    for (int32_t start = 0; start < NUM_BIG_DOCS; start += NUM_BIG_DOCS / 2) {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        for (int32_t i = start; i < start + NUM_BIG_DOCS / 2; i++) {
+            Doc       *doc   = Doc_new(NULL, 0);
+            Integer64 *value = Int64_new(S_big_value(i));
+            Doc_Store(doc, field, (Obj*)value);
+            Indexer_Add_Doc(indexer, doc, 1.0f);
+            DECREF(value);
+            DECREF(doc);
+        }
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+    S_check_big(runner, folder, "two segments");
+
+    {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        Indexer_Optimize(indexer);
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+    S_check_big(runner, folder, "after merge");
+    PointWriter_set_default_mem_thresh(0x400000);
+
+    PolyReader *reader    = PolyReader_open((Obj*)folder, NULL, NULL);
+    VArray     *seg_readers = PolyReader_Get_Seg_Readers(reader);
+    SegReader  *seg_reader  = (SegReader*)VA_Fetch(seg_readers, 0);
+    Hash       *metadata    = (Hash*)Seg_Fetch_Metadata_Utf8(
+                                  SegReader_Get_Segment(seg_reader),
+                                  "points", 6);
+    VArray     *trees       = metadata
+                              ? (VArray*)Hash_Fetch_Utf8(metadata, "trees", 5)
+                              : NULL;
+    TEST_TRUE(runner, trees && VA_Get_Size(trees) > 1,
+              "points beyond the memory threshold spill into several trees");
+    DECREF(reader);
+
+    DECREF(field);
+    DECREF(folder);
+    DECREF(type);
+    DECREF(schema);
+}
+
+void
+TestBoxQuery_Run_IMP(TestBoxQuery *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 37);
+    test_Dump_Load_and_Equals(runner);
+    test_point_index(runner);
+    test_large_ints(runner);
+}
+
+
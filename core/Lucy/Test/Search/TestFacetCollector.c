@@ -0,0 +1,233 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTFACETCOLLECTOR
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestFacetCollector.h"
+#include "Lucy/Search/Collector/FacetCollector.h"
+
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchAllQuery.h"
+#include "Lucy/Search/PolySearcher.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestFacetCollector*
+TestFacetColl_new() {
+    return (TestFacetCollector*)VTable_Make_Obj(TESTFACETCOLLECTOR);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema = Schema_new();
+    StringType *color  = StringType_new();
+    Int32Type  *size   = Int32Type_new();
+    FType_Set_Sortable((FieldType*)color, true);
+    FType_Set_Sortable((FieldType*)size, true);
+    FType_Set_Indexed((FieldType*)size, false);
+    String *field = Str_newf("color");
+    Schema_Spec_Field(schema, field, (FieldType*)color);
+    DECREF(field);
+    field = Str_newf("size");
+    Schema_Spec_Field(schema, field, (FieldType*)size);
+    DECREF(field);
+    DECREF(size);
+    DECREF(color);
+    return schema;
+}
+
+// Add products numbered from `start`.  Odd products are "red", the rest
+// alternate between "green" and "blue".  Sizes cycle from 1 to 5, and every
+// seventh product has no size.
+static void
+S_add_docs(RAMFolder *folder, Schema *schema, int32_t start, int32_t count) {
+    Indexer *indexer     = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    String  *color_field = Str_newf("color");
+    String  *size_field  = Str_newf("size");
+    for (int32_t i = start; i < start + count; i++) {
+        Doc    *doc   = Doc_new(NULL, 0);
+        String *color = Str_newf(i % 2 ? "red" : i % 4 ? "green" : "blue");
+        Doc_Store(doc, color_field, (Obj*)color);
+        DECREF(color);
+        if (i % 7) {
+            Integer32 *size = Int32_new(i % 5 + 1);
+            Doc_Store(doc, size_field, (Obj*)size);
+            DECREF(size);
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(size_field);
+    DECREF(color_field);
+    DECREF(indexer);
+}
+
+static int64_t
+S_count(FacetCollector *collector, const char *value) {
+    String  *string = Str_newf(value);
+    int64_t  count  = FacetColl_Count(collector, (Obj*)string);
+    DECREF(string);
+    return count;
+}
+
+static void
+test_facets(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+    Schema    *schema = S_create_schema();
+    // Two segments.
+    S_add_docs(folder, schema, 1, 15);
+    S_add_docs(folder, schema, 16, 5);
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    MatchAllQuery *match_all = MatchAllQuery_new();
+    String *color = Str_newf("color");
+    String *size  = Str_newf("size");
+
+    {
+        FacetCollector *collector = FacetColl_new(color);
+        IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+        TEST_TRUE(runner, S_count(collector, "red") == 10
+                          && S_count(collector, "green") == 5
+                          && S_count(collector, "blue") == 5
+                          && Hash_Get_Size(FacetColl_Get_Counts(collector)) == 3,
+                  "Counts merged across segments");
+
+        VArray *top = FacetColl_Top_Values(collector, 2);
+        String *first  = (String*)VA_Fetch(top, 0);
+        String *second = (String*)VA_Fetch(top, 1);
+        TEST_TRUE(runner, VA_Get_Size(top) == 2
+                          && Str_Equals_Utf8(first, "red", 3)
+                          && Str_Equals_Utf8(second, "blue", 4),
+                  "Top_Values() orders by count, then value");
+        DECREF(top);
+        DECREF(collector);
+    }
+
+    {
+        String    *term  = Str_newf("blue");
+        TermQuery *query = TermQuery_new(color, (Obj*)term);
+        FacetCollector *collector = FacetColl_new(color);
+        IxSearcher_Collect(searcher, (Query*)query, (Collector*)collector);
+        TEST_TRUE(runner, S_count(collector, "blue") == 5
+                          && S_count(collector, "red") == 0,
+                  "Only hits are counted");
+        DECREF(collector);
+        DECREF(query);
+        DECREF(term);
+    }
+
+    {
+        FacetCollector *collector = FacetColl_new(size);
+        IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+        Integer32 *value = Int32_new(3);
+        TEST_TRUE(runner, FacetColl_Count(collector, (Obj*)value) == 3
+                          && FacetColl_Get_Num_Missing(collector) == 2,
+                  "Numeric values and missing values");
+        DECREF(value);
+        DECREF(collector);
+    }
+
+    {
+        VArray *bounds = VA_new(2);
+        VA_Push(bounds, (Obj*)Int32_new(2));
+        VA_Push(bounds, (Obj*)Int32_new(4));
+        RangeFacetCollector *collector = RangeFacetColl_new(size, bounds);
+        IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+        TEST_TRUE(runner, RangeFacetColl_Num_Buckets(collector) == 3
+                          && RangeFacetColl_Bucket_Count(collector, 0) == 4
+                          && RangeFacetColl_Bucket_Count(collector, 1) == 7
+                          && RangeFacetColl_Bucket_Count(collector, 2) == 7,
+                  "RangeFacetCollector buckets values");
+        DECREF(collector);
+        DECREF(bounds);
+    }
+
+    DECREF(size);
+    DECREF(color);
+    DECREF(match_all);
+    DECREF(searcher);
+    DECREF(schema);
+    DECREF(folder);
+}
+
+static void
+test_poly_searcher(TestBatchRunner *runner) {
+    Schema    *schema   = S_create_schema();
+    RAMFolder *folder_a = RAMFolder_new(NULL);
+    RAMFolder *folder_b = RAMFolder_new(NULL);
+    S_add_docs(folder_a, schema, 1, 8);
+    S_add_docs(folder_b, schema, 9, 12);
+    VArray *searchers = VA_new(2);
+    VA_Push(searchers, (Obj*)IxSearcher_new((Obj*)folder_a));
+    VA_Push(searchers, (Obj*)IxSearcher_new((Obj*)folder_b));
+    PolySearcher  *poly_searcher = PolySearcher_new(schema, searchers);
+    MatchAllQuery *match_all     = MatchAllQuery_new();
+    String        *color         = Str_newf("color");
+
+    FacetCollector *collector = FacetColl_new(color);
+    PolySearcher_Collect(poly_searcher, (Query*)match_all,
+                         (Collector*)collector);
+    TEST_TRUE(runner, S_count(collector, "red") == 10
+                      && S_count(collector, "green") == 5
+                      && S_count(collector, "blue") == 5,
+              "Counts merged across PolySearcher sub-searchers");
+
+    DECREF(collector);
+    DECREF(color);
+    DECREF(match_all);
+    DECREF(poly_searcher);
+    DECREF(searchers);
+    DECREF(folder_b);
+    DECREF(folder_a);
+    DECREF(schema);
+}
+
+static void
+S_unordered_bounds(void *context) {
+    VArray *bounds = VA_new(2);
+    VA_Push(bounds, (Obj*)Int32_new(4));
+    VA_Push(bounds, (Obj*)Int32_new(2));
+    RangeFacetCollector *collector
+        = RangeFacetColl_new((String*)context, bounds);
+    DECREF(collector);
+    DECREF(bounds);
+}
+
+static void
+test_bad_bounds(TestBatchRunner *runner) {
+    String *size = Str_newf("size");
+    Err *error = Err_trap(S_unordered_bounds, size);
+    TEST_TRUE(runner, error != NULL, "Unordered bounds throw");
+    DECREF(error);
+    DECREF(size);
+}
+
+void
+TestFacetColl_Run_IMP(TestFacetCollector *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 7);
+    test_facets(runner);
+    test_poly_searcher(runner);
+    test_bad_bounds(runner);
+}
@@ -0,0 +1,270 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTGROUPCOLLECTOR
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/CharBuf.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestGroupCollector.h"
+#include "Lucy/Search/Collector/GroupCollector.h"
+
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchDoc.h"
+#include "Lucy/Search/PolySearcher.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Search/TopDocs.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_GROUPS     3
+#define DOCS_PER_GROUP 2
+
+TestGroupCollector*
+TestGroupColl_new() {
+    return (TestGroupCollector*)VTable_Make_Obj(TESTGROUPCOLLECTOR);
+}
+
+static Schema*
+S_create_schema() {
+    Schema            *schema    = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType      *content   = FullTextType_new((Analyzer*)tokenizer);
+    StringType        *site      = StringType_new();
+    FType_Set_Sortable((FieldType*)site, true);
+    String *field = Str_newf("content");
+    Schema_Spec_Field(schema, field, (FieldType*)content);
+    DECREF(field);
+    field = Str_newf("site");
+    Schema_Spec_Field(schema, field, (FieldType*)site);
+    DECREF(field);
+    DECREF(site);
+    DECREF(content);
+    DECREF(tokenizer);
+    return schema;
+}
+
+// Build the text of doc number `i`.  Term frequencies and lengths vary so
+// that scores differ, but plenty of hits tie.
+static String*
+S_content(int32_t i) {
+    CharBuf *buf = CB_new(0);
+    for (int32_t j = 0; j <= i % 5; j++) {
+        CB_Cat_Trusted_Utf8(buf, "x ", 2);
+    }
+    for (int32_t j = 0; j < i % 3; j++) {
+        CB_Cat_Trusted_Utf8(buf, "y ", 2);
+    }
+    String *content = CB_Yield_String(buf);
+    DECREF(buf);
+    return content;
+}
+
+// Every eleventh doc has no site.
+static void
+S_add_docs(RAMFolder *folder, Schema *schema, int32_t start, int32_t end) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    String  *content = Str_newf("content");
+    String  *site    = Str_newf("site");
+    for (int32_t i = start; i <= end; i++) {
+        Doc    *doc  = Doc_new(NULL, 0);
+        String *text = S_content(i);
+        Doc_Store(doc, content, (Obj*)text);
+        DECREF(text);
+        if (i % 11) {
+            String *site_value = Str_newf("site%i32", i % 7);
+            Doc_Store(doc, site, (Obj*)site_value);
+            DECREF(site_value);
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(site);
+    DECREF(content);
+    DECREF(indexer);
+}
+
+static Query*
+S_make_query() {
+    String *field = Str_newf("content");
+    String *term  = Str_newf("x");
+    Query  *query = (Query*)TermQuery_new(field, (Obj*)term);
+    DECREF(term);
+    DECREF(field);
+    return query;
+}
+
+// Collapse a full ranking of the hits by hand: a group's rank is that of
+// its first hit.  Returns an array of doc id arrays, one per group.
+static VArray*
+S_expected(Searcher *searcher, Query *query, String *field) {
+    TopDocs *top_docs   = Searcher_Top_Docs(searcher, query, 1000, NULL);
+    VArray  *match_docs = TopDocs_Get_Match_Docs(top_docs);
+    VArray  *groups     = VA_new(NUM_GROUPS);
+    Hash    *ticks      = Hash_new(0);
+    for (uint32_t i = 0, max = VA_Get_Size(match_docs); i < max; i++) {
+        MatchDoc *match_doc = (MatchDoc*)VA_Fetch(match_docs, i);
+        int32_t   doc_id    = MatchDoc_Get_Doc_ID(match_doc);
+        HitDoc   *hit_doc   = Searcher_Fetch_Doc(searcher, doc_id);
+        Obj      *value     = HitDoc_Extract(hit_doc, field);
+        if (value) {
+            Integer32 *tick = (Integer32*)Hash_Fetch(ticks, value);
+            if (!tick && Hash_Get_Size(ticks) < NUM_GROUPS) {
+                tick = Int32_new(VA_Get_Size(groups));
+                Hash_Store(ticks, value, (Obj*)tick);
+                VA_Push(groups, (Obj*)VA_new(DOCS_PER_GROUP));
+            }
+            if (tick) {
+                VArray *doc_ids
+                    = (VArray*)VA_Fetch(groups, Int32_Get_Value(tick));
+                if (VA_Get_Size(doc_ids) < DOCS_PER_GROUP) {
+                    VA_Push(doc_ids, (Obj*)Int32_new(doc_id));
+                }
+            }
+        }
+        DECREF(hit_doc);
+    }
+    DECREF(ticks);
+    DECREF(top_docs);
+    return groups;
+}
+
+static VArray*
+S_doc_ids(VArray *top_docs) {
+    VArray *groups = VA_new(VA_Get_Size(top_docs));
+    for (uint32_t i = 0, max = VA_Get_Size(top_docs); i < max; i++) {
+        TopDocs *group_docs = (TopDocs*)VA_Fetch(top_docs, i);
+        VArray  *match_docs = TopDocs_Get_Match_Docs(group_docs);
+        VArray  *doc_ids    = VA_new(VA_Get_Size(match_docs));
+        for (uint32_t j = 0, jmax = VA_Get_Size(match_docs); j < jmax; j++) {
+            MatchDoc *match_doc = (MatchDoc*)VA_Fetch(match_docs, j);
+            VA_Push(doc_ids, (Obj*)Int32_new(MatchDoc_Get_Doc_ID(match_doc)));
+        }
+        VA_Push(groups, (Obj*)doc_ids);
+    }
+    return groups;
+}
+
+static void
+S_test_grouping(TestBatchRunner *runner, Searcher *searcher,
+                const char *label) {
+    Query  *query    = S_make_query();
+    String *field    = Str_newf("site");
+    VArray *expected = S_expected(searcher, query, field);
+
+    GroupCollector *group_coll = GroupColl_new(field, NUM_GROUPS);
+    Searcher_Collect(searcher, query, (Collector*)group_coll);
+    VArray *groups = GroupColl_Top_Groups(group_coll);
+    VArray *best   = GroupColl_Top_Group_Docs(group_coll);
+    bool    best_ok = VA_Get_Size(best) == VA_Get_Size(expected);
+    for (uint32_t i = 0; best_ok && i < VA_Get_Size(best); i++) {
+        MatchDoc *match_doc = (MatchDoc*)VA_Fetch(best, i);
+        VArray   *doc_ids   = (VArray*)VA_Fetch(expected, i);
+        Obj      *doc_id    = VA_Fetch(doc_ids, 0);
+        best_ok = MatchDoc_Get_Doc_ID(match_doc) == Obj_To_I64(doc_id);
+    }
+    TEST_TRUE(runner, best_ok, "Top groups and their best hits %s", label);
+
+    GroupDocsCollector *docs_coll
+        = GroupDocsColl_new(field, groups, DOCS_PER_GROUP);
+    Searcher_Collect(searcher, query, (Collector*)docs_coll);
+    VArray *top_docs = GroupDocsColl_Get_Top_Docs(docs_coll);
+    VArray *got      = S_doc_ids(top_docs);
+    TEST_TRUE(runner, VA_Equals(got, (Obj*)expected),
+              "Top hits within each group %s", label);
+
+    DECREF(got);
+    DECREF(docs_coll);
+    DECREF(best);
+    DECREF(groups);
+    DECREF(group_coll);
+    DECREF(expected);
+    DECREF(field);
+    DECREF(query);
+}
+
+static void
+test_group_hits(TestBatchRunner *runner, Searcher *searcher) {
+    Query  *query = S_make_query();
+    String *field = Str_newf("site");
+    VArray *groups = VA_new(2);
+    VA_Push(groups, (Obj*)Str_newf("site3"));
+    VA_Push(groups, (Obj*)Str_newf("no such site"));
+
+    GroupCollector *group_coll = GroupColl_new(field, NUM_GROUPS);
+    Searcher_Collect(searcher, query, (Collector*)group_coll);
+    TEST_INT_EQ(runner, GroupColl_Get_Total_Hits(group_coll), 60,
+                "Get_Total_Hits counts ungrouped hits too");
+
+    // Docs 3, 10, 17, ... 59.
+    GroupDocsCollector *docs_coll = GroupDocsColl_new(field, groups, 100);
+    Searcher_Collect(searcher, query, (Collector*)docs_coll);
+    VArray  *top_docs = GroupDocsColl_Get_Top_Docs(docs_coll);
+    TopDocs *site3    = (TopDocs*)VA_Fetch(top_docs, 0);
+    TopDocs *missing  = (TopDocs*)VA_Fetch(top_docs, 1);
+    TEST_TRUE(runner, TopDocs_Get_Total_Hits(site3) == 9
+                      && VA_Get_Size(TopDocs_Get_Match_Docs(site3)) == 9
+                      && TopDocs_Get_Total_Hits(missing) == 0,
+              "Per-group hit counts");
+
+    DECREF(docs_coll);
+    DECREF(group_coll);
+    DECREF(groups);
+    DECREF(field);
+    DECREF(query);
+}
+
+void
+TestGroupColl_Run_IMP(TestGroupCollector *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 6);
+    Schema *schema = S_create_schema();
+
+    // Two segments in a single index.
+    RAMFolder *folder = RAMFolder_new(NULL);
+    S_add_docs(folder, schema, 0, 44);
+    S_add_docs(folder, schema, 45, 59);
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    S_test_grouping(runner, (Searcher*)searcher, "across segments");
+    test_group_hits(runner, (Searcher*)searcher);
+
+    // The same docs split between two indexes.
+    RAMFolder *folder_a = RAMFolder_new(NULL);
+    RAMFolder *folder_b = RAMFolder_new(NULL);
+    S_add_docs(folder_a, schema, 0, 29);
+    S_add_docs(folder_b, schema, 30, 59);
+    VArray *searchers = VA_new(2);
+    VA_Push(searchers, (Obj*)IxSearcher_new((Obj*)folder_a));
+    VA_Push(searchers, (Obj*)IxSearcher_new((Obj*)folder_b));
+    PolySearcher *poly_searcher = PolySearcher_new(schema, searchers);
+    S_test_grouping(runner, (Searcher*)poly_searcher, "via PolySearcher");
+
+    DECREF(poly_searcher);
+    DECREF(searchers);
+    DECREF(folder_b);
+    DECREF(folder_a);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
@@ -0,0 +1,308 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTIMPACTMATCHER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+#include <math.h>
+
+#include "Clownfish/CharBuf.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/TestUtils.h"
+#include "Lucy/Test/Search/TestImpactMatcher.h"
+#include "Lucy/Search/ImpactMatcher.h"
+
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/ImpactWriter.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchDoc.h"
+#include "Lucy/Search/ORQuery.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Search/TopDocs.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS     1200
+#define FIRST_COMMIT 700
+#define NUM_WANTED   10
+
+TestImpactMatcher*
+TestImpactMatcher_new() {
+    return (TestImpactMatcher*)VTable_Make_Obj(TESTIMPACTMATCHER);
+}
+
+static void
+test_level(TestBatchRunner *runner) {
+    TEST_TRUE(runner,
+              ImpactWriter_level(1.0f) == 0
+              && ImpactWriter_level(2.0f) == IMPACTWRITER_LEVELS_PER_DOUBLING
+              && ImpactWriter_level(0.5f) == -IMPACTWRITER_LEVELS_PER_DOUBLING
+              && ImpactWriter_level(1.1f) == ImpactWriter_level(1.0f)
+              && ImpactWriter_level(0.0f) < ImpactWriter_level(0.001f),
+              "level() buckets impacts by fractions of a doubling");
+}
+
+// Build the text of doc number `i`.  Each of the words "w0" through "w7"
+// occurs zero to four times, and a varying amount of filler spreads out the
+// length norms.
+static String*
+S_content(int32_t i) {
+    CharBuf *buf = CB_new(0);
+    for (uint32_t word = 0; word < 8; word++) {
+        uint32_t hash = (uint32_t)i * 2654435761u + word * 40503u;
+        uint32_t freq = (hash >> 13) % 5;
+        for (uint32_t j = 0; j < freq; j++) {
+            CB_catf(buf, "w%u32 ", word);
+        }
+    }
+    for (int32_t j = 0, max = (i * 13) % 17; j < max; j++) {
+        CB_Cat_Trusted_Utf8(buf, "filler ", 7);
+    }
+    String *content = CB_Yield_String(buf);
+    DECREF(buf);
+    return content;
+}
+
+static void
+S_add_docs(RAMFolder *folder, Schema *schema, int32_t start, int32_t end) {
+    String  *content_field = Str_newf("content");
+    String  *plain_field   = Str_newf("plain");
+    String  *id_field      = Str_newf("id");
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t i = start; i < end; i++) {
+        Doc    *doc     = Doc_new(NULL, 0);
+        String *content = S_content(i);
+        String *id      = Str_newf("%i32", i);
+        Doc_Store(doc, content_field, (Obj*)content);
+        Doc_Store(doc, plain_field, (Obj*)content);
+        Doc_Store(doc, id_field, (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f + (float)(i % 3) * 0.5f);
+        DECREF(id);
+        DECREF(content);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(id_field);
+    DECREF(plain_field);
+    DECREF(content_field);
+}
+
+static Query*
+S_make_query(const char *field_name, const char **words) {
+    String *field    = Str_newf(field_name);
+    VArray *children = VA_new(0);
+    for (uint32_t i = 0; words[i] != NULL; i++) {
+        String *term = Str_newf(words[i]);
+        VA_Push(children, (Obj*)TermQuery_new(field, (Obj*)term));
+        DECREF(term);
+    }
+    Query *query = VA_Get_Size(children) == 1
+                   ? (Query*)INCREF(VA_Fetch(children, 0))
+                   : (Query*)ORQuery_new(children);
+    DECREF(children);
+    DECREF(field);
+    return query;
+}
+
+static bool
+S_close(float a, float b) {
+    return fabs(a - b) <= 1e-6 * fabs(a);
+}
+
+// Verify that both TopDocs hold the same docs with the same scores.  An
+// ORScorer which skips ahead may sum its children's scores in a different
+// order, so scores may differ in the last bit, and docs whose scores tie may
+// trade places.
+static bool
+S_same_docs(TopDocs *a, TopDocs *b) {
+    VArray *a_docs = TopDocs_Get_Match_Docs(a);
+    VArray *b_docs = TopDocs_Get_Match_Docs(b);
+    if (VA_Get_Size(a_docs) != VA_Get_Size(b_docs)) { return false; }
+    for (uint32_t i = 0, max = VA_Get_Size(a_docs); i < max; i++) {
+        MatchDoc *a_doc = (MatchDoc*)VA_Fetch(a_docs, i);
+        MatchDoc *b_doc = (MatchDoc*)VA_Fetch(b_docs, i);
+        float a_score = MatchDoc_Get_Score(a_doc);
+        if (!S_close(a_score, MatchDoc_Get_Score(b_doc))) { return false; }
+        if (MatchDoc_Get_Doc_ID(a_doc) == MatchDoc_Get_Doc_ID(b_doc)) {
+            continue;
+        }
+        bool tied = false;
+        for (uint32_t j = 0; j < max; j++) {
+            MatchDoc *other = (MatchDoc*)VA_Fetch(a_docs, j);
+            if (MatchDoc_Get_Doc_ID(other) == MatchDoc_Get_Doc_ID(b_doc)
+                && S_close(a_score, MatchDoc_Get_Score(other))
+               ) {
+                tied = true;
+            }
+        }
+        if (!tied && !S_close(a_score, MatchDoc_Get_Score(
+                                  (MatchDoc*)VA_Fetch(a_docs, max - 1)))
+           ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void
+S_check_queries(TestBatchRunner *runner, RAMFolder *folder,
+                const char *stage) {
+    static const char *single[] = { "w1", NULL };
+    static const char *pair[]   = { "w1", "w2", NULL };
+    static const char *many[]   = { "w0", "w1", "w2", "w3", "w4", "w5", NULL };
+    static const char *missing[] = { "w3", "nope", NULL };
+    static const char **word_lists[] = { single, pair, many, missing };
+    static const char *labels[] = {
+        "TermQuery", "ORQuery", "ORQuery with six clauses",
+        "ORQuery with a missing term"
+    };
+    IndexSearcher *full_searcher  = IxSearcher_new((Obj*)folder);
+    IndexSearcher *early_searcher = IxSearcher_new((Obj*)folder);
+    IxSearcher_Set_Early_Termination(early_searcher, true);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        Query   *query = S_make_query("content", word_lists[i]);
+        TopDocs *full  = IxSearcher_Top_Docs(full_searcher, query,
+                                             NUM_WANTED, NULL);
+        TopDocs *early = IxSearcher_Top_Docs(early_searcher, query,
+                                             NUM_WANTED, NULL);
+        TEST_TRUE(runner,
+                  S_same_docs(full, early)
+                  && TopDocs_Get_Total_Hits(early)
+                     <= TopDocs_Get_Total_Hits(full),
+                  "%s finds the same top docs, %s", labels[i], stage);
+        if (i == 0) {
+            TEST_TRUE(runner,
+                      TopDocs_Get_Total_Hits(early)
+                      < TopDocs_Get_Total_Hits(full),
+                      "Impacts skip docs, %s: %u32 of %u32", stage,
+                      TopDocs_Get_Total_Hits(early),
+                      TopDocs_Get_Total_Hits(full));
+        }
+        DECREF(early);
+        DECREF(full);
+        DECREF(query);
+    }
+
+    DECREF(early_searcher);
+    DECREF(full_searcher);
+}
+
+static void
+test_impacts(TestBatchRunner *runner) {
+    Schema            *schema    = Schema_new();
+    RAMFolder         *folder    = RAMFolder_new(NULL);
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType      *impact_type = FullTextType_new((Analyzer*)tokenizer);
+    FullTextType      *plain_type  = FullTextType_new((Analyzer*)tokenizer);
+    StringType        *id_type     = StringType_new();
+    String            *content_field = Str_newf("content");
+    String            *plain_field   = Str_newf("plain");
+    String            *id_field      = Str_newf("id");
+    FullTextType_Set_Impacts(impact_type, true);
+    Schema_Spec_Field(schema, content_field, (FieldType*)impact_type);
+    Schema_Spec_Field(schema, plain_field, (FieldType*)plain_type);
+    Schema_Spec_Field(schema, id_field, (FieldType*)id_type);
+
+    S_add_docs(folder, schema, 0, FIRST_COMMIT);
+    // Force the second segment and the merged one to spill several runs.
+    ImpactWriter_set_default_mem_thresh(4000);
+    S_add_docs(folder, schema, FIRST_COMMIT, NUM_DOCS);
+    S_check_queries(runner, folder, "two segments");
+
+    {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        for (int32_t i = 0; i < NUM_DOCS; i += 7) {
+            String *id = Str_newf("%i32", i);
+            Indexer_Delete_By_Term(indexer, id_field, (Obj*)id);
+            DECREF(id);
+        }
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+    S_check_queries(runner, folder, "with deletions");
+
+    {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        Indexer_Optimize(indexer);
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+    ImpactWriter_set_default_mem_thresh(0x400000);
+    {
+        PolyReader *reader   = PolyReader_open((Obj*)folder, NULL, NULL);
+        SegReader  *seg_reader
+            = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+        Hash       *metadata = (Hash*)Seg_Fetch_Metadata_Utf8(
+                                   SegReader_Get_Segment(seg_reader),
+                                   "impacts", 7);
+        VArray     *runs     = metadata
+                               ? (VArray*)Hash_Fetch_Utf8(metadata, "runs", 4)
+                               : NULL;
+        TEST_TRUE(runner, runs && VA_Get_Size(runs) > 1,
+                  "postings beyond the memory threshold spill into runs");
+        DECREF(reader);
+    }
+    S_check_queries(runner, folder, "after merge");
+
+    {
+        // Fields without impacts are searched in full.
+        static const char *words[] = { "w1", NULL };
+        IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+        Query   *query = S_make_query("plain", words);
+        TopDocs *full  = IxSearcher_Top_Docs(searcher, query, NUM_WANTED,
+                                             NULL);
+        IxSearcher_Set_Early_Termination(searcher, true);
+        TopDocs *early = IxSearcher_Top_Docs(searcher, query, NUM_WANTED,
+                                             NULL);
+        TEST_TRUE(runner,
+                  S_same_docs(full, early)
+                  && TopDocs_Get_Total_Hits(early)
+                     == TopDocs_Get_Total_Hits(full),
+                  "Field without impacts is searched in full");
+        DECREF(early);
+        DECREF(full);
+        DECREF(query);
+        DECREF(searcher);
+    }
+
+    DECREF(id_field);
+    DECREF(plain_field);
+    DECREF(content_field);
+    DECREF(id_type);
+    DECREF(plain_type);
+    DECREF(impact_type);
+    DECREF(tokenizer);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+void
+TestImpactMatcher_Run_IMP(TestImpactMatcher *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 18);
+    test_level(runner);
+    test_impacts(runner);
+}
+
@@ -23,7 +23,21 @@
 #include "Lucy/Test.h"
 #include "Lucy/Test/TestUtils.h"
 #include "Lucy/Test/Search/TestPhraseQuery.h"
+#include "Clownfish/CharBuf.h"
+#include "Lucy/Analysis/CommonGramsFilter.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Search/Collector.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
 #include "Lucy/Search/PhraseQuery.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
 #include "Lucy/Util/Freezer.h"
 
 TestPhraseQuery*
@@ -44,10 +58,277 @@ test_Dump_And_Load(TestBatchRunner *runner) {
     DECREF(twin);
 }
 
+static void
+S_add_doc(Indexer *indexer, String *field, const char *prefix,
+          uint32_t filler, const char *suffix) {
+    CharBuf *content = CB_new(0);
+    CB_Cat_Trusted_Utf8(content, prefix, strlen(prefix));
+    for (uint32_t i = 0; i < filler; i++) {
+        CB_Cat_Trusted_Utf8(content, " x", 2);
+    }
+    CB_Cat_Trusted_Utf8(content, " ", 1);
+    CB_Cat_Trusted_Utf8(content, suffix, strlen(suffix));
+    String *content_str = CB_Yield_String(content);
+    Doc *doc = Doc_new(NULL, 0);
+    Doc_Store(doc, field, (Obj*)content_str);
+    Indexer_Add_Doc(indexer, doc, 1.0f);
+    DECREF(doc);
+    DECREF(content_str);
+    DECREF(content);
+}
+
+static uint32_t
+S_num_hits(IndexSearcher *searcher, Query *query) {
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    uint32_t num_hits = Hits_Total_Hits(hits);
+    DECREF(hits);
+    return num_hits;
+}
+
+// Positions are decoded lazily by ScorePosting.  Use long docs, so that the
+// skipped position data spans stream buffer refills, and make sure phrase
+// matching still sees the right positions.
+static void
+test_positions(TestBatchRunner *runner) {
+    Schema            *schema    = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType      *type      = FullTextType_new((Analyzer*)tokenizer);
+    String            *field     = Str_newf("content");
+    RAMFolder         *folder    = RAMFolder_new(NULL);
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    S_add_doc(indexer, field, "a b c", 3000, "a b c");
+    S_add_doc(indexer, field, "c b a", 3000, "a x b c");
+    S_add_doc(indexer, field, "x", 3000, "x a b c");
+    S_add_doc(indexer, field, "a", 3000, "b c");
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    PhraseQuery *abc
+        = TestUtils_make_phrase_query("content", "a", "b", "c", NULL);
+    PhraseQuery *xx
+        = TestUtils_make_phrase_query("content", "x", "x", NULL);
+    PhraseQuery *cx
+        = TestUtils_make_phrase_query("content", "c", "x", NULL);
+    TEST_INT_EQ(runner, S_num_hits(searcher, (Query*)abc), 2,
+                "Phrase matches at start and end of long docs");
+    TEST_INT_EQ(runner, S_num_hits(searcher, (Query*)xx), 4,
+                "Phrase matches repeated term");
+    TEST_INT_EQ(runner, S_num_hits(searcher, (Query*)cx), 1,
+                "Phrase matches only where positions line up");
+
+    DECREF(cx);
+    DECREF(xx);
+    DECREF(abc);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(field);
+    DECREF(type);
+    DECREF(tokenizer);
+    DECREF(schema);
+}
+
+static void
+S_add_text(Indexer *indexer, String *field, const char *text) {
+    String *content = Str_newf(text);
+    Doc *doc = Doc_new(NULL, 0);
+    Doc_Store(doc, field, (Obj*)content);
+    Indexer_Add_Doc(indexer, doc, 1.0f);
+    DECREF(doc);
+    DECREF(content);
+}
+
+// The rarest term drives matching, and need not be the first term of the
+// phrase.
+static void
+test_rare_anchor(TestBatchRunner *runner) {
+    Schema            *schema    = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType      *type      = FullTextType_new((Analyzer*)tokenizer);
+    String            *field     = Str_newf("content");
+    RAMFolder         *folder    = RAMFolder_new(NULL);
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int i = 0; i < 200; i++) {
+        S_add_text(indexer, field, "of the states of the x");
+    }
+    S_add_text(indexer, field, "united states of the united states");
+    S_add_text(indexer, field, "of the united states of the united states");
+    S_add_text(indexer, field, "united of the states");
+    S_add_text(indexer, field, "the united states");
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    PhraseQuery *query
+        = TestUtils_make_phrase_query("content", "of", "the", "united",
+                                      "states", NULL);
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    TEST_INT_EQ(runner, Hits_Total_Hits(hits), 2,
+                "Phrase anchored on rare term mid-phrase");
+    HitDoc *hit_doc = Hits_Next(hits);
+    Obj *content = hit_doc ? HitDoc_Extract(hit_doc, field) : NULL;
+    TEST_TRUE(runner,
+              content && Str_Starts_With_Utf8((String*)content, "of", 2),
+              "Phrase freq counts every occurrence");
+    DECREF(content);
+    DECREF(hit_doc);
+    DECREF(hits);
+
+    // BitCollector doesn't need scores, so phrase matching can stop at the
+    // first occurrence in each doc.
+    BitVector *bit_vec = BitVec_new(0);
+    BitCollector *collector
+        = BitColl_init((BitCollector*)VTable_Make_Obj(BITCOLLECTOR), bit_vec);
+    IxSearcher_Collect(searcher, (Query*)query, (Collector*)collector);
+    TEST_TRUE(runner,
+              BitVec_Count(bit_vec) == 2
+              && BitVec_Get(bit_vec, 201)
+              && BitVec_Get(bit_vec, 202),
+              "Phrase matching without scores");
+    DECREF(collector);
+    DECREF(bit_vec);
+
+    DECREF(query);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(field);
+    DECREF(type);
+    DECREF(tokenizer);
+    DECREF(schema);
+}
+
+// Phrases against a field with common grams are rewritten to use the grams,
+// and must match the same docs as against a field without them.
+static void
+test_common_grams(TestBatchRunner *runner) {
+    Schema            *schema    = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType      *plain     = FullTextType_new((Analyzer*)tokenizer);
+    FullTextType      *grams     = FullTextType_new((Analyzer*)tokenizer);
+    String            *plain_field = Str_newf("plain");
+    String            *grams_field = Str_newf("grams");
+    RAMFolder         *folder    = RAMFolder_new(NULL);
+    Hash              *common    = Hash_new(0);
+    const char *common_words[] = { "to", "be", "or", "not", "the", "of", NULL };
+    for (int i = 0; common_words[i] != NULL; i++) {
+        Hash_Store_Utf8(common, common_words[i], strlen(common_words[i]),
+                        (Obj*)Str_newf(""));
+    }
+    CommonGramsFilter *filter = CommonGrams_new(common);
+    FullTextType_Set_Common_Grams(grams, filter);
+    Schema_Spec_Field(schema, plain_field, (FieldType*)plain);
+    Schema_Spec_Field(schema, grams_field, (FieldType*)grams);
+
+    const char *texts[] = {
+        "to be or not to be", "not to be", "to be or not", "the who",
+        "who the", "the united states of america", "of the people", NULL
+    };
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int i = 0; texts[i] != NULL; i++) {
+        String *text = Str_newf(texts[i]);
+        Doc *doc = Doc_new(NULL, 0);
+        Doc_Store(doc, plain_field, (Obj*)text);
+        Doc_Store(doc, grams_field, (Obj*)text);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+        DECREF(text);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    struct { const char *terms[7]; uint32_t num_hits; } phrases[] = {
+        { { "to", "be", "or", "not", "to", "be", NULL }, 1 },
+        { { "not", "to", "be", NULL }, 2 },
+        { { "the", "who", NULL }, 1 },
+        { { "united", "states", "of", NULL }, 1 },
+        { { "of", "the", "people", NULL }, 1 },
+    };
+    for (uint32_t p = 0; p < sizeof(phrases) / sizeof(phrases[0]); p++) {
+        VArray *terms = VA_new(0);
+        for (int i = 0; phrases[p].terms[i] != NULL; i++) {
+            VA_Push(terms, (Obj*)Str_newf(phrases[p].terms[i]));
+        }
+        PhraseQuery *plain_query = PhraseQuery_new(plain_field, terms);
+        PhraseQuery *grams_query = PhraseQuery_new(grams_field, terms);
+        uint32_t plain_hits = S_num_hits(searcher, (Query*)plain_query);
+        uint32_t grams_hits = S_num_hits(searcher, (Query*)grams_query);
+        TEST_TRUE(runner,
+                  plain_hits == phrases[p].num_hits
+                  && grams_hits == phrases[p].num_hits,
+                  "Common grams phrase %u: %u plain, %u grams", p,
+                  plain_hits, grams_hits);
+        DECREF(grams_query);
+        DECREF(plain_query);
+        DECREF(terms);
+    }
+
+    String    *gram       = Str_newf("to be");
+    TermQuery *gram_query = TermQuery_new(grams_field, (Obj*)gram);
+    TEST_INT_EQ(runner, S_num_hits(searcher, (Query*)gram_query), 3,
+                "Grams are indexed as terms");
+    DECREF(gram_query);
+    DECREF(gram);
+
+    // The grams are stacked on the positions of their first words, so they
+    // mustn't change the length norm of ordinary term queries.
+    const char *words[] = { "the", "be", "people", NULL };
+    bool same_scores = true;
+    for (int i = 0; words[i] != NULL; i++) {
+        String    *word        = Str_newf(words[i]);
+        TermQuery *plain_query = TermQuery_new(plain_field, (Obj*)word);
+        TermQuery *grams_query = TermQuery_new(grams_field, (Obj*)word);
+        Hits *plain_hits = IxSearcher_Hits(searcher, (Obj*)plain_query, 0,
+                                           10, NULL);
+        Hits *grams_hits = IxSearcher_Hits(searcher, (Obj*)grams_query, 0,
+                                           10, NULL);
+        if (Hits_Total_Hits(plain_hits) != Hits_Total_Hits(grams_hits)) {
+            same_scores = false;
+        }
+        HitDoc *plain_doc;
+        while (NULL != (plain_doc = Hits_Next(plain_hits))) {
+            HitDoc *grams_doc = Hits_Next(grams_hits);
+            if (!grams_doc
+                || HitDoc_Get_Doc_ID(grams_doc) != HitDoc_Get_Doc_ID(plain_doc)
+                || HitDoc_Get_Score(grams_doc) != HitDoc_Get_Score(plain_doc)
+               ) {
+                same_scores = false;
+            }
+            DECREF(grams_doc);
+            DECREF(plain_doc);
+        }
+        DECREF(grams_hits);
+        DECREF(plain_hits);
+        DECREF(grams_query);
+        DECREF(plain_query);
+        DECREF(word);
+    }
+    TEST_TRUE(runner, same_scores,
+              "Grams don't change the scores of term queries");
+
+    DECREF(searcher);
+    DECREF(filter);
+    DECREF(common);
+    DECREF(folder);
+    DECREF(grams_field);
+    DECREF(plain_field);
+    DECREF(grams);
+    DECREF(plain);
+    DECREF(tokenizer);
+    DECREF(schema);
+}
+
 void
 TestPhraseQuery_Run_IMP(TestPhraseQuery *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 1);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 14);
     test_Dump_And_Load(runner);
+    test_positions(runner);
+    test_rare_anchor(runner);
+    test_common_grams(runner);
 }
 
 
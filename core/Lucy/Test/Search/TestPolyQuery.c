@@ -23,11 +23,16 @@
 #include "Lucy/Test.h"
 #include "Lucy/Test/TestUtils.h"
 #include "Lucy/Test/Search/TestPolyQuery.h"
+#include "Lucy/Index/Similarity.h"
+#include "Lucy/Search/ANDMatcher.h"
 #include "Lucy/Search/ANDQuery.h"
+#include "Lucy/Search/ORBucketScorer.h"
+#include "Lucy/Search/ORMatcher.h"
 #include "Lucy/Search/ORQuery.h"
 #include "Lucy/Search/PolyQuery.h"
 #include "Lucy/Search/LeafQuery.h"
 #include "Lucy/Util/Freezer.h"
+#include "LucyX/Search/MockMatcher.h"
 
 TestANDQuery*
 TestANDQuery_new() {
@@ -78,16 +83,193 @@ test_Dump_Load_and_Equals(TestBatchRunner *runner, uint32_t boolop) {
     DECREF(clone);
 }
 
+// Make a MockMatcher which matches every doc up to `doc_max` whose id leaves
+// `remainder` when divided by `modulus`.
+static MockMatcher*
+S_make_mock(int32_t modulus, int32_t remainder, float score,
+            int32_t doc_max) {
+    int32_t *doc_ids  = (int32_t*)MALLOCATE(doc_max * sizeof(int32_t));
+    float   *scores   = (float*)MALLOCATE(doc_max * sizeof(float));
+    int32_t  num_docs = 0;
+    for (int32_t doc_id = 1; doc_id <= doc_max; doc_id++) {
+        if (doc_id % modulus == remainder) {
+            doc_ids[num_docs] = doc_id;
+            scores[num_docs]  = score;
+            num_docs++;
+        }
+    }
+    I32Array *doc_id_array = I32Arr_new_steal(doc_ids, num_docs);
+    ByteBuf  *score_buf    = BB_new_bytes(scores, num_docs * sizeof(float));
+    MockMatcher *mock = MockMatcher_new(doc_id_array, score_buf);
+    DECREF(doc_id_array);
+    DECREF(score_buf);
+    FREEMEM(scores);
+    return mock;
+}
+
+// Build a set of children which spread their matches over several
+// ORBucketScorer windows, with a NULL child thrown in.
+static VArray*
+S_make_or_children(uint32_t num_kids, int32_t doc_max) {
+    VArray *children = VA_new(num_kids + 1);
+    for (uint32_t i = 0; i < num_kids; i++) {
+        int32_t modulus = i == 0 ? 3001 : (int32_t)i + 1;
+        VA_Push(children, (Obj*)S_make_mock(modulus, (int32_t)(i % 3),
+                                            1.0f / (float)(i + 1), doc_max));
+    }
+    VA_Push(children, NULL);
+    return children;
+}
+
+static VArray*
+S_make_and_children(int32_t doc_max) {
+    VArray *children = VA_new(3);
+    VA_Push(children, (Obj*)S_make_mock(2, 0, 1.0f, doc_max));
+    VA_Push(children, (Obj*)S_make_mock(3, 0, 0.5f, doc_max));
+    VA_Push(children, (Obj*)S_make_mock(7, 1, 0.25f, doc_max));
+    return children;
+}
+
+// Drive `by_block` through Next_Block(), hopping ahead with Advance() after
+// every other block as Matcher_Collect() does, and check each doc and score
+// against `by_doc` driven through Next() and Advance().
+static bool
+S_blocks_agree(Matcher *by_block, Matcher *by_doc, uint32_t *num_hits) {
+    int32_t  doc_ids[7];
+    float    scores[7];
+    uint32_t block_num = 0;
+    *num_hits = 0;
+    while (true) {
+        uint32_t num_docs = Matcher_Next_Block(by_block, doc_ids, scores, 7);
+        for (uint32_t i = 0; i < num_docs; i++) {
+            if (Matcher_Next(by_doc) != doc_ids[i]) { return false; }
+            float diff = Matcher_Score(by_doc) - scores[i];
+            if (diff > 0.0001f || diff < -0.0001f) { return false; }
+            (*num_hits)++;
+        }
+        if (num_docs < 7) { break; }
+        if (block_num++ % 2) {
+            int32_t target = doc_ids[num_docs - 1] + 25;
+            int32_t got    = Matcher_Advance(by_block, target);
+            if (Matcher_Advance(by_doc, target) != got) { return false; }
+            if (!got) { break; }
+            float diff = Matcher_Score(by_doc) - Matcher_Score(by_block);
+            if (diff > 0.0001f || diff < -0.0001f) { return false; }
+            (*num_hits)++;
+        }
+    }
+    return Matcher_Next(by_doc) == 0;
+}
+
+static void
+test_ANDMatcher_Next_Block(TestBatchRunner *runner) {
+    Similarity *sim        = Sim_new();
+    VArray     *block_kids = S_make_and_children(5000);
+    VArray     *doc_kids   = S_make_and_children(5000);
+    ANDMatcher *by_block   = ANDMatcher_new(block_kids, sim);
+    ANDMatcher *by_doc     = ANDMatcher_new(doc_kids, sim);
+    uint32_t    num_hits;
+    bool agree = S_blocks_agree((Matcher*)by_block, (Matcher*)by_doc,
+                                &num_hits);
+    TEST_TRUE(runner, agree && num_hits > 10,
+              "ANDMatcher Next_Block agrees with Next and Score");
+    DECREF(by_doc);
+    DECREF(by_block);
+    DECREF(doc_kids);
+    DECREF(block_kids);
+    DECREF(sim);
+}
+
+static void
+test_ORScorer_Next_Block(TestBatchRunner *runner) {
+    Similarity *sim        = Sim_new();
+    VArray     *block_kids = S_make_or_children(4, 5000);
+    VArray     *doc_kids   = S_make_or_children(4, 5000);
+    ORScorer   *by_block   = ORScorer_new(block_kids, sim);
+    ORScorer   *by_doc     = ORScorer_new(doc_kids, sim);
+    uint32_t    num_hits;
+    bool agree = S_blocks_agree((Matcher*)by_block, (Matcher*)by_doc,
+                                &num_hits);
+    TEST_TRUE(runner, agree && num_hits > 10,
+              "ORScorer Next_Block agrees with Next and Score");
+    DECREF(by_doc);
+    DECREF(by_block);
+    DECREF(doc_kids);
+    DECREF(block_kids);
+    DECREF(sim);
+}
+
+static void
+test_ORBucketScorer(TestBatchRunner *runner) {
+    const uint32_t num_kids = 40;
+    const int32_t  doc_max  = 10000;
+    Similarity *sim = Sim_new();
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool use_advance = pass == 1;
+        VArray *heap_kids   = S_make_or_children(num_kids, doc_max);
+        VArray *bucket_kids = S_make_or_children(num_kids, doc_max);
+        ORScorer *heap_scorer = ORScorer_new(heap_kids, sim);
+        ORBucketScorer *bucket_scorer
+            = ORBucketScorer_new(bucket_kids, sim);
+        int32_t  step      = 1;
+        uint32_t num_hits  = 0;
+        bool     agree     = true;
+
+        while (true) {
+            int32_t expected;
+            int32_t got;
+            if (use_advance) {
+                // Alternate short hops within a window with long jumps
+                // between windows.
+                int32_t target = ORScorer_Get_Doc_ID(heap_scorer) + step;
+                expected = ORScorer_Advance(heap_scorer, target);
+                got      = ORBucketScorer_Advance(bucket_scorer, target);
+                step = step > 1000 ? 1 : step * 5;
+            }
+            else {
+                expected = ORScorer_Next(heap_scorer);
+                got      = ORBucketScorer_Next(bucket_scorer);
+            }
+            if (expected != got) {
+                agree = false;
+                break;
+            }
+            if (!expected) { break; }
+            float diff = ORScorer_Score(heap_scorer)
+                         - ORBucketScorer_Score(bucket_scorer);
+            if (diff > 0.0001f || diff < -0.0001f) {
+                agree = false;
+                break;
+            }
+            num_hits++;
+        }
+        TEST_TRUE(runner, agree && num_hits > 10,
+                  "ORBucketScorer agrees with ORScorer via %s",
+                  use_advance ? "Advance" : "Next");
+
+        DECREF(heap_scorer);
+        DECREF(bucket_scorer);
+        DECREF(heap_kids);
+        DECREF(bucket_kids);
+    }
+
+    DECREF(sim);
+}
+
 void
 TestANDQuery_Run_IMP(TestANDQuery *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 4);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 5);
     test_Dump_Load_and_Equals(runner, BOOLOP_AND);
+    test_ANDMatcher_Next_Block(runner);
 }
 
 void
 TestORQuery_Run_IMP(TestORQuery *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 4);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 7);
     test_Dump_Load_and_Equals(runner, BOOLOP_OR);
+    test_ORBucketScorer(runner);
+    test_ORScorer_Next_Block(runner);
 }
 
 
@@ -25,6 +25,19 @@
 #include "Lucy/Test/Search/TestRangeQuery.h"
 #include "Lucy/Search/RangeQuery.h"
 
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/RangeMatcher.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS 700
+
 TestRangeQuery*
 TestRangeQuery_new() {
     return (TestRangeQuery*)VTable_Make_Obj(TESTRANGEQUERY);
@@ -65,11 +78,106 @@ test_Dump_Load_and_Equals(TestBatchRunner *runner) {
     DECREF(clone);
 }
 
+// Check a RangeMatcher against the docs selected by SortCache_Ordinal().
+static bool
+S_check_range(SortCache *sort_cache, int32_t doc_max, int32_t lower,
+              int32_t upper, int32_t stride) {
+    RangeMatcher *matcher
+        = RangeMatcher_new(lower, upper, sort_cache, doc_max);
+    int32_t expected = 0;
+    bool    agree    = true;
+
+    while (agree) {
+        // Find the next expected doc, hopping ahead by `stride` if Advance()
+        // is being tested.
+        int32_t target = expected + stride;
+        int32_t got    = stride == 1
+                         ? RangeMatcher_Next(matcher)
+                         : RangeMatcher_Advance(matcher, target);
+        for (expected = target; expected <= doc_max; expected++) {
+            int32_t ord = SortCache_Ordinal(sort_cache, expected);
+            if (ord >= lower && ord <= upper) { break; }
+        }
+        if (expected > doc_max) { expected = 0; }
+        if (got != expected) { agree = false; }
+        if (!expected)       { break; }
+    }
+
+    DECREF(matcher);
+    return agree;
+}
+
+static void
+test_RangeMatcher(TestBatchRunner *runner) {
+    // Cardinalities chosen to produce ord widths of 1, 2, 4, 8 and 16 bits.
+    int32_t cardinalities[] = { 1, 3, 10, 200, 1000, 0 };
+    String *field = Str_newf("value");
+
+    for (uint32_t c = 0; cardinalities[c] != 0; c++) {
+        int32_t     cardinality = cardinalities[c];
+        Schema     *schema      = Schema_new();
+        StringType *type        = StringType_new();
+        RAMFolder  *folder      = RAMFolder_new(NULL);
+        StringType_Set_Sortable(type, true);
+        Schema_Spec_Field(schema, field, (FieldType*)type);
+
+        // Leave every seventh doc without a value.
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        for (int32_t i = 0; i < NUM_DOCS; i++) {
+            Doc *doc = Doc_new(NULL, 0);
+            if (i % 7 != 3) {
+                String *value = Str_newf("%i32", (i * 31) % cardinality);
+                Doc_Store(doc, field, (Obj*)value);
+                DECREF(value);
+            }
+            Indexer_Add_Doc(indexer, doc, 1.0f);
+            DECREF(doc);
+        }
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+
+        IndexReader *reader = IxReader_open((Obj*)folder, NULL, NULL);
+        SegReader *seg_reader
+            = (SegReader*)VA_Fetch(IxReader_Seg_Readers(reader), 0);
+        SortReader *sort_reader
+            = (SortReader*)SegReader_Fetch(seg_reader,
+                                           VTable_Get_Name(SORTREADER));
+        SortCache *sort_cache
+            = SortReader_Fetch_Sort_Cache(sort_reader, field);
+        int32_t doc_max = SegReader_Doc_Max(seg_reader);
+        int32_t max_ord = SortCache_Get_Cardinality(sort_cache);
+
+        bool agree = true;
+        int32_t bounds[][2] = {
+            { 0, max_ord }, { 0, 0 }, { 1, max_ord / 2 },
+            { max_ord / 2, max_ord }, { max_ord, max_ord }, { 2, 1 }
+        };
+        int32_t strides[] = { 1, 2, 5, 63, 64, 65, 300, 0 };
+        for (uint32_t b = 0; b < sizeof(bounds) / sizeof(bounds[0]); b++) {
+            for (uint32_t s = 0; strides[s] != 0; s++) {
+                if (!S_check_range(sort_cache, doc_max, bounds[b][0],
+                                   bounds[b][1], strides[s])) {
+                    agree = false;
+                }
+            }
+        }
+        TEST_TRUE(runner, agree, "RangeMatcher with %d-bit ords",
+                  (int)SortCache_Get_Ord_Width(sort_cache));
+
+        DECREF(reader);
+        DECREF(folder);
+        DECREF(type);
+        DECREF(schema);
+    }
+
+    DECREF(field);
+}
 
 void
 TestRangeQuery_Run_IMP(TestRangeQuery *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 5);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 10);
     test_Dump_Load_and_Equals(runner);
+    test_RangeMatcher(runner);
 }
 
 
@@ -23,6 +23,7 @@
 #include "Lucy/Test.h"
 #include "Lucy/Test/Search/TestSeriesMatcher.h"
 #include "Lucy/Search/BitVecMatcher.h"
+#include "Lucy/Search/Collector.h"
 #include "Lucy/Search/SeriesMatcher.h"
 
 TestSeriesMatcher*
@@ -129,10 +130,82 @@ test_matrix(TestBatchRunner *runner) {
     }
 }
 
+static BitVector*
+S_make_bit_vec(int32_t first, int32_t max, int32_t doc_inc) {
+    BitVector *bit_vec = BitVec_new(max);
+    for (int32_t doc_id = first; doc_id < max; doc_id += doc_inc) {
+        BitVec_Set(bit_vec, doc_id);
+    }
+    return bit_vec;
+}
+
+static void
+test_blocks(TestBatchRunner *runner) {
+    const int32_t doc_max = 1000;
+    BitVector *matches   = S_make_bit_vec(1, doc_max, 3);
+    BitVector *deleted   = S_make_bit_vec(2, doc_max, 5);
+    BitVector *collected = BitVec_new(doc_max);
+
+    // Next_Block() should yield the same doc ids as Next().
+    {
+        BitVecMatcher *by_one   = BitVecMatcher_new(matches);
+        BitVecMatcher *by_block = BitVecMatcher_new(matches);
+        int32_t  doc_ids[MATCHER_BLOCK_SIZE];
+        uint32_t num_in_agreement = 0;
+        uint32_t num_docs;
+        bool     agree = true;
+        do {
+            num_docs = BitVecMatcher_Next_Block(by_block, doc_ids, NULL,
+                                                MATCHER_BLOCK_SIZE);
+            for (uint32_t i = 0; i < num_docs; i++) {
+                if (doc_ids[i] != BitVecMatcher_Next(by_one)) {
+                    agree = false;
+                }
+                else {
+                    num_in_agreement++;
+                }
+            }
+        } while (num_docs == MATCHER_BLOCK_SIZE);
+        TEST_TRUE(runner,
+                  agree
+                  && num_in_agreement == BitVec_Count(matches)
+                  && BitVecMatcher_Next(by_one) == 0,
+                  "Next_Block agrees with Next");
+        DECREF(by_one);
+        DECREF(by_block);
+    }
+
+    // Collect() should skip deleted docs when feeding blocks.
+    {
+        BitVecMatcher *matcher   = BitVecMatcher_new(matches);
+        BitVecMatcher *deletions = BitVecMatcher_new(deleted);
+        BitCollector  *collector
+            = BitColl_init((BitCollector*)VTable_Make_Obj(BITCOLLECTOR),
+                           collected);
+        BitVecMatcher_Collect(matcher, (Collector*)collector,
+                              (Matcher*)deletions);
+        bool agree = true;
+        for (int32_t doc_id = 0; doc_id < doc_max; doc_id++) {
+            bool wanted = BitVec_Get(matches, doc_id)
+                          && !BitVec_Get(deleted, doc_id);
+            if (wanted != BitVec_Get(collected, doc_id)) { agree = false; }
+        }
+        TEST_TRUE(runner, agree, "Collect with deletions via blocks");
+        DECREF(matcher);
+        DECREF(deletions);
+        DECREF(collector);
+    }
+
+    DECREF(matches);
+    DECREF(deleted);
+    DECREF(collected);
+}
+
 void
 TestSeriesMatcher_Run_IMP(TestSeriesMatcher *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 135);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 137);
     test_matrix(runner);
+    test_blocks(runner);
 }
 
 
@@ -33,13 +33,23 @@
 #include "Lucy/Document/Doc.h"
 #include "Lucy/Document/HitDoc.h"
 #include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SegWriter.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/SortCache/TextSortCache.h"
+#include "Lucy/Index/SortReader.h"
 #include "Lucy/Plan/FullTextType.h"
 #include "Lucy/Plan/NumericType.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Plan/StringType.h"
 #include "Lucy/Search/Hits.h"
 #include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchAllQuery.h"
+#include "Lucy/Search/MatchDoc.h"
 #include "Lucy/Search/SortRule.h"
+#include "Lucy/Search/TopDocs.h"
 #include "Lucy/Store/RAMFolder.h"
 
 static String *air_str;
@@ -629,11 +639,327 @@ test_sort_spec(TestBatchRunner *runner) {
     DECREF(folder);
 }
 
+// Add docs whose "num" values are a scrambled sequence.
+static void
+S_add_scrambled(Indexer *indexer, String *num_field, String *id_field,
+                int32_t start, int32_t end) {
+    for (int32_t i = start; i < end; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        String *num = Str_newf("%i32", (i * 7919) % 1000);
+        String *id  = Str_newf("%i32", i);
+        Doc_Store(doc, num_field, (Obj*)num);
+        Doc_Store(doc, id_field, (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(num);
+        DECREF(doc);
+    }
+}
+
+// Verify that "num" values ascend within doc ids [first, last].
+static bool
+S_ascending(IndexSearcher *searcher, String *num_field, int32_t first,
+            int32_t last) {
+    int64_t prev = -1;
+    for (int32_t doc_id = first; doc_id <= last; doc_id++) {
+        HitDoc *doc = IxSearcher_Fetch_Doc(searcher, doc_id);
+        Obj *value = HitDoc_Extract(doc, num_field);
+        int64_t num = Obj_To_I64(value);
+        DECREF(value);
+        DECREF(doc);
+        if (num < prev) { return false; }
+        prev = num;
+    }
+    return true;
+}
+
+static TopDocs*
+S_top_docs(IndexSearcher *searcher, SortRule *first, SortRule *second,
+           bool early_termination) {
+    VArray *rules = VA_new(2);
+    VA_Push(rules, INCREF(first));
+    if (second) { VA_Push(rules, INCREF(second)); }
+    SortSpec      *spec  = SortSpec_new(rules);
+    MatchAllQuery *query = MatchAllQuery_new();
+    IxSearcher_Set_Early_Termination(searcher, early_termination);
+    TopDocs *top_docs = IxSearcher_Top_Docs(searcher, (Query*)query, 10, spec);
+    DECREF(query);
+    DECREF(spec);
+    DECREF(rules);
+    return top_docs;
+}
+
+static bool
+S_same_docs(TopDocs *a, TopDocs *b) {
+    VArray *a_docs = TopDocs_Get_Match_Docs(a);
+    VArray *b_docs = TopDocs_Get_Match_Docs(b);
+    if (VA_Get_Size(a_docs) != VA_Get_Size(b_docs)) { return false; }
+    for (uint32_t i = 0, max = VA_Get_Size(a_docs); i < max; i++) {
+        MatchDoc *a_doc = (MatchDoc*)VA_Fetch(a_docs, i);
+        MatchDoc *b_doc = (MatchDoc*)VA_Fetch(b_docs, i);
+        if (MatchDoc_Get_Doc_ID(a_doc) != MatchDoc_Get_Doc_ID(b_doc)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void
+test_index_sort(TestBatchRunner *runner) {
+    Schema     *schema    = Schema_new();
+    RAMFolder  *folder    = RAMFolder_new(NULL);
+    String     *num_field = Str_newf("num");
+    String     *id_field  = Str_newf("id");
+    StringType *id_type   = StringType_new();
+    Int32Type  *num_type  = Int32Type_new();
+    Int32Type_Set_Indexed(num_type, false);
+    Int32Type_Set_Sortable(num_type, true);
+    Schema_Spec_Field(schema, id_field, (FieldType*)id_type);
+    Schema_Spec_Field(schema, num_field, (FieldType*)num_type);
+    SortRule *by_num     = SortRule_new(SortRule_FIELD, num_field, false);
+    SortRule *by_num_rev = SortRule_new(SortRule_FIELD, num_field, true);
+    SortRule *by_score   = SortRule_new(SortRule_SCORE, NULL, false);
+    Schema_Set_Index_Sort(schema, by_num);
+
+    {
+        Hash   *dump   = Schema_Dump(schema);
+        Schema *loaded = Schema_Load(schema, (Obj*)dump);
+        SortRule *index_sort = Schema_Get_Index_Sort(loaded);
+        TEST_TRUE(runner,
+                  index_sort
+                  && Str_Equals(SortRule_Get_Field(index_sort),
+                                (Obj*)num_field)
+                  && !SortRule_Get_Reverse(index_sort),
+                  "Index sort survives Dump/Load");
+        DECREF(loaded);
+        DECREF(dump);
+    }
+
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    S_add_scrambled(indexer, num_field, id_field, 0, 300);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    TEST_TRUE(runner, S_ascending(searcher, num_field, 1, 300),
+              "Doc ids follow the index sort");
+    DECREF(searcher);
+
+    // Delete some docs, add more, and merge everything into one segment.
+    indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t i = 0; i < 10; i++) {
+        String *id = Str_newf("%i32", i);
+        Indexer_Delete_By_Term(indexer, id_field, (Obj*)id);
+        DECREF(id);
+    }
+    S_add_scrambled(indexer, num_field, id_field, 300, 600);
+    Indexer_Optimize(indexer);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    searcher = IxSearcher_new((Obj*)folder);
+    IndexReader *reader      = IxSearcher_Get_Reader(searcher);
+    VArray      *seg_readers = IxReader_Seg_Readers(reader);
+    SegReader   *seg_reader  = (SegReader*)VA_Fetch(seg_readers, 0);
+    Hash        *metadata
+        = (Hash*)Seg_Fetch_Metadata_Utf8(SegReader_Get_Segment(seg_reader),
+                                         "index_sort", 10);
+    VArray *runs = metadata
+                   ? (VArray*)Hash_Fetch_Utf8(metadata, "runs", 4)
+                   : NULL;
+    TEST_TRUE(runner,
+              VA_Get_Size(seg_readers) == 1
+              && runs && VA_Get_Size(runs) == 2
+              && Obj_To_I64(VA_Fetch(runs, 1)) == 301
+              && S_ascending(searcher, num_field, 1, 300)
+              && S_ascending(searcher, num_field, 301, 590),
+              "Merging keeps sorted runs");
+    DECREF(seg_readers);
+
+    TopDocs *full  = S_top_docs(searcher, by_num, NULL, false);
+    TopDocs *early = S_top_docs(searcher, by_num, NULL, true);
+    TEST_TRUE(runner, S_same_docs(full, early),
+              "Early termination finds the same top docs");
+    TEST_TRUE(runner,
+              TopDocs_Get_Total_Hits(full) == 590
+              && TopDocs_Get_Total_Hits(early) < 590,
+              "Early termination skips docs: %u32 of %u32",
+              TopDocs_Get_Total_Hits(early), TopDocs_Get_Total_Hits(full));
+    DECREF(early);
+    DECREF(full);
+
+    full  = S_top_docs(searcher, by_num, by_score, false);
+    early = S_top_docs(searcher, by_num, by_score, true);
+    TEST_TRUE(runner,
+              S_same_docs(full, early)
+              && TopDocs_Get_Total_Hits(early) < 590,
+              "Early termination with a tie-breaking rule");
+    DECREF(early);
+    DECREF(full);
+
+    full  = S_top_docs(searcher, by_num_rev, NULL, false);
+    early = S_top_docs(searcher, by_num_rev, NULL, true);
+    TEST_TRUE(runner,
+              S_same_docs(full, early)
+              && TopDocs_Get_Total_Hits(early) == 590,
+              "No early termination against the index sort");
+    DECREF(early);
+    DECREF(full);
+
+    DECREF(searcher);
+
+    // A small buffer threshold splits a segment into several sorted runs.
+    RAMFolder *spill_folder = RAMFolder_new(NULL);
+    SegWriter_set_default_mem_thresh(4000);
+    indexer = Indexer_new(schema, (Obj*)spill_folder, NULL, 0);
+    S_add_scrambled(indexer, num_field, id_field, 0, 300);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    SegWriter_set_default_mem_thresh(0x1000000);
+    searcher    = IxSearcher_new((Obj*)spill_folder);
+    reader      = IxSearcher_Get_Reader(searcher);
+    seg_readers = IxReader_Seg_Readers(reader);
+    seg_reader  = (SegReader*)VA_Fetch(seg_readers, 0);
+    metadata
+        = (Hash*)Seg_Fetch_Metadata_Utf8(SegReader_Get_Segment(seg_reader),
+                                         "index_sort", 10);
+    runs = metadata ? (VArray*)Hash_Fetch_Utf8(metadata, "runs", 4) : NULL;
+    bool runs_sorted = runs && VA_Get_Size(runs) > 1;
+    for (uint32_t i = 0; runs_sorted && i < VA_Get_Size(runs); i++) {
+        int32_t first = (int32_t)Obj_To_I64(VA_Fetch(runs, i));
+        int32_t last  = i + 1 < VA_Get_Size(runs)
+                        ? (int32_t)Obj_To_I64(VA_Fetch(runs, i + 1)) - 1
+                        : 300;
+        runs_sorted = S_ascending(searcher, num_field, first, last);
+    }
+    full  = S_top_docs(searcher, by_num, NULL, false);
+    early = S_top_docs(searcher, by_num, NULL, true);
+    TEST_TRUE(runner, runs_sorted && S_same_docs(full, early),
+              "Buffered docs spill into several sorted runs");
+    DECREF(early);
+    DECREF(full);
+    DECREF(seg_readers);
+    DECREF(searcher);
+    DECREF(spill_folder);
+
+    DECREF(by_score);
+    DECREF(by_num_rev);
+    DECREF(by_num);
+    DECREF(num_type);
+    DECREF(id_type);
+    DECREF(id_field);
+    DECREF(num_field);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void
+test_text_sort_cache(TestBatchRunner *runner) {
+    Schema     *schema = Schema_new();
+    RAMFolder  *folder = RAMFolder_new(NULL);
+    String     *field  = Str_newf("url");
+    String     *other  = Str_newf("other");
+    StringType *type   = StringType_new();
+    StringType_Set_Sortable(type, true);
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+    Schema_Spec_Field(schema, other, (FieldType*)type);
+
+    // Two segments, each with one doc lacking a value.
+    for (int32_t seg = 0; seg < 2; seg++) {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        for (int32_t i = 0; i < 50; i++) {
+            Doc *doc = Doc_new(NULL, 0);
+            String *url = Str_newf("http://example.com/%i32", i * 2 + seg);
+            Doc_Store(doc, i == 7 ? other : field, (Obj*)url);
+            Indexer_Add_Doc(indexer, doc, 1.0f);
+            DECREF(url);
+            DECREF(doc);
+        }
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    IndexReader   *reader   = IxSearcher_Get_Reader(searcher);
+    VArray        *seg_readers = IxReader_Seg_Readers(reader);
+    SegReader     *seg_reader  = (SegReader*)VA_Fetch(seg_readers, 0);
+    SortReader    *sort_reader = (SortReader*)SegReader_Fetch(
+                                     seg_reader, VTable_Get_Name(SORTREADER));
+    TextSortCache *cache = (TextSortCache*)SortReader_Fetch_Sort_Cache(
+                               sort_reader, field);
+    int32_t cardinality = TextSortCache_Get_Cardinality(cache);
+    int32_t null_ord    = TextSortCache_Get_Null_Ord(cache);
+
+    bool values_match = true;
+    bool finds_match  = true;
+    for (int32_t ord = 0; ord < cardinality; ord++) {
+        size_t      size;
+        const char *ptr   = TextSortCache_Value_Ptr(cache, ord, &size);
+        String     *value = (String*)TextSortCache_Value(cache, ord);
+        if (ord == null_ord) {
+            if (ptr || value) { values_match = false; }
+        }
+        else if (!ptr || !value
+                 || !Str_Equals_Utf8(value, ptr, size)) {
+            values_match = false;
+        }
+        else if (TextSortCache_Find(cache, (Obj*)value) != ord) {
+            finds_match = false;
+        }
+        DECREF(value);
+    }
+    TEST_TRUE(runner, cardinality == 50 && null_ord == 49 && values_match,
+              "Value_Ptr matches Value, NULL for null ord");
+    TEST_TRUE(runner, finds_match, "Find locates every value");
+    String *between = Str_newf("http://example.com/1");
+    String *first   = (String*)TextSortCache_Value(cache, 0);
+    TEST_TRUE(runner,
+              TextSortCache_Find(cache, (Obj*)between) == 0
+              && Str_Equals_Utf8(first, "http://example.com/0", 20),
+              "Find returns predecessor of absent term");
+    DECREF(first);
+    DECREF(between);
+
+    // Values collected for sorting wrap the mapped sort data; the hits
+    // handed back must hold copies.
+    SortRule *by_url = SortRule_new(SortRule_FIELD, field, false);
+    size_t      first_size;
+    const char *data_start = TextSortCache_Value_Ptr(cache, 0, &first_size);
+    TopDocs *top_docs = S_top_docs(searcher, by_url, NULL, false);
+    VArray  *match_docs = TopDocs_Get_Match_Docs(top_docs);
+    bool sorted = VA_Get_Size(match_docs) == 10;
+    bool copied = true;
+    String *prev = NULL;
+    for (uint32_t i = 0, max = VA_Get_Size(match_docs); i < max; i++) {
+        MatchDoc *match_doc = (MatchDoc*)VA_Fetch(match_docs, i);
+        VArray   *values    = MatchDoc_Get_Values(match_doc);
+        String   *value     = (String*)VA_Fetch(values, 0);
+        if (!value) { sorted = false; break; }
+        if (prev && Str_Compare_To(prev, (Obj*)value) > 0) { sorted = false; }
+        const char *ptr = Str_Get_Ptr8(value);
+        if (ptr >= data_start && ptr < data_start + 2000) { copied = false; }
+        prev = value;
+    }
+    TEST_TRUE(runner, sorted, "sort by text values across segments");
+    TEST_TRUE(runner, copied, "collected text values are copied out");
+    DECREF(top_docs);
+    DECREF(by_url);
+
+    DECREF(seg_readers);
+    DECREF(searcher);
+    DECREF(type);
+    DECREF(other);
+    DECREF(field);
+    DECREF(folder);
+    DECREF(schema);
+}
+
 void
 TestSortSpec_Run_IMP(TestSortSpec *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 18);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 31);
     S_init_strings();
     test_sort_spec(runner);
+    test_index_sort(runner);
+    test_text_sort_cache(runner);
     S_destroy_strings();
 }
 
@@ -23,7 +23,19 @@
 #include "Lucy/Test.h"
 #include "Lucy/Test/Search/TestTermQuery.h"
 #include "Lucy/Test/TestUtils.h"
+#include "Clownfish/CharBuf.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/Collector.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
 #include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
 
 TestTermQuery*
 TestTermQuery_new() {
@@ -57,10 +69,98 @@ test_Dump_Load_and_Equals(TestBatchRunner *runner) {
     DECREF(clone);
 }
 
+static RAMFolder*
+S_create_index(Schema *schema, String *field) {
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+
+    // Doc n holds "foo" n % 3 times, so that freqs and positions vary and
+    // some docs don't match at all.
+    for (uint32_t doc_num = 0; doc_num < 100; doc_num++) {
+        CharBuf *content = CB_new(0);
+        for (uint32_t i = 0; i < doc_num % 3; i++) {
+            CB_Cat_Trusted_Utf8(content, "foo bar ", 8);
+        }
+        CB_Cat_Trusted_Utf8(content, "baz", 3);
+        String *content_str = CB_Yield_String(content);
+        Doc *doc = Doc_new(NULL, 0);
+        Doc_Store(doc, field, (Obj*)content_str);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+        DECREF(content_str);
+        DECREF(content);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    return folder;
+}
+
+static void
+test_need_score(TestBatchRunner *runner) {
+    Schema            *schema    = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType      *type      = FullTextType_new((Analyzer*)tokenizer);
+    String            *field     = Str_newf("content");
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+    RAMFolder *folder = S_create_index(schema, field);
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    TermQuery     *query    = TestUtils_make_term_query("content", "foo");
+    TermQuery     *bar      = TestUtils_make_term_query("content", "bar");
+    Hits          *hits     = IxSearcher_Hits(searcher, (Obj*)query, 0, 100,
+                                              NULL);
+    BitVector     *bit_vec  = BitVec_new(IxSearcher_Doc_Max(searcher) + 1);
+    BitCollector  *collector
+        = BitColl_init((BitCollector*)VTable_Make_Obj(BITCOLLECTOR), bit_vec);
+
+    // BitCollector doesn't need scores, so this takes the doc-ids-only path.
+    IxSearcher_Collect(searcher, (Query*)query, (Collector*)collector);
+    TEST_INT_EQ(runner, BitVec_Count(bit_vec), Hits_Total_Hits(hits),
+                "Non-scoring collection finds as many docs as scoring search");
+    bool all_match = true;
+    HitDoc *hit_doc;
+    while (NULL != (hit_doc = Hits_Next(hits))) {
+        if (!BitVec_Get(bit_vec, HitDoc_Get_Doc_ID(hit_doc))) {
+            all_match = false;
+        }
+        DECREF(hit_doc);
+    }
+    TEST_TRUE(runner, all_match,
+              "Non-scoring collection finds the same docs as scoring search");
+    DECREF(hits);
+    DECREF(searcher);
+
+    // Delete_By_Term iterates postings without decoding them.
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    String  *foo     = Str_newf("foo");
+    Indexer_Delete_By_Term(indexer, field, (Obj*)foo);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    searcher = IxSearcher_new((Obj*)folder);
+    hits = IxSearcher_Hits(searcher, (Obj*)bar, 0, 10, NULL);
+    TEST_INT_EQ(runner, Hits_Total_Hits(hits), 0,
+                "Delete_By_Term removes every matching doc");
+
+    DECREF(foo);
+    DECREF(hits);
+    DECREF(searcher);
+    DECREF(collector);
+    DECREF(bit_vec);
+    DECREF(bar);
+    DECREF(query);
+    DECREF(folder);
+    DECREF(field);
+    DECREF(type);
+    DECREF(tokenizer);
+    DECREF(schema);
+}
+
 void
 TestTermQuery_Run_IMP(TestTermQuery *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 4);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 7);
     test_Dump_Load_and_Equals(runner);
+    test_need_score(runner);
 }
 
 
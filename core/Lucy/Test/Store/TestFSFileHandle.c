@@ -32,6 +32,8 @@
 #include "Lucy/Test/Store/TestFSFileHandle.h"
 #include "Lucy/Store/FSFileHandle.h"
 #include "Lucy/Store/FileWindow.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
 
 TestFSFileHandle*
 TestFSFH_new() {
@@ -248,13 +250,108 @@ test_Window(TestBatchRunner *runner) {
     remove(Str_Get_Ptr8(test_filename));
 }
 
+static void
+test_Copy_From(TestBatchRunner *runner) {
+    String *source_filename = (String*)SSTR_WRAP_UTF8("_fstest", 7);
+    String *dest_filename   = (String*)SSTR_WRAP_UTF8("_fstest2", 8);
+    char buf[8];
+
+    remove(Str_Get_Ptr8(source_filename));
+    remove(Str_Get_Ptr8(dest_filename));
+    FSFileHandle *source = FSFH_open(source_filename,
+                                     FH_CREATE | FH_WRITE_ONLY | FH_EXCLUSIVE);
+    FSFH_Write(source, "foobarbaz", 9);
+    if (!FSFH_Close(source)) { RETHROW(INCREF(Err_get_error())); }
+    DECREF(source);
+    source = FSFH_open(source_filename, FH_READ_ONLY);
+
+    FSFileHandle *dest = FSFH_open(dest_filename,
+                                   FH_CREATE | FH_WRITE_ONLY | FH_EXCLUSIVE);
+    FSFH_Write(dest, "xx", 2);
+    TEST_TRUE(runner, FSFH_Copy_From(dest, (FileHandle*)source, 5, 6) == 0,
+              "Copy_From() past EOF copies nothing");
+    int64_t copied = FSFH_Copy_From(dest, (FileHandle*)source, 3, 6);
+    TEST_TRUE(runner, copied >= 0 && copied <= 6,
+              "Copy_From() copies no more than requested");
+    if (copied < 6) {
+        FSFH_Write(dest, "barbaz" + copied, (size_t)(6 - copied));
+    }
+    TEST_TRUE(runner, FSFH_Length(dest) == 8, "Length after Copy_From()");
+    if (!FSFH_Close(dest)) { RETHROW(INCREF(Err_get_error())); }
+    DECREF(dest);
+
+    dest = FSFH_open(dest_filename, FH_READ_ONLY);
+    TEST_TRUE(runner, FSFH_Read(dest, buf, 0, 8)
+              && strncmp(buf, "xxbarbaz", 8) == 0,
+              "Copy_From() appends content");
+
+    DECREF(dest);
+    DECREF(source);
+    remove(Str_Get_Ptr8(source_filename));
+    remove(Str_Get_Ptr8(dest_filename));
+}
+
+static void
+test_Absorb(TestBatchRunner *runner) {
+    String *source_filename = (String*)SSTR_WRAP_UTF8("_fstest", 7);
+    String *dest_filename   = (String*)SSTR_WRAP_UTF8("_fstest2", 8);
+    const int64_t len = 100000;
+
+    remove(Str_Get_Ptr8(source_filename));
+    remove(Str_Get_Ptr8(dest_filename));
+    OutStream *outstream = OutStream_open((Obj*)source_filename);
+    for (int64_t i = 0; i < len; i++) {
+        OutStream_Write_U8(outstream, (uint8_t)(i % 251));
+    }
+    OutStream_Close(outstream);
+    DECREF(outstream);
+
+    // Absorb the whole file, then a sub-range as seen through Reopen().
+    InStream *instream = InStream_open((Obj*)source_filename);
+    InStream *substream = InStream_Reopen(instream, NULL, 1001, 5000);
+    outstream = OutStream_open((Obj*)dest_filename);
+    OutStream_Write_U8(outstream, 42);
+    OutStream_Absorb(outstream, instream);
+    TEST_TRUE(runner, OutStream_Tell(outstream) == len + 1,
+              "Tell() after Absorb()");
+    OutStream_Absorb(outstream, substream);
+    TEST_TRUE(runner, OutStream_Tell(outstream) == len + 5001,
+              "Tell() after absorbing sub-range");
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    DECREF(substream);
+    DECREF(instream);
+
+    instream = InStream_open((Obj*)dest_filename);
+    TEST_TRUE(runner, InStream_Length(instream) == len + 5001,
+              "Length after Absorb()");
+    bool content_ok = InStream_Read_U8(instream) == 42;
+    for (int64_t i = 0; i < len; i++) {
+        if (InStream_Read_U8(instream) != (uint8_t)(i % 251)) {
+            content_ok = false;
+        }
+    }
+    for (int64_t i = 1001; i < 6001; i++) {
+        if (InStream_Read_U8(instream) != (uint8_t)(i % 251)) {
+            content_ok = false;
+        }
+    }
+    TEST_TRUE(runner, content_ok, "Absorb() copies content");
+    DECREF(instream);
+
+    remove(Str_Get_Ptr8(source_filename));
+    remove(Str_Get_Ptr8(dest_filename));
+}
+
 void
 TestFSFH_Run_IMP(TestFSFileHandle *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 46);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 54);
     test_open(runner);
     test_Read_Write(runner);
     test_Close(runner);
     test_Window(runner);
+    test_Copy_From(runner);
+    test_Absorb(runner);
 }
 
 
@@ -0,0 +1,236 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+// fork, _exit
+#ifdef CHY_HAS_UNISTD_H
+  #include <unistd.h>
+#endif
+
+// waitpid
+#ifdef CHY_HAS_SYS_WAIT_H
+  #include <sys/wait.h>
+#endif
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Store/TestPosixLock.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Store/Lock.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/PosixLock.h"
+#include "Lucy/Store/PosixLockFactory.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestPosixLock*
+TestPosixLock_new() {
+    return (TestPosixLock*)VTable_Make_Obj(TESTPOSIXLOCK);
+}
+
+static Folder*
+S_create_test_folder() {
+    String   *test_dir = (String*)SSTR_WRAP_UTF8("_posixlocktest", 14);
+    FSFolder *folder   = FSFolder_new(test_dir);
+    FSFolder_Initialize(folder);
+    if (!FSFolder_Check(folder)) {
+        RETHROW(INCREF(Err_get_error()));
+    }
+    return (Folder*)folder;
+}
+
+static void
+S_destroy_test_folder(Folder *folder) {
+    String *test_dir = (String*)SSTR_WRAP_UTF8("_posixlocktest", 14);
+    String *locks    = (String*)SSTR_WRAP_UTF8("locks", 5);
+    Folder *parent   = (Folder*)FSFolder_new((String*)SSTR_WRAP_UTF8(".", 1));
+    Folder_Delete_Tree(folder, locks);
+    Folder_Delete(parent, test_dir);
+    DECREF(parent);
+    DECREF(folder);
+}
+
+static void
+test_exclusive(TestBatchRunner *runner, LockFactory *factory, Folder *folder) {
+    String *name      = (String*)SSTR_WRAP_UTF8("foo", 3);
+    String *lock_path = (String*)SSTR_WRAP_UTF8("locks/foo.lock", 14);
+    Lock *lock  = LockFact_Make_Lock(factory, name, 0, 100);
+    Lock *other = LockFact_Make_Lock(factory, name, 0, 100);
+
+    TEST_TRUE(runner, Lock_Is_A(lock, POSIXLOCK), "Make_Lock");
+    TEST_FALSE(runner, Lock_Shared(lock), "Shared() false");
+    TEST_FALSE(runner, Lock_Is_Locked(lock), "not locked before Obtain()");
+    TEST_TRUE(runner, Lock_Obtain(lock), "Obtain()");
+    TEST_TRUE(runner, Lock_Is_Locked(other), "Is_Locked()");
+    TEST_TRUE(runner, Folder_Exists(folder, lock_path), "lock file created");
+
+    Err_set_error(NULL);
+    TEST_FALSE(runner, Lock_Request(other),
+               "second exclusive lock within process fails");
+    TEST_TRUE(runner, Err_get_error() && Err_Is_A(Err_get_error(), LOCKERR),
+              "failed Request() sets LockErr");
+    TEST_FALSE(runner, Lock_Request(lock), "double Request() fails");
+
+    Lock_Clear_Stale(other);
+    TEST_TRUE(runner, Folder_Exists(folder, lock_path),
+              "Clear_Stale() leaves held lock alone");
+
+    Lock_Release(lock);
+    TEST_FALSE(runner, Lock_Is_Locked(other), "Release()");
+    TEST_FALSE(runner, Folder_Exists(folder, lock_path),
+               "Release() removes lock file");
+    TEST_TRUE(runner, Lock_Obtain(other), "Obtain() after Release()");
+
+    DECREF(other);
+    TEST_FALSE(runner, Lock_Is_Locked(lock), "Destroy() releases lock");
+    DECREF(lock);
+}
+
+static void
+test_shared(TestBatchRunner *runner, LockFactory *factory, Folder *folder) {
+    String *name      = (String*)SSTR_WRAP_UTF8("bar", 3);
+    String *lock_path = (String*)SSTR_WRAP_UTF8("locks/bar.lock", 14);
+    Lock *lock      = LockFact_Make_Shared_Lock(factory, name, 0, 100);
+    Lock *other     = LockFact_Make_Shared_Lock(factory, name, 0, 100);
+    Lock *exclusive = LockFact_Make_Lock(factory, name, 0, 100);
+
+    TEST_TRUE(runner, Lock_Shared(lock), "Shared() true");
+    TEST_TRUE(runner, Lock_Obtain(lock), "Obtain() shared lock");
+    TEST_TRUE(runner, Lock_Obtain(other), "Obtain() second shared lock");
+    TEST_FALSE(runner, Lock_Request(exclusive),
+               "exclusive lock blocked by shared locks");
+
+    Lock_Release(lock);
+    TEST_TRUE(runner, Lock_Is_Locked(lock),
+              "still locked while another shared lock is held");
+    TEST_TRUE(runner, Folder_Exists(folder, lock_path),
+              "lock file survives while shared lock is held");
+    Lock_Release(other);
+    TEST_FALSE(runner, Lock_Is_Locked(lock),
+               "unlocked once all shared locks are released");
+    TEST_FALSE(runner, Folder_Exists(folder, lock_path),
+               "last Release() removes lock file");
+
+    DECREF(exclusive);
+    DECREF(other);
+    DECREF(lock);
+}
+
+static void
+test_stale(TestBatchRunner *runner, LockFactory *factory, Folder *folder) {
+    String *name      = (String*)SSTR_WRAP_UTF8("baz", 3);
+    String *lock_path = (String*)SSTR_WRAP_UTF8("locks/baz.lock", 14);
+    Lock *lock = LockFact_Make_Lock(factory, name, 0, 100);
+
+    // A lock file from another host with nobody holding it.
+    OutStream *outstream = Folder_Open_Out(folder, lock_path);
+    const char *foreign = "{\"host\":\"elsewhere\",\"name\":\"baz\",\"pid\":\"1\"}";
+    OutStream_Write_Bytes(outstream, foreign, strlen(foreign));
+    OutStream_Close(outstream);
+    DECREF(outstream);
+
+    TEST_FALSE(runner, Lock_Is_Locked(lock),
+               "leftover lock file without record lock isn't locked");
+    Lock_Clear_Stale(lock);
+    TEST_TRUE(runner, Folder_Exists(folder, lock_path),
+              "Clear_Stale() leaves other hosts' lock files alone");
+    Folder_Delete(folder, lock_path);
+
+    // An empty lock file from a process which died right after creating it.
+    outstream = Folder_Open_Out(folder, lock_path);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    Lock_Clear_Stale(lock);
+    TEST_FALSE(runner, Folder_Exists(folder, lock_path),
+               "Clear_Stale() removes unowned lock file");
+
+    DECREF(lock);
+}
+
+static void
+test_other_process(TestBatchRunner *runner, LockFactory *factory) {
+#if defined(CHY_HAS_UNISTD_H) && defined(CHY_HAS_SYS_WAIT_H)
+    String *name = (String*)SSTR_WRAP_UTF8("qux", 3);
+    Lock *lock = LockFact_Make_Lock(factory, name, 0, 100);
+    Lock_Obtain(lock);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Child: the lock must be visible through the kernel alone.
+        Lock *child_lock = LockFact_Make_Lock(factory, name, 0, 100);
+        int status = 0;
+        if (!Lock_Is_Locked(child_lock)) { status |= 1; }
+        if (Lock_Request(child_lock))    { status |= 2; }
+        _exit(status);
+    }
+    int status = -1;
+    waitpid(pid, &status, 0);
+    TEST_TRUE(runner, WIFEXITED(status) && !(WEXITSTATUS(status) & 1),
+              "Is_Locked() sees lock held by another process");
+    TEST_TRUE(runner, WIFEXITED(status) && !(WEXITSTATUS(status) & 2),
+              "Request() fails while another process holds lock");
+
+    Lock_Release(lock);
+    DECREF(lock);
+#else
+    UNUSED_VAR(factory);
+    SKIP(runner, "No fork()");
+    SKIP(runner, "No fork()");
+#endif
+}
+
+static void
+test_fallback(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+    String *host = (String*)SSTR_WRAP_UTF8("testhost", 8);
+    String *name = (String*)SSTR_WRAP_UTF8("foo", 3);
+    PosixLockFactory *factory = PosixLockFact_new((Folder*)folder, host);
+    Lock *lock = PosixLockFact_Make_Lock(factory, name, 0, 100);
+    Lock *shlock = PosixLockFact_Make_Shared_Lock(factory, name, 0, 100);
+    TEST_TRUE(runner, Lock_Is_A(lock, LOCKFILELOCK),
+              "falls back to LockFileLock for non-FS Folder");
+    TEST_TRUE(runner, Lock_Shared(shlock),
+              "falls back to SharedLock for non-FS Folder");
+    DECREF(shlock);
+    DECREF(lock);
+    DECREF(factory);
+    DECREF(folder);
+}
+
+void
+TestPosixLock_Run_IMP(TestPosixLock *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 29);
+    if (!PosixLock_supported()) {
+        for (int i = 0; i < 29; i++) {
+            SKIP(runner, "POSIX locks not supported");
+        }
+        return;
+    }
+
+    Folder *folder = S_create_test_folder();
+    String *host = (String*)SSTR_WRAP_UTF8("testhost", 8);
+    LockFactory *factory = (LockFactory*)PosixLockFact_new(folder, host);
+    test_exclusive(runner, factory, folder);
+    test_shared(runner, factory, folder);
+    test_stale(runner, factory, folder);
+    test_other_process(runner, factory);
+    test_fallback(runner);
+    DECREF(factory);
+    S_destroy_test_folder(folder);
+}
+
@@ -32,6 +32,7 @@
 #include "Lucy/Search/SortSpec.h"
 #include "Lucy/Search/MatchDoc.h"
 #include "Lucy/Search/TopDocs.h"
+#include "Lucy/Search/Collector/AggregateCollector.h"
 
 void
 Freezer_freeze(Obj *obj, OutStream *outstream) {
@@ -115,6 +116,9 @@ Freezer_serialize(Obj *obj, OutStream *outstream) {
     else if (Obj_Is_A(obj, SORTRULE)) {
         SortRule_Serialize((SortRule*)obj, outstream);
     }
+    else if (Obj_Is_A(obj, AGGREGATECOLLECTOR)) {
+        AggColl_Serialize((AggregateCollector*)obj, outstream);
+    }
     else {
         THROW(ERR, "Don't know how to serialize a %o",
               Obj_Get_Class_Name(obj));
@@ -194,6 +198,9 @@ Freezer_deserialize(Obj *obj, InStream *instream) {
     else if (Obj_Is_A(obj, SORTRULE)) {
         obj = (Obj*)SortRule_Deserialize((SortRule*)obj, instream);
     }
+    else if (Obj_Is_A(obj, AGGREGATECOLLECTOR)) {
+        obj = (Obj*)AggColl_Deserialize((AggregateCollector*)obj, instream);
+    }
     else {
         THROW(ERR, "Don't know how to deserialize a %o",
               Obj_Get_Class_Name(obj));
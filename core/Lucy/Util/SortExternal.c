@@ -35,6 +35,11 @@ S_absorb_slices(SortExternal *self, SortExternalIVARS *ivars,
 static uint8_t*
 S_find_endpost(SortExternal *self, SortExternalIVARS *ivars);
 
+// Merge the sorted slices of the main cache into the scratch buffer.
+static void
+S_merge_slices(SortExternal *self, SortExternalIVARS *ivars,
+               CFISH_Sort_Compare_t compare);
+
 // Determine how many cache items are less than or equal to [endpost].
 static uint32_t
 S_find_slice_size(SortExternal *self, SortExternalIVARS *ivars,
@@ -267,45 +272,105 @@ S_absorb_slices(SortExternal *self, SortExternalIVARS *ivars,
         total += slice_sizes[i];
     }
 
-    // The main cache now consists of several slices.  Sort the main cache,
-    // but exploit the fact that each slice is already sorted.
-    if (ivars->scratch_cap < ivars->cache_cap) {
-        ivars->scratch_cap = ivars->cache_cap;
-        ivars->scratch = (uint8_t*)REALLOCATE(
-                            ivars->scratch, ivars->scratch_cap * width);
+    // The main cache now consists of several slices, each already sorted.
+    // Merge them in a single pass through a loser tree.
+    if (ivars->num_slices > 1) {
+        if (ivars->scratch_cap < ivars->cache_cap) {
+            ivars->scratch_cap = ivars->cache_cap;
+            ivars->scratch = (uint8_t*)REALLOCATE(
+                                ivars->scratch, ivars->scratch_cap * width);
+        }
+        S_merge_slices(self, ivars, compare);
+
+        // Trade buffers rather than copying the merged elements back.
+        uint8_t *merged      = ivars->scratch;
+        uint32_t merged_cap  = ivars->scratch_cap;
+        ivars->scratch       = ivars->cache;
+        ivars->scratch_cap   = ivars->cache_cap;
+        ivars->cache         = merged;
+        ivars->cache_cap     = merged_cap;
     }
 
-    // Exploit previous sorting, rather than sort cache naively.
-    // Leave the first slice intact if the number of slices is odd. */
-    while (ivars->num_slices > 1) {
-        uint32_t i = 0;
-        uint32_t j = 0;
-
-        while (i < ivars->num_slices) {
-            if (ivars->num_slices - i >= 2) {
-                // Merge two consecutive slices.
-                const uint32_t merged_size = slice_sizes[i] + slice_sizes[i + 1];
-                Sort_merge(slice_starts[i], slice_sizes[i],
-                           slice_starts[i + 1], slice_sizes[i + 1], ivars->scratch,
-                           ivars->width, compare, self);
-                slice_sizes[j]  = merged_size;
-                slice_starts[j] = slice_starts[i];
-                memcpy(slice_starts[j], ivars->scratch, merged_size * width);
-                i += 2;
-                j += 1;
-            }
-            else if (ivars->num_slices - i >= 1) {
-                // Move single slice pointer.
-                slice_sizes[j]  = slice_sizes[i];
-                slice_starts[j] = slice_starts[i];
-                i += 1;
-                j += 1;
+    ivars->num_slices = 0;
+}
+
+// A loser tree over the slices being merged.  Node 0 holds the index of the
+// slice whose head sorts first; nodes 1 through num_slices - 1 hold the
+// losers of the matches played there.  Slice i sits at leaf position
+// num_slices + i, so the parent of any position p is p / 2.
+typedef struct {
+    uint8_t             **heads;
+    uint8_t             **ends;
+    uint32_t             *nodes;
+    uint32_t              num_slices;
+    CFISH_Sort_Compare_t  compare;
+    void                 *context;
+} SortExLoserTree;
+
+// Return true if the head of slice `a` sorts before the head of slice `b`.
+// Exhausted slices lose to everything; ties go to the earlier slice.
+static CFISH_INLINE bool
+SI_beats(SortExLoserTree *tree, uint32_t a, uint32_t b) {
+    if (tree->heads[a] == tree->ends[a]) { return false; }
+    if (tree->heads[b] == tree->ends[b]) { return true; }
+    int comparison = tree->compare(tree->context, tree->heads[a],
+                                   tree->heads[b]);
+    return comparison < 0 || (comparison == 0 && a < b);
+}
+
+// Play out the matches below `pos`, recording losers, and return the
+// winning slice.
+static uint32_t
+S_build_tree(SortExLoserTree *tree, uint32_t pos) {
+    if (pos >= tree->num_slices) { return pos - tree->num_slices; }
+    uint32_t left  = S_build_tree(tree, pos * 2);
+    uint32_t right = S_build_tree(tree, pos * 2 + 1);
+    if (SI_beats(tree, right, left)) {
+        tree->nodes[pos] = left;
+        return right;
+    }
+    tree->nodes[pos] = right;
+    return left;
+}
+
+static void
+S_merge_slices(SortExternal *self, SortExternalIVARS *ivars,
+               CFISH_Sort_Compare_t compare) {
+    const uint32_t num_slices = ivars->num_slices;
+    const size_t   width      = ivars->width;
+    SortExLoserTree tree;
+    tree.heads      = (uint8_t**)MALLOCATE(num_slices * sizeof(uint8_t*));
+    tree.ends       = (uint8_t**)MALLOCATE(num_slices * sizeof(uint8_t*));
+    tree.nodes      = (uint32_t*)MALLOCATE(num_slices * sizeof(uint32_t));
+    tree.num_slices = num_slices;
+    tree.compare    = compare;
+    tree.context    = self;
+    for (uint32_t i = 0; i < num_slices; i++) {
+        tree.heads[i] = ivars->slice_starts[i];
+        tree.ends[i]  = ivars->slice_starts[i] + ivars->slice_sizes[i] * width;
+    }
+    tree.nodes[0] = S_build_tree(&tree, 1);
+
+    // Each element costs one comparison per level of the tree.
+    uint8_t *dest = ivars->scratch;
+    for (uint32_t i = 0, max = ivars->cache_max; i < max; i++) {
+        uint32_t winner = tree.nodes[0];
+        memcpy(dest, tree.heads[winner], width);
+        dest += width;
+        tree.heads[winner] += width;
+        for (uint32_t pos = (winner + num_slices) / 2; pos > 0; pos /= 2) {
+            if (SI_beats(&tree, tree.nodes[pos], winner)) {
+                uint32_t loser   = winner;
+                winner           = tree.nodes[pos];
+                tree.nodes[pos]  = loser;
             }
         }
-        ivars->num_slices = j;
+        tree.nodes[0] = winner;
     }
 
-    ivars->num_slices = 0;
+    FREEMEM(tree.heads);
+    FREEMEM(tree.ends);
+    FREEMEM(tree.nodes);
 }
 
 void
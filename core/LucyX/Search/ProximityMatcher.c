@@ -280,7 +280,7 @@ ProximityMatcher_Calc_Proximity_Freq_IMP(ProximityMatcher *self) {
     size_t    amount        = anchors_remaining * sizeof(uint32_t);
     uint32_t *anchors_start = (uint32_t*)BB_Grow(ivars->anchor_set, amount);
     uint32_t *anchors_end   = anchors_start + anchors_remaining;
-    memcpy(anchors_start, post_ivars->prox, amount);
+    memcpy(anchors_start, ScorePost_Get_Prox(posting), amount);
 
     // Match the positions of other terms against the anchor set.
     for (uint32_t i = 1, max = ivars->num_elements; i < max; i++) {
@@ -288,7 +288,7 @@ ProximityMatcher_Calc_Proximity_Freq_IMP(ProximityMatcher *self) {
         // set (which is a copy), these won't be overwritten.
         ScorePosting *next_post = (ScorePosting*)PList_Get_Posting(plists[i]);
         ScorePostingIVARS *const next_post_ivars = ScorePost_IVARS(next_post);
-        uint32_t *candidates_start = next_post_ivars->prox;
+        uint32_t *candidates_start = ScorePost_Get_Prox(next_post);
         uint32_t *candidates_end   = candidates_start + next_post_ivars->freq;
 
         // Splice out anchors that don't match the next term.  Bail out if
@@ -22,10 +22,12 @@ $VERSION = eval $VERSION;
 sub bind_all {
     my $class = shift;
     $class->bind_backgroundmerger;
+    $class->bind_commitgroup;
     $class->bind_datareader;
     $class->bind_datawriter;
     $class->bind_deletionswriter;
     $class->bind_docreader;
+    $class->bind_docvaluesreader;
     $class->bind_indexmanager;
     $class->bind_indexreader;
     $class->bind_indexer;
@@ -74,6 +76,42 @@ END_CONSTRUCTOR
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_commitgroup {
+    my @exposed = qw(
+        Add
+        Commit
+        Get_Num_Commits
+        Get_Num_Syncs
+        Get_Sync_Micros
+        Get_Max_Sync_Micros
+    );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $group = Lucy::Index::CommitGroup->new;
+    for my $shard (@shards) {
+        my $indexer = Lucy::Index::Indexer->new( index => $shard );
+        $indexer->add_doc($_) for @{ $docs{$shard} };
+        $group->add($indexer);
+    }
+    $group->commit;
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $group = Lucy::Index::CommitGroup->new;
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Index::CommitGroup",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_datareader {
     my @exposed = qw(
         Get_Schema
@@ -200,6 +238,31 @@ END_SYNOPSIS
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_docvaluesreader {
+    my @exposed = qw( Fetch_Value Fetch_Values Fetch_Hit_Values Aggregator );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $values_reader
+        = $poly_reader->obtain("Lucy::Index::DocValuesReader");
+    my $hits   = $searcher->top_docs( query => $query, num_wanted => 10 );
+    my $prices = $values_reader->fetch_hit_values(
+        field    => 'price',
+        top_docs => $hits,
+    );
+END_SYNOPSIS
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Index::DocValuesReader",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_indexmanager {
     my @exposed = qw(
         Make_Write_Lock
@@ -341,6 +404,7 @@ sub bind_indexer {
         Delete_By_Term
         Delete_By_Query
         Delete_By_Doc_ID
+        Open_Reader
         Get_Schema
     );
     my @hand_rolled = qw( Add_Doc );
@@ -457,6 +521,20 @@ CODE:
     RETVAL = lucy_Indexer_TRUNCATE;
 OUTPUT: RETVAL
 
+int32_t
+NEAR_REAL_TIME(...)
+CODE:
+    CFISH_UNUSED_VAR(items);
+    RETVAL = lucy_Indexer_NEAR_REAL_TIME;
+OUTPUT: RETVAL
+
+int32_t
+DURABLE(...)
+CODE:
+    CFISH_UNUSED_VAR(items);
+    RETVAL = lucy_Indexer_DURABLE;
+OUTPUT: RETVAL
+
 void
 add_doc(self, ...)
     lucy_Indexer *self;
@@ -21,10 +21,17 @@ $VERSION = eval $VERSION;
 
 sub bind_all {
     my $class = shift;
+    $class->bind_aggregatecollector;
     $class->bind_andquery;
     $class->bind_collector;
     $class->bind_bitcollector;
+    $class->bind_boxquery;
+    $class->bind_cardinalitycollector;
     $class->bind_compiler;
+    $class->bind_facetcollector;
+    $class->bind_groupcollector;
+    $class->bind_groupdocscollector;
+    $class->bind_histogramcollector;
     $class->bind_hits;
     $class->bind_indexsearcher;
     $class->bind_leafquery;
@@ -40,16 +47,38 @@ sub bind_all {
     $class->bind_polysearcher;
     $class->bind_query;
     $class->bind_queryparser;
+    $class->bind_rangefacetcollector;
     $class->bind_rangequery;
     $class->bind_requiredoptionalquery;
     $class->bind_searcher;
     $class->bind_sortrule;
     $class->bind_sortspec;
     $class->bind_span;
+    $class->bind_statscollector;
     $class->bind_termquery;
     $class->bind_termcompiler;
 }
 
+sub bind_aggregatecollector {
+    my @exposed = qw( Merge Get_Num_Missing Get_Field );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    # Abstract base class.
+    $stats->merge($stats_from_other_shard);
+END_SYNOPSIS
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::Collector::AggregateCollector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_andquery {
     my @exposed = qw( Add_Child );
 
@@ -141,6 +170,69 @@ END_CONSTRUCTOR
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_boxquery {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    # Match all stores within a latitude/longitude rectangle.
+    my $box_query = Lucy::Search::BoxQuery->new(
+        fields       => [ 'lat', 'lon' ],
+        lower_bounds => [ 40.5, -74.3 ],
+        upper_bounds => [ 40.9, -73.7 ],
+    );
+    my $hits = $searcher->hits( query => $box_query );
+    ...
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $box_query = Lucy::Search::BoxQuery->new(
+        fields       => [ 'lat', 'lon', 'price' ],  # required
+        lower_bounds => [ 40.5, -74.3 ],            # required
+        upper_bounds => [ 40.9, -73.7, 100 ],       # required
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::BoxQuery",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
+sub bind_cardinalitycollector {
+    my @exposed = qw( Estimate );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $card_collector = Lucy::Search::Collector::CardinalityCollector->new(
+        field => 'user',
+    );
+    $searcher->collect(
+        collector => $card_collector,
+        query     => $query,
+    );
+    printf( "about %d distinct users\n", $card_collector->estimate );
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $card_collector = Lucy::Search::Collector::CardinalityCollector->new(
+        field => 'user',    # required
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::Collector::CardinalityCollector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_compiler {
     my @exposed = qw(
         Make_Matcher
@@ -186,6 +278,160 @@ END_CONSTRUCTOR_CODE_SAMPLE
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_facetcollector {
+    my @exposed = qw( Get_Counts Count Get_Num_Missing Top_Values Get_Field );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $facet_collector = Lucy::Search::Collector::FacetCollector->new(
+        field => 'category',
+    );
+    $searcher->collect(
+        collector => $facet_collector,
+        query     => $query,
+    );
+    for my $category ( @{ $facet_collector->top_values( num_wanted => 5 ) } ) {
+        my $count = $facet_collector->count($category);
+        print "$category ($count)\n";
+    }
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $facet_collector = Lucy::Search::Collector::FacetCollector->new(
+        field => 'category',    # required
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::Collector::FacetCollector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
+sub bind_groupcollector {
+    my @exposed = qw( Top_Groups Top_Group_Docs Get_Total_Hits Get_Field );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    # Best hit per site.
+    my $group_collector = Lucy::Search::Collector::GroupCollector->new(
+        field      => 'site',
+        num_groups => 10,
+    );
+    $searcher->collect(
+        collector => $group_collector,
+        query     => $query,
+    );
+    for my $match_doc ( @{ $group_collector->top_group_docs } ) {
+        my $doc = $searcher->fetch_doc( $match_doc->get_doc_id );
+        print "$doc->{site}: $doc->{title}\n";
+    }
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $group_collector = Lucy::Search::Collector::GroupCollector->new(
+        field      => 'site',    # required
+        num_groups => 10,        # default: 10
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::Collector::GroupCollector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
+sub bind_groupdocscollector {
+    my @exposed = qw( Get_Top_Docs Get_Groups );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    # Top three hits for each of the top sites.
+    my $docs_collector = Lucy::Search::Collector::GroupDocsCollector->new(
+        field          => 'site',
+        groups         => $group_collector->top_groups,
+        docs_per_group => 3,
+    );
+    $searcher->collect(
+        collector => $docs_collector,
+        query     => $query,
+    );
+    my $groups = $docs_collector->get_groups;
+    my $top_docs = $docs_collector->get_top_docs;
+    for my $tick ( 0 .. $#$groups ) {
+        my $group_docs = $top_docs->[$tick];
+        printf( "%s (%d hits)\n",
+            $groups->[$tick], $group_docs->get_total_hits );
+    }
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $docs_collector = Lucy::Search::Collector::GroupDocsCollector->new(
+        field          => 'site',                           # required
+        groups         => $group_collector->top_groups,    # required
+        docs_per_group => 3,                                # default: 1
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::Collector::GroupDocsCollector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
+sub bind_histogramcollector {
+    my @exposed = qw( Get_Buckets Count );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $histo_collector = Lucy::Search::Collector::HistogramCollector->new(
+        field    => 'price',
+        interval => 100,
+    );
+    $searcher->collect(
+        collector => $histo_collector,
+        query     => $query,
+    );
+    for my $start ( @{ $histo_collector->get_buckets } ) {
+        my $count = $histo_collector->count($start);
+        print "$start: $count\n";
+    }
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $histo_collector = Lucy::Search::Collector::HistogramCollector->new(
+        field    => 'price',    # required
+        interval => 100,        # required
+        offset   => 0,          # default: 0
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::Collector::HistogramCollector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_hits {
     my @exposed = qw( Next Total_Hits );
 
@@ -688,6 +934,40 @@ END_CONSTRUCTOR
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_rangefacetcollector {
+    my @exposed = qw( Num_Buckets Bucket_Count );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $price_collector = Lucy::Search::Collector::RangeFacetCollector->new(
+        field  => 'price',
+        bounds => [ 10, 50, 100 ],
+    );
+    $searcher->collect(
+        collector => $price_collector,
+        query     => $query,
+    );
+    my $under_ten = $price_collector->bucket_count(0);
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $price_collector = Lucy::Search::Collector::RangeFacetCollector->new(
+        field  => 'price',           # required
+        bounds => [ 10, 50, 100 ],   # required
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::Collector::RangeFacetCollector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_rangequery {
     my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
     my $synopsis = <<'END_SYNOPSIS';
@@ -925,6 +1205,39 @@ END_CONSTRUCTOR
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_statscollector {
+    my @exposed = qw( Get_Count Get_Sum Get_Min Get_Max Get_Mean );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $stats_collector = Lucy::Search::Collector::StatsCollector->new(
+        field => 'price',
+    );
+    $searcher->collect(
+        collector => $stats_collector,
+        query     => $query,
+    );
+    printf( "%d prices, mean %.2f\n",
+        $stats_collector->get_count, $stats_collector->get_mean );
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $stats_collector = Lucy::Search::Collector::StatsCollector->new(
+        field => 'price',    # required
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::Collector::StatsCollector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_termquery {
     my @exposed = qw( Get_Field Get_Term );
 
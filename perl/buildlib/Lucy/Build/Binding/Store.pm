@@ -30,6 +30,7 @@ sub bind_all {
     $class->bind_lockerr;
     $class->bind_lockfactory;
     $class->bind_outstream;
+    $class->bind_posixlockfactory;
     $class->bind_ramfilehandle;
     $class->bind_ramfolder;
 }
@@ -364,6 +365,41 @@ END_XS_CODE
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_posixlockfactory {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    use Sys::Hostname qw( hostname );
+    my $hostname = hostname() or die "Can't get unique hostname";
+    my $folder = Lucy::Store::FSFolder->new(
+        path => '/path/to/index',
+    );
+    my $lock_factory = Lucy::Store::PosixLockFactory->new(
+        folder => $folder,
+        host   => $hostname,
+    );
+    my $manager = Lucy::Index::IndexManager->new(
+        host         => $hostname,
+        lock_factory => $lock_factory,
+    );
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $lock_factory = Lucy::Store::PosixLockFactory->new(
+        folder => $folder,      # required
+        host   => $hostname,    # required
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Store::PosixLockFactory",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_ramfilehandle {
     my $binding = Clownfish::CFC::Binding::Perl::Class->new(
         parcel     => "Lucy",
@@ -133,6 +133,8 @@ BEGIN {
         my $flags = 0;
         $flags |= CREATE   if delete $args{'create'};
         $flags |= TRUNCATE if delete $args{'truncate'};
+        $flags |= NEAR_REAL_TIME if delete $args{'near_real_time'};
+        $flags |= DURABLE        if delete $args{'durable'};
         return $either->_new( %args, flags => $flags );
     }
 }